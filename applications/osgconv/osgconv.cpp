@@ -18,6 +18,7 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/ReaderWriter>
 #include <osgDB/PluginQuery>
+#include <osgDB/fstream>
 
 #include <osgUtil/Optimizer>
 #include <osgUtil/Simplifier>
@@ -529,6 +530,9 @@ static void usage( const char *prog, const char *msg )
     osg::notify( osg::NOTICE ) <<
         "    --plugin <plugin>  - Display information about the specified <plugin>,\n"
         "                         where <plugin> is the plugin's full path and file name." << std::endl;
+    osg::notify( osg::NOTICE ) <<
+        "    --plugin-manifest <file> - Write a manifest of all the plugins and the\n"
+        "                         extensions they support, for OSG_PLUGIN_MANIFEST." << std::endl;
 }
 
 
@@ -574,6 +578,19 @@ int main( int argc, char **argv )
         return 0;
     }
 
+    std::string manifest;
+    if (arguments.read("--plugin-manifest", manifest))
+    {
+        osgDB::ofstream fout(manifest.c_str());
+        if (!fout || !osgDB::writePluginManifest(fout, osgDB::listAllAvailablePlugins()))
+        {
+            std::cout<<"Unable to write plugin manifest "<<manifest<<std::endl;
+            return 1;
+        }
+        std::cout<<"Written plugin manifest "<<manifest<<std::endl;
+        return 0;
+    }
+
     std::string plugin;
     if (arguments.read("--plugin", plugin))
     {
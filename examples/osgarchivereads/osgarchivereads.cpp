@@ -0,0 +1,218 @@
+/* OpenSceneGraph example, osgarchivereads.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Image>
+#include <osg/Timer>
+
+#include <osgDB/Archive>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Atomic>
+
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+
+// Benchmark measuring how many files per second a number of threads can read from a single archive, either
+// a generated .osga archive or one given on the command line such as a .zip of images, in the way that the
+// DatabasePager threads share an archive when paging a database packaged with osgarchive.
+
+class ReadThread : public OpenThreads::Thread
+{
+public:
+
+    ReadThread(osgDB::Archive* archive, const osgDB::Archive::FileNameList& fileNames, unsigned int numReads, bool randomOrder, OpenThreads::Atomic& nextRead, OpenThreads::Atomic& numFailed):
+        _archive(archive),
+        _fileNames(fileNames),
+        _numReads(numReads),
+        _randomOrder(randomOrder),
+        _nextRead(nextRead),
+        _numFailed(numFailed) {}
+
+    virtual void run()
+    {
+        unsigned int i;
+        while((i = (++_nextRead)-1) < _numReads)
+        {
+            // a pager reads tiles in no particular order, spread the reads over the archive with a simple hash.
+            unsigned int index = _randomOrder ? (i * 2654435761u) % _fileNames.size() : i % _fileNames.size();
+            osgDB::ReaderWriter::ReadResult result = _archive->readImage(_fileNames[index]);
+            if (!result.validImage()) ++_numFailed;
+        }
+    }
+
+protected:
+
+    osgDB::Archive*                         _archive;
+    const osgDB::Archive::FileNameList&     _fileNames;
+    unsigned int                            _numReads;
+    bool                                    _randomOrder;
+    OpenThreads::Atomic&                    _nextRead;
+    OpenThreads::Atomic&                    _numFailed;
+};
+
+osg::Image* createTestImage(unsigned int size, unsigned int seed)
+{
+    osg::Image* image = new osg::Image;
+    image->allocateImage(size, size, 1, GL_RGB, GL_UNSIGNED_BYTE);
+    unsigned char* ptr = image->data();
+    for(unsigned int i=0; i<image->getTotalSizeInBytes(); ++i)
+    {
+        *(ptr++) = static_cast<unsigned char>((i*7 + seed*13 + (i>>9)) & 255);
+    }
+    return image;
+}
+
+bool createArchive(const std::string& filename, unsigned int numFiles, unsigned int imageSize)
+{
+    osg::ref_ptr<osgDB::Archive> archive = osgDB::openArchive(filename, osgDB::Archive::CREATE);
+    if (!archive) return false;
+
+    for(unsigned int i=0; i<numFiles; ++i)
+    {
+        std::ostringstream name;
+        name<<"tile_"<<i<<".rgb";
+
+        osg::ref_ptr<osg::Image> image = createTestImage(imageSize, i);
+        if (!archive->writeImage(*image, name.str()).success()) return false;
+    }
+
+    archive->close();
+
+    // the Registry caches opened archives, drop the one opened for writing so that the archive is reopened for reading.
+    osgDB::Registry::instance()->removeFromArchiveCache(filename);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures the rate at which several threads can read files from a single archive, such as a .osga or .zip archive.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] [archive.osga]");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <num>","Maximum number of reading threads, the test is run for 1, 2, 4... up to this number, default 8.");
+    arguments.getApplicationUsage()->addCommandLineOption("--reads <num>","Number of file reads in each test, default 4000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--files <num>","Number of images in the generated archive, default 500.");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <num>","Width and height of the generated images, default 64.");
+    arguments.getApplicationUsage()->addCommandLineOption("--random","Read the files in a scattered order rather than in the order they are listed in the archive.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int maxNumThreads = 8;
+    while(arguments.read("--threads", maxNumThreads)) {}
+    if (maxNumThreads==0) maxNumThreads = 1;
+
+    unsigned int numReads = 4000;
+    while(arguments.read("--reads", numReads)) {}
+
+    unsigned int numFiles = 500;
+    while(arguments.read("--files", numFiles)) {}
+
+    unsigned int imageSize = 64;
+    while(arguments.read("--size", imageSize)) {}
+
+    bool randomOrder = false;
+    while(arguments.read("--random")) { randomOrder = true; }
+
+    std::string archiveFilename;
+    bool removeArchive = false;
+    for(int pos=1; pos<arguments.argc(); ++pos)
+    {
+        if (!arguments.isOption(pos)) archiveFilename = arguments[pos];
+    }
+
+    if (archiveFilename.empty())
+    {
+        archiveFilename = "osgarchivereads_test.osga";
+        removeArchive = true;
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        if (!createArchive(archiveFilename, numFiles, imageSize))
+        {
+            std::cout<<"Unable to create test archive "<<archiveFilename<<std::endl;
+            return 1;
+        }
+        std::cout<<"Created "<<archiveFilename<<" with "<<numFiles<<" images in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms"<<std::endl;
+    }
+
+    osg::ref_ptr<osgDB::Archive> archive = osgDB::openArchive(archiveFilename, osgDB::Archive::READ);
+    osgDB::Archive::FileNameList fileNames;
+    if (!archive || !archive->getFileNames(fileNames))
+    {
+        std::cout<<"Unable to read "<<archiveFilename<<std::endl;
+        return 1;
+    }
+
+    // the archive may hold files other than images, only time the ones an image plugin can read.
+    osgDB::Archive::FileNameList imageFileNames;
+    for(osgDB::Archive::FileNameList::const_iterator itr=fileNames.begin(); itr!=fileNames.end(); ++itr)
+    {
+        if (archive->readImage(*itr).validImage()) imageFileNames.push_back(*itr);
+    }
+
+    if (imageFileNames.empty())
+    {
+        std::cout<<"No images found in "<<archiveFilename<<std::endl;
+        return 1;
+    }
+
+    double singleThreadRate = 0.0;
+    for(unsigned int numThreads=1; numThreads<=maxNumThreads; numThreads*=2)
+    {
+        OpenThreads::Atomic nextRead;
+        OpenThreads::Atomic numFailed;
+
+        std::vector< ReadThread* > threads;
+        for(unsigned int i=0; i<numThreads; ++i)
+        {
+            threads.push_back(new ReadThread(archive.get(), imageFileNames, numReads, randomOrder, nextRead, numFailed));
+        }
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        for(unsigned int i=0; i<threads.size(); ++i) threads[i]->startThread();
+        for(unsigned int i=0; i<threads.size(); ++i)
+        {
+            threads[i]->join();
+            delete threads[i];
+        }
+
+        double seconds = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+        double rate = seconds>0.0 ? double(numReads)/seconds : 0.0;
+        if (numThreads==1) singleThreadRate = rate;
+
+        std::cout<<"threads="<<numThreads<<" reads="<<numReads<<" time="<<seconds*1000.0<<"ms "<<rate<<" files/s"
+                 <<" speedup="<<(singleThreadRate>0.0 ? rate/singleThreadRate : 0.0);
+        if (static_cast<unsigned int>(numFailed)>0) std::cout<<" failed="<<static_cast<unsigned int>(numFailed);
+        std::cout<<std::endl;
+    }
+
+    archive = 0;
+    if (removeArchive) remove(archiveFilename.c_str());
+
+    return 0;
+}
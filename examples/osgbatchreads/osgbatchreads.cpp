@@ -0,0 +1,199 @@
+/* OpenSceneGraph example, osgbatchreads.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Timer>
+
+#include <osgDB/BatchReader>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+#include <osgDB/Registry>
+
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+
+// Benchmark comparing the loading of a list of models one after the other with osgDB::readRefNodeFile()
+// against loading them with an osgDB::BatchReader, for 1, 2, 4... worker threads, in the way an application
+// loads its library of models at startup.
+
+osg::Node* createTestModel(unsigned int numVertices, unsigned int seed)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    for(unsigned int i=0; i<numVertices; ++i)
+    {
+        float a = float(i*7 + seed*13) * 0.001f;
+        vertices->push_back(osg::Vec3(cosf(a)*float(i), sinf(a)*float(i), float(seed)));
+        normals->push_back(osg::Vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, (numVertices/3)*3));
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+    return geode;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures how the loading of many models scales with the number of threads of an osgDB::BatchReader.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] [model files]");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <num>","Maximum number of reading threads, the test is run for 1, 2, 4... up to this number, default 8.");
+    arguments.getApplicationUsage()->addCommandLineOption("--files <num>","Number of models generated when none are given, default 200.");
+    arguments.getApplicationUsage()->addCommandLineOption("--vertices <num>","Number of vertices of the generated models, default 20000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--ext <ext>","Format of the generated models, default osgt.");
+    arguments.getApplicationUsage()->addCommandLineOption("--cache","Read the models through the object cache, the last test then reading them again from the cache.");
+    arguments.getApplicationUsage()->addCommandLineOption("--verbose","Report the queue and read time of each file of the last test.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int maxNumThreads = 8;
+    while(arguments.read("--threads", maxNumThreads)) {}
+    if (maxNumThreads==0) maxNumThreads = 1;
+
+    unsigned int numFiles = 200;
+    while(arguments.read("--files", numFiles)) {}
+
+    unsigned int numVertices = 20000;
+    while(arguments.read("--vertices", numVertices)) {}
+
+    std::string ext = "osgt";
+    while(arguments.read("--ext", ext)) {}
+
+    bool useCache = false;
+    while(arguments.read("--cache")) { useCache = true; }
+
+    bool verbose = false;
+    while(arguments.read("--verbose")) { verbose = true; }
+
+    std::vector<std::string> fileNames;
+    for(int pos=1; pos<arguments.argc(); ++pos)
+    {
+        if (!arguments.isOption(pos)) fileNames.push_back(arguments[pos]);
+    }
+
+    bool removeFiles = false;
+    if (fileNames.empty())
+    {
+        removeFiles = true;
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        for(unsigned int i=0; i<numFiles; ++i)
+        {
+            std::ostringstream name;
+            name<<"osgbatchreads_test_"<<i<<"."<<ext;
+
+            osg::ref_ptr<osg::Node> model = createTestModel(numVertices, i);
+            if (!osgDB::writeNodeFile(*model, name.str()))
+            {
+                std::cout<<"Unable to write test model "<<name.str()<<std::endl;
+                return 1;
+            }
+            fileNames.push_back(name.str());
+        }
+        std::cout<<"Created "<<numFiles<<" ."<<ext<<" models in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms"<<std::endl;
+    }
+
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+    options->setObjectCacheHint(useCache ? osgDB::Options::CACHE_NODES : osgDB::Options::CACHE_NONE);
+
+    // load the plugins up front so that the first test doesn't include their loading.
+    osgDB::readRefNodeFile(fileNames.front(), options.get());
+    osgDB::Registry::instance()->clearObjectCache();
+
+    double serialSeconds = 0.0;
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        unsigned int numFailed = 0;
+        for(std::vector<std::string>::const_iterator itr=fileNames.begin(); itr!=fileNames.end(); ++itr)
+        {
+            if (!osgDB::readRefNodeFile(*itr, options.get())) ++numFailed;
+        }
+        serialSeconds = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+
+        std::cout<<"readRefNodeFile files="<<fileNames.size()<<" time="<<serialSeconds*1000.0<<"ms";
+        if (numFailed>0) std::cout<<" failed="<<numFailed;
+        std::cout<<std::endl;
+    }
+
+    osgDB::BatchReader::RequestList requests;
+    for(unsigned int numThreads=1; numThreads<=maxNumThreads; numThreads*=2)
+    {
+        // in the cache test the serial reads have filled the cache, so clear it for every test but the last
+        if (numThreads*2<=maxNumThreads || !useCache) osgDB::Registry::instance()->clearObjectCache();
+
+        osg::ref_ptr<osgDB::BatchReader> batchReader = new osgDB::BatchReader(numThreads);
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        requests = batchReader->read(fileNames, options.get());
+        batchReader->waitForCompletion();
+
+        double seconds = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+
+        unsigned int numFailed = 0;
+        unsigned int numFromCache = 0;
+        for(osgDB::BatchReader::RequestList::iterator itr=requests.begin(); itr!=requests.end(); ++itr)
+        {
+            if (!(*itr)->getNode()) ++numFailed;
+            if ((*itr)->loadedFromCache()) ++numFromCache;
+        }
+
+        std::cout<<"BatchReader threads="<<numThreads<<" files="<<fileNames.size()<<" time="<<seconds*1000.0<<"ms"
+                 <<" speedup="<<(seconds>0.0 ? serialSeconds/seconds : 0.0);
+        if (numFromCache>0) std::cout<<" cached="<<numFromCache;
+        if (numFailed>0) std::cout<<" failed="<<numFailed;
+        std::cout<<std::endl;
+    }
+
+    if (verbose)
+    {
+        for(osgDB::BatchReader::RequestList::iterator itr=requests.begin(); itr!=requests.end(); ++itr)
+        {
+            std::cout<<"  "<<(*itr)->getFileName()<<" queued="<<(*itr)->getQueueTime()<<"ms read="<<(*itr)->getReadTime()<<"ms"
+                     <<((*itr)->loadedFromCache() ? " (cache)" : "")<<std::endl;
+        }
+    }
+
+    requests.clear();
+    osgDB::Registry::instance()->clearObjectCache();
+
+    if (removeFiles)
+    {
+        for(std::vector<std::string>::const_iterator itr=fileNames.begin(); itr!=fileNames.end(); ++itr)
+        {
+            remove(itr->c_str());
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/* OpenSceneGraph example, osgdxtc.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Image>
+#include <osg/ImageUtils>
+#include <osg/Timer>
+
+#include <osgDB/BlockCompressionImageProcessor>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <iostream>
+#include <stdio.h>
+#include <math.h>
+
+// Throughput benchmark for CPU side handling of DXT compressed images: decompression with osg::createDecompressedImage()
+// compared to per pixel Image::getColor(), in place vertical flipping, and reading .dds files with and without dds_flip.
+
+osg::Image* createTestImage(int width, int height)
+{
+    osg::Image* image = new osg::Image;
+    image->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+    for(int t=0; t<height; ++t)
+    {
+        unsigned char* ptr = image->data(0, t);
+        for(int s=0; s<width; ++s)
+        {
+            *(ptr++) = static_cast<unsigned char>(128.0+127.0*sin(double(s)*0.05));
+            *(ptr++) = static_cast<unsigned char>(128.0+127.0*cos(double(t)*0.03));
+            *(ptr++) = static_cast<unsigned char>((s+t)&255);
+            *(ptr++) = static_cast<unsigned char>(((s/16+t/16)%2) ? 255 : (s*4)&255);
+        }
+    }
+    return image;
+}
+
+double megaPixelsPerSecond(const osg::Image* image, unsigned int numIterations, double milliseconds)
+{
+    return milliseconds>0.0 ? (double(image->s())*double(image->t())*double(numIterations)/1.0e6)/(milliseconds/1000.0) : 0.0;
+}
+
+void benchmarkFormat(const osg::Image* source, osg::Texture::InternalFormatMode mode, const char* name, unsigned int numIterations, const std::string& filename)
+{
+    osg::Timer* timer = osg::Timer::instance();
+
+    osg::ref_ptr<osgDB::BlockCompressionImageProcessor> processor = new osgDB::BlockCompressionImageProcessor;
+    osg::ref_ptr<osg::Image> compressed = new osg::Image(*source, osg::CopyOp::DEEP_COPY_ALL);
+    processor->compress(*compressed, mode, true, false, osgDB::ImageProcessor::USE_CPU, osgDB::ImageProcessor::FASTEST);
+
+    std::cout<<name<<" "<<compressed->s()<<"x"<<compressed->t()<<" with "<<compressed->getNumMipmapLevels()<<" mipmap levels"<<std::endl;
+
+    // reference decompression through per pixel Image::getColor()
+    osg::Timer_t startTick = timer->tick();
+    osg::Vec4 sum;
+    for(int t=0; t<compressed->t(); ++t)
+    {
+        for(int s=0; s<compressed->s(); ++s)
+        {
+            sum += compressed->getColor(s, t);
+        }
+    }
+    double getColorTime = timer->delta_m(startTick, timer->tick());
+    std::cout<<"  Image::getColor()           "<<megaPixelsPerSecond(compressed.get(), 1, getColorTime)<<" MPixels/s"<<std::endl;
+
+    startTick = timer->tick();
+    for(unsigned int i=0; i<numIterations; ++i)
+    {
+        osg::ref_ptr<osg::Image> decompressed = osg::createDecompressedImage(compressed.get());
+    }
+    double decompressTime = timer->delta_m(startTick, timer->tick());
+    std::cout<<"  createDecompressedImage()   "<<megaPixelsPerSecond(compressed.get(), numIterations, decompressTime)<<" MPixels/s (all levels)"<<std::endl;
+
+    startTick = timer->tick();
+    for(unsigned int i=0; i<numIterations; ++i)
+    {
+        compressed->flipVertical();
+    }
+    double flipTime = timer->delta_m(startTick, timer->tick());
+    std::cout<<"  Image::flipVertical()       "<<megaPixelsPerSecond(compressed.get(), numIterations, flipTime)<<" MPixels/s"<<std::endl;
+
+    if (!filename.empty() && osgDB::writeImageFile(*compressed, filename))
+    {
+        const char* optionStrings[] = { "", "dds_flip" };
+        for(unsigned int o=0; o<2; ++o)
+        {
+            osg::ref_ptr<osgDB::Options> options = new osgDB::Options(optionStrings[o]);
+            startTick = timer->tick();
+            for(unsigned int i=0; i<numIterations; ++i)
+            {
+                osg::ref_ptr<osg::Image> image = osgDB::readRefImageFile(filename, options.get());
+            }
+            double readTime = timer->delta_m(startTick, timer->tick());
+            std::cout<<"  read .dds "<<(o==0 ? "         " : "dds_flip ")<<"        "<<megaPixelsPerSecond(compressed.get(), numIterations, readTime)<<" MPixels/s"<<std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures the throughput of DXT decompression, vertical flipping and .dds reading.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] [imagefile]");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <width> <height>","Size of the generated test image when no image file is given, default 2048 2048.");
+    arguments.getApplicationUsage()->addCommandLineOption("--iterations <num>","Number of times to repeat each test, default 10.");
+    arguments.getApplicationUsage()->addCommandLineOption("--dds <filename>","Temporary .dds file used for the read tests, default osgdxtc_test.dds.");
+    arguments.getApplicationUsage()->addCommandLineOption("--no-read","Skip the .dds read tests.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    int width = 2048, height = 2048;
+    while(arguments.read("--size", width, height)) {}
+
+    unsigned int numIterations = 10;
+    while(arguments.read("--iterations", numIterations)) {}
+    if (numIterations==0) numIterations = 1;
+
+    std::string filename("osgdxtc_test.dds");
+    while(arguments.read("--dds", filename)) {}
+    if (arguments.read("--no-read")) filename.clear();
+
+    osg::ref_ptr<osg::Image> image;
+    for(int pos=1; pos<arguments.argc() && !image; ++pos)
+    {
+        if (!arguments.isOption(pos))
+        {
+            image = osgDB::readRefImageFile(arguments[pos]);
+            if (image && (image->isCompressed() || image->getDataType()!=GL_UNSIGNED_BYTE)) image = 0;
+            if (!image) std::cout<<"Could not use image file "<<arguments[pos]<<", using generated test image."<<std::endl;
+        }
+    }
+
+    if (!image) image = createTestImage(width, height);
+
+    benchmarkFormat(image.get(), osg::Texture::USE_S3TC_DXT1_COMPRESSION, "DXT1", numIterations, filename);
+    benchmarkFormat(image.get(), osg::Texture::USE_S3TC_DXT3_COMPRESSION, "DXT3", numIterations, filename);
+    benchmarkFormat(image.get(), osg::Texture::USE_S3TC_DXT5_COMPRESSION, "DXT5", numIterations, filename);
+
+    if (!filename.empty()) remove(filename.c_str());
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+/* OpenSceneGraph example, osgimagescale.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/GLU>
+#include <osg/Image>
+#include <osg/ImageUtils>
+#include <osg/Timer>
+
+#include <osgDB/ReadFile>
+
+#include <iostream>
+#include <stdlib.h>
+
+// Benchmark comparing gluScaleImage with osg::resampleImageData for the different filters and thread counts,
+// along with the cost of generating a full mipmap chain on the CPU.
+
+osg::Image* createTestImage(int width, int height, GLenum pixelFormat)
+{
+    osg::Image* image = new osg::Image;
+    image->allocateImage(width, height, 1, pixelFormat, GL_UNSIGNED_BYTE);
+
+    unsigned int numComponents = osg::Image::computeNumComponents(pixelFormat);
+    for(int t=0; t<height; ++t)
+    {
+        unsigned char* ptr = image->data(0, t);
+        for(int s=0; s<width; ++s)
+        {
+            for(unsigned int c=0; c<numComponents; ++c)
+            {
+                *(ptr++) = static_cast<unsigned char>((s*(c+1) + t*(3-c) + (rand()&15)) & 255);
+            }
+        }
+    }
+    return image;
+}
+
+double timeGluScaleImage(const osg::Image* image, int width, int height, unsigned int numIterations)
+{
+    std::vector<unsigned char> output(osg::Image::computeRowWidthInBytes(width, image->getPixelFormat(), image->getDataType(), image->getPacking())*height);
+
+    osg::PixelStorageModes psm;
+    psm.pack_alignment = image->getPacking();
+    psm.unpack_alignment = image->getPacking();
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    for(unsigned int i=0; i<numIterations; ++i)
+    {
+        osg::gluScaleImage(&psm, image->getPixelFormat(),
+                           image->s(), image->t(), image->getDataType(), image->data(),
+                           width, height, image->getDataType(), &output.front());
+    }
+    return osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())/double(numIterations);
+}
+
+double timeResampleImageData(const osg::Image* image, int width, int height, osg::ResampleFilter filter, unsigned int numThreads, unsigned int numIterations)
+{
+    unsigned int outRowStep = osg::Image::computeRowWidthInBytes(width, image->getPixelFormat(), image->getDataType(), image->getPacking());
+    std::vector<unsigned char> output(outRowStep*height);
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    for(unsigned int i=0; i<numIterations; ++i)
+    {
+        if (!osg::resampleImageData(image->getPixelFormat(),
+                                    image->s(), image->t(), image->getDataType(), image->data(), image->getRowStepInBytes(),
+                                    width, height, image->getDataType(), &output.front(), outRowStep,
+                                    filter, numThreads))
+        {
+            return -1.0;
+        }
+    }
+    return osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())/double(numIterations);
+}
+
+double timeGenerateMipmaps(const osg::Image* image, osg::ResampleFilter filter, unsigned int numIterations)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    for(unsigned int i=0; i<numIterations; ++i)
+    {
+        osg::ref_ptr<osg::Image> copy = new osg::Image(*image, osg::CopyOp::DEEP_COPY_ALL);
+        if (!osg::generateMipmaps(copy.get(), filter)) return -1.0;
+    }
+    return osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())/double(numIterations);
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" compares the performance of gluScaleImage with osg::resampleImageData.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] [imagefile]");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <width> <height>","Size of the generated test image when no image file is given, default 4096 4096.");
+    arguments.getApplicationUsage()->addCommandLineOption("--scale <width> <height>","Size to scale to, default is half the size of the source image.");
+    arguments.getApplicationUsage()->addCommandLineOption("--rgb","Use a RGB rather than RGBA test image.");
+    arguments.getApplicationUsage()->addCommandLineOption("--iterations <num>","Number of times to repeat each test, default 5.");
+    arguments.getApplicationUsage()->addCommandLineOption("--max-threads <num>","Maximum number of threads to test, default 8.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    int width = 4096, height = 4096;
+    while(arguments.read("--size", width, height)) {}
+
+    int scaledWidth = 0, scaledHeight = 0;
+    while(arguments.read("--scale", scaledWidth, scaledHeight)) {}
+
+    unsigned int numIterations = 5;
+    while(arguments.read("--iterations", numIterations)) {}
+    if (numIterations==0) numIterations = 1;
+
+    unsigned int maxThreads = 8;
+    while(arguments.read("--max-threads", maxThreads)) {}
+
+    GLenum pixelFormat = arguments.read("--rgb") ? GL_RGB : GL_RGBA;
+
+    osg::ref_ptr<osg::Image> image;
+    for(int pos=1; pos<arguments.argc() && !image; ++pos)
+    {
+        if (!arguments.isOption(pos))
+        {
+            image = osgDB::readRefImageFile(arguments[pos]);
+            if (!image) std::cout<<"Could not read image file "<<arguments[pos]<<", using generated test image."<<std::endl;
+        }
+    }
+
+    if (!image) image = createTestImage(width, height, pixelFormat);
+
+    if (scaledWidth<=0 || scaledHeight<=0)
+    {
+        scaledWidth = osg::maximum(image->s()/2, 1);
+        scaledHeight = osg::maximum(image->t()/2, 1);
+    }
+
+    std::cout<<"Scaling "<<image->s()<<"x"<<image->t()<<" to "<<scaledWidth<<"x"<<scaledHeight
+             <<", averaged over "<<numIterations<<" iterations"<<std::endl;
+
+    std::cout<<"  gluScaleImage                 "<<timeGluScaleImage(image.get(), scaledWidth, scaledHeight, numIterations)<<"ms"<<std::endl;
+
+    const char* filterNames[] = { "RESAMPLE_BOX", "RESAMPLE_BILINEAR", "RESAMPLE_LANCZOS3" };
+    for(unsigned int f=0; f<3; ++f)
+    {
+        osg::ResampleFilter filter = static_cast<osg::ResampleFilter>(f);
+        for(unsigned int numThreads=1; numThreads<=maxThreads; numThreads*=2)
+        {
+            std::cout<<"  resampleImageData "<<filterNames[f]<<" threads="<<numThreads<<"  "
+                     <<timeResampleImageData(image.get(), scaledWidth, scaledHeight, filter, numThreads, numIterations)<<"ms"<<std::endl;
+        }
+        std::cout<<"  resampleImageData "<<filterNames[f]<<" threads=auto  "
+                 <<timeResampleImageData(image.get(), scaledWidth, scaledHeight, filter, 0, numIterations)<<"ms"<<std::endl;
+    }
+
+    std::cout<<"Mipmap generation"<<std::endl;
+    for(unsigned int f=0; f<3; ++f)
+    {
+        std::cout<<"  generateMipmaps "<<filterNames[f]<<"  "<<timeGenerateMipmaps(image.get(), static_cast<osg::ResampleFilter>(f), numIterations)<<"ms"<<std::endl;
+    }
+
+    return 0;
+}
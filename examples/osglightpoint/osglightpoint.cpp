@@ -70,6 +70,7 @@ void addToLightPointNode(osgSim::LightPointNode& lpn,osgSim::LightPoint& start,o
 #undef INTERPOLATE
 
 bool usePointSprites;
+osgSim::LightPointNode::ComputeMode computeMode = osgSim::LightPointNode::COMPUTE_ON_CPU;
 
 osg::Node* createLightPointsDatabase()
 {
@@ -119,6 +120,7 @@ osg::Node* createLightPointsDatabase()
 //        start._sector = sector;
 
         osgSim::LightPointNode* lpn = new osgSim::LightPointNode;
+        lpn->setComputeMode(computeMode);
 
         //
         osg::StateSet* set = lpn->getOrCreateStateSet();
@@ -157,6 +159,7 @@ osg::Node* createLightPointsDatabase()
 static osg::Node* CreateBlinkSequenceLightNode()
 {
    osgSim::LightPointNode*      lightPointNode = new osgSim::LightPointNode;;
+   lightPointNode->setComputeMode(computeMode);
 
    osgSim::LightPointNode::LightPointList       lpList;
 
@@ -215,6 +218,7 @@ int main( int argc, char **argv )
     arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] filename ...");
     arguments.getApplicationUsage()->addCommandLineOption("-h or --help","Display this information");
     arguments.getApplicationUsage()->addCommandLineOption("--sprites","Point sprites.");
+    arguments.getApplicationUsage()->addCommandLineOption("--gpu","Evaluate light points in shaders rather than on the CPU during cull.");
 
     // construct the viewer.
     osgViewer::Viewer viewer;
@@ -228,6 +232,7 @@ int main( int argc, char **argv )
 
     usePointSprites = false;
     while (arguments.read("--sprites")) { usePointSprites = true; };
+    while (arguments.read("--gpu")) { computeMode = osgSim::LightPointNode::COMPUTE_ON_GPU; };
 
     osg::Group* rootnode = new osg::Group;
 
@@ -0,0 +1,248 @@
+/* OpenSceneGraph example, osgobjreads.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <osg/Timer>
+
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Thread>
+
+#include <iostream>
+#include <sstream>
+#include <math.h>
+#include <stdio.h>
+
+// Benchmark measuring the rate in MB/s at which the obj plugin loads a Wavefront .obj file, either a generated
+// grid or one given on the command line, when parsing the file with 1, 2, 4... threads (the parseThreads option),
+// and when reading it from a stream rather than from a memory mapped file.
+
+class CountVisitor : public osg::NodeVisitor
+{
+public:
+
+    CountVisitor():
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+        numVertices(0),
+        numIndices(0) {}
+
+    virtual void apply(osg::Geometry& geometry)
+    {
+        if (geometry.getVertexArray()) numVertices += geometry.getVertexArray()->getNumElements();
+        for(unsigned int i=0; i<geometry.getNumPrimitiveSets(); ++i)
+        {
+            numIndices += geometry.getPrimitiveSet(i)->getNumIndices();
+        }
+    }
+
+    unsigned int numVertices;
+    unsigned int numIndices;
+};
+
+// Writes a size x size grid of vertices with normals and texture coordinates, split in two groups and materials.
+bool createOBJ(const std::string& filename, unsigned int size)
+{
+    osgDB::ofstream fout(filename.c_str());
+    if (!fout) return false;
+
+    fout<<"# osgobjreads test grid\n";
+    fout<<"o grid\ng part1\ns 1\n";
+
+    char line[256];
+    for(unsigned int j=0; j<size; ++j)
+    {
+        for(unsigned int i=0; i<size; ++i)
+        {
+            sprintf(line, "v %f %f %f\n", float(i)*0.1f, float(j)*0.1f, sinf(float(i)*0.05f)*cosf(float(j)*0.07f));
+            fout<<line;
+        }
+    }
+
+    for(unsigned int j=0; j<size; ++j)
+    {
+        for(unsigned int i=0; i<size; ++i)
+        {
+            sprintf(line, "vn %f %f %f\n", 0.0f, 0.0f, 1.0f);
+            fout<<line;
+        }
+    }
+
+    for(unsigned int j=0; j<size; ++j)
+    {
+        for(unsigned int i=0; i<size; ++i)
+        {
+            sprintf(line, "vt %f %f\n", float(i)/float(size), float(j)/float(size));
+            fout<<line;
+        }
+    }
+
+    for(unsigned int j=0; j+1<size; ++j)
+    {
+        if (j==size/2) fout<<"g part2\n";
+
+        for(unsigned int i=0; i+1<size; ++i)
+        {
+            unsigned int a = j*size+i+1, b = a+1, c = a+size, d = c+1;
+            sprintf(line, "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n", a,a,a, b,b,b, d,d,d, a,a,a, d,d,d, c,c,c);
+            fout<<line;
+        }
+    }
+
+    return !fout.fail();
+}
+
+// Reads the file numRepeats times and prints the fastest time, returns the rate in MB/s or -1 if the file couldn't be read.
+double timeRead(osgDB::ReaderWriter* rw, const std::string& filename, double fileSize, const std::string& optionString, unsigned int numThreads, unsigned int numRepeats, bool fromStream, double singleThreadRate)
+{
+    std::ostringstream options;
+    options<<optionString<<" parseThreads="<<numThreads;
+    osg::ref_ptr<osgDB::Options> readOptions = new osgDB::Options(options.str());
+
+    double bestSeconds = 0.0;
+    CountVisitor cv;
+    for(unsigned int r=0; r<numRepeats; ++r)
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        osg::ref_ptr<osg::Node> node;
+        if (fromStream)
+        {
+            osgDB::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+            node = rw->readNode(fin, readOptions.get()).getNode();
+        }
+        else
+        {
+            node = rw->readNode(filename, readOptions.get()).getNode();
+        }
+
+        double seconds = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+        if (!node)
+        {
+            std::cout<<"Unable to read "<<filename<<std::endl;
+            return -1.0;
+        }
+
+        if (r==0 || seconds<bestSeconds) bestSeconds = seconds;
+        if (r==0) node->accept(cv);
+    }
+
+    double rate = bestSeconds>0.0 ? fileSize/bestSeconds : 0.0;
+
+    std::cout<<(fromStream ? "stream" : "file")<<" threads="<<numThreads<<" time="<<bestSeconds*1000.0<<"ms "<<rate<<" MB/s"
+             <<" speedup="<<(singleThreadRate>0.0 ? rate/singleThreadRate : 1.0)
+             <<" vertices="<<cv.numVertices<<" indices="<<cv.numIndices<<std::endl;
+
+    return rate;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures the rate at which the obj plugin loads a Wavefront .obj file.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] [file.obj]");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads <num>","Maximum number of parsing threads, the test is run for 1, 2, 4... up to this number, default the number of processors.");
+    arguments.getApplicationUsage()->addCommandLineOption("--size <num>","Width and height in vertices of the generated grid, default 700 which makes a file of about 100MB.");
+    arguments.getApplicationUsage()->addCommandLineOption("--repeat <num>","Number of times each test is run, the fastest run is reported, default 3.");
+    arguments.getApplicationUsage()->addCommandLineOption("--options <string>","Options passed to the obj plugin, default \"noTriStripPolygons noTesselateLargePolygons\" so that the parsing dominates.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int maxNumThreads = OpenThreads::GetNumberOfProcessors();
+    while(arguments.read("--threads", maxNumThreads)) {}
+    if (maxNumThreads==0) maxNumThreads = 1;
+
+    unsigned int size = 700;
+    while(arguments.read("--size", size)) {}
+    if (size<2) size = 2;
+
+    unsigned int numRepeats = 3;
+    while(arguments.read("--repeat", numRepeats)) {}
+    if (numRepeats==0) numRepeats = 1;
+
+    std::string optionString = "noTriStripPolygons noTesselateLargePolygons";
+    while(arguments.read("--options", optionString)) {}
+
+    std::string filename;
+    bool removeFile = false;
+    for(int pos=1; pos<arguments.argc(); ++pos)
+    {
+        if (!arguments.isOption(pos)) filename = arguments[pos];
+    }
+
+    if (filename.empty())
+    {
+        filename = "osgobjreads_test.obj";
+        removeFile = true;
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        if (!createOBJ(filename, size))
+        {
+            std::cout<<"Unable to create test file "<<filename<<std::endl;
+            return 1;
+        }
+        std::cout<<"Created "<<filename<<" with a "<<size<<"x"<<size<<" grid in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms"<<std::endl;
+    }
+
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("obj");
+    if (!rw)
+    {
+        std::cout<<"Unable to load the obj plugin"<<std::endl;
+        return 1;
+    }
+
+    double fileSize = 0.0;
+    {
+        osgDB::ifstream fin(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!fin)
+        {
+            std::cout<<"Unable to open "<<filename<<std::endl;
+            return 1;
+        }
+        fin.seekg(0, std::ios::end);
+        fileSize = double(fin.tellg())/(1024.0*1024.0);
+    }
+
+    std::cout<<filename<<" "<<fileSize<<"MB, options \""<<optionString<<"\""<<std::endl;
+
+    double singleThreadRate = 0.0;
+    for(unsigned int numThreads=1; numThreads<=maxNumThreads; numThreads*=2)
+    {
+        double rate = timeRead(rw, filename, fileSize, optionString, numThreads, numRepeats, false, singleThreadRate);
+        if (rate<0.0) return 1;
+        if (numThreads==1) singleThreadRate = rate;
+    }
+
+    // reading from a stream, as when the file comes from an archive or a server, copies it into memory first.
+    if (timeRead(rw, filename, fileSize, optionString, maxNumThreads, numRepeats, true, singleThreadRate)<0.0) return 1;
+
+    if (removeFile) remove(filename.c_str());
+
+    return 0;
+}
@@ -0,0 +1,257 @@
+/* OpenSceneGraph example, osgserializerio.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osg/ArgumentParser>
+#include <osg/ApplicationUsage>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Texture2D>
+#include <osg/Timer>
+
+#include <osgDB/ConvertBase64>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <stdlib.h>
+
+// Benchmark of the writing and reading of a scene in the three formats of the osg plugin, the .osgb
+// binary, .osgt ascii and .osgx XML formats, which also checks that the scene survives the round
+// trip by writing the scene read back again and comparing the two. The scene is a large Geometry
+// with a texture, the image data of which is written as Base64 in the text formats.
+
+osg::Node* createScene(unsigned int numVertices, unsigned int imageSize)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(numVertices);
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(numVertices);
+    osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array(numVertices);
+    osg::ref_ptr<osg::Vec4ubArray> colors = new osg::Vec4ubArray(numVertices);
+    for(unsigned int i=0; i<numVertices; ++i)
+    {
+        float a = float(i) * 0.0137f;
+        (*vertices)[i].set(cosf(a)*float(i)*0.01f, sinf(a)*float(i)*0.01f, float(i%977)*0.1f);
+        (*normals)[i].set(cosf(a), sinf(a), 0.0f);
+        (*texcoords)[i].set(float(i%1024)/1024.0f, float(i/1024)/1024.0f);
+        (*colors)[i].set(i&255, (i>>8)&255, (i>>16)&255, 255);
+    }
+
+    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(GL_TRIANGLES);
+    for(unsigned int i=0; i+2<numVertices; ++i)
+    {
+        indices->push_back(i);
+        indices->push_back(i+1);
+        indices->push_back(i+2);
+    }
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->setTexCoordArray(0, texcoords.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(indices.get());
+
+    if (imageSize>0)
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        image->allocateImage(imageSize, imageSize, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+        unsigned char* data = image->data();
+        unsigned int seed = 12345;
+        for(unsigned int i=0; i<image->getTotalSizeInBytes(); ++i)
+        {
+            seed = seed*1103515245 + 12345;
+            data[i] = static_cast<unsigned char>(seed>>16);
+        }
+        geometry->getOrCreateStateSet()->setTextureAttributeAndModes(0, new osg::Texture2D(image.get()));
+    }
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+    return geode;
+}
+
+bool testFormat(const std::string& ext, osg::Node* scene, unsigned int numRepeats)
+{
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+    if (!rw)
+    {
+        std::cout<<"No plugin found for ."<<ext<<std::endl;
+        return false;
+    }
+
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+    options->setPluginStringData("fileType", ext=="osgt" ? "Ascii" : (ext=="osgx" ? "XML" : "Binary"));
+    options->setPluginStringData("WriteImageHint", "IncludeData");
+
+    std::string written;
+    double writeTime = 0.0;
+    for(unsigned int i=0; i<numRepeats; ++i)
+    {
+        std::ostringstream out;
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        osgDB::ReaderWriter::WriteResult result = rw->writeNode(*scene, out, options.get());
+        writeTime += osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+        if (!result.success())
+        {
+            std::cout<<"Unable to write ."<<ext<<" : "<<result.message()<<std::endl;
+            return false;
+        }
+        written = out.str();
+    }
+
+    osg::ref_ptr<osg::Node> node;
+    double readTime = 0.0;
+    for(unsigned int i=0; i<numRepeats; ++i)
+    {
+        std::istringstream in(written);
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        node = rw->readNode(in, options.get()).getNode();
+        readTime += osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+        if (!node)
+        {
+            std::cout<<"Unable to read ."<<ext<<std::endl;
+            return false;
+        }
+    }
+
+    // write the scene read back, which has to give the same file if nothing was lost on the way
+    std::ostringstream rewritten;
+    rw->writeNode(*node, rewritten, options.get());
+    bool identical = (rewritten.str()==written);
+
+    double megabytes = double(written.size())/(1024.0*1024.0);
+    writeTime /= double(numRepeats);
+    readTime /= double(numRepeats);
+
+    std::cout<<"."<<ext<<" size="<<megabytes<<"MB"
+             <<" write="<<writeTime<<"ms ("<<(writeTime>0.0 ? megabytes*1000.0/writeTime : 0.0)<<"MB/s)"
+             <<" read="<<readTime<<"ms ("<<(readTime>0.0 ? megabytes*1000.0/readTime : 0.0)<<"MB/s)"
+             <<(identical ? " round trip ok" : " round trip FAILED")<<std::endl;
+
+    return identical;
+}
+
+bool testBase64(unsigned int size, unsigned int numRepeats)
+{
+    std::string data(size, '\0');
+    unsigned int seed = 54321;
+    for(unsigned int i=0; i<size; ++i)
+    {
+        seed = seed*1103515245 + 12345;
+        data[i] = static_cast<char>(seed>>16);
+    }
+
+    std::vector<std::string> encoded(1);
+    double encodeTime = 0.0;
+    for(unsigned int i=0; i<numRepeats; ++i)
+    {
+        osgDB::Base64encoder encoder;
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        encoder.encode(data.c_str(), static_cast<int>(data.size()), encoded[0]);
+        encodeTime += osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+    }
+
+    bool identical = true;
+    double decodeTime = 0.0;
+    for(unsigned int i=0; i<numRepeats; ++i)
+    {
+        osgDB::Base64decoder decoder;
+        std::vector<unsigned int> sizes;
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        char* decoded = decoder.decode(encoded, sizes);
+        decodeTime += osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+
+        if (sizes.back()!=size || memcmp(decoded, data.c_str(), size)!=0) identical = false;
+        delete [] decoded;
+    }
+
+    double megabytes = double(size)/(1024.0*1024.0);
+    encodeTime /= double(numRepeats);
+    decodeTime /= double(numRepeats);
+
+    std::cout<<"Base64 size="<<megabytes<<"MB"
+             <<" encode="<<encodeTime<<"ms ("<<(encodeTime>0.0 ? megabytes*1000.0/encodeTime : 0.0)<<"MB/s)"
+             <<" decode="<<decodeTime<<"ms ("<<(decodeTime>0.0 ? megabytes*1000.0/decodeTime : 0.0)<<"MB/s)"
+             <<(identical ? " round trip ok" : " round trip FAILED")<<std::endl;
+
+    return identical;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" measures the writing and reading of a scene in the .osgb, .osgt and .osgx formats, and of Base64 encoded data.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options] [model file]");
+    arguments.getApplicationUsage()->addCommandLineOption("--vertices <num>","Number of vertices of the generated scene, default 200000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--image <size>","Size of the texture of the generated scene, default 1024, 0 for no texture.");
+    arguments.getApplicationUsage()->addCommandLineOption("--base64 <size>","Size in bytes of the data of the Base64 test, default 16777216, 0 to skip the test.");
+    arguments.getApplicationUsage()->addCommandLineOption("--repeat <num>","Number of times each test is run, the times reported being their average, default 3.");
+    arguments.getApplicationUsage()->addCommandLineOption("--ext <ext>","Only test the given format, may be used several times.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numVertices = 200000;
+    while(arguments.read("--vertices", numVertices)) {}
+
+    unsigned int imageSize = 1024;
+    while(arguments.read("--image", imageSize)) {}
+
+    unsigned int base64Size = 16*1024*1024;
+    while(arguments.read("--base64", base64Size)) {}
+
+    unsigned int numRepeats = 3;
+    while(arguments.read("--repeat", numRepeats)) {}
+    if (numRepeats==0) numRepeats = 1;
+
+    std::vector<std::string> extensions;
+    std::string ext;
+    while(arguments.read("--ext", ext)) { extensions.push_back(ext); }
+    if (extensions.empty())
+    {
+        extensions.push_back("osgb");
+        extensions.push_back("osgt");
+        extensions.push_back("osgx");
+    }
+
+    osg::ref_ptr<osg::Node> scene;
+    for(int pos=1; pos<arguments.argc() && !scene; ++pos)
+    {
+        if (!arguments.isOption(pos)) scene = osgDB::readRefNodeFile(arguments[pos]);
+    }
+    if (!scene) scene = createScene(numVertices, imageSize);
+
+    bool success = true;
+    for(std::vector<std::string>::const_iterator itr=extensions.begin(); itr!=extensions.end(); ++itr)
+    {
+        if (!testFormat(*itr, scene.get(), numRepeats)) success = false;
+    }
+
+    if (base64Size>0)
+    {
+        if (!testBase64(base64Size, numRepeats)) success = false;
+    }
+
+    return success ? 0 : 1;
+}
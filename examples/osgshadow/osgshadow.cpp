@@ -737,6 +737,10 @@ int main(int argc, char** argv)
     arguments.getApplicationUsage()->addCommandLineOption("--two-pass", "Use two-pass stencil for shadow volumes.");
     arguments.getApplicationUsage()->addCommandLineOption("--near-far-mode","COMPUTE_NEAR_USING_PRIMITIVES, COMPUTE_NEAR_FAR_USING_PRIMITIVES, COMPUTE_NEAR_FAR_USING_BOUNDING_VOLUMES, DO_NOT_COMPUTE_NEAR_FAR");
     arguments.getApplicationUsage()->addCommandLineOption("--max-shadow-distance","<float> Maximum distance that the shadow map should extend from the eye point.");
+    arguments.getApplicationUsage()->addCommandLineOption("--cull-threads","<num> VDSM, number of threads used to cull the shadow maps in parallel.");
+    arguments.getApplicationUsage()->addCommandLineOption("--cache-casters","VDSM, reuse the shadow casting render lists while the shadow camera and scene are unchanged.");
+    arguments.getApplicationUsage()->addCommandLineOption("--split-static","VDSM, cache the depth map of static shadow casters and render only dynamic casters each frame.");
+    arguments.getApplicationUsage()->addCommandLineOption("--static-threshold","<float> VDSM, fraction of the shadow map the shadow camera may move before the static depth map is re-rendered.");
 
     // construct the viewer.
     osgViewer::Viewer viewer(arguments);
@@ -951,6 +955,15 @@ int main(int argc, char** argv)
         if (arguments.read("--parallel-split") || arguments.read("--ps") ) settings->setMultipleShadowMapHint(osgShadow::ShadowSettings::PARALLEL_SPLIT);
         if (arguments.read("--cascaded")) settings->setMultipleShadowMapHint(osgShadow::ShadowSettings::CASCADED);
 
+        unsigned int numCullThreads;
+        if (arguments.read("--cull-threads",numCullThreads)) settings->setNumShadowCastingCullThreads(numCullThreads);
+
+        if (arguments.read("--cache-casters")) settings->setCacheShadowCastingRenderLists(true);
+
+        if (arguments.read("--split-static")) settings->setSplitStaticShadowCasters(true);
+
+        double staticThreshold;
+        if (arguments.read("--static-threshold",staticThreshold)) settings->setStaticShadowMapUpdateThreshold(staticThreshold);
 
         int mapres = 1024;
         while (arguments.read("--mapres", mapres))
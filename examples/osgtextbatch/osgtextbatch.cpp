@@ -0,0 +1,158 @@
+/* OpenSceneGraph example, osgtextbatch.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include <osgViewer/Viewer>
+#include <osgViewer/ViewerEventHandlers>
+
+#include <osg/Geode>
+#include <osg/Math>
+#include <osg/Timer>
+
+#include <osgText/Text>
+#include <osgText/TextBatch>
+
+#include <iostream>
+#include <sstream>
+
+// Benchmark comparing a scene of many individual osgText::Text labels against the same
+// labels rendered through an osgText::TextBatch.
+
+osgText::Text* createLabel(osgText::Font* font, const osg::Vec3& position, unsigned int i, bool screenCoords)
+{
+    std::ostringstream str;
+    str<<"Track "<<i;
+
+    osgText::Text* text = new osgText::Text;
+    text->setFont(font);
+    text->setPosition(position);
+    text->setText(str.str());
+    text->setAlignment(osgText::Text::CENTER_CENTER);
+    text->setAxisAlignment(osgText::Text::SCREEN);
+    text->setColor(osg::Vec4(float(i%7)/6.0f, 1.0f, 1.0f-float(i%5)/4.0f, 1.0f));
+
+    if (screenCoords)
+    {
+        text->setCharacterSizeMode(osgText::Text::SCREEN_COORDS);
+        text->setCharacterSize(14.0f);
+    }
+    else
+    {
+        text->setCharacterSize(0.4f);
+    }
+
+    return text;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+
+    arguments.getApplicationUsage()->setApplicationName(arguments.getApplicationName());
+    arguments.getApplicationUsage()->setDescription(arguments.getApplicationName()+" compares the rendering cost of many osgText::Text labels with and without osgText::TextBatch.");
+    arguments.getApplicationUsage()->setCommandLineUsage(arguments.getApplicationName()+" [options]");
+    arguments.getApplicationUsage()->addCommandLineOption("--labels <num>","Number of labels to create, default 20000.");
+    arguments.getApplicationUsage()->addCommandLineOption("--batch","Render the labels through a osgText::TextBatch.");
+    arguments.getApplicationUsage()->addCommandLineOption("--screen","Use SCREEN_COORDS character size mode.");
+    arguments.getApplicationUsage()->addCommandLineOption("--update <num>","Number of labels to modify each frame, default 0.");
+    arguments.getApplicationUsage()->addCommandLineOption("--frames <num>","Number of frames to render before reporting timings, default 500.");
+    arguments.getApplicationUsage()->addCommandLineOption("--font <filename>","Font to use.");
+
+    if (arguments.read("-h") || arguments.read("--help"))
+    {
+        arguments.getApplicationUsage()->write(std::cout);
+        return 1;
+    }
+
+    unsigned int numLabels = 20000;
+    while(arguments.read("--labels", numLabels)) {}
+
+    unsigned int numUpdates = 0;
+    while(arguments.read("--update", numUpdates)) {}
+
+    unsigned int numFrames = 500;
+    while(arguments.read("--frames", numFrames)) {}
+
+    bool useBatch = arguments.read("--batch");
+    bool screenCoords = arguments.read("--screen");
+
+    std::string fontFile("fonts/arial.ttf");
+    while(arguments.read("--font", fontFile)) {}
+
+    osgViewer::Viewer viewer(arguments);
+    viewer.addEventHandler(new osgViewer::StatsHandler);
+
+    osg::ref_ptr<osgText::Font> font = osgText::readRefFontFile(fontFile);
+
+    unsigned int numColumns = static_cast<unsigned int>(sqrt(static_cast<double>(numLabels)))+1;
+
+    std::vector< osg::ref_ptr<osgText::Text> > labels;
+    for(unsigned int i=0; i<numLabels; ++i)
+    {
+        osg::Vec3 position(float(i%numColumns), float(i/numColumns), 0.0f);
+        labels.push_back(createLabel(font.get(), position, i, screenCoords));
+    }
+
+    osg::ref_ptr<osg::Node> scene;
+    if (useBatch)
+    {
+        osg::ref_ptr<osgText::TextBatch> batch = new osgText::TextBatch;
+        for(unsigned int i=0; i<labels.size(); ++i)
+        {
+            batch->addLabel(labels[i].get());
+        }
+        scene = batch;
+    }
+    else
+    {
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+        for(unsigned int i=0; i<labels.size(); ++i)
+        {
+            geode->addDrawable(labels[i].get());
+        }
+        scene = geode;
+    }
+
+    viewer.setSceneData(scene.get());
+    viewer.realize();
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    unsigned int frameNumber = 0;
+    unsigned int updateIndex = 0;
+
+    while(!viewer.done() && (numFrames==0 || frameNumber<numFrames))
+    {
+        for(unsigned int i=0; i<numUpdates && !labels.empty(); ++i, ++updateIndex)
+        {
+            osgText::Text* text = labels[updateIndex%labels.size()].get();
+
+            std::ostringstream str;
+            str<<"Track "<<(updateIndex%labels.size())<<" "<<frameNumber;
+            text->setText(str.str());
+        }
+
+        viewer.frame();
+        ++frameNumber;
+    }
+
+    double totalTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+
+    std::cout<<(useBatch ? "TextBatch" : "Text")<<" labels="<<numLabels<<" updates/frame="<<numUpdates
+             <<" frames="<<frameNumber<<" total="<<totalTime<<"s average frame="<<(frameNumber>0 ? totalTime*1000.0/double(frameNumber) : 0.0)<<"ms"<<std::endl;
+
+    return 0;
+}
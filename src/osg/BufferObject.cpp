@@ -56,6 +56,10 @@ GLBufferObject::GLBufferObject(unsigned int contextID, BufferObject* bufferObjec
     _profile(0,0,0),
     _allocatedSize(0),
     _dirty(true),
+    _incrementalUpload(false),
+    _incrementalUploadEntry(0),
+    _incrementalUploadOffset(0),
+    _incrementalUploadModifiedCount(0),
     _bufferObject(0),
     _set(0),
     _previous(0),
@@ -117,10 +121,8 @@ void GLBufferObject::clear()
     _dirty = true;
 }
 
-void GLBufferObject::compileBuffer()
+bool GLBufferObject::allocateBuffer()
 {
-    _dirty = false;
-
     _bufferEntries.reserve(_bufferObject->getNumBufferData());
 
     bool compileAll = false;
@@ -215,6 +217,17 @@ void GLBufferObject::compileBuffer()
         compileAll = true;
     }
 
+    return compileAll;
+}
+
+void GLBufferObject::compileBuffer()
+{
+    _dirty = false;
+    _incrementalUpload = false;
+    _incrementalUploadOffset = 0;
+
+    bool compileAll = allocateBuffer();
+
     for(BufferEntries::iterator itr = _bufferEntries.begin();
         itr != _bufferEntries.end();
         ++itr)
@@ -223,11 +236,26 @@ void GLBufferObject::compileBuffer()
         if (entry.dataSource && (compileAll || entry.modifiedCount != entry.dataSource->getModifiedCount()))
         {
             // OSG_NOTICE<<"GLBufferObject::compileBuffer(..) downloading BufferEntry "<<&entry<<std::endl;
+            // if only a sub range of the data has been modified since the last download just update that range.
+            unsigned int rangeStart = 0;
+            unsigned int rangeEnd = 0;
+            bool updateRange = !compileAll &&
+                               entry.dataSource->getModifiedRange(entry.modifiedCount, rangeStart, rangeEnd) &&
+                               rangeEnd<=entry.dataSize;
+
             entry.numRead = 0;
             entry.modifiedCount = entry.dataSource->getModifiedCount();
 
             const osg::Image* image = entry.dataSource->asImage();
-            if (image && !(image->isDataContiguous()))
+            if (updateRange && !image)
+            {
+                if (rangeEnd>rangeStart)
+                {
+                    const char* data = static_cast<const char*>(entry.dataSource->getDataPointer());
+                    _extensions->glBufferSubData(_profile._target, (GLintptr)(entry.offset+rangeStart), (GLsizeiptr)(rangeEnd-rangeStart), data+rangeStart);
+                }
+            }
+            else if (image && !(image->isDataContiguous()))
             {
                 unsigned int offset = entry.offset;
                 for(osg::Image::DataIterator img_itr(image); img_itr.valid(); ++img_itr)
@@ -244,6 +272,121 @@ void GLBufferObject::compileBuffer()
     }
 }
 
+bool GLBufferObject::compileBufferIncrementally(unsigned int maxUploadSize, unsigned int& numBytesUploaded)
+{
+    numBytesUploaded = 0;
+
+    if (!_dirty) return true;
+
+    if (!_incrementalUpload)
+    {
+        unsigned int totalSize = 0;
+        for(unsigned int i=0; i<_bufferObject->getNumBufferData(); ++i)
+        {
+            BufferData* bd = _bufferObject->getBufferData(i);
+            if (bd) totalSize += bd->getTotalDataSize();
+        }
+
+        if (_allocatedSize!=0 || totalSize<=maxUploadSize)
+        {
+            compileBuffer();
+            numBytesUploaded = totalSize;
+            return true;
+        }
+
+        // lay out and allocate the buffer, leaving the entries marked as requiring upload so that
+        // a compileBuffer() called before the incremental upload completes uploads the remainder.
+        allocateBuffer();
+
+        _incrementalUpload = true;
+        _incrementalUploadOffset = 0;
+    }
+    else if (isIncrementalUploadStale())
+    {
+        // lay out the buffer again and restart the entries affected, all of them if it had to be reallocated.
+        if (allocateBuffer())
+        {
+            for(BufferEntries::iterator itr = _bufferEntries.begin();
+                itr != _bufferEntries.end();
+                ++itr)
+            {
+                itr->modifiedCount = 0xffffff;
+            }
+        }
+
+        _incrementalUploadOffset = 0;
+    }
+    else
+    {
+        _extensions->glBindBuffer(_profile._target, _glObjectID);
+    }
+
+    for(unsigned int i=0; i<_bufferEntries.size(); ++i)
+    {
+        BufferEntry& entry = _bufferEntries[i];
+        if (!entry.dataSource || entry.modifiedCount == entry.dataSource->getModifiedCount()) continue;
+
+        if (numBytesUploaded>=maxUploadSize) return false;
+
+        const osg::Image* image = entry.dataSource->asImage();
+        if (image && !(image->isDataContiguous()))
+        {
+            unsigned int offset = entry.offset;
+            for(osg::Image::DataIterator img_itr(image); img_itr.valid(); ++img_itr)
+            {
+                _extensions->glBufferSubData(_profile._target, (GLintptr)offset, (GLsizeiptr)img_itr.size(), img_itr.data());
+                offset += img_itr.size();
+            }
+            numBytesUploaded += entry.dataSize;
+        }
+        else
+        {
+            if (_incrementalUploadOffset==0)
+            {
+                _incrementalUploadEntry = i;
+                _incrementalUploadModifiedCount = entry.dataSource->getModifiedCount();
+            }
+
+            unsigned int size = osg::minimum(entry.dataSize-_incrementalUploadOffset, maxUploadSize-numBytesUploaded);
+            const char* data = static_cast<const char*>(entry.dataSource->getDataPointer());
+            _extensions->glBufferSubData(_profile._target, (GLintptr)(entry.offset+_incrementalUploadOffset), (GLsizeiptr)size, data+_incrementalUploadOffset);
+
+            numBytesUploaded += size;
+            _incrementalUploadOffset += size;
+            if (_incrementalUploadOffset<entry.dataSize) return false;
+        }
+
+        entry.numRead = 0;
+        entry.modifiedCount = entry.dataSource->getModifiedCount();
+        _incrementalUploadOffset = 0;
+    }
+
+    _dirty = false;
+    _incrementalUpload = false;
+    return true;
+}
+
+bool GLBufferObject::isIncrementalUploadStale() const
+{
+    if (_bufferEntries.size()!=_bufferObject->getNumBufferData()) return true;
+
+    for(unsigned int i=0; i<_bufferEntries.size(); ++i)
+    {
+        const BufferEntry& entry = _bufferEntries[i];
+        const BufferData* bd = _bufferObject->getBufferData(i);
+        if (entry.dataSource!=bd || (bd && entry.dataSize!=bd->getTotalDataSize())) return true;
+    }
+
+    // the parts of the entry already uploaded hold the data from before the modification.
+    if (_incrementalUploadOffset>0)
+    {
+        const BufferData* bd = _bufferEntries[_incrementalUploadEntry].dataSource;
+        if (bd && bd->getModifiedCount()!=_incrementalUploadModifiedCount) return true;
+    }
+
+    return false;
+}
+
 void GLBufferObject::deleteGLObject()
 {
     OSG_DEBUG<<"GLBufferObject::deleteGLObject() "<<_glObjectID<<std::endl;
@@ -254,6 +397,9 @@ void GLBufferObject::deleteGLObject()
 
         _allocatedSize = 0;
         _bufferEntries.clear();
+
+        _incrementalUpload = false;
+        _incrementalUploadOffset = 0;
     }
 }
 
@@ -1251,6 +1397,36 @@ void BufferData::setBufferObject(BufferObject* bufferObject)
     _bufferIndex = _bufferObject.valid() ? _bufferObject->addBufferData(this) : 0;
 }
 
+bool BufferData::getModifiedRange(unsigned int sinceModifiedCount, unsigned int& start, unsigned int& end) const
+{
+    if (_modifiedRanges.empty() || sinceModifiedCount>=_modifiedCount) return false;
+
+    // the ranges of all the modifications after sinceModifiedCount need to be known.
+    if (_modifiedRanges.front().modifiedCount>sinceModifiedCount+1) return false;
+
+    bool found = false;
+    for(ModifiedRanges::const_iterator itr = _modifiedRanges.begin();
+        itr != _modifiedRanges.end();
+        ++itr)
+    {
+        if (itr->modifiedCount<=sinceModifiedCount) continue;
+
+        if (!found)
+        {
+            start = itr->start;
+            end = itr->end;
+            found = true;
+        }
+        else
+        {
+            start = osg::minimum(start, itr->start);
+            end = osg::maximum(end, itr->end);
+        }
+    }
+
+    return found;
+}
+
 void BufferData::resizeGLObjectBuffers(unsigned int maxSize)
 {
     if (_bufferObject.valid())
@@ -108,6 +108,7 @@ void DisplaySettings::setDisplaySettings(const DisplaySettings& vs)
     _application = vs._application;
 
     _maxTexturePoolSize = vs._maxTexturePoolSize;
+    _enforceMaxTexturePoolSize = vs._enforceMaxTexturePoolSize;
     _maxBufferObjectPoolSize = vs._maxBufferObjectPoolSize;
 
     _implicitBufferAttachmentRenderMask = vs._implicitBufferAttachmentRenderMask;
@@ -155,6 +156,7 @@ void DisplaySettings::merge(const DisplaySettings& vs)
     if (_application.empty()) _application = vs._application;
 
     if (vs._maxTexturePoolSize>_maxTexturePoolSize) _maxTexturePoolSize = vs._maxTexturePoolSize;
+    if (vs._enforceMaxTexturePoolSize) _enforceMaxTexturePoolSize = true;
     if (vs._maxBufferObjectPoolSize>_maxBufferObjectPoolSize) _maxBufferObjectPoolSize = vs._maxBufferObjectPoolSize;
 
     // these are bit masks so merging them is like logical or
@@ -236,6 +238,7 @@ void DisplaySettings::setDefaults()
     _numHttpDatabaseThreadsHint = 1;
 
     _maxTexturePoolSize = 0;
+    _enforceMaxTexturePoolSize = false;
     _maxBufferObjectPoolSize = 0;
 
     _implicitBufferAttachmentRenderMask = DEFAULT_IMPLICIT_BUFFER_ATTACHMENT;
@@ -352,6 +355,9 @@ static ApplicationUsageProxy DisplaySetting_e18(ApplicationUsage::ENVIRONMENTAL_
 static ApplicationUsageProxy DisplaySetting_e19(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
         "OSG_TEXTURE_POOL_SIZE <int>",
         "Set the hint for the size of the texture pool to manage.");
+static ApplicationUsageProxy DisplaySetting_e37(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
+        "OSG_ENFORCE_TEXTURE_POOL_SIZE <mode>",
+        "ON | OFF - Enforce the texture pool size as a hard limit, evicting least recently used textures to stay within it.");
 static ApplicationUsageProxy DisplaySetting_e20(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
         "OSG_BUFFER_OBJECT_POOL_SIZE <int>",
         "Set the hint for the size of the vertex buffer object pool to manage.");
@@ -581,6 +587,12 @@ void DisplaySettings::readEnvironmentalVariables()
 
     getEnvVar("OSG_TEXTURE_POOL_SIZE", _maxTexturePoolSize);
 
+    if (getEnvVar("OSG_ENFORCE_TEXTURE_POOL_SIZE", value))
+    {
+        if (value=="ON") _enforceMaxTexturePoolSize = true;
+        else if (value=="OFF") _enforceMaxTexturePoolSize = false;
+    }
+
     getEnvVar("OSG_BUFFER_OBJECT_POOL_SIZE", _maxBufferObjectPoolSize);
 
 
@@ -955,6 +967,7 @@ void DisplaySettings::readCommandLine(ArgumentParser& arguments)
     while(arguments.read("--num-http-threads",_numHttpDatabaseThreadsHint)) {}
 
     while(arguments.read("--texture-pool-size",_maxTexturePoolSize)) {}
+    while(arguments.read("--enforce-texture-pool-size")) { _enforceMaxTexturePoolSize = true; }
     while(arguments.read("--buffer-object-pool-size",_maxBufferObjectPoolSize)) {}
 
     {  // Read implicit buffer attachments combinations for both render and resolve mask
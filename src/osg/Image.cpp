@@ -14,6 +14,7 @@
 #include <osg/GLU>
 
 #include <osg/Image>
+#include <osg/ImageUtils>
 #include <osg/Notify>
 #include <osg/io_utils>
 
@@ -1609,20 +1610,27 @@ void Image::scaleImage(int s,int t,int r, GLenum newDataType)
         return;
     }
 
-    PixelStorageModes psm;
-    psm.pack_alignment = _packing;
-    psm.pack_row_length = _rowLength;
-    psm.unpack_alignment = _packing;
+    GLint status = 0;
+    if (!resampleImageData(_pixelFormat,
+                           _s, _t, _dataType, _data, getRowStepInBytes(),
+                           s, t, newDataType, newData, computeRowWidthInBytes(s,_pixelFormat,newDataType,_packing)))
+    {
+        // fallback to GLU for the pixel types that resampleImageData() doesn't handle
+        PixelStorageModes psm;
+        psm.pack_alignment = _packing;
+        psm.pack_row_length = _rowLength;
+        psm.unpack_alignment = _packing;
 
-    GLint status = gluScaleImage(&psm, _pixelFormat,
-        _s,
-        _t,
-        _dataType,
-        _data,
-        s,
-        t,
-        newDataType,
-        newData);
+        status = gluScaleImage(&psm, _pixelFormat,
+            _s,
+            _t,
+            _dataType,
+            _data,
+            s,
+            t,
+            newDataType,
+            newData);
+    }
 
     if (status==0)
     {
@@ -1709,6 +1717,13 @@ void Image::copySubImage(int s_offset, int t_offset, int r_offset, const osg::Im
         }
         return;
     }
+    if (resampleImageData(_pixelFormat,
+                          source->s(), source->t(), source->getDataType(), source->data(), source->getRowStepInBytes(),
+                          source->s(), source->t(), _dataType, data_destination, getRowStepInBytes()))
+    {
+        return;
+    }
+
     PixelStorageModes psm;
     psm.pack_alignment = _packing;
     psm.pack_row_length = _rowLength!=0 ? _rowLength : _s;
@@ -1777,16 +1792,15 @@ void Image::flipHorizontal()
 
 void flipImageVertical(unsigned char* top, unsigned char* bottom, unsigned int rowSize, unsigned int rowStep)
 {
+    if (rowSize==0) return;
+
+    // swap whole rows through a temporary row so the copies run at memcpy speed.
+    std::vector<unsigned char> temp(rowSize);
     while(top<bottom)
     {
-        unsigned char* t = top;
-        unsigned char* b = bottom;
-        for(unsigned int i=0;i<rowSize;++i, ++t,++b)
-        {
-            unsigned char temp=*t;
-            *t = *b;
-            *b = temp;
-        }
+        memcpy(&temp.front(), top, rowSize);
+        memcpy(top, bottom, rowSize);
+        memcpy(bottom, &temp.front(), rowSize);
         top += rowStep;
         bottom -= rowStep;
     }
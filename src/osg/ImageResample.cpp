@@ -0,0 +1,502 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/ImageUtils>
+#include <osg/Math>
+#include <osg/Notify>
+#include <osg/Texture>
+
+#include <OpenThreads/Thread>
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=1)
+    #define OSG_RESAMPLE_USE_SSE 1
+    #include <xmmintrin.h>
+#endif
+
+#if defined(__AVX__)
+    #define OSG_RESAMPLE_USE_AVX 1
+    #include <immintrin.h>
+#endif
+
+namespace osg
+{
+
+namespace
+{
+
+// the input samples contributing to one output sample, clamped to the edges of the input.
+struct Contribution
+{
+    int             first;
+    unsigned int    count;
+    unsigned int    weightOffset;
+};
+
+struct FilterWeights
+{
+    FilterWeights(): maxCount(0) {}
+
+    std::vector<Contribution>   contributions;
+    std::vector<float>          weights;
+    unsigned int                maxCount;
+};
+
+inline double sinc(double x)
+{
+    if (x==0.0) return 1.0;
+    x *= osg::PI;
+    return sin(x)/x;
+}
+
+inline double filterKernel(ResampleFilter filter, double x)
+{
+    x = fabs(x);
+    switch(filter)
+    {
+        case(RESAMPLE_BILINEAR): return x<1.0 ? 1.0-x : 0.0;
+        case(RESAMPLE_LANCZOS3): return x<3.0 ? sinc(x)*sinc(x/3.0) : 0.0;
+        default: return x<0.5 ? 1.0 : 0.0;
+    }
+}
+
+inline double filterRadius(ResampleFilter filter)
+{
+    switch(filter)
+    {
+        case(RESAMPLE_BILINEAR): return 1.0;
+        case(RESAMPLE_LANCZOS3): return 3.0;
+        default: return 0.5;
+    }
+}
+
+void computeWeights(int inSize, int outSize, ResampleFilter filter, FilterWeights& fw)
+{
+    fw.contributions.resize(outSize);
+    fw.weights.clear();
+    fw.maxCount = 0;
+
+    // number of input samples per output sample.
+    double scale = double(inSize)/double(outSize);
+
+    std::vector<double> weights;
+    for(int o=0; o<outSize; ++o)
+    {
+        int first, last;
+        weights.clear();
+
+        if (filter==RESAMPLE_BOX)
+        {
+            // weight each input sample by how much of it the output sample covers.
+            double start = double(o)*scale;
+            double end = double(o+1)*scale;
+            first = static_cast<int>(floor(start));
+            last = osg::minimum(static_cast<int>(ceil(end))-1, inSize-1);
+            if (last<first) last = first;
+
+            for(int i=first; i<=last; ++i)
+            {
+                weights.push_back(osg::maximum(osg::minimum(end, double(i+1)) - osg::maximum(start, double(i)), 0.0));
+            }
+        }
+        else
+        {
+            // when minifying widen the kernel to cover all the input samples.
+            double filterScale = osg::maximum(scale, 1.0);
+            double support = filterRadius(filter)*filterScale;
+            double center = (double(o)+0.5)*scale;
+
+            int firstSample = static_cast<int>(floor(center-support));
+            int lastSample = static_cast<int>(ceil(center+support));
+            first = osg::clampBetween(firstSample, 0, inSize-1);
+            last = osg::clampBetween(lastSample, 0, inSize-1);
+
+            weights.resize(last-first+1, 0.0);
+            for(int i=firstSample; i<=lastSample; ++i)
+            {
+                // samples beyond the edges of the input reuse the edge samples.
+                int clamped = osg::clampBetween(i, first, last);
+                weights[clamped-first] += filterKernel(filter, (double(i)+0.5-center)/filterScale);
+            }
+        }
+
+        // trim zero weights from the ends.
+        unsigned int begin = 0;
+        unsigned int end = static_cast<unsigned int>(weights.size());
+        while(begin+1<end && weights[begin]==0.0) ++begin;
+        while(end>begin+1 && weights[end-1]==0.0) --end;
+
+        double sum = 0.0;
+        for(unsigned int i=begin; i<end; ++i) sum += weights[i];
+        if (sum==0.0) sum = 1.0;
+
+        Contribution& contribution = fw.contributions[o];
+        contribution.first = first+begin;
+        contribution.count = end-begin;
+        contribution.weightOffset = static_cast<unsigned int>(fw.weights.size());
+
+        for(unsigned int i=begin; i<end; ++i)
+        {
+            fw.weights.push_back(static_cast<float>(weights[i]/sum));
+        }
+
+        if (contribution.count>fw.maxCount) fw.maxCount = contribution.count;
+    }
+}
+
+template<typename T>
+void convertToFloat(const T* src, unsigned int num, float scale, float* dst)
+{
+    for(unsigned int i=0; i<num; ++i) dst[i] = static_cast<float>(src[i])*scale;
+}
+
+template<typename T>
+void convertFromFloat(const float* src, unsigned int num, float scale, float minValue, float maxValue, T* dst)
+{
+    for(unsigned int i=0; i<num; ++i)
+    {
+        float v = src[i]*scale;
+        v = v<minValue ? minValue : (v>maxValue ? maxValue : v);
+        dst[i] = static_cast<T>(v<0.0f ? v-0.5f : v+0.5f);
+    }
+}
+
+bool isSupportedDataType(GLenum dataType)
+{
+    switch(dataType)
+    {
+        case(GL_BYTE):
+        case(GL_UNSIGNED_BYTE):
+        case(GL_SHORT):
+        case(GL_UNSIGNED_SHORT):
+        case(GL_INT):
+        case(GL_UNSIGNED_INT):
+        case(GL_FLOAT):
+            return true;
+        default:
+            return false;
+    }
+}
+
+// convert a row of samples to floats normalized to the 0 to 1 range for unsigned types and -1 to 1 for signed types.
+void readRowAsFloat(GLenum dataType, const unsigned char* src, unsigned int num, float* dst)
+{
+    switch(dataType)
+    {
+        case(GL_BYTE):              convertToFloat(reinterpret_cast<const signed char*>(src), num, 1.0f/127.0f, dst); break;
+        case(GL_UNSIGNED_BYTE):     convertToFloat(src, num, 1.0f/255.0f, dst); break;
+        case(GL_SHORT):             convertToFloat(reinterpret_cast<const short*>(src), num, 1.0f/32767.0f, dst); break;
+        case(GL_UNSIGNED_SHORT):    convertToFloat(reinterpret_cast<const unsigned short*>(src), num, 1.0f/65535.0f, dst); break;
+        case(GL_INT):               convertToFloat(reinterpret_cast<const int*>(src), num, 1.0f/2147483647.0f, dst); break;
+        case(GL_UNSIGNED_INT):      convertToFloat(reinterpret_cast<const unsigned int*>(src), num, 1.0f/4294967295.0f, dst); break;
+        case(GL_FLOAT):             memcpy(dst, src, num*sizeof(float)); break;
+    }
+}
+
+void writeRowFromFloat(GLenum dataType, const float* src, unsigned int num, unsigned char* dst)
+{
+    switch(dataType)
+    {
+        case(GL_BYTE):              convertFromFloat(src, num, 127.0f, -127.0f, 127.0f, reinterpret_cast<signed char*>(dst)); break;
+        case(GL_UNSIGNED_BYTE):     convertFromFloat(src, num, 255.0f, 0.0f, 255.0f, dst); break;
+        case(GL_SHORT):             convertFromFloat(src, num, 32767.0f, -32767.0f, 32767.0f, reinterpret_cast<short*>(dst)); break;
+        case(GL_UNSIGNED_SHORT):    convertFromFloat(src, num, 65535.0f, 0.0f, 65535.0f, reinterpret_cast<unsigned short*>(dst)); break;
+        case(GL_INT):               convertFromFloat(src, num, 2147483647.0f, -2147483647.0f, 2147483520.0f, reinterpret_cast<int*>(dst)); break;
+        case(GL_UNSIGNED_INT):      convertFromFloat(src, num, 4294967295.0f, 0.0f, 4294967040.0f, reinterpret_cast<unsigned int*>(dst)); break;
+        case(GL_FLOAT):             memcpy(dst, src, num*sizeof(float)); break;
+    }
+}
+
+// dst[i] += weight*src[i]
+inline void accumulateRow(float* dst, const float* src, float weight, unsigned int num)
+{
+    unsigned int i = 0;
+#if defined(OSG_RESAMPLE_USE_AVX)
+    __m256 w8 = _mm256_set1_ps(weight);
+    for(; i+8<=num; i+=8)
+    {
+        _mm256_storeu_ps(dst+i, _mm256_add_ps(_mm256_loadu_ps(dst+i), _mm256_mul_ps(w8, _mm256_loadu_ps(src+i))));
+    }
+#endif
+#if defined(OSG_RESAMPLE_USE_SSE)
+    __m128 w4 = _mm_set1_ps(weight);
+    for(; i+4<=num; i+=4)
+    {
+        _mm_storeu_ps(dst+i, _mm_add_ps(_mm_loadu_ps(dst+i), _mm_mul_ps(w4, _mm_loadu_ps(src+i))));
+    }
+#endif
+    for(; i<num; ++i) dst[i] += weight*src[i];
+}
+
+template<unsigned int NC>
+void resampleRowHorizontal(const float* src, const FilterWeights& fw, float* dst)
+{
+    const float* weights = &(fw.weights.front());
+    for(std::vector<Contribution>::const_iterator itr = fw.contributions.begin();
+        itr != fw.contributions.end();
+        ++itr)
+    {
+        const float* s = src + itr->first*NC;
+        const float* w = weights + itr->weightOffset;
+
+        float sum[NC];
+        for(unsigned int c=0; c<NC; ++c) sum[c] = 0.0f;
+
+        for(unsigned int k=0; k<itr->count; ++k, s+=NC)
+        {
+            for(unsigned int c=0; c<NC; ++c) sum[c] += w[k]*s[c];
+        }
+
+        for(unsigned int c=0; c<NC; ++c) *dst++ = sum[c];
+    }
+}
+
+#if defined(OSG_RESAMPLE_USE_SSE)
+template<>
+void resampleRowHorizontal<4>(const float* src, const FilterWeights& fw, float* dst)
+{
+    const float* weights = &(fw.weights.front());
+    for(std::vector<Contribution>::const_iterator itr = fw.contributions.begin();
+        itr != fw.contributions.end();
+        ++itr, dst+=4)
+    {
+        const float* s = src + itr->first*4;
+        const float* w = weights + itr->weightOffset;
+
+        __m128 sum = _mm_setzero_ps();
+        for(unsigned int k=0; k<itr->count; ++k, s+=4)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(s)));
+        }
+        _mm_storeu_ps(dst, sum);
+    }
+}
+#endif
+
+void resampleRowHorizontal(unsigned int numComponents, const float* src, const FilterWeights& fw, float* dst)
+{
+    switch(numComponents)
+    {
+        case(1): resampleRowHorizontal<1>(src, fw, dst); break;
+        case(2): resampleRowHorizontal<2>(src, fw, dst); break;
+        case(3): resampleRowHorizontal<3>(src, fw, dst); break;
+        case(4): resampleRowHorizontal<4>(src, fw, dst); break;
+    }
+}
+
+struct ResampleContext
+{
+    unsigned int            numComponents;
+    int                     inWidth;
+    GLenum                  inDataType;
+    const unsigned char*    inData;
+    unsigned int            inRowStep;
+    int                     outWidth;
+    GLenum                  outDataType;
+    unsigned char*          outData;
+    unsigned int            outRowStep;
+    FilterWeights           horizontal;
+    FilterWeights           vertical;
+};
+
+void resampleRows(const ResampleContext& context, int startRow, int endRow)
+{
+    const unsigned int numIn = context.inWidth*context.numComponents;
+    const unsigned int numOut = context.outWidth*context.numComponents;
+
+    // ring of horizontally resampled input rows, large enough for all the rows contributing to one output row.
+    const unsigned int numCachedRows = context.vertical.maxCount;
+    std::vector<float> inputRow(numIn);
+    std::vector<float> cache(numCachedRows*numOut);
+    std::vector<int> cachedRowIndices(numCachedRows, -1);
+    std::vector<float> outputRow(numOut);
+
+    const float* weights = &(context.vertical.weights.front());
+    for(int y=startRow; y<endRow; ++y)
+    {
+        const Contribution& contribution = context.vertical.contributions[y];
+
+        std::fill(outputRow.begin(), outputRow.end(), 0.0f);
+
+        for(unsigned int k=0; k<contribution.count; ++k)
+        {
+            int row = contribution.first+k;
+            unsigned int slot = row % numCachedRows;
+            float* cachedRow = &cache[slot*numOut];
+            if (cachedRowIndices[slot]!=row)
+            {
+                readRowAsFloat(context.inDataType, context.inData+row*context.inRowStep, numIn, &inputRow.front());
+                resampleRowHorizontal(context.numComponents, &inputRow.front(), context.horizontal, cachedRow);
+                cachedRowIndices[slot] = row;
+            }
+
+            accumulateRow(&outputRow.front(), cachedRow, weights[contribution.weightOffset+k], numOut);
+        }
+
+        writeRowFromFloat(context.outDataType, &outputRow.front(), numOut, context.outData+y*context.outRowStep);
+    }
+}
+
+class ResampleThread : public OpenThreads::Thread
+{
+public:
+    ResampleThread(const ResampleContext& context, int startRow, int endRow):
+        _context(context),
+        _startRow(startRow),
+        _endRow(endRow) {}
+
+    virtual void run()
+    {
+        resampleRows(_context, _startRow, _endRow);
+    }
+
+protected:
+    const ResampleContext&  _context;
+    int                     _startRow;
+    int                     _endRow;
+};
+
+}
+
+bool resampleImageData(GLenum pixelFormat,
+                       int inWidth, int inHeight, GLenum inDataType, const void* inData, unsigned int inRowStepInBytes,
+                       int outWidth, int outHeight, GLenum outDataType, void* outData, unsigned int outRowStepInBytes,
+                       ResampleFilter filter, unsigned int numThreads)
+{
+    if (inWidth<=0 || inHeight<=0 || outWidth<=0 || outHeight<=0 || !inData || !outData) return false;
+
+    if (!isSupportedDataType(inDataType) || !isSupportedDataType(outDataType)) return false;
+
+    if (Texture::isCompressedInternalFormat(pixelFormat)) return false;
+
+    unsigned int numComponents = Image::computeNumComponents(pixelFormat);
+    if (numComponents<1 || numComponents>4) return false;
+
+    ResampleContext context;
+    context.numComponents = numComponents;
+    context.inWidth = inWidth;
+    context.inDataType = inDataType;
+    context.inData = static_cast<const unsigned char*>(inData);
+    context.inRowStep = inRowStepInBytes!=0 ? inRowStepInBytes : Image::computeRowWidthInBytes(inWidth, pixelFormat, inDataType, 1);
+    context.outWidth = outWidth;
+    context.outDataType = outDataType;
+    context.outData = static_cast<unsigned char*>(outData);
+    context.outRowStep = outRowStepInBytes!=0 ? outRowStepInBytes : Image::computeRowWidthInBytes(outWidth, pixelFormat, outDataType, 1);
+
+    computeWeights(inWidth, outWidth, filter, context.horizontal);
+    computeWeights(inHeight, outHeight, filter, context.vertical);
+
+    if (numThreads==0)
+    {
+        // only spread the work across threads when there is enough of it to amortize starting them.
+        const unsigned int minimumNumSamplesPerThread = 128*1024;
+        unsigned int numSamples = static_cast<unsigned int>(osg::maximum(inWidth, outWidth))*static_cast<unsigned int>(osg::maximum(inHeight, outHeight));
+        numThreads = osg::clampBetween(numSamples/minimumNumSamplesPerThread, 1u, static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1)));
+    }
+    numThreads = osg::clampBetween(numThreads, 1u, static_cast<unsigned int>(outHeight));
+
+    if (numThreads==1)
+    {
+        resampleRows(context, 0, outHeight);
+        return true;
+    }
+
+    // each thread resamples a contiguous band of output rows, the calling thread does the first band.
+    std::vector<ResampleThread*> threads;
+    for(unsigned int i=1; i<numThreads; ++i)
+    {
+        int startRow = (outHeight*i)/numThreads;
+        int endRow = (outHeight*(i+1))/numThreads;
+        ResampleThread* thread = new ResampleThread(context, startRow, endRow);
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    resampleRows(context, 0, outHeight/numThreads);
+
+    for(std::vector<ResampleThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+
+    return true;
+}
+
+bool generateMipmaps(osg::Image* image, ResampleFilter filter)
+{
+    if (!image || !image->data() || image->r()!=1 || image->isMipmap()) return false;
+    if (image->isCompressed() || !isSupportedDataType(image->getDataType())) return false;
+
+    GLenum pixelFormat = image->getPixelFormat();
+    GLenum dataType = image->getDataType();
+    int packing = image->getPacking();
+
+    // compute the offsets of each level in the new data block.
+    osg::Image::MipmapDataType mipmapOffsets;
+    unsigned int totalSize = Image::computeRowWidthInBytes(image->s(), pixelFormat, dataType, packing)*image->t();
+    int width = image->s();
+    int height = image->t();
+    while(width>1 || height>1)
+    {
+        width = osg::maximum(width>>1, 1);
+        height = osg::maximum(height>>1, 1);
+        mipmapOffsets.push_back(totalSize);
+        totalSize += Image::computeRowWidthInBytes(width, pixelFormat, dataType, packing)*height;
+    }
+
+    if (mipmapOffsets.empty()) return false;
+
+    unsigned char* data = new unsigned char[totalSize];
+
+    // copy level 0, dropping any row length padding.
+    unsigned int rowSize = Image::computeRowWidthInBytes(image->s(), pixelFormat, dataType, packing);
+    for(int t=0; t<image->t(); ++t)
+    {
+        memcpy(data+t*rowSize, image->data(0,t), rowSize);
+    }
+
+    // resample each level from the previous one.
+    width = image->s();
+    height = image->t();
+    unsigned int previousOffset = 0;
+    for(osg::Image::MipmapDataType::iterator itr = mipmapOffsets.begin();
+        itr != mipmapOffsets.end();
+        ++itr)
+    {
+        int levelWidth = osg::maximum(width>>1, 1);
+        int levelHeight = osg::maximum(height>>1, 1);
+
+        resampleImageData(pixelFormat,
+                          width, height, dataType, data+previousOffset, Image::computeRowWidthInBytes(width, pixelFormat, dataType, packing),
+                          levelWidth, levelHeight, dataType, data+(*itr), Image::computeRowWidthInBytes(levelWidth, pixelFormat, dataType, packing),
+                          filter);
+
+        previousOffset = *itr;
+        width = levelWidth;
+        height = levelHeight;
+    }
+
+    image->setImage(image->s(), image->t(), 1, image->getInternalTextureFormat(), pixelFormat, dataType, data, osg::Image::USE_NEW_DELETE, packing);
+    image->setMipmapLevels(mipmapOffsets);
+
+    return true;
+}
+
+}
@@ -348,6 +348,38 @@ bool clearImageToColor(osg::Image* image, const osg::Vec4& colour)
     return true;
 }
 
+osg::Image* createDecompressedImage(const osg::Image* image)
+{
+    if (!image || !image->data() || image->r()!=1 || !dxtc_tool::isDXTC(image->getPixelFormat())) return 0;
+
+    osg::ref_ptr<osg::Image> decompressed = new osg::Image;
+
+    unsigned int numLevels = image->getNumMipmapLevels();
+    osg::Image::MipmapDataType mipmapOffsets;
+    unsigned int totalSize = 0;
+    for(unsigned int i=0; i<numLevels; ++i)
+    {
+        if (i>0) mipmapOffsets.push_back(totalSize);
+        totalSize += osg::maximum(image->s()>>i, 1)*osg::maximum(image->t()>>i, 1)*4;
+    }
+
+    unsigned char* data = new unsigned char[totalSize];
+    for(unsigned int i=0; i<numLevels; ++i)
+    {
+        int width = osg::maximum(image->s()>>i, 1);
+        int height = osg::maximum(image->t()>>i, 1);
+        unsigned char* destination = data + (i>0 ? mipmapOffsets[i-1] : 0);
+        dxtc_tool::DecompressImage(width, height, image->getPixelFormat(), image->getMipmapData(i), destination, width*4);
+    }
+
+    decompressed->setImage(image->s(), image->t(), 1, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, data, osg::Image::USE_NEW_DELETE, 1);
+    decompressed->setMipmapLevels(mipmapOffsets);
+    decompressed->setOrigin(image->getOrigin());
+    decompressed->setFileName(image->getFileName());
+
+    return decompressed.release();
+}
+
 /** Search through the list of Images and find the maximum number of components used among the images.*/
 unsigned int maximimNumOfComponents(const ImageList& imageList)
 {
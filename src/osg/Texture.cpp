@@ -12,6 +12,7 @@
 */
 #include <osg/GLExtensions>
 #include <osg/Image>
+#include <osg/ImageUtils>
 #include <osg/Texture>
 #include <osg/State>
 #include <osg/Notify>
@@ -26,6 +27,8 @@
 #include <OpenThreads/ScopedLock>
 #include <OpenThreads/Mutex>
 
+#include <algorithm>
+
 #ifndef GL_TEXTURE_WRAP_R
 #define GL_TEXTURE_WRAP_R                 0x8072
 #endif
@@ -566,6 +569,7 @@ void TextureObjectSet::flushAllDeletedTextureObjects()
     _parent->getCurrTexturePoolSize() -= numDeleted*_profile._size;
     _parent->getNumberOrphanedTextureObjects() -= numDeleted;
     _parent->getNumberDeleted() += numDeleted;
+    _parent->getCurrentFrameStats().numDeleted += numDeleted;
 
     _orphanedTextureObjects.clear();
 }
@@ -665,6 +669,7 @@ void TextureObjectSet::flushDeletedTextureObjects(double /*currentTime*/, double
     // update the number of active and orphaned TextureObjects
     _parent->getNumberOrphanedTextureObjects() -= numDeleted;
     _parent->getNumberDeleted() += numDeleted;
+    _parent->getCurrentFrameStats().numDeleted += numDeleted;
 
     availableTime -= timer.elapsedTime();
 }
@@ -706,6 +711,7 @@ osg::ref_ptr<Texture::TextureObject> TextureObjectSet::takeFromOrphans(Texture*
     // update the number of active and orphaned TextureObjects
     _parent->getNumberOrphanedTextureObjects() -= 1;
     _parent->getNumberActiveTextureObjects() += 1;
+    ++(_parent->getCurrentFrameStats().numReused);
 
     // place at back of active list
     addToBack(to.get());
@@ -764,9 +770,25 @@ osg::ref_ptr<Texture::TextureObject> TextureObjectSet::takeOrGenerate(Texture* t
         // assign to new texture
         to->setTexture(texture);
 
+        ++(_parent->getCurrentFrameStats().numReused);
+
         return to;
     }
 
+    // when the pool size is a hard limit evict other TextureObjects to make room for the new one.
+    if (_parent->getEnforceMaxTexturePoolSize() &&
+        (_parent->getMaxTexturePoolSize()!=0) &&
+        (_profile._size!=0) &&
+        (!_parent->hasSpace(_profile._size)))
+    {
+        unsigned int sizeRequired = _parent->getCurrTexturePoolSize() + _profile._size - _parent->getMaxTexturePoolSize();
+        if (!_parent->makeSpace(sizeRequired))
+        {
+            OSG_INFO<<"TextureObjectSet="<<this<<": unable to make space for new TextureObject, exceeding MaxTexturePoolSize="<<_parent->getMaxTexturePoolSize()<<std::endl;
+            ++(_parent->getCurrentFrameStats().numOverBudget);
+        }
+    }
+
     //
     // no TextureObjects available to recycle so have to create one from scratch
     //
@@ -780,6 +802,7 @@ osg::ref_ptr<Texture::TextureObject> TextureObjectSet::takeOrGenerate(Texture* t
     // update the current texture pool size
     _parent->getCurrTexturePoolSize() += _profile._size;
     _parent->getNumberActiveTextureObjects() += 1;
+    ++(_parent->getCurrentFrameStats().numGenerated);
 
     addToBack(to.get());
 
@@ -947,6 +970,40 @@ void TextureObjectSet::moveToSet(Texture::TextureObject* to, TextureObjectSet* s
     set->addToBack(to);
 }
 
+bool TextureObjectSet::evict(Texture::TextureObject* to)
+{
+    // keep a reference as detaching from the Texture would otherwise delete the TextureObject.
+    ref_ptr<Texture::TextureObject> keep(to);
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        Texture* texture = to->getTexture();
+
+        // already orphaned, so will be handled as part of the pending orphans.
+        if (!texture) return false;
+
+        to->setTexture(0);
+        texture->setTextureObject(_contextID, 0);
+    }
+
+    remove(to);
+
+    GLuint id = to->id();
+    glDeleteTextures( 1L, &id);
+
+    --_numOfTextureObjects;
+
+    _parent->getCurrTexturePoolSize() -= _profile._size;
+    _parent->getNumberActiveTextureObjects() -= 1;
+    _parent->getNumberDeleted() += 1;
+
+    _parent->getCurrentFrameStats().numEvicted += 1;
+    _parent->getCurrentFrameStats().sizeEvicted += _profile._size;
+
+    return true;
+}
+
 unsigned int TextureObjectSet::computeNumTextureObjectsInList() const
 {
     unsigned int num=0;
@@ -971,8 +1028,10 @@ TextureObjectManager::TextureObjectManager(unsigned int contextID):
     _numDeleted(0),
     _deleteTime(0.0),
     _numGenerated(0),
-    _generateTime(0.0)
+    _generateTime(0.0),
+    _enforceMaxTexturePoolSize(false)
 {
+    _evictionCallback = new EvictionCallback;
 }
 
 TextureObjectManager::~TextureObjectManager()
@@ -992,8 +1051,28 @@ void TextureObjectManager::setMaxTexturePoolSize(unsigned int size)
     _maxTexturePoolSize = size;
 }
 
+struct LessFrameLastUsed
+{
+    bool operator() (const std::pair<unsigned int, Texture::TextureObject*>& lhs, const std::pair<unsigned int, Texture::TextureObject*>& rhs) const
+    {
+        return lhs.first<rhs.first;
+    }
+};
+
+bool TextureObjectManager::EvictionCallback::canEvict(const Texture* texture, unsigned int /*contextID*/) const
+{
+    if (texture->getNumImages()==0) return false;
+
+    for(unsigned int i=0; i<texture->getNumImages(); ++i)
+    {
+        if (!texture->getImage(i)) return false;
+    }
+    return true;
+}
+
 bool TextureObjectManager::makeSpace(unsigned int size)
 {
+    // first reclaim the orphaned TextureObjects.
     for(TextureSetMap::iterator itr = _textureSetMap.begin();
         itr != _textureSetMap.end() && size>0;
         ++itr)
@@ -1001,6 +1080,46 @@ bool TextureObjectManager::makeSpace(unsigned int size)
         if ((*itr).second->makeSpace(size)) return true;
     }
 
+    if (size==0) return true;
+    if (!_enforceMaxTexturePoolSize || !_evictionCallback) return false;
+
+    // collect the active TextureObjects not used in this frame, the lists of each set are already ordered by use.
+    typedef std::vector< std::pair<unsigned int, Texture::TextureObject*> > Candidates;
+    Candidates candidates;
+    for(TextureSetMap::iterator itr = _textureSetMap.begin();
+        itr != _textureSetMap.end();
+        ++itr)
+    {
+        for(Texture::TextureObject* to = itr->second->getHead();
+            to!=0 && to->_frameLastUsed<_frameNumber;
+            to = to->_next)
+        {
+            if (to->_profile._size!=0 && to->getTexture()) candidates.push_back(Candidates::value_type(to->_frameLastUsed, to));
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), LessFrameLastUsed());
+
+    // evict the least recently used first.
+    for(Candidates::iterator itr = candidates.begin();
+        itr != candidates.end() && size>0;
+        ++itr)
+    {
+        Texture::TextureObject* to = itr->second;
+        ref_ptr<Texture> texture = to->getTexture();
+        if (!texture || !_evictionCallback->canEvict(texture.get(), _contextID)) continue;
+
+        unsigned int sizeEvicted = to->_profile._size;
+        if (to->_set->evict(to))
+        {
+            OSG_INFO<<"TextureObjectManager::makeSpace() evicted TextureObject of Texture "<<texture.get()<<", size="<<sizeEvicted<<std::endl;
+
+            _evictionCallback->evicted(texture.get(), _contextID);
+
+            size = (size>sizeEvicted) ? size-sizeEvicted : 0;
+        }
+    }
+
     return size==0;
 }
 
@@ -1116,6 +1235,14 @@ void TextureObjectManager::flushDeletedGLObjects(double currentTime, double& ava
 
 void TextureObjectManager::newFrame(osg::FrameStamp* fs)
 {
+    // complete the statistics of the previous frame.
+    _currentFrameStats.frameNumber = _frameNumber;
+    _currentFrameStats.poolSize = _currTexturePoolSize;
+    _currentFrameStats.numActive = _numActiveTextureObjects;
+    _currentFrameStats.numOrphans = _numOrphanedTextureObjects;
+    _lastFrameStats = _currentFrameStats;
+    _currentFrameStats = FrameStats();
+
     if (fs) _frameNumber = fs->getFrameNumber();
     else ++_frameNumber;
 
@@ -1130,6 +1257,9 @@ void TextureObjectManager::reportStats(std::ostream& out)
     out<<"   total _numGenerated="<<_numGenerated<<", _generateTime="<<_generateTime<<", averagePerFrame="<<_generateTime/numFrames*1000.0<<"ms"<<std::endl;
     out<<"   total _numDeleted="<<_numDeleted<<", _deleteTime="<<_deleteTime<<", averagePerFrame="<<_deleteTime/numFrames*1000.0<<"ms"<<std::endl;
     out<<"   getMaxTexturePoolSize()="<<getMaxTexturePoolSize()<<" current/max size = "<<double(_currTexturePoolSize)/double(getMaxTexturePoolSize())<<std::endl;
+    out<<"   last frame "<<_lastFrameStats.frameNumber<<": generated="<<_lastFrameStats.numGenerated<<", reused="<<_lastFrameStats.numReused
+       <<", deleted="<<_lastFrameStats.numDeleted<<", evicted="<<_lastFrameStats.numEvicted<<" ("<<_lastFrameStats.sizeEvicted<<" bytes)"
+       <<", overBudget="<<_lastFrameStats.numOverBudget<<std::endl;
     recomputeStats(out);
 }
 
@@ -2129,6 +2259,61 @@ GLenum Texture::selectSizedInternalFormat(const osg::Image* image) const
     }
 }
 
+/** Generate and download all the mipmap levels of a 2D texture image by resampling on the CPU,
+  * returns the number of levels downloaded or 0 when the pixel format/type isn't supported and gluBuild2DMipmaps() should be used instead.*/
+static GLsizei buildMipmapsWithResampling(GLenum target, GLint internalFormat, GLsizei width, GLsizei height,
+                                          GLenum pixelFormat, GLenum dataType, int packing, const unsigned char* data)
+{
+    if (width<=0 || height<=0 || !data) return 0;
+
+    GLsizei numLevels = 1;
+    for(GLsizei w = width, h = height; w>1 || h>1; w>>=1, h>>=1) ++numLevels;
+
+    std::vector<unsigned char> buffers[2];
+
+    const unsigned char* levelData = data;
+    unsigned int levelRowStep = Image::computeRowWidthInBytes(width, pixelFormat, dataType, packing);
+    GLsizei levelWidth = width;
+    GLsizei levelHeight = height;
+
+    for(GLsizei level = 1; level<numLevels; ++level)
+    {
+        GLsizei nextWidth = osg::maximum(levelWidth>>1, 1);
+        GLsizei nextHeight = osg::maximum(levelHeight>>1, 1);
+        unsigned int nextRowStep = Image::computeRowWidthInBytes(nextWidth, pixelFormat, dataType, packing);
+
+        std::vector<unsigned char>& buffer = buffers[level%2];
+        buffer.resize(nextRowStep*nextHeight);
+
+        if (!resampleImageData(pixelFormat,
+                               levelWidth, levelHeight, dataType, levelData, levelRowStep,
+                               nextWidth, nextHeight, dataType, &buffer.front(), nextRowStep))
+        {
+            return 0;
+        }
+
+        // only download level 0 once we know that the rest of the chain can be generated.
+        if (level==1)
+        {
+            glTexImage2D(target, 0, internalFormat, width, height, 0, pixelFormat, dataType, data);
+        }
+
+        glTexImage2D(target, level, internalFormat, nextWidth, nextHeight, 0, pixelFormat, dataType, &buffer.front());
+
+        levelData = &buffer.front();
+        levelRowStep = nextRowStep;
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    if (numLevels==1)
+    {
+        glTexImage2D(target, 0, internalFormat, width, height, 0, pixelFormat, dataType, data);
+    }
+
+    return numLevels;
+}
+
 void Texture::applyTexImage2D_load(State& state, GLenum target, const Image* image, GLsizei inwidth, GLsizei inheight,GLsizei numMipmapLevels) const
 {
     // if we don't have a valid image we can't create a texture!
@@ -2239,16 +2424,22 @@ void Texture::applyTexImage2D_load(State& state, GLenum target, const Image* ima
         if (!image->getFileName().empty()) { OSG_NOTICE << "Scaling image '"<<image->getFileName()<<"' from ("<<image->s()<<","<<image->t()<<") to ("<<inwidth<<","<<inheight<<")"<<std::endl; }
         else { OSG_NOTICE << "Scaling image from ("<<image->s()<<","<<image->t()<<") to ("<<inwidth<<","<<inheight<<")"<<std::endl; }
 
-        PixelStorageModes psm;
-        psm.pack_alignment = image->getPacking();
-        psm.pack_row_length = image->getRowLength();
-        psm.unpack_alignment = image->getPacking();
-
         // rescale the image to the correct size.
-        gluScaleImage(&psm, image->getPixelFormat(),
-                        image->s(),image->t(),image->getDataType(),image->data(),
-                        inwidth,inheight,image->getDataType(),
-                        dataPtr);
+        if (!resampleImageData(image->getPixelFormat(),
+                               image->s(),image->t(),image->getDataType(),image->data(),image->getRowStepInBytes(),
+                               inwidth,inheight,image->getDataType(),
+                               dataPtr,osg::Image::computeRowWidthInBytes(inwidth,image->getPixelFormat(),image->getDataType(),image->getPacking())))
+        {
+            PixelStorageModes psm;
+            psm.pack_alignment = image->getPacking();
+            psm.pack_row_length = image->getRowLength();
+            psm.unpack_alignment = image->getPacking();
+
+            gluScaleImage(&psm, image->getPixelFormat(),
+                            image->s(),image->t(),image->getDataType(),image->data(),
+                            inwidth,inheight,image->getDataType(),
+                            dataPtr);
+        }
 
         rowLength = 0;
     }
@@ -2433,10 +2624,18 @@ void Texture::applyTexImage2D_load(State& state, GLenum target, const Image* ima
             {
                 numMipmapLevels = 0;
 
-                gluBuild2DMipmaps( target, _internalFormat,
-                    inwidth,inheight,
-                    (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
-                    dataPtr);
+                // generate the mipmaps on the CPU with the multithreaded resampler when the data is tightly addressed,
+                // otherwise fallback to gluBuild2DMipmaps() which honours the unpack row length.
+                if (rowLength!=0 ||
+                    buildMipmapsWithResampling(target, _internalFormat, inwidth, inheight,
+                                               (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
+                                               image->getPacking(), dataPtr)==0)
+                {
+                    gluBuild2DMipmaps( target, _internalFormat,
+                        inwidth,inheight,
+                        (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
+                        dataPtr);
+                }
 
                 int width  = image->s();
                 int height = image->t();
@@ -2566,14 +2765,20 @@ void Texture::applyTexImage2D_subload(State& state, GLenum target, const Image*
         else { OSG_NOTICE << "Scaling image from ("<<image->s()<<","<<image->t()<<") to ("<<inwidth<<","<<inheight<<")"<<std::endl; }
 
         // rescale the image to the correct size.
-        PixelStorageModes psm;
-        psm.pack_alignment = image->getPacking();
-        psm.unpack_alignment = image->getPacking();
-
-        gluScaleImage(&psm, image->getPixelFormat(),
-                      image->s(),image->t(),image->getDataType(),image->data(),
-                      inwidth,inheight,image->getDataType(),
-                      dataPtr);
+        if (!resampleImageData(image->getPixelFormat(),
+                               image->s(),image->t(),image->getDataType(),image->data(),image->getRowStepInBytes(),
+                               inwidth,inheight,image->getDataType(),
+                               dataPtr,osg::Image::computeRowWidthInBytes(inwidth,image->getPixelFormat(),image->getDataType(),image->getPacking())))
+        {
+            PixelStorageModes psm;
+            psm.pack_alignment = image->getPacking();
+            psm.unpack_alignment = image->getPacking();
+
+            gluScaleImage(&psm, image->getPixelFormat(),
+                          image->s(),image->t(),image->getDataType(),image->data(),
+                          inwidth,inheight,image->getDataType(),
+                          dataPtr);
+        }
 
         rowLength = 0;
     }
@@ -339,6 +339,176 @@ void Texture2D::apply(State& state) const
     }
 }
 
+bool Texture2D::applyIncrementally(State& state, unsigned int maxUploadSize, unsigned int& uploadedSize) const
+{
+    const unsigned int contextID = state.getContextID();
+    TextureObject* textureObject = getTextureObject(contextID);
+
+    // a texture object released since the last call has to be uploaded from the start again.
+    if (!textureObject) uploadedSize = 0;
+
+    osg::ref_ptr<osg::Image> image = _image;
+    if (uploadedSize==0)
+    {
+        if (textureObject || _subloadCallback.valid() || !image.valid() || !image->data() ||
+            image->getTotalSizeInBytesIncludingMipmaps()<=maxUploadSize)
+        {
+            apply(state);
+            return true;
+        }
+
+        if (!isSubImageUploadSupported(state))
+        {
+            apply(state);
+            return true;
+        }
+
+        textureObject = allocateForSubImageUpload(state);
+    }
+    else
+    {
+        if (!image.valid() || !image->data()) return true;
+
+        textureObject->bind(state);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT,image->getPacking());
+
+    // upload whole rows of each mipmap level in turn until the upload budget is used up.
+    bool useMipmaps = _min_filter!=LINEAR && _min_filter!=NEAREST;
+    unsigned int numLevels = (useMipmaps && image->isMipmap()) ? image->getNumMipmapLevels() : 1;
+    unsigned int levelStart = 0;
+    unsigned int budget = maxUploadSize;
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        GLsizei width = osg::maximum(image->s()>>level, 1);
+        GLsizei height = osg::maximum(image->t()>>level, 1);
+        unsigned int rowSize = Image::computeRowWidthInBytes(width, image->getPixelFormat(), image->getDataType(), image->getPacking());
+        unsigned int levelSize = rowSize*height;
+
+        if (uploadedSize<levelStart+levelSize)
+        {
+            if (budget==0) return false;
+
+            unsigned int row = (uploadedSize-levelStart)/rowSize;
+            unsigned int numRows = osg::minimum(static_cast<unsigned int>(height)-row, osg::maximum(budget/rowSize, 1u));
+
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, row, width, numRows,
+                            (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
+                            image->getMipmapData(level)+row*rowSize);
+
+            uploadedSize += numRows*rowSize;
+            budget -= osg::minimum(budget, numRows*rowSize);
+
+            if (row+numRows<static_cast<unsigned int>(height)) return false;
+        }
+
+        levelStart += levelSize;
+    }
+
+    if (useMipmaps && !image->isMipmap()) generateMipmap(state);
+
+    // update the modified tag to show that it is up to date.
+    getModifiedCount(contextID) = image->getModifiedCount();
+
+    if (isSafeToUnrefImageData(state) && image->getDataVariance()==STATIC)
+    {
+        Texture2D* non_const_this = const_cast<Texture2D*>(this);
+        non_const_this->_image = NULL;
+    }
+
+    return true;
+}
+
+bool Texture2D::isSubImageUploadSupported(State& state) const
+{
+    if (!_image.valid() || !_image->data() || _subloadCallback.valid()) return false;
+
+    const Image& image = *_image;
+
+    computeInternalFormat();
+    computeRequiredTextureDimensions(state,image,_textureWidth, _textureHeight, _numMipmapLevels);
+
+    const GLExtensions* extensions = state.get<GLExtensions>();
+    bool useMipmaps = _min_filter!=LINEAR && _min_filter!=NEAREST;
+    bool generateMipmaps = useMipmaps && !image.isMipmap();
+
+    return _textureWidth==image.s() && _textureHeight==image.t() && _borderWidth==0 &&
+           !isCompressedInternalFormat(_internalFormat) && !isCompressedInternalFormat(image.getPixelFormat()) &&
+           image.getRowLength()==0 && image.isDataContiguous() && !image.getPixelBufferObject() &&
+           !(extensions->isClientStorageSupported && getClientStorageHint()) &&
+           !(generateMipmaps && !(extensions->isFrameBufferObjectSupported && extensions->glGenerateMipmap));
+}
+
+Texture::TextureObject* Texture2D::allocateForSubImageUpload(State& state) const
+{
+    const Image& image = *_image;
+    bool useMipmaps = _min_filter!=LINEAR && _min_filter!=NEAREST;
+
+    TextureObject* textureObject = generateAndAssignTextureObject(state.getContextID(),GL_TEXTURE_2D,_numMipmapLevels,_internalFormat,_textureWidth,_textureHeight,1,_borderWidth);
+    textureObject->bind(state);
+
+    applyTexParameters(GL_TEXTURE_2D,state);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT,image.getPacking());
+
+    if (!textureObject->isAllocated())
+    {
+        unsigned int numLevels = (useMipmaps && image.isMipmap()) ? image.getNumMipmapLevels() : 1;
+        for(unsigned int level=0; level<numLevels; ++level)
+        {
+            GLsizei width = osg::maximum(image.s()>>level, 1);
+            GLsizei height = osg::maximum(image.t()>>level, 1);
+            glTexImage2D(GL_TEXTURE_2D, level, _internalFormat, width, height, _borderWidth,
+                         (GLenum)image.getPixelFormat(), (GLenum)image.getDataType(), 0);
+        }
+        textureObject->setAllocated(true);
+    }
+
+    return textureObject;
+}
+
+bool Texture2D::applyFromPixelUnpackBuffer(State& state, GLuint pixelUnpackBuffer) const
+{
+    const unsigned int contextID = state.getContextID();
+    if (getTextureObject(contextID) || !isSubImageUploadSupported(state)) return false;
+
+    osg::ref_ptr<osg::Image> image = _image;
+
+    // allocate the levels before binding the buffer, as glTexImage2D would otherwise read them from it.
+    allocateForSubImageUpload(state);
+
+    const GLExtensions* extensions = state.get<GLExtensions>();
+    extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, pixelUnpackBuffer);
+
+    // with a pixel unpack buffer bound the data pointers are offsets into the buffer.
+    bool useMipmaps = _min_filter!=LINEAR && _min_filter!=NEAREST;
+    unsigned int numLevels = (useMipmaps && image->isMipmap()) ? image->getNumMipmapLevels() : 1;
+    for(unsigned int level=0; level<numLevels; ++level)
+    {
+        GLsizei width = osg::maximum(image->s()>>level, 1);
+        GLsizei height = osg::maximum(image->t()>>level, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height,
+                        (GLenum)image->getPixelFormat(), (GLenum)image->getDataType(),
+                        reinterpret_cast<const GLvoid*>(static_cast<size_t>(image->getMipmapOffset(level))));
+    }
+
+    extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+    if (useMipmaps && !image->isMipmap()) generateMipmap(state);
+
+    // update the modified tag to show that it is up to date.
+    getModifiedCount(contextID) = image->getModifiedCount();
+
+    if (isSafeToUnrefImageData(state) && image->getDataVariance()==STATIC)
+    {
+        Texture2D* non_const_this = const_cast<Texture2D*>(this);
+        non_const_this->_image = NULL;
+    }
+
+    return true;
+}
+
 void Texture2D::computeInternalFormat() const
 {
     if (_image.valid()) computeInternalFormatWithImage(*_image);
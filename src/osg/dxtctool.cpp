@@ -8,6 +8,13 @@
 
 #include "dxtctool.h"
 
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+    #define DXTC_USE_SSE2 1
+    #include <emmintrin.h>
+#endif
+
 
 namespace dxtc_tool {
 
@@ -25,33 +32,124 @@ namespace dxtc_tool {
 
 
 //////////////////////////////////////////////////////////////////////
-// Members Functions
+// Block flipping helpers, each block is flipped as whole 64bit words
 //////////////////////////////////////////////////////////////////////
 
-bool dxtc_pixels::OpenGLSize() const
+namespace {
+
+typedef unsigned long long dxtc_uint64;
+
+inline dxtc_uint64 Load64(const void * p) {
+    dxtc_uint64 Value;
+    memcpy(&Value, p, sizeof(Value));
+    return Value;
+}
+
+inline void Store64(void * p, dxtc_uint64 Value) {
+    memcpy(p, &Value, sizeof(Value));
+}
+
+// Reverse the 4 rows of 2 bit color indices held in the upper 32 bits of a color block
+inline dxtc_uint64 FlipColorBlock(dxtc_uint64 Block) {
+    dxtc_uint64 Indices = Block >> 32;
+    Indices = ((Indices & 0x000000FFull) << 24) | ((Indices & 0x0000FF00ull) << 8) |
+              ((Indices & 0x00FF0000ull) >> 8) | ((Indices & 0xFF000000ull) >> 24);
+    return (Block & 0xFFFFFFFFull) | (Indices << 32);
+}
+
+// Reverse the 4 rows of 16 bits of a DXT3 alpha block
+inline dxtc_uint64 FlipAlphaDXT3Block(dxtc_uint64 Block) {
+    return ((Block & 0x000000000000FFFFull) << 48) | ((Block & 0x00000000FFFF0000ull) << 16) |
+           ((Block & 0x0000FFFF00000000ull) >> 16) | ((Block & 0xFFFF000000000000ull) >> 48);
+}
+
+// Reverse the 4 rows of 12 bits of alpha indices held in the upper 48 bits of a DXT5 alpha block
+inline dxtc_uint64 FlipAlphaDXT5Block(dxtc_uint64 Block) {
+    return (Block & 0x000000000000FFFFull) |
+           ((Block & 0x000000000FFF0000ull) << 36) | ((Block & 0x000000FFF0000000ull) << 12) |
+           ((Block & 0x000FFF0000000000ull) >> 12) | ((Block & 0xFFF0000000000000ull) >> 36);
+}
+
+struct FlipDXT1
 {
-    size_t Width = m_Width;
-    size_t Height = m_Height;
-    // size_t TotalTrueBits = 0;
+    enum { BlockSize = 8 };
+    void operator() (unsigned char * pBlock1, unsigned char * pBlock2) const {
+        dxtc_uint64 Color1 = FlipColorBlock(Load64(pBlock1));
+        dxtc_uint64 Color2 = FlipColorBlock(Load64(pBlock2));
+        Store64(pBlock1, Color2);
+        Store64(pBlock2, Color1);
+    }
+};
 
-    if ((Width == 0) || (Height == 0))
-        return false;
+struct FlipDXT3
+{
+    enum { BlockSize = 16 };
+    void operator() (unsigned char * pBlock1, unsigned char * pBlock2) const {
+        dxtc_uint64 Alpha1 = FlipAlphaDXT3Block(Load64(pBlock1));
+        dxtc_uint64 Color1 = FlipColorBlock(Load64(pBlock1 + 8));
+        dxtc_uint64 Alpha2 = FlipAlphaDXT3Block(Load64(pBlock2));
+        dxtc_uint64 Color2 = FlipColorBlock(Load64(pBlock2 + 8));
+        Store64(pBlock1, Alpha2);
+        Store64(pBlock1 + 8, Color2);
+        Store64(pBlock2, Alpha1);
+        Store64(pBlock2 + 8, Color1);
+    }
+};
 
-    for (; (Width % 2) == 0; Width /= 2);
-    for (; (Height % 2) == 0; Height /= 2);
+struct FlipDXT5
+{
+    enum { BlockSize = 16 };
+    void operator() (unsigned char * pBlock1, unsigned char * pBlock2) const {
+        dxtc_uint64 Alpha1 = FlipAlphaDXT5Block(Load64(pBlock1));
+        dxtc_uint64 Color1 = FlipColorBlock(Load64(pBlock1 + 8));
+        dxtc_uint64 Alpha2 = FlipAlphaDXT5Block(Load64(pBlock2));
+        dxtc_uint64 Color2 = FlipColorBlock(Load64(pBlock2 + 8));
+        Store64(pBlock1, Alpha2);
+        Store64(pBlock1 + 8, Color2);
+        Store64(pBlock2, Alpha1);
+        Store64(pBlock2 + 8, Color1);
+    }
+};
 
-    if ((Width != 1) || (Height != 1))
-        return false;
-    else
-        return true;
+// Swap the block rows from the top and bottom towards the middle, flipping each block, a middle row is flipped in place.
+template<class FlipBlocks>
+void FlipBlockRows(unsigned char * pPixels, size_t Width, size_t Height, const FlipBlocks& Flip)
+{
+    const size_t RowSize = ((Width + 3) / 4) * FlipBlocks::BlockSize;
+    unsigned char * pTop = pPixels;
+    unsigned char * pBottom = pPixels + ((Height + 3) / 4 - 1) * RowSize;
+
+    for (; pTop <= pBottom; pTop += RowSize, pBottom -= RowSize)
+        for (size_t j = 0; j < RowSize; j += FlipBlocks::BlockSize)
+            Flip(pTop + j, pBottom + j);
+}
+
+// Reverse the order of the first NumRows of the 4 rows of Bits bits held in Value, starting at bit Offset
+inline dxtc_uint64 ReverseRows(dxtc_uint64 Value, unsigned int Offset, unsigned int Bits, size_t NumRows)
+{
+    const dxtc_uint64 Mask = (dxtc_uint64(1) << Bits) - 1;
+    dxtc_uint64 Result = Value;
+    for (size_t Row = 0; Row < NumRows; ++Row) {
+        const unsigned int From = Offset + Bits * static_cast<unsigned int>(NumRows - 1 - Row);
+        const unsigned int To = Offset + Bits * static_cast<unsigned int>(Row);
+        Result &= ~(Mask << To);
+        Result |= ((Value >> From) & Mask) << To;
+    }
+    return Result;
 }
 
+} // namespace
 
 
+
+//////////////////////////////////////////////////////////////////////
+// Members Functions
+//////////////////////////////////////////////////////////////////////
+
 bool dxtc_pixels::VFlip() const
 {
-    // Check that the given dimensions are 2^x, 2^y
-    if (! OpenGLSize())
+    // Check that the given dimensions can be flipped
+    if (! FlippableSize())
         return false;
 
     // Check that the given format are supported
@@ -62,7 +160,9 @@ bool dxtc_pixels::VFlip() const
     if (m_Height == 1)
         return true;
 
-    if (DXT1())
+    if (m_Height < 4)
+        VFlip_SingleBlockRow();
+    else if (DXT1())
         VFlip_DXT1();
     else if (DXT3())
         VFlip_DXT3();
@@ -78,81 +178,40 @@ bool dxtc_pixels::VFlip() const
 
 void dxtc_pixels::VFlip_DXT1() const
 {
-    // const size_t Size = ((m_Width + 3) / 4) * ((m_Height + 3) / 4) * BSIZE_DXT1;
-    dxtc_int8 * pPixels = (dxtc_int8 * ) m_pPixels;
-
-    if (m_Height == 2)
-        for (size_t j = 0; j < (m_Width + 3) / 4; ++j)
-            BVF_Color_H2(pPixels + j * BSIZE_DXT1);
-
-    if (m_Height == 4)
-        for (size_t j = 0; j < (m_Width + 3) / 4; ++j)
-            BVF_Color_H4(pPixels + j * BSIZE_DXT1);
-
-    if (m_Height > 4)
-        for (size_t i = 0; i < ((m_Height + 7) / 8); ++i)
-            for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-                const size_t TargetRow = ((m_Height + 3) / 4) - (i + 1);
-                BVF_Color(GetBlock(i, j, BSIZE_DXT1), GetBlock(TargetRow, j, BSIZE_DXT1));
-            }
+    FlipBlockRows((unsigned char *) m_pPixels, m_Width, m_Height, FlipDXT1());
 }
 
 
 
 void dxtc_pixels::VFlip_DXT3() const
 {
-    // const size_t Size = ((m_Width + 3) / 4) * ((m_Height + 3) / 4) * BSIZE_DXT3;
-    // dxtc_int8 * const pPixels = (dxtc_int8 * const) m_pPixels;
+    FlipBlockRows((unsigned char *) m_pPixels, m_Width, m_Height, FlipDXT3());
+}
 
-    if (m_Height == 2)
-        for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-            BVF_Alpha_DXT3_H2(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT3));
-            BVF_Color_H2(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT3 + BSIZE_ALPHA_DXT3));
-        }
 
-    if (m_Height == 4)
-        for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-            BVF_Alpha_DXT3_H4(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT3));
-            BVF_Color_H4(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT3 + BSIZE_ALPHA_DXT3));
-        }
 
-    if (m_Height > 4)
-        for (size_t i = 0; i < ((m_Height + 7) / 8); ++i)
-            for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-                const size_t TargetRow = ((m_Height + 3) / 4) - (i + 1);
-                BVF_Alpha_DXT3(GetBlock(i, j, BSIZE_DXT3), GetBlock(TargetRow, j, BSIZE_DXT3));
-                BVF_Color(((dxtc_int8 * ) GetBlock(i, j, BSIZE_DXT3)) + BSIZE_ALPHA_DXT3,
-                          ((dxtc_int8 * ) GetBlock(TargetRow, j, BSIZE_DXT3)) + BSIZE_ALPHA_DXT3);
-            }
+void dxtc_pixels::VFlip_DXT5() const
+{
+    FlipBlockRows((unsigned char *) m_pPixels, m_Width, m_Height, FlipDXT5());
 }
 
 
 
-void dxtc_pixels::VFlip_DXT5() const
+void dxtc_pixels::VFlip_SingleBlockRow() const
 {
-    // const size_t Size = ((m_Width + 3) / 4) * ((m_Height + 3) / 4) * BSIZE_DXT5;
-    // dxtc_int8 * const pPixels = (dxtc_int8 * const) m_pPixels;
+    const size_t BlockSize = DXT1() ? BSIZE_DXT1 : BSIZE_DXT3;
+    const size_t ColorOffset = DXT1() ? 0 : BSIZE_ALPHA_DXT3;
 
-    if (m_Height == 2)
-        for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-            BVF_Alpha_DXT5_H2(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT5));
-            BVF_Color_H2(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT5 + BSIZE_ALPHA_DXT5));
-        }
+    for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
+        unsigned char * pBlock = (unsigned char *) GetBlock(0, j, BlockSize);
 
-    if (m_Height == 4)
-        for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-            BVF_Alpha_DXT5_H4(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT5));
-            BVF_Color_H4(((dxtc_int8 * ) m_pPixels) + (j * BSIZE_DXT5 + BSIZE_ALPHA_DXT5));
-        }
+        if (DXT3())
+            Store64(pBlock, ReverseRows(Load64(pBlock), 0, 16, m_Height));
+        else if (DXT5())
+            Store64(pBlock, ReverseRows(Load64(pBlock), 16, 12, m_Height));
 
-    if (m_Height > 4)
-        for (size_t i = 0; i < ((m_Height + 7) / 8); ++i)
-            for (size_t j = 0; j < (m_Width + 3) / 4; ++j) {
-                const size_t TargetRow = ((m_Height + 3) / 4) - (i + 1);
-                BVF_Alpha_DXT5(GetBlock(i, j, BSIZE_DXT5), GetBlock(TargetRow, j, BSIZE_DXT5));
-                BVF_Color(((dxtc_int8 * ) GetBlock(i, j, BSIZE_DXT5)) + BSIZE_ALPHA_DXT5,
-                          ((dxtc_int8 * ) GetBlock(TargetRow, j, BSIZE_DXT5)) + BSIZE_ALPHA_DXT5);
-            }
+        Store64(pBlock + ColorOffset, ReverseRows(Load64(pBlock + ColorOffset), 32, 8, m_Height));
+    }
 }
 
 //
@@ -655,4 +714,146 @@ void compressedBlockStripAlhpa(const GLenum format, const unsigned char *src_blo
     }
     }
 }
+
+
+
+//////////////////////////////////////////////////////////////////////
+// Decompression
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+inline unsigned int Expand565(unsigned int Color, unsigned int Alpha) {
+    unsigned int Red = (Color >> 11) & 0x1F;
+    unsigned int Green = (Color >> 5) & 0x3F;
+    unsigned int Blue = Color & 0x1F;
+    return ((Red << 3) | (Red >> 2)) | (((Green << 2) | (Green >> 4)) << 8) | (((Blue << 3) | (Blue >> 2)) << 16) | (Alpha << 24);
+}
+
+// Compute the four RGBA colors of a color block, the alpha of all entries is 255 except a transparent index 3 of a DXT1a block
+void DecodeColorPalette(const unsigned char * pBlock, bool FourColorsOnly, bool TransparentBlack, unsigned int Palette[4])
+{
+    const unsigned int Color0 = pBlock[0] | (pBlock[1] << 8);
+    const unsigned int Color1 = pBlock[2] | (pBlock[3] << 8);
+    const bool FourColors = FourColorsOnly || (Color0 > Color1);
+
+#if defined(DXTC_USE_SSE2)
+    // interpolate both mid colors at once in 16 bit lanes, lanes 0-3 hold color0 and lanes 4-7 color1
+    const unsigned int Packed0 = Expand565(Color0, 255);
+    const unsigned int Packed1 = Expand565(Color1, 255);
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i Colors = _mm_unpacklo_epi8(_mm_cvtsi32_si128(Packed0) , Zero);
+    const __m128i Ends = _mm_unpacklo_epi64(Colors, _mm_unpacklo_epi8(_mm_cvtsi32_si128(Packed1), Zero));
+    const __m128i Swapped = _mm_shuffle_epi32(Ends, _MM_SHUFFLE(1, 0, 3, 2));
+
+    __m128i Mid;
+    if (FourColors) {
+        // (2*a + b + 1) / 3, the multiply by 21846 and keeping the high 16 bits is an exact division by 3 for sums up to 766
+        __m128i Sum = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(Ends, 1), Swapped), _mm_set1_epi16(1));
+        Mid = _mm_mulhi_epu16(Sum, _mm_set1_epi16(21846));
+    } else {
+        Mid = _mm_srli_epi16(_mm_add_epi16(Ends, Swapped), 1);
+    }
+
+    unsigned int Results[4];
+    _mm_storeu_si128((__m128i *) Results, _mm_packus_epi16(Ends, Mid));
+    Palette[0] = Results[0];
+    Palette[1] = Results[1];
+    Palette[2] = Results[2];
+    Palette[3] = FourColors ? Results[3] : (TransparentBlack ? 0 : 0xFF000000);
+#else
+    Palette[0] = Expand565(Color0, 255);
+    Palette[1] = Expand565(Color1, 255);
+    for (unsigned int Shift = 0; Shift < 24; Shift += 8) {
+        const unsigned int Channel0 = (Palette[0] >> Shift) & 0xFF;
+        const unsigned int Channel1 = (Palette[1] >> Shift) & 0xFF;
+        if (FourColors) {
+            Palette[2] = (Shift ? Palette[2] : 0xFF000000) | (((2 * Channel0 + Channel1 + 1) / 3) << Shift);
+            Palette[3] = (Shift ? Palette[3] : 0xFF000000) | (((Channel0 + 2 * Channel1 + 1) / 3) << Shift);
+        } else {
+            Palette[2] = (Shift ? Palette[2] : 0xFF000000) | (((Channel0 + Channel1) / 2) << Shift);
+        }
+    }
+    if (!FourColors)
+        Palette[3] = TransparentBlack ? 0 : 0xFF000000;
+#endif
+}
+
+// Decode one 4x4 block to RGBA pixels in row order
+void DecodeBlock(GLenum Format, const unsigned char * pBlock, unsigned int Pixels[16])
+{
+    const bool DXT1 = (Format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) || (Format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+    const unsigned char * pColor = DXT1 ? pBlock : pBlock + 8;
+
+    unsigned int Palette[4];
+    DecodeColorPalette(pColor, !DXT1, Format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, Palette);
+
+    for (unsigned int Row = 0; Row < 4; ++Row) {
+        const unsigned int Indices = pColor[4 + Row];
+        Pixels[Row * 4 + 0] = Palette[Indices & 0x3];
+        Pixels[Row * 4 + 1] = Palette[(Indices >> 2) & 0x3];
+        Pixels[Row * 4 + 2] = Palette[(Indices >> 4) & 0x3];
+        Pixels[Row * 4 + 3] = Palette[Indices >> 6];
+    }
+
+    if (Format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT) {
+        for (unsigned int i = 0; i < 16; ++i) {
+            const unsigned int Alpha = (pBlock[i / 2] >> ((i & 1) * 4)) & 0xF;
+            Pixels[i] = (Pixels[i] & 0x00FFFFFF) | ((Alpha * 17) << 24);
+        }
+    }
+    else if (Format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) {
+        const unsigned int Alpha0 = pBlock[0];
+        const unsigned int Alpha1 = pBlock[1];
+        unsigned int Alphas[8];
+        Alphas[0] = Alpha0;
+        Alphas[1] = Alpha1;
+        if (Alpha0 > Alpha1) {
+            for (unsigned int i = 1; i < 7; ++i)
+                Alphas[i + 1] = ((7 - i) * Alpha0 + i * Alpha1 + 3) / 7;
+        } else {
+            for (unsigned int i = 1; i < 5; ++i)
+                Alphas[i + 1] = ((5 - i) * Alpha0 + i * Alpha1 + 2) / 5;
+            Alphas[6] = 0;
+            Alphas[7] = 255;
+        }
+
+        dxtc_uint64 Indices = Load64(pBlock) >> 16;
+        for (unsigned int i = 0; i < 16; ++i, Indices >>= 3)
+            Pixels[i] = (Pixels[i] & 0x00FFFFFF) | (Alphas[Indices & 0x7] << 24);
+    }
+}
+
+} // namespace
+
+bool DecompressImage(size_t Width, size_t Height, GLenum Format, const void * pPixels, unsigned char * pRGBA, size_t RowStep)
+{
+    if (! isDXTC(Format) || (pPixels == NULL) || (pRGBA == NULL))
+        return false;
+
+    const bool DXT1 = (Format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) || (Format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT);
+    const size_t BlockSize = DXT1 ? 8 : 16;
+    const size_t BlocksWide = (Width + 3) / 4;
+    const size_t BlocksHigh = (Height + 3) / 4;
+
+    const unsigned char * pBlock = (const unsigned char *) pPixels;
+    unsigned int Pixels[16];
+
+    for (size_t i = 0; i < BlocksHigh; ++i) {
+        const size_t NumRows = (i * 4 + 4 <= Height) ? 4 : Height - i * 4;
+        unsigned char * pRow = pRGBA + i * 4 * RowStep;
+
+        for (size_t j = 0; j < BlocksWide; ++j, pBlock += BlockSize) {
+            const size_t NumColumns = (j * 4 + 4 <= Width) ? 4 : Width - j * 4;
+
+            DecodeBlock(Format, pBlock, Pixels);
+
+            for (size_t Row = 0; Row < NumRows; ++Row)
+                memcpy(pRow + Row * RowStep + j * 16, Pixels + Row * 4, NumColumns * 4);
+        }
+    }
+
+    return true;
+}
+
 } // namespace dxtc_tool
@@ -79,6 +79,9 @@ bool isDXTC(GLenum pixelFormat);
 
 bool VerticalFlip(size_t Width, size_t Height, GLenum Format, void * pPixels);
 
+// Decompress a DXT1/DXT3/DXT5 image to RGBA (GL_RGBA, GL_UNSIGNED_BYTE), RowStep is the number of bytes between destination rows.
+bool DecompressImage(size_t Width, size_t Height, GLenum Format, const void * pPixels, unsigned char * pRGBA, size_t RowStep);
+
 bool isCompressedImageTranslucent(size_t Width, size_t Height, GLenum Format, void * pPixels);
 
 //interpolate RGB565 colors with 2/3 part color1 and 1/3 part color2
@@ -108,24 +111,14 @@ protected:
     inline bool DXT1() const;
     inline bool DXT3() const;
     inline bool DXT5() const;
-    inline bool OpenGLSize() const;
+    inline bool FlippableSize() const;
     inline bool SupportedFormat() const;
 
     // Vertical flipping functions
     void VFlip_DXT1() const;
     void VFlip_DXT3() const;
     void VFlip_DXT5() const;
-
-    // Block vertical flipping functions
-    inline void BVF_Color_H2(void * const pBlock) const;                            // V. flip one color block with its virtual height == 2
-    inline void BVF_Color_H4(void * const pBlock) const;                            // V. flip one color block with its virtual height == 4
-    inline void BVF_Color(void * const pBlock1, void * const pBlock2) const;        // V. flip and swap two color blocks, with their virtual height == 4
-    inline void BVF_Alpha_DXT3_H2(void * const pBlock) const;                        // V. flip one alpha (DXT3) block with its virtual height == 2
-    inline void BVF_Alpha_DXT3_H4(void * const pBlock) const;                        // V. flip one alpha (DXT3) block with its virtual height == 4
-    inline void BVF_Alpha_DXT3(void * const pBlock1, void * const pBlock2) const;    // V. flip and swap two alpha (DXT3) blocks, with their virtual height == 4
-    inline void BVF_Alpha_DXT5_H2(void * const pBlock) const;                        // V. flip one alpha (DXT5) block with its virtual height == 2
-    inline void BVF_Alpha_DXT5_H4(void * const pBlock) const;                        // V. flip one alpha (DXT5) block with its virtual height == 4
-    inline void BVF_Alpha_DXT5(void * const pBlock1, void * const pBlock2) const;    // V. flip and swap two alpha (DXT5) blocks, with their virtual height == 4
+    void VFlip_SingleBlockRow() const;                                              // V. flip the first m_Height rows of the only row of blocks
 
     // Block localization functions
     inline void * GetBlock(size_t i, size_t j, size_t BlockSize) const;
@@ -198,117 +191,9 @@ inline bool dxtc_pixels::SupportedFormat() const {
 }
 
 
-inline void dxtc_pixels::BVF_Color_H2(void * const pBlock) const {
-    // Swap the two first row of pixels
-    dxtc_int8 * pP = ((dxtc_int8 *) pBlock) + 4;
-
-    std::swap(pP[0], pP[1]);
-}
-
-
-inline void dxtc_pixels::BVF_Color_H4(void * const pBlock) const {
-    // Swap the first row of pixels with the last one, then the 2 middle row of pixels
-    dxtc_int8 * pP = ((dxtc_int8 *) pBlock) + 4;
-
-    std::swap(pP[0], pP[3]);
-    std::swap(pP[1], pP[2]);
-}
-
-
-inline void dxtc_pixels::BVF_Color(void * const pBlock1, void * const pBlock2) const {
-    // Swap the "2 colors" header (32bits each header)
-    dxtc_int32 * pHdr1 = (dxtc_int32 * ) pBlock1;
-    dxtc_int32 * pHdr2 = (dxtc_int32 * ) pBlock2;
-
-    std::swap(* pHdr1, * pHdr2);
-
-    // Now swap the pixel values
-    dxtc_int8 * pP1 = ((dxtc_int8 * ) pBlock1) + 4;
-    dxtc_int8 * pP2 = ((dxtc_int8 * ) pBlock2) + 4;
-
-    std::swap(pP1[0], pP2[3]);
-    std::swap(pP1[1], pP2[2]);
-    std::swap(pP1[2], pP2[1]);
-    std::swap(pP1[3], pP2[0]);
-}
-
-
-inline void dxtc_pixels::BVF_Alpha_DXT3_H2(void * const pBlock) const {
-    // Swap the two first row of pixels
-    dxtc_int16 * pP = (dxtc_int16 * ) pBlock;
-
-    std::swap(pP[0], pP[1]);
-}
-
-
-inline void dxtc_pixels::BVF_Alpha_DXT3_H4(void * const pBlock) const {
-    // Swap the first row of pixels with the last one, then the 2 middle row of pixels
-    dxtc_int16 * pP = (dxtc_int16 * ) pBlock;
-
-    std::swap(pP[0], pP[3]);
-    std::swap(pP[1], pP[2]);
-}
-
-
-inline void dxtc_pixels::BVF_Alpha_DXT3(void * const pBlock1, void * const pBlock2) const {
-    // Swap all the pixel values
-    dxtc_int16 * pP1 = (dxtc_int16 * ) pBlock1;
-    dxtc_int16 * pP2 = (dxtc_int16 * ) pBlock2;
-
-    std::swap(pP1[0], pP2[3]);
-    std::swap(pP1[1], pP2[2]);
-    std::swap(pP1[2], pP2[1]);
-    std::swap(pP1[3], pP2[0]);
-}
-
-
-inline void dxtc_pixels::BVF_Alpha_DXT5_H2(void * const pBlock) const {
-    // Swap the two first row of pixels (kinda tricky with DXT5 unaligned encoding)
-    dxtc_int32 * pP = (dxtc_int32 * ) (((dxtc_int8 * ) pBlock) + 2);
-
-    dxtc_int32 TmpDWord = (pP[0] & 0xFF000000);
-    TmpDWord |=    (pP[0] & 0x00000FFF) << 12;
-    TmpDWord |= (pP[0] & 0x00FFF000) >> 12;
-    pP[0] = TmpDWord;
-}
-
-
-
-
-
-
-inline void dxtc_pixels::BVF_Alpha_DXT5_H4(void * const pBlock) const {
-    // Swap the first row of pixels with the last one, then the 2 middle row of pixels (tricky again)
-    dxtc_int64 * pB = (dxtc_int64 * ) pBlock;
-
-    dxtc_int64 TmpQWord = (pB[0] & HEX_0x000000000000FFFF);
-    TmpQWord |= (pB[0] & HEX_0x000000000FFF0000) << 36;
-    TmpQWord |= (pB[0] & HEX_0x000000FFF0000000) << 12;
-    TmpQWord |= (pB[0] & HEX_0x000FFF0000000000) >> 12;
-    TmpQWord |= (pB[0] & HEX_0xFFF0000000000000) >> 36;
-    pB[0] = TmpQWord;
-}
-
-
-inline void dxtc_pixels::BVF_Alpha_DXT5(void * const pBlock1, void * const pBlock2) const {
-    // Swap all the pixel values (same trick for DXT5)
-    dxtc_int64 * pB1 = (dxtc_int64 * ) pBlock1;
-    dxtc_int64 * pB2 = (dxtc_int64 * ) pBlock2;
-
-    dxtc_int64 TmpQWord1 = (pB1[0] & HEX_0x000000000000FFFF);
-    TmpQWord1 |= (pB1[0] & HEX_0x000000000FFF0000) << 36;
-    TmpQWord1 |= (pB1[0] & HEX_0x000000FFF0000000) << 12;
-    TmpQWord1 |= (pB1[0] & HEX_0x000FFF0000000000) >> 12;
-    TmpQWord1 |= (pB1[0] & HEX_0xFFF0000000000000) >> 36;
-
-    dxtc_int64 TmpQWord2 = (pB2[0] & HEX_0x000000000000FFFF);
-    TmpQWord2 |= (pB2[0] & HEX_0x000000000FFF0000) << 36;
-    TmpQWord2 |= (pB2[0] & HEX_0x000000FFF0000000) << 12;
-    TmpQWord2 |= (pB2[0] & HEX_0x000FFF0000000000) >> 12;
-    TmpQWord2 |= (pB2[0] & HEX_0xFFF0000000000000) >> 36;
-
-    pB1[0] = TmpQWord2;
-    pB2[0] = TmpQWord1;
+inline bool dxtc_pixels::FlippableSize() const {
+    // whole rows of blocks can only be swapped when the height is a multiple of 4, smaller images are flipped within their single row of blocks
+    return (m_Width > 0) && (m_Height > 0) && ((m_Height <= 4) || ((m_Height % 4) == 0));
 }
 
 
@@ -0,0 +1,445 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/Notify>
+#include <osg/Image>
+#include <osg/Shader>
+#include <osg/Shape>
+#include <osg/ScriptEngine>
+
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+
+#include <osgDB/BatchReader>
+#include <osgDB/Registry>
+
+using namespace osgDB;
+
+namespace
+{
+
+Options::CacheHintOptions getCacheHint(BatchReader::ReadType readType)
+{
+    switch(readType)
+    {
+        case(BatchReader::READ_OBJECT):         return Options::CACHE_OBJECTS;
+        case(BatchReader::READ_IMAGE):          return Options::CACHE_IMAGES;
+        case(BatchReader::READ_HEIGHTFIELD):    return Options::CACHE_HEIGHTFIELDS;
+        case(BatchReader::READ_NODE):           return Options::CACHE_NODES;
+        case(BatchReader::READ_SHADER):         return Options::CACHE_SHADERS;
+        default:                                return Options::CACHE_NONE;
+    }
+}
+
+bool isValid(BatchReader::ReadType readType, osg::Object* object)
+{
+    switch(readType)
+    {
+        case(BatchReader::READ_OBJECT):         return object!=0;
+        case(BatchReader::READ_IMAGE):          return dynamic_cast<osg::Image*>(object)!=0;
+        case(BatchReader::READ_HEIGHTFIELD):    return dynamic_cast<osg::HeightField*>(object)!=0;
+        case(BatchReader::READ_NODE):           return dynamic_cast<osg::Node*>(object)!=0;
+        case(BatchReader::READ_SHADER):         return dynamic_cast<osg::Shader*>(object)!=0;
+        case(BatchReader::READ_SCRIPT):         return dynamic_cast<osg::Script*>(object)!=0;
+        default:                                return false;
+    }
+}
+
+// Look up a file in the object caches the Registry would search when reading it with these options.
+osg::ref_ptr<osg::Object> getFromObjectCache(const std::string& fileName, const Options* options, BatchReader::ReadType readType)
+{
+    Options::CacheHintOptions cacheHint = getCacheHint(readType);
+    if (!options || (options->getObjectCacheHint() & cacheHint)==0) return 0;
+
+    osg::ref_ptr<osg::Object> object;
+
+    ObjectCache* optionsCache = options->getObjectCache();
+    if (optionsCache) object = optionsCache->getRefFromObjectCache(fileName, options);
+
+    ObjectCache* registryCache = Registry::instance()->getObjectCache();
+    if (!object && registryCache) object = registryCache->getRefFromObjectCache(fileName, options);
+
+    return isValid(readType, object.get()) ? object : 0;
+}
+
+// Worker threads left running by BatchReaders destroyed on one of their own worker threads, which can't
+// cancel themselves, kept until they have finished the Request they were completing.
+class DetachedThreads
+{
+    public:
+
+        ~DetachedThreads()
+        {
+            for(Threads::iterator itr = _threads.begin();
+                itr != _threads.end();
+                ++itr)
+            {
+                (*itr)->cancel();
+            }
+        }
+
+        void add(osg::OperationThread* thread)
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            _threads.push_back(thread);
+        }
+
+        void removeStopped()
+        {
+            Threads stopped;
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                for(Threads::iterator itr = _threads.begin();
+                    itr != _threads.end();
+                    )
+                {
+                    if ((*itr)->isRunning()) ++itr;
+                    else
+                    {
+                        stopped.push_back(*itr);
+                        itr = _threads.erase(itr);
+                    }
+                }
+            }
+        }
+
+    protected:
+
+        typedef std::vector< osg::ref_ptr<osg::OperationThread> > Threads;
+
+        OpenThreads::Mutex  _mutex;
+        Threads             _threads;
+};
+
+DetachedThreads& getDetachedThreads()
+{
+    static DetachedThreads s_detachedThreads;
+    return s_detachedThreads;
+}
+
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  BatchReader::Request
+//
+BatchReader::Request::Request(const std::string& fileName, const Options* options, ReadType readType):
+    osg::Referenced(true),
+    osg::Operation(fileName, false),
+    _fileName(fileName),
+    _options(options),
+    _readType(readType),
+    _state(PENDING),
+    _queuedTick(osg::Timer::instance()->tick()),
+    _startTick(_queuedTick),
+    _completedTick(_queuedTick)
+{
+}
+
+bool BatchReader::Request::isCompleted() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _state==COMPLETED || _state==CANCELLED;
+}
+
+bool BatchReader::Request::isCancelled() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _state==CANCELLED;
+}
+
+void BatchReader::Request::waitForCompletion() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    while(_state!=COMPLETED && _state!=CANCELLED)
+    {
+        _completedCondition.wait(&_mutex);
+    }
+}
+
+ReaderWriter::ReadResult& BatchReader::Request::getReadResult()
+{
+    waitForCompletion();
+    return _result;
+}
+
+const ReaderWriter::ReadResult& BatchReader::Request::getReadResult() const
+{
+    waitForCompletion();
+    return _result;
+}
+
+double BatchReader::Request::getQueueTime() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return osg::Timer::instance()->delta_m(_queuedTick, _startTick);
+}
+
+double BatchReader::Request::getReadTime() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return osg::Timer::instance()->delta_m(_startTick, _completedTick);
+}
+
+void BatchReader::Request::addCompletionCallback(CompletionCallback* callback)
+{
+    if (!callback) return;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        if (_state!=COMPLETED && _state!=CANCELLED)
+        {
+            _completionCallbacks.push_back(callback);
+            return;
+        }
+    }
+
+    callback->completed(this);
+}
+
+bool BatchReader::Request::start()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    if (_state!=PENDING) return false;
+
+    _state = RUNNING;
+    _startTick = osg::Timer::instance()->tick();
+    return true;
+}
+
+void BatchReader::Request::complete(const ReaderWriter::ReadResult& result, State state)
+{
+    CompletionCallbacks callbacks;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        _result = result;
+        _state = state;
+        _completedTick = osg::Timer::instance()->tick();
+        if (state==CANCELLED) _startTick = _completedTick;
+
+        callbacks.swap(_completionCallbacks);
+
+        _completedCondition.broadcast();
+    }
+
+    for(CompletionCallbacks::iterator itr = callbacks.begin();
+        itr != callbacks.end();
+        ++itr)
+    {
+        (*itr)->completed(this);
+    }
+
+    if (_pendingRequests.valid()) _pendingRequests->completed(this);
+}
+
+void BatchReader::Request::operator () (osg::Object*)
+{
+    if (!start()) return;
+
+    Registry* registry = Registry::instance();
+    const Options* options = _options.get();
+
+    ReaderWriter::ReadResult result;
+    switch(_readType)
+    {
+        case(READ_OBJECT):      result = registry->readObject(_fileName, options); break;
+        case(READ_IMAGE):       result = registry->readImage(_fileName, options); break;
+        case(READ_HEIGHTFIELD): result = registry->readHeightField(_fileName, options); break;
+        case(READ_NODE):        result = registry->readNode(_fileName, options); break;
+        case(READ_SHADER):      result = registry->readShader(_fileName, options); break;
+        case(READ_SCRIPT):      result = registry->readScript(_fileName, options); break;
+    }
+
+    if (!result.success()) OSG_WARN << "Error reading file " << _fileName << ": " << result.statusMessage() << std::endl;
+
+    complete(result, COMPLETED);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  BatchReader
+//
+BatchReader::BatchReader(unsigned int numThreads):
+    osg::Referenced(true),
+    _operationQueue(new osg::OperationQueue),
+    _pendingRequests(new PendingRequests)
+{
+    getDetachedThreads().removeStopped();
+
+    if (numThreads==0) numThreads = OpenThreads::GetNumberOfProcessors();
+    if (numThreads==0) numThreads = 1;
+
+    OSG_INFO<<"BatchReader::BatchReader() starting "<<numThreads<<" threads"<<std::endl;
+
+    for(unsigned int i=0; i<numThreads; ++i)
+    {
+        osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+        thread->setOperationQueue(_operationQueue.get());
+        thread->startThread();
+        _threads.push_back(thread);
+    }
+}
+
+BatchReader::~BatchReader()
+{
+    cancel();
+
+    for(Threads::iterator itr = _threads.begin();
+        itr != _threads.end();
+        ++itr)
+    {
+        (*itr)->setDone(true);
+    }
+
+    // cancelling a thread waits for the Request it is reading to complete, except when the last reference
+    // to the BatchReader is released by a CompletionCallback on one of the worker threads, which can't
+    // wait for itself so is detached to exit once the Request it is completing returns
+    OpenThreads::Thread* currentThread = OpenThreads::Thread::CurrentThread();
+    for(Threads::iterator itr = _threads.begin();
+        itr != _threads.end();
+        ++itr)
+    {
+        if (static_cast<OpenThreads::Thread*>(itr->get())==currentThread) getDetachedThreads().add(itr->get());
+        else (*itr)->cancel();
+    }
+
+    getDetachedThreads().removeStopped();
+}
+
+osg::ref_ptr<BatchReader::Request> BatchReader::read(const std::string& fileName, const Options* options, ReadType readType, CompletionCallback* callback)
+{
+    if (!options) options = Registry::instance()->getOptions();
+
+    osg::ref_ptr<Request> request;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingRequests->_mutex);
+
+        RequestKey key(fileName, std::make_pair(options, readType));
+        RequestMap::iterator itr = _pendingRequests->_requests.find(key);
+        if (itr != _pendingRequests->_requests.end())
+        {
+            request = itr->second;
+        }
+        else
+        {
+            osg::ref_ptr<osg::Object> object = getFromObjectCache(fileName, options, readType);
+
+            request = new Request(fileName, options, readType);
+
+            if (!object)
+            {
+                request->_pendingRequests = _pendingRequests;
+                _pendingRequests->_requests[key] = request;
+                _operationQueue->add(request.get());
+            }
+            else
+            {
+                request->complete(ReaderWriter::ReadResult(object.get(), ReaderWriter::ReadResult::FILE_LOADED_FROM_CACHE), Request::COMPLETED);
+            }
+        }
+    }
+
+    request->addCompletionCallback(callback);
+
+    return request;
+}
+
+BatchReader::RequestList BatchReader::read(const std::vector<std::string>& fileNames, const Options* options, ReadType readType, CompletionCallback* callback)
+{
+    // share the Request of files listed more than once even if the first read completes before the
+    // file comes up again, in which case it would no longer be pending
+    typedef std::map<std::string, unsigned int> FirstRequests;
+    FirstRequests firstRequests;
+
+    RequestList requests;
+    requests.reserve(fileNames.size());
+
+    for(std::vector<std::string>::const_iterator itr = fileNames.begin();
+        itr != fileNames.end();
+        ++itr)
+    {
+        FirstRequests::iterator first = firstRequests.find(*itr);
+        if (first != firstRequests.end())
+        {
+            requests.push_back(requests[first->second]);
+        }
+        else
+        {
+            firstRequests[*itr] = static_cast<unsigned int>(requests.size());
+            requests.push_back(read(*itr, options, readType, callback));
+        }
+    }
+
+    return requests;
+}
+
+unsigned int BatchReader::getNumPendingRequests() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingRequests->_mutex);
+    return static_cast<unsigned int>(_pendingRequests->_requests.size());
+}
+
+void BatchReader::waitForCompletion() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingRequests->_mutex);
+    while(!_pendingRequests->_requests.empty())
+    {
+        _pendingRequests->_condition.wait(&_pendingRequests->_mutex);
+    }
+}
+
+void BatchReader::cancel()
+{
+    RequestList cancelled;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_pendingRequests->_mutex);
+        for(RequestMap::iterator itr = _pendingRequests->_requests.begin();
+            itr != _pendingRequests->_requests.end();
+            ++itr)
+        {
+            _operationQueue->remove(itr->second.get());
+            cancelled.push_back(itr->second);
+        }
+    }
+
+    // Requests already taken by a worker thread are left to complete, start() refusing the others
+    for(RequestList::iterator itr = cancelled.begin();
+        itr != cancelled.end();
+        ++itr)
+    {
+        Request* request = itr->get();
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(request->_mutex);
+            if (request->_state!=Request::PENDING) continue;
+            request->_state = Request::RUNNING;
+        }
+
+        request->complete(ReaderWriter::ReadResult(ReaderWriter::ReadResult::FILE_NOT_HANDLED), Request::CANCELLED);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+//  BatchReader::PendingRequests
+//
+void BatchReader::PendingRequests::completed(Request* request)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    RequestKey key(request->getFileName(), std::make_pair(request->getOptions(), request->getReadType()));
+    RequestMap::iterator itr = _requests.find(key);
+    if (itr != _requests.end() && itr->second==request) _requests.erase(itr);
+
+    _condition.broadcast();
+}
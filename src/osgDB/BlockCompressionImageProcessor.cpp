@@ -0,0 +1,970 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/BlockCompressionImageProcessor>
+
+#include <osg/ImageUtils>
+#include <osg/Math>
+#include <osg/Notify>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
+
+#include <float.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+    #define OSGDB_BLOCKCOMPRESSION_USE_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+using namespace osgDB;
+
+namespace
+{
+
+enum BlockFormat
+{
+    BLOCK_DXT1,
+    BLOCK_DXT1a,
+    BLOCK_DXT3,
+    BLOCK_DXT5,
+    BLOCK_RGTC1,
+    BLOCK_RGTC2
+};
+
+struct CompressionSettings
+{
+    bool            usePrincipalAxis;
+    unsigned int    numRefinements;
+    bool            tryThreeColourMode;
+    bool            trySixValueAlphaMode;
+    int             alphaSearchRadius;
+};
+
+CompressionSettings getCompressionSettings(ImageProcessor::CompressionQuality quality)
+{
+    CompressionSettings settings;
+    settings.usePrincipalAxis = quality!=ImageProcessor::FASTEST;
+    settings.numRefinements = quality==ImageProcessor::HIGHEST ? 8 : (quality==ImageProcessor::PRODUCTION ? 2 : 0);
+    settings.tryThreeColourMode = quality==ImageProcessor::HIGHEST;
+    settings.trySixValueAlphaMode = quality==ImageProcessor::PRODUCTION || quality==ImageProcessor::HIGHEST;
+    settings.alphaSearchRadius = quality==ImageProcessor::HIGHEST ? 2 : (quality==ImageProcessor::PRODUCTION ? 1 : 0);
+    return settings;
+}
+
+unsigned int getBlockSize(BlockFormat format)
+{
+    return (format==BLOCK_DXT1 || format==BLOCK_DXT1a || format==BLOCK_RGTC1) ? 8 : 16;
+}
+
+GLenum getCompressedPixelFormat(BlockFormat format)
+{
+    switch(format)
+    {
+        case(BLOCK_DXT1): return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case(BLOCK_DXT1a): return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case(BLOCK_DXT3): return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case(BLOCK_DXT5): return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case(BLOCK_RGTC1): return GL_COMPRESSED_RED_RGTC1_EXT;
+        default: return GL_COMPRESSED_RED_GREEN_RGTC2_EXT;
+    }
+}
+
+bool hasAlpha(GLenum pixelFormat)
+{
+    return pixelFormat==GL_RGBA || pixelFormat==GL_BGRA || pixelFormat==GL_LUMINANCE_ALPHA || pixelFormat==GL_ALPHA;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Index selection, the innermost loops of the compressor.
+//
+
+/** Select the nearest palette entry for each of the 16 pixels of a block, return the summed squared error.*/
+float selectColourIndices(const float* r, const float* g, const float* b, const float palette[4][3], unsigned int numColours, unsigned char* indices)
+{
+#if defined(OSGDB_BLOCKCOMPRESSION_USE_SSE2)
+    float errors[16];
+    int selected[16];
+    for(unsigned int i=0; i<16; i+=4)
+    {
+        __m128 pr = _mm_loadu_ps(r+i);
+        __m128 pg = _mm_loadu_ps(g+i);
+        __m128 pb = _mm_loadu_ps(b+i);
+
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for(unsigned int p=0; p<numColours; ++p)
+        {
+            __m128 dr = _mm_sub_ps(pr, _mm_set1_ps(palette[p][0]));
+            __m128 dg = _mm_sub_ps(pg, _mm_set1_ps(palette[p][1]));
+            __m128 db = _mm_sub_ps(pb, _mm_set1_ps(palette[p][2]));
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best = _mm_min_ps(d, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32(p)));
+        }
+
+        _mm_storeu_ps(errors+i, best);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(selected+i), bestIndex);
+    }
+
+    float error = 0.0f;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        indices[i] = static_cast<unsigned char>(selected[i]);
+        error += errors[i];
+    }
+    return error;
+#else
+    float error = 0.0f;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        float best = FLT_MAX;
+        unsigned char bestIndex = 0;
+        for(unsigned int p=0; p<numColours; ++p)
+        {
+            float dr = r[i]-palette[p][0];
+            float dg = g[i]-palette[p][1];
+            float db = b[i]-palette[p][2];
+            float d = dr*dr + dg*dg + db*db;
+            if (d<best) { best = d; bestIndex = static_cast<unsigned char>(p); }
+        }
+        indices[i] = bestIndex;
+        error += best;
+    }
+    return error;
+#endif
+}
+
+/** Select the nearest of the 8 palette values for each of the 16 values of a block, return the summed squared error.*/
+float selectAlphaIndices(const float* values, const float palette[8], unsigned char* indices)
+{
+#if defined(OSGDB_BLOCKCOMPRESSION_USE_SSE2)
+    float errors[16];
+    int selected[16];
+    for(unsigned int i=0; i<16; i+=4)
+    {
+        __m128 v = _mm_loadu_ps(values+i);
+
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for(unsigned int p=0; p<8; ++p)
+        {
+            __m128 dv = _mm_sub_ps(v, _mm_set1_ps(palette[p]));
+            __m128 d = _mm_mul_ps(dv, dv);
+
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best = _mm_min_ps(d, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32(p)));
+        }
+
+        _mm_storeu_ps(errors+i, best);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(selected+i), bestIndex);
+    }
+
+    float error = 0.0f;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        indices[i] = static_cast<unsigned char>(selected[i]);
+        error += errors[i];
+    }
+    return error;
+#else
+    float error = 0.0f;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        float best = FLT_MAX;
+        unsigned char bestIndex = 0;
+        for(unsigned int p=0; p<8; ++p)
+        {
+            float d = (values[i]-palette[p])*(values[i]-palette[p]);
+            if (d<best) { best = d; bestIndex = static_cast<unsigned char>(p); }
+        }
+        indices[i] = bestIndex;
+        error += best;
+    }
+    return error;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Colour blocks, DXT1 and the colour half of DXT3/DXT5
+//
+
+struct ColourBlock
+{
+    float           r[16];
+    float           g[16];
+    float           b[16];
+    bool            transparent[16];
+    unsigned int    numOpaque;
+};
+
+inline unsigned short encode565(const float* colour)
+{
+    int r = osg::clampBetween(static_cast<int>(colour[0]*(31.0f/255.0f)+0.5f), 0, 31);
+    int g = osg::clampBetween(static_cast<int>(colour[1]*(63.0f/255.0f)+0.5f), 0, 63);
+    int b = osg::clampBetween(static_cast<int>(colour[2]*(31.0f/255.0f)+0.5f), 0, 31);
+    return static_cast<unsigned short>((r<<11) | (g<<5) | b);
+}
+
+inline void decode565(unsigned short c, float* colour)
+{
+    int r = (c>>11)&31;
+    int g = (c>>5)&63;
+    int b = c&31;
+    colour[0] = static_cast<float>((r<<3) | (r>>2));
+    colour[1] = static_cast<float>((g<<2) | (g>>4));
+    colour[2] = static_cast<float>((b<<3) | (b>>2));
+}
+
+struct ColourFit
+{
+    ColourFit(): c0(0), c1(0), error(FLT_MAX), threeColourMode(false) { memset(indices, 0, sizeof(indices)); }
+
+    unsigned short  c0;
+    unsigned short  c1;
+    unsigned char   indices[16];
+    float           error;
+    bool            threeColourMode;
+};
+
+/** Quantize the endpoints, then select the indices against the palette the hardware will decode from them.*/
+void evaluateColourEndpoints(const ColourBlock& block, const float* start, const float* end, bool threeColourMode, ColourFit& fit)
+{
+    fit.c0 = encode565(start);
+    fit.c1 = encode565(end);
+    fit.threeColourMode = threeColourMode;
+
+    float palette[4][3];
+    decode565(fit.c0, palette[0]);
+    decode565(fit.c1, palette[1]);
+
+    unsigned int numColours = 4;
+    if (threeColourMode)
+    {
+        for(unsigned int c=0; c<3; ++c)
+        {
+            palette[2][c] = (palette[0][c]+palette[1][c])*0.5f;
+        }
+        numColours = 3;
+    }
+    else
+    {
+        for(unsigned int c=0; c<3; ++c)
+        {
+            palette[2][c] = (2.0f*palette[0][c]+palette[1][c])/3.0f;
+            palette[3][c] = (palette[0][c]+2.0f*palette[1][c])/3.0f;
+        }
+    }
+
+    fit.error = selectColourIndices(block.r, block.g, block.b, palette, numColours, fit.indices);
+
+    if (block.numOpaque<16)
+    {
+        // transparent pixels use index 3 of the three colour mode and don't contribute to the error
+        for(unsigned int i=0; i<16; ++i)
+        {
+            if (block.transparent[i])
+            {
+                fit.indices[i] = 3;
+            }
+        }
+
+        fit.error = 0.0f;
+        for(unsigned int i=0; i<16; ++i)
+        {
+            if (block.transparent[i]) continue;
+            const float* p = palette[fit.indices[i]];
+            float dr = block.r[i]-p[0];
+            float dg = block.g[i]-p[1];
+            float db = block.b[i]-p[2];
+            fit.error += dr*dr + dg*dg + db*db;
+        }
+    }
+}
+
+/** Solve for the endpoints that minimize the squared error of the current index assignment.*/
+bool refineColourEndpoints(const ColourBlock& block, const ColourFit& fit, float* start, float* end)
+{
+    static const float weights4[4] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+    static const float weights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+    const float* weights = fit.threeColourMode ? weights3 : weights4;
+
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+    for(unsigned int i=0; i<16; ++i)
+    {
+        if (block.transparent[i]) continue;
+
+        float a = weights[fit.indices[i]];
+        float b = 1.0f-a;
+        aa += a*a;
+        ab += a*b;
+        bb += b*b;
+        ax[0] += a*block.r[i]; ax[1] += a*block.g[i]; ax[2] += a*block.b[i];
+        bx[0] += b*block.r[i]; bx[1] += b*block.g[i]; bx[2] += b*block.b[i];
+    }
+
+    float det = aa*bb - ab*ab;
+    if (fabsf(det)<1e-6f) return false;
+
+    float inv = 1.0f/det;
+    for(unsigned int c=0; c<3; ++c)
+    {
+        start[c] = osg::clampBetween((ax[c]*bb - bx[c]*ab)*inv, 0.0f, 255.0f);
+        end[c] = osg::clampBetween((bx[c]*aa - ax[c]*ab)*inv, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+void computeBoundingBoxEndpoints(const ColourBlock& block, float* start, float* end)
+{
+    float minColour[3] = { 255.0f, 255.0f, 255.0f };
+    float maxColour[3] = { 0.0f, 0.0f, 0.0f };
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for(unsigned int i=0; i<16; ++i)
+    {
+        if (block.transparent[i]) continue;
+        minColour[0] = osg::minimum(minColour[0], block.r[i]); maxColour[0] = osg::maximum(maxColour[0], block.r[i]);
+        minColour[1] = osg::minimum(minColour[1], block.g[i]); maxColour[1] = osg::maximum(maxColour[1], block.g[i]);
+        minColour[2] = osg::minimum(minColour[2], block.b[i]); maxColour[2] = osg::maximum(maxColour[2], block.b[i]);
+        mean[0] += block.r[i]; mean[1] += block.g[i]; mean[2] += block.b[i];
+    }
+    for(unsigned int c=0; c<3; ++c) mean[c] /= static_cast<float>(block.numOpaque);
+
+    // pick the diagonal of the box that follows the correlation of green and blue with red.
+    float covRG = 0.0f, covRB = 0.0f;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        if (block.transparent[i]) continue;
+        covRG += (block.r[i]-mean[0])*(block.g[i]-mean[1]);
+        covRB += (block.r[i]-mean[0])*(block.b[i]-mean[2]);
+    }
+
+    // inset the box slightly to reduce the error of the interpolated colours.
+    for(unsigned int c=0; c<3; ++c)
+    {
+        float inset = (maxColour[c]-minColour[c])/16.0f;
+        start[c] = maxColour[c]-inset;
+        end[c] = minColour[c]+inset;
+    }
+    if (covRG<0.0f) std::swap(start[1], end[1]);
+    if (covRB<0.0f) std::swap(start[2], end[2]);
+}
+
+void computePrincipalAxisEndpoints(const ColourBlock& block, float* start, float* end)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for(unsigned int i=0; i<16; ++i)
+    {
+        if (block.transparent[i]) continue;
+        mean[0] += block.r[i]; mean[1] += block.g[i]; mean[2] += block.b[i];
+    }
+    for(unsigned int c=0; c<3; ++c) mean[c] /= static_cast<float>(block.numOpaque);
+
+    float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for(unsigned int i=0; i<16; ++i)
+    {
+        if (block.transparent[i]) continue;
+        float r = block.r[i]-mean[0];
+        float g = block.g[i]-mean[1];
+        float b = block.b[i]-mean[2];
+        covariance[0] += r*r; covariance[1] += r*g; covariance[2] += r*b;
+        covariance[3] += g*g; covariance[4] += g*b; covariance[5] += b*b;
+    }
+
+    // power iteration for the dominant eigenvector of the covariance matrix.
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for(unsigned int iteration=0; iteration<8; ++iteration)
+    {
+        float x = covariance[0]*axis[0] + covariance[1]*axis[1] + covariance[2]*axis[2];
+        float y = covariance[1]*axis[0] + covariance[3]*axis[1] + covariance[4]*axis[2];
+        float z = covariance[2]*axis[0] + covariance[4]*axis[1] + covariance[5]*axis[2];
+        float length = osg::maximum(fabsf(x), osg::maximum(fabsf(y), fabsf(z)));
+        if (length<1e-6f) break;
+        axis[0] = x/length; axis[1] = y/length; axis[2] = z/length;
+    }
+
+    float minProjection = FLT_MAX, maxProjection = -FLT_MAX;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        if (block.transparent[i]) continue;
+        float projection = (block.r[i]-mean[0])*axis[0] + (block.g[i]-mean[1])*axis[1] + (block.b[i]-mean[2])*axis[2];
+        minProjection = osg::minimum(minProjection, projection);
+        maxProjection = osg::maximum(maxProjection, projection);
+    }
+
+    float lengthSquared = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    for(unsigned int c=0; c<3; ++c)
+    {
+        start[c] = osg::clampBetween(mean[c] + axis[c]*maxProjection/lengthSquared, 0.0f, 255.0f);
+        end[c] = osg::clampBetween(mean[c] + axis[c]*minProjection/lengthSquared, 0.0f, 255.0f);
+    }
+}
+
+void fitColourMode(const ColourBlock& block, const CompressionSettings& settings, bool threeColourMode, ColourFit& bestFit)
+{
+    float start[3], end[3];
+    if (settings.usePrincipalAxis) computePrincipalAxisEndpoints(block, start, end);
+    else computeBoundingBoxEndpoints(block, start, end);
+
+    ColourFit fit;
+    evaluateColourEndpoints(block, start, end, threeColourMode, fit);
+    if (fit.error<bestFit.error) bestFit = fit;
+
+    for(unsigned int iteration=0; iteration<settings.numRefinements && fit.error>0.0f; ++iteration)
+    {
+        if (!refineColourEndpoints(block, fit, start, end)) break;
+
+        ColourFit refined;
+        evaluateColourEndpoints(block, start, end, threeColourMode, refined);
+        if (refined.error>=fit.error) break;
+
+        fit = refined;
+        if (fit.error<bestFit.error) bestFit = fit;
+    }
+}
+
+void writeColourBlock(const ColourFit& fit, unsigned char* output)
+{
+    unsigned short c0 = fit.c0;
+    unsigned short c1 = fit.c1;
+    unsigned char indices[16];
+    memcpy(indices, fit.indices, sizeof(indices));
+
+    if (fit.threeColourMode)
+    {
+        // three colour mode is selected by c0<=c1
+        if (c0>c1)
+        {
+            std::swap(c0, c1);
+            for(unsigned int i=0; i<16; ++i)
+            {
+                if (indices[i]<2) indices[i] ^= 1;
+            }
+        }
+    }
+    else if (c0<c1)
+    {
+        std::swap(c0, c1);
+        for(unsigned int i=0; i<16; ++i)
+        {
+            indices[i] ^= 1;
+        }
+    }
+    else if (c0==c1)
+    {
+        memset(indices, 0, sizeof(indices));
+    }
+
+    unsigned int packedIndices = 0;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        packedIndices |= static_cast<unsigned int>(indices[i]) << (i*2);
+    }
+
+    output[0] = static_cast<unsigned char>(c0 & 0xff);
+    output[1] = static_cast<unsigned char>(c0 >> 8);
+    output[2] = static_cast<unsigned char>(c1 & 0xff);
+    output[3] = static_cast<unsigned char>(c1 >> 8);
+    output[4] = static_cast<unsigned char>(packedIndices & 0xff);
+    output[5] = static_cast<unsigned char>((packedIndices >> 8) & 0xff);
+    output[6] = static_cast<unsigned char>((packedIndices >> 16) & 0xff);
+    output[7] = static_cast<unsigned char>((packedIndices >> 24) & 0xff);
+}
+
+void compressColourBlock(const unsigned char* rgba, const CompressionSettings& settings, bool useAlpha, bool allowThreeColourMode, unsigned char* output)
+{
+    ColourBlock block;
+    block.numOpaque = 0;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        block.r[i] = rgba[i*4];
+        block.g[i] = rgba[i*4+1];
+        block.b[i] = rgba[i*4+2];
+        block.transparent[i] = useAlpha && rgba[i*4+3]<128;
+        if (!block.transparent[i]) ++block.numOpaque;
+    }
+
+    ColourFit bestFit;
+    if (block.numOpaque==0)
+    {
+        bestFit.threeColourMode = true;
+        memset(bestFit.indices, 3, sizeof(bestFit.indices));
+    }
+    else if (block.numOpaque<16)
+    {
+        fitColourMode(block, settings, true, bestFit);
+    }
+    else
+    {
+        fitColourMode(block, settings, false, bestFit);
+        if (allowThreeColourMode && settings.tryThreeColourMode && bestFit.error>0.0f)
+        {
+            fitColourMode(block, settings, true, bestFit);
+        }
+    }
+
+    writeColourBlock(bestFit, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Alpha blocks, used for DXT5 alpha and the channels of RGTC1/RGTC2
+//
+
+void computeAlphaPalette(int a0, int a1, float palette[8])
+{
+    palette[0] = static_cast<float>(a0);
+    palette[1] = static_cast<float>(a1);
+    if (a0>a1)
+    {
+        for(int i=1; i<7; ++i) palette[i+1] = static_cast<float>(((7-i)*a0 + i*a1 + 3)/7);
+    }
+    else
+    {
+        for(int i=1; i<5; ++i) palette[i+1] = static_cast<float>(((5-i)*a0 + i*a1 + 2)/5);
+        palette[6] = 0.0f;
+        palette[7] = 255.0f;
+    }
+}
+
+struct AlphaFit
+{
+    AlphaFit(): a0(0), a1(0), error(FLT_MAX) { memset(indices, 0, sizeof(indices)); }
+
+    int             a0;
+    int             a1;
+    unsigned char   indices[16];
+    float           error;
+};
+
+void evaluateAlphaEndpoints(const float* values, int a0, int a1, AlphaFit& bestFit)
+{
+    float palette[8];
+    computeAlphaPalette(a0, a1, palette);
+
+    AlphaFit fit;
+    fit.a0 = a0;
+    fit.a1 = a1;
+    fit.error = selectAlphaIndices(values, palette, fit.indices);
+    if (fit.error<bestFit.error) bestFit = fit;
+}
+
+void compressAlphaBlock(const unsigned char* rgba, unsigned int channel, const CompressionSettings& settings, unsigned char* output)
+{
+    float values[16];
+    int minValue = 255, maxValue = 0;
+    int minInner = 255, maxInner = 0;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        int value = rgba[i*4+channel];
+        values[i] = static_cast<float>(value);
+        minValue = osg::minimum(minValue, value);
+        maxValue = osg::maximum(maxValue, value);
+        if (value!=0 && value!=255)
+        {
+            minInner = osg::minimum(minInner, value);
+            maxInner = osg::maximum(maxInner, value);
+        }
+    }
+
+    AlphaFit bestFit;
+
+    // eight value mode, a0>a1, searching around the extremes of the block
+    for(int d0=0; d0<=settings.alphaSearchRadius; ++d0)
+    {
+        for(int d1=0; d1<=settings.alphaSearchRadius; ++d1)
+        {
+            int a0 = maxValue-d0;
+            int a1 = minValue+d1;
+            if (a0>a1) evaluateAlphaEndpoints(values, a0, a1, bestFit);
+        }
+    }
+
+    if (maxValue==minValue)
+    {
+        evaluateAlphaEndpoints(values, maxValue, minValue, bestFit);
+    }
+
+    // six value mode, a0<=a1, with the extremes 0 and 255 represented exactly
+    if (settings.trySixValueAlphaMode && bestFit.error>0.0f && minInner<=maxInner)
+    {
+        for(int d0=0; d0<=settings.alphaSearchRadius; ++d0)
+        {
+            for(int d1=0; d1<=settings.alphaSearchRadius; ++d1)
+            {
+                int a0 = minInner+d0;
+                int a1 = maxInner-d1;
+                if (a0<=a1) evaluateAlphaEndpoints(values, a0, a1, bestFit);
+            }
+        }
+    }
+
+    output[0] = static_cast<unsigned char>(bestFit.a0);
+    output[1] = static_cast<unsigned char>(bestFit.a1);
+
+    unsigned long long packedIndices = 0;
+    for(unsigned int i=0; i<16; ++i)
+    {
+        packedIndices |= static_cast<unsigned long long>(bestFit.indices[i]) << (i*3);
+    }
+    for(unsigned int i=0; i<6; ++i)
+    {
+        output[2+i] = static_cast<unsigned char>((packedIndices >> (i*8)) & 0xff);
+    }
+}
+
+void compressExplicitAlphaBlock(const unsigned char* rgba, unsigned char* output)
+{
+    for(unsigned int i=0; i<16; i+=2)
+    {
+        unsigned int lower = (static_cast<unsigned int>(rgba[i*4+3])*15+127)/255;
+        unsigned int upper = (static_cast<unsigned int>(rgba[(i+1)*4+3])*15+127)/255;
+        output[i/2] = static_cast<unsigned char>(lower | (upper<<4));
+    }
+}
+
+void compressBlock(const unsigned char* rgba, BlockFormat format, const CompressionSettings& settings, unsigned char* output)
+{
+    switch(format)
+    {
+        case(BLOCK_DXT1):
+            compressColourBlock(rgba, settings, false, true, output);
+            break;
+        case(BLOCK_DXT1a):
+            compressColourBlock(rgba, settings, true, true, output);
+            break;
+        case(BLOCK_DXT3):
+            compressExplicitAlphaBlock(rgba, output);
+            compressColourBlock(rgba, settings, false, false, output+8);
+            break;
+        case(BLOCK_DXT5):
+            compressAlphaBlock(rgba, 3, settings, output);
+            compressColourBlock(rgba, settings, false, false, output+8);
+            break;
+        case(BLOCK_RGTC1):
+            compressAlphaBlock(rgba, 0, settings, output);
+            break;
+        case(BLOCK_RGTC2):
+            compressAlphaBlock(rgba, 0, settings, output);
+            compressAlphaBlock(rgba, 1, settings, output+8);
+            break;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Image level handling and threading
+//
+
+struct LevelData
+{
+    const unsigned char*    rgba;
+    int                     width;
+    int                     height;
+    unsigned char*          output;
+    unsigned int            numBlocksX;
+    unsigned int            numBlocksY;
+};
+
+struct CompressionContext
+{
+    BlockFormat                 format;
+    CompressionSettings         settings;
+    unsigned int                blockSize;
+    std::vector<LevelData>      levels;
+
+    // flattened list of block rows across all the levels, handed out to the threads through nextRow
+    std::vector< std::pair<unsigned int, unsigned int> >   rows;
+    OpenThreads::Atomic         nextRow;
+};
+
+void compressBlockRow(const CompressionContext& context, const LevelData& level, unsigned int blockRow)
+{
+    unsigned char rgba[64];
+    unsigned char* output = level.output + blockRow*level.numBlocksX*context.blockSize;
+    for(unsigned int blockColumn=0; blockColumn<level.numBlocksX; ++blockColumn)
+    {
+        // gather the 4x4 block, replicating the edge pixels of levels that aren't multiples of 4.
+        for(unsigned int y=0; y<4; ++y)
+        {
+            int t = osg::minimum(static_cast<int>(blockRow*4+y), level.height-1);
+            const unsigned char* row = level.rgba + t*level.width*4;
+            for(unsigned int x=0; x<4; ++x)
+            {
+                int s = osg::minimum(static_cast<int>(blockColumn*4+x), level.width-1);
+                memcpy(rgba+(y*4+x)*4, row+s*4, 4);
+            }
+        }
+
+        compressBlock(rgba, context.format, context.settings, output);
+        output += context.blockSize;
+    }
+}
+
+void compressRows(CompressionContext& context)
+{
+    for(;;)
+    {
+        unsigned int index = (++context.nextRow) - 1;
+        if (index>=context.rows.size()) break;
+
+        const std::pair<unsigned int, unsigned int>& row = context.rows[index];
+        compressBlockRow(context, context.levels[row.first], row.second);
+    }
+}
+
+class CompressionThread : public OpenThreads::Thread
+{
+public:
+    CompressionThread(CompressionContext& context):
+        _context(context) {}
+
+    virtual void run()
+    {
+        compressRows(_context);
+    }
+
+protected:
+    CompressionContext& _context;
+};
+
+/** Expand a 2D image of any uncompressed, non packed, pixel format and type to tightly packed GL_RGBA/GL_UNSIGNED_BYTE, ignoring any mipmaps.*/
+osg::Image* createRGBAImage(const osg::Image& image)
+{
+    GLenum pixelFormat = image.getPixelFormat();
+    const unsigned char* data = image.data();
+    unsigned int rowStep = image.getRowStepInBytes();
+
+    // convert other data types to GL_UNSIGNED_BYTE first so that only the component layout needs handling below.
+    std::vector<unsigned char> converted;
+    if (image.getDataType()!=GL_UNSIGNED_BYTE)
+    {
+        rowStep = osg::Image::computeRowWidthInBytes(image.s(), pixelFormat, GL_UNSIGNED_BYTE, 1);
+        converted.resize(rowStep*image.t());
+        if (!osg::resampleImageData(pixelFormat,
+                                    image.s(), image.t(), image.getDataType(), image.data(), image.getRowStepInBytes(),
+                                    image.s(), image.t(), GL_UNSIGNED_BYTE, &converted.front(), rowStep))
+        {
+            return 0;
+        }
+        data = &converted.front();
+    }
+
+    int r = -1, g = -1, b = -1, a = -1;
+    unsigned int numComponents = 0;
+    switch(pixelFormat)
+    {
+        case(GL_RGBA): r = 0; g = 1; b = 2; a = 3; numComponents = 4; break;
+        case(GL_BGRA): r = 2; g = 1; b = 0; a = 3; numComponents = 4; break;
+        case(GL_RGB): r = 0; g = 1; b = 2; numComponents = 3; break;
+        case(GL_BGR): r = 2; g = 1; b = 0; numComponents = 3; break;
+        case(GL_RG): r = 0; g = 1; numComponents = 2; break;
+        case(GL_LUMINANCE_ALPHA): r = g = b = 0; a = 1; numComponents = 2; break;
+        case(GL_LUMINANCE):
+        case(GL_INTENSITY):
+        case(GL_RED): r = g = b = 0; numComponents = 1; break;
+        case(GL_ALPHA): a = 0; numComponents = 1; break;
+        default: return 0;
+    }
+
+    osg::ref_ptr<osg::Image> rgba = new osg::Image;
+    rgba->allocateImage(image.s(), image.t(), 1, GL_RGBA, GL_UNSIGNED_BYTE, 1);
+    if (!rgba->data()) return 0;
+
+    for(int t=0; t<image.t(); ++t)
+    {
+        const unsigned char* source = data + t*rowStep;
+        unsigned char* destination = rgba->data(0, t);
+        for(int s=0; s<image.s(); ++s)
+        {
+            destination[0] = r>=0 ? source[r] : 0;
+            destination[1] = g>=0 ? source[g] : 0;
+            destination[2] = b>=0 ? source[b] : 0;
+            destination[3] = a>=0 ? source[a] : 255;
+            source += numComponents;
+            destination += 4;
+        }
+    }
+
+    return rgba.release();
+}
+
+bool resizeToPowerOfTwo(osg::Image& image)
+{
+    int s = osg::Image::computeNearestPowerOfTwo(image.s());
+    int t = osg::Image::computeNearestPowerOfTwo(image.t());
+    if (s==image.s() && t==image.t()) return false;
+
+    image.scaleImage(s, t, image.r());
+    return true;
+}
+
+}
+
+BlockCompressionImageProcessor::BlockCompressionImageProcessor():
+    _maximumNumOfThreads(0)
+{
+}
+
+BlockCompressionImageProcessor::BlockCompressionImageProcessor(const BlockCompressionImageProcessor& rhs, const osg::CopyOp& copyop):
+    ImageProcessor(rhs, copyop),
+    _maximumNumOfThreads(rhs._maximumNumOfThreads)
+{
+}
+
+BlockCompressionImageProcessor::~BlockCompressionImageProcessor()
+{
+}
+
+bool BlockCompressionImageProcessor::isSupported(osg::Texture::InternalFormatMode compressedFormat)
+{
+    switch(compressedFormat)
+    {
+        case(osg::Texture::USE_S3TC_DXT1_COMPRESSION):
+        case(osg::Texture::USE_S3TC_DXT1c_COMPRESSION):
+        case(osg::Texture::USE_S3TC_DXT1a_COMPRESSION):
+        case(osg::Texture::USE_S3TC_DXT3_COMPRESSION):
+        case(osg::Texture::USE_S3TC_DXT5_COMPRESSION):
+        case(osg::Texture::USE_RGTC1_COMPRESSION):
+        case(osg::Texture::USE_RGTC2_COMPRESSION):
+            return true;
+        default:
+            return false;
+    }
+}
+
+void BlockCompressionImageProcessor::compress(osg::Image& image, osg::Texture::InternalFormatMode compressedFormat, bool generateMipMap, bool resizeToPowerOfTwo, CompressionMethod /*method*/, CompressionQuality quality)
+{
+    BlockFormat format;
+    switch(compressedFormat)
+    {
+        case(osg::Texture::USE_S3TC_DXT1_COMPRESSION):
+            format = hasAlpha(image.getPixelFormat()) ? BLOCK_DXT1a : BLOCK_DXT1;
+            break;
+        case(osg::Texture::USE_S3TC_DXT1c_COMPRESSION): format = BLOCK_DXT1; break;
+        case(osg::Texture::USE_S3TC_DXT1a_COMPRESSION): format = BLOCK_DXT1a; break;
+        case(osg::Texture::USE_S3TC_DXT3_COMPRESSION): format = BLOCK_DXT3; break;
+        case(osg::Texture::USE_S3TC_DXT5_COMPRESSION): format = BLOCK_DXT5; break;
+        case(osg::Texture::USE_RGTC1_COMPRESSION): format = BLOCK_RGTC1; break;
+        case(osg::Texture::USE_RGTC2_COMPRESSION): format = BLOCK_RGTC2; break;
+        default:
+            OSG_WARN<<"BlockCompressionImageProcessor::compress() : Invalid or not supported compress format"<<std::endl;
+            return;
+    }
+
+    if (!image.data() || image.isCompressed() || image.r()!=1)
+    {
+        OSG_WARN<<"BlockCompressionImageProcessor::compress() : only uncompressed 2D images can be compressed"<<std::endl;
+        return;
+    }
+
+    osg::ref_ptr<osg::Image> rgba = createRGBAImage(image);
+    if (!rgba)
+    {
+        OSG_WARN<<"BlockCompressionImageProcessor::compress() : unsupported pixel format or data type"<<std::endl;
+        return;
+    }
+
+    if (resizeToPowerOfTwo) ::resizeToPowerOfTwo(*rgba);
+
+    if (generateMipMap) osg::generateMipmaps(rgba.get());
+
+    CompressionContext context;
+    context.format = format;
+    context.settings = getCompressionSettings(quality);
+    context.blockSize = getBlockSize(format);
+
+    // lay out the compressed levels contiguously
+    unsigned int numLevels = rgba->getNumMipmapLevels();
+    osg::Image::MipmapDataType mipmapOffsets;
+    unsigned int totalSize = 0;
+    for(unsigned int i=0; i<numLevels; ++i)
+    {
+        LevelData level;
+        level.rgba = rgba->getMipmapData(i);
+        level.width = osg::maximum(rgba->s()>>i, 1);
+        level.height = osg::maximum(rgba->t()>>i, 1);
+        level.output = 0;
+        level.numBlocksX = (level.width+3)/4;
+        level.numBlocksY = (level.height+3)/4;
+        context.levels.push_back(level);
+
+        if (i>0) mipmapOffsets.push_back(totalSize);
+        totalSize += level.numBlocksX*level.numBlocksY*context.blockSize;
+    }
+
+    unsigned char* data = new unsigned char[totalSize];
+    unsigned int offset = 0;
+    unsigned int numBlocks = 0;
+    for(unsigned int i=0; i<context.levels.size(); ++i)
+    {
+        LevelData& level = context.levels[i];
+        level.output = data + offset;
+        offset += level.numBlocksX*level.numBlocksY*context.blockSize;
+        numBlocks += level.numBlocksX*level.numBlocksY;
+
+        for(unsigned int row=0; row<level.numBlocksY; ++row)
+        {
+            context.rows.push_back(std::pair<unsigned int, unsigned int>(i, row));
+        }
+    }
+
+    // only spread the work across threads when there is enough of it to amortize starting them.
+    const unsigned int minimumNumBlocksPerThread = 1024;
+    unsigned int numThreads = _maximumNumOfThreads!=0 ? _maximumNumOfThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+    numThreads = osg::clampBetween(numBlocks/minimumNumBlocksPerThread, 1u, numThreads);
+    numThreads = osg::minimum(numThreads, static_cast<unsigned int>(context.rows.size()));
+
+    std::vector<CompressionThread*> threads;
+    for(unsigned int i=1; i<numThreads; ++i)
+    {
+        CompressionThread* thread = new CompressionThread(context);
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    compressRows(context);
+
+    for(std::vector<CompressionThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+
+    GLenum pixelFormat = getCompressedPixelFormat(format);
+    image.setImage(rgba->s(), rgba->t(), 1, pixelFormat, pixelFormat, GL_UNSIGNED_BYTE, data, osg::Image::USE_NEW_DELETE);
+    image.setMipmapLevels(mipmapOffsets);
+}
+
+void BlockCompressionImageProcessor::generateMipMap(osg::Image& image, bool resizeToPowerOfTwo, CompressionMethod /*method*/)
+{
+    if (image.isMipmap()) return;
+
+    if (resizeToPowerOfTwo) ::resizeToPowerOfTwo(image);
+
+    if (!osg::generateMipmaps(&image))
+    {
+        OSG_WARN<<"BlockCompressionImageProcessor::generateMipMap() : unable to generate mipmaps for image"<<std::endl;
+    }
+}
@@ -18,14 +18,20 @@
 
 #include <osgDB/ConvertBase64>
 
-#include <sstream>
 #include <string.h>
 
+#if defined(__SSSE3__) || defined(__AVX__)
+    #define OSGDB_BASE64_USE_SSSE3 1
+    #include <tmmintrin.h>
+#endif
+
 namespace osgDB
 {
 
     const int CHARS_PER_LINE = 72;
 
+    static const char* const base64_encoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
     int base64_decode_value(char value_in)
     {
         static const signed char decoding[] = {62,-1,-1,-1,63,52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-2,-1,-1,-1,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,-1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51};
@@ -35,6 +41,89 @@ namespace osgDB
         return decoding[(int)value_in];
     }
 
+    // base64_decode_value() of every char, negative for the ones that aren't part of the encoding
+    struct Base64DecodingTable
+    {
+        Base64DecodingTable()
+        {
+            for(int i=0; i<256; ++i) values[i] = static_cast<signed char>(base64_decode_value(static_cast<char>(i)));
+        }
+
+        signed char values[256];
+    };
+
+    static const Base64DecodingTable s_base64DecodingTable;
+
+#if defined(OSGDB_BASE64_USE_SSSE3)
+    // Decode 16 chars into 12 bytes, returning false without writing anything if one of the chars
+    // isn't part of the encoding, such as a line break or padding.
+    static inline bool base64_decode_16(const unsigned char* in, unsigned char* out)
+    {
+        const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+        const __m128i lutLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i lutHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), nibbleMask);
+        __m128i lowNibbles = _mm_and_si128(chars, nibbleMask);
+
+        // a char is valid when its low and high nibbles don't share a class bit
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lutLow, lowNibbles), _mm_shuffle_epi8(lutHigh, highNibbles));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0) return false;
+
+        // map the chars to their 6 bit values, '/' being the one char sharing its high nibble with another range
+        __m128i isSlash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        __m128i values = _mm_add_epi8(chars, _mm_shuffle_epi8(lutRoll, _mm_add_epi8(isSlash, highNibbles)));
+
+        // pack the 4 x 6 bits of each 32 bit lane into 3 bytes
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+        unsigned char bytes[16];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), merged);
+        memcpy(out, bytes, 12);
+        return true;
+    }
+#endif
+
+    // Decode the whole groups of 4 valid chars at the start of the code, skipping the line breaks
+    // between them, and stop at the first group that needs the char by char state machine.
+    static void base64_decode_groups(const char*& code_in, const char* code_end, char*& plaintext_out)
+    {
+        const signed char* decoding = s_base64DecodingTable.values;
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(code_in);
+        const unsigned char* end = reinterpret_cast<const unsigned char*>(code_end);
+        unsigned char* out = reinterpret_cast<unsigned char*>(plaintext_out);
+
+        for(;;)
+        {
+#if defined(OSGDB_BASE64_USE_SSSE3)
+            while (end-in >= 16 && base64_decode_16(in, out))
+            {
+                in += 16;
+                out += 12;
+            }
+#endif
+            while (in<end && (*in=='\n' || *in=='\r')) ++in;
+
+            if (end-in < 4) break;
+
+            int a = decoding[in[0]], b = decoding[in[1]], c = decoding[in[2]], d = decoding[in[3]];
+            if ((a|b|c|d) < 0) break;
+
+            out[0] = static_cast<unsigned char>((a << 2) | (b >> 4));
+            out[1] = static_cast<unsigned char>((b << 4) | (c >> 2));
+            out[2] = static_cast<unsigned char>((c << 6) | d);
+            in += 4;
+            out += 3;
+        }
+
+        code_in = reinterpret_cast<const char*>(in);
+        plaintext_out = reinterpret_cast<char*>(out);
+    }
+
     int base64_decode_block(const char* code_in, const int length_in, char* plaintext_out, base64_decodestate* state_in)
     {
         const char* codechar = code_in;
@@ -48,6 +137,7 @@ namespace osgDB
             while (1)
             {
         case step_a:
+                base64_decode_groups(codechar, code_in+length_in, plainchar);
                 do {
                     if (codechar == code_in+length_in)
                     {
@@ -101,9 +191,73 @@ namespace osgDB
 
     char base64_encode_value(char value_in)
     {
-        static const char* encoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
         if (value_in > 63) return '=';
-        return encoding[(int)value_in];
+        return base64_encoding[(int)value_in];
+    }
+
+#if defined(OSGDB_BASE64_USE_SSSE3)
+    // Encode the first 12 of the 16 bytes read into 16 chars.
+    static inline void base64_encode_12(const unsigned char* in, char* out)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        bytes = _mm_shuffle_epi8(bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+        // split each group of 3 bytes into 4 x 6 bits, one per byte
+        __m128i high = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        __m128i low = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        __m128i values = _mm_or_si128(high, low);
+
+        // offset from each value to its char, looked up from the range the value falls in
+        const __m128i lutShift = _mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+                                               '0'-52, '0'-52, '0'-52, '+'-62, '/'-63, 'A', 0, 0);
+        __m128i range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        __m128i isUpperCase = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+        range = _mm_or_si128(range, _mm_and_si128(isUpperCase, _mm_set1_epi8(13)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi8(values, _mm_shuffle_epi8(lutShift, range)));
+    }
+#endif
+
+    // Encode the whole groups of 3 bytes at the start of the plain text, when no partial group is pending.
+    static void base64_encode_groups(const char*& plaintext_in, const char* plaintext_end, char*& code_out, base64_encodestate* state_in)
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(plaintext_in);
+        const unsigned char* end = reinterpret_cast<const unsigned char*>(plaintext_end);
+        char* out = code_out;
+        int stepcount = state_in->stepcount;
+
+        while (end-in >= 3)
+        {
+#if defined(OSGDB_BASE64_USE_SSSE3)
+            // 4 groups at a time while they leave at least one on the current line, the last group
+            // of the line being encoded below along with the line break
+            while (stepcount+4 < CHARS_PER_LINE/4 && end-in >= 16)
+            {
+                base64_encode_12(in, out);
+                in += 12;
+                out += 16;
+                stepcount += 4;
+            }
+            if (end-in < 3) break;
+#endif
+            unsigned int group = (static_cast<unsigned int>(in[0]) << 16) | (static_cast<unsigned int>(in[1]) << 8) | in[2];
+            out[0] = base64_encoding[group >> 18];
+            out[1] = base64_encoding[(group >> 12) & 0x3f];
+            out[2] = base64_encoding[(group >> 6) & 0x3f];
+            out[3] = base64_encoding[group & 0x3f];
+            in += 3;
+            out += 4;
+
+            if (++stepcount == CHARS_PER_LINE/4)
+            {
+                *out++ = '\n';
+                stepcount = 0;
+            }
+        }
+
+        state_in->stepcount = stepcount;
+        plaintext_in = reinterpret_cast<const char*>(in);
+        code_out = out;
     }
 
     int base64_encode_block(const char* plaintext_in, int length_in, char* code_out, base64_encodestate* state_in)
@@ -121,6 +275,7 @@ namespace osgDB
             while (1)
             {
         case step_A:
+                base64_encode_groups(plainchar, plaintextend, codechar, state_in);
                 if (plainchar == plaintextend)
                 {
                     state_in->result = result;
@@ -236,17 +391,20 @@ namespace osgDB
 
     void Base64encoder::encode(const char* chars_in, int length_in, std::string& code_out)
     {
-        std::stringstream stream_out;
-        {
-            std::stringstream stream_in;
-            {
-                stream_in<<std::string(chars_in, length_in);
-            }
-            stream_in.seekg(0, stream_in.beg);
-            encode(stream_in, stream_out);
-        }
-        stream_out.seekg (0, stream_out.beg);
-        code_out = stream_out.str();
+        if (length_in < 0) length_in = 0;
+
+        // 4 chars per group of 3 bytes, a line break per line, and the padding and line break of encode_end()
+        const std::string::size_type numGroups = (static_cast<std::string::size_type>(length_in)+2)/3;
+        code_out.resize(numGroups*4 + numGroups/(CHARS_PER_LINE/4) + 2);
+
+        base64_init_encodestate(&_state);
+
+        char* code = &code_out[0];
+        int codelength = encode(chars_in, length_in, code);
+        codelength += encode_end(code + codelength);
+        code_out.resize(codelength);
+
+        base64_init_encodestate(&_state);
     }
 
     int Base64decoder::decode(char value_in)
@@ -286,27 +444,27 @@ namespace osgDB
 
     char* Base64decoder::decode(const std::vector<std::string>& str_in, std::vector<unsigned int>& pos_out)
     {
-        std::stringstream stream_out;
+        // each string decodes to at most 3 bytes per 4 chars, plus the byte written ahead for a partial group
+        std::string::size_type maxSize = 1;
+        for (unsigned int i = 0; i < str_in.size(); ++i)
         {
-            std::stringstream stream_in;
+            maxSize += (str_in[i].size()/4)*3 + 3;
+        }
 
-            pos_out.resize(str_in.size());
+        // Allocate memory for use with osg::Image
+        char* allocated_out = new char[maxSize];
 
-            for (unsigned int i = 0; i < str_in.size(); ++i)
-            {
-                stream_in.clear();
-                stream_in<<str_in.at(i);
-                stream_in.seekg(0, stream_in.beg);
+        pos_out.resize(str_in.size());
 
-                decode(stream_in, stream_out);
-                pos_out.at(i) = stream_out.tellp();
-            }
+        unsigned int size = 0;
+        for (unsigned int i = 0; i < str_in.size(); ++i)
+        {
+            base64_init_decodestate(&_state);
+            size += decode(str_in[i].data(), static_cast<int>(str_in[i].size()), allocated_out + size);
+            pos_out[i] = size;
         }
 
-        // Allocate memory for use with osg::Image
-        const std::string str = stream_out.str();
-        char* allocated_out = new char[str.size()];
-        memcpy(allocated_out, str.c_str(), str.size());
+        base64_init_decodestate(&_state);
 
         return allocated_out;
     }
@@ -71,6 +71,34 @@ struct DatabasePager::DatabasePagerCompileCompletedCallback : public osgUtil::In
 };
 
 
+// Lets plugins abandon reads of requests that have become stale whilst they were being loaded.
+struct DatabasePager::DatabasePagerReadCancelCallback : public osgDB::ReadCancelCallback
+{
+    DatabasePagerReadCancelCallback(osgDB::DatabasePager* pager, osgDB::DatabasePager::DatabaseRequest* databaseRequest):
+        _pager(pager),
+        _databaseRequest(databaseRequest) {}
+
+    virtual bool isReadCancelled(const std::string& /*filename*/, const osgDB::Options* /*options*/)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        if (!_databaseRequest) return false;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+        return _pager->_done || !_databaseRequest->isRequestCurrent(_pager->_frameNumber);
+    }
+
+    // Called once the read has completed, as plugins may keep hold of the Options in the loaded subgraph.
+    void release()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _databaseRequest = 0;
+    }
+
+    OpenThreads::Mutex                                  _mutex;
+    osgDB::DatabasePager*                               _pager;
+    osg::ref_ptr<osgDB::DatabasePager::DatabaseRequest> _databaseRequest;
+};
+
 void DatabasePager::compileCompleted(DatabaseRequest* databaseRequest)
 {
     //OSG_NOTICE<<"DatabasePager::compileCompleted("<<databaseRequest<<")"<<std::endl;
@@ -854,14 +882,31 @@ void DatabasePager::DatabaseThread::run()
             //osg::Timer_t before = osg::Timer::instance()->tick();
 
 
+            osg::ref_ptr<DatabasePagerReadCancelCallback> readCancelCallback = new DatabasePagerReadCancelCallback(_pager, databaseRequest.get());
+            dr_loadOptions->setReadCancelCallback(readCancelCallback.get());
+
             // assume that readNode is thread safe...
             ReaderWriter::ReadResult rr = readFromFileCache ?
                         fileCache->readNode(fileName, dr_loadOptions.get(), false) :
                         Registry::instance()->readNode(fileName, dr_loadOptions.get(), false);
 
+            bool readCancelled = readCancelCallback->isReadCancelled(fileName, dr_loadOptions.get());
+            readCancelCallback->release();
+            dr_loadOptions->setReadCancelCallback(0);
+
             osg::ref_ptr<osg::Node> loadedModel;
             if (rr.validNode()) loadedModel = rr.getNode();
-            if (!rr.success()) OSG_WARN<<"Error in reading file "<<fileName<<" : "<<rr.statusMessage() << std::endl;
+            if (!rr.success())
+            {
+                if (readCancelled)
+                {
+                    OSG_INFO<<_name<<": Read of "<<fileName<<" cancelled : "<<rr.statusMessage() << std::endl;
+                }
+                else
+                {
+                    OSG_WARN<<"Error in reading file "<<fileName<<" : "<<rr.statusMessage() << std::endl;
+                }
+            }
 
             if (loadedModel.valid() &&
                 fileCache.valid() &&
@@ -91,6 +91,22 @@ DynamicLibrary* DynamicLibrary::loadLibrary(const std::string& libraryName)
     return NULL;
 }
 
+DynamicLibrary* DynamicLibrary::loadLibrary(const std::string& libraryName, const std::string& fullLibraryName)
+{
+    OSG_DEBUG << "DynamicLibrary::try to load library \"" << libraryName << "\" from \"" << fullLibraryName << "\"" << std::endl;
+
+    HANDLE handle = getLibraryHandle( fullLibraryName );
+    if (handle)
+    {
+        DynamicLibrary* dl = new DynamicLibrary(libraryName,handle);
+        dl->_fullName = fullLibraryName;
+        return dl;
+    }
+
+    // the library may have been moved since fullLibraryName was recorded, so look for it.
+    return loadLibrary(libraryName);
+}
+
 DynamicLibrary::HANDLE DynamicLibrary::getLibraryHandle( const std::string& libraryName)
 {
     HANDLE handle = NULL;
@@ -12,6 +12,7 @@
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
 #include <osg/Version>
+#include <osg/Notify>
 
 #include <osgDB/PluginQuery>
 
@@ -187,3 +188,44 @@ bool osgDB::outputPluginDetails(std::ostream& out, const std::string& fileName)
     }
 }
 
+bool osgDB::writePluginManifest(std::ostream& out, const FileNameList& plugins)
+{
+    std::string pluginDirectoryName = std::string("osgPlugins-")+std::string(osgGetVersion());
+
+    out<<"# OpenSceneGraph "<<osgGetVersion()<<" plugin manifest, read by Registry::readPluginManifest() or OSG_PLUGIN_MANIFEST."<<std::endl;
+    out<<"# library name<tab>library file<tab>extensions"<<std::endl;
+
+    for(FileNameList::const_iterator itr = plugins.begin();
+        itr != plugins.end();
+        ++itr)
+    {
+        osgDB::ReaderWriterInfoList infoList;
+        if (!osgDB::queryPlugin(*itr, infoList))
+        {
+            OSG_NOTICE<<"Unable to load plugin "<<*itr<<", leaving it out of the manifest."<<std::endl;
+            continue;
+        }
+
+        // the name the Registry loads the plugin by, as created by Registry::createLibraryNameForExtension().
+        out<<pluginDirectoryName<<"/"<<getSimpleFileName(*itr)<<"\t"<<getRealPath(*itr)<<"\t";
+
+        bool first = true;
+        for(osgDB::ReaderWriterInfoList::iterator rwi_itr = infoList.begin();
+            rwi_itr != infoList.end();
+            ++rwi_itr)
+        {
+            osgDB::ReaderWriter::FormatDescriptionMap& extensions = (*rwi_itr)->extensions;
+            for(osgDB::ReaderWriter::FormatDescriptionMap::iterator fdm_itr = extensions.begin();
+                fdm_itr != extensions.end();
+                ++fdm_itr)
+            {
+                if (!first) out<<" ";
+                out<<fdm_itr->first;
+                first = false;
+            }
+        }
+        out<<std::endl;
+    }
+
+    return out.good();
+}
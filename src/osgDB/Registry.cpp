@@ -31,10 +31,15 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/fstream>
 #include <osgDB/Archive>
+#include <osgDB/BlockCompressionImageProcessor>
+#include <osgDB/PluginQuery>
+
+#include <OpenThreads/Thread>
 
 #include <algorithm>
 #include <set>
 #include <memory>
+#include <sstream>
 
 #include <stdlib.h>
 
@@ -63,18 +68,30 @@ static osg::ApplicationUsageProxy Registry_e1(osg::ApplicationUsage::ENVIRONMENT
 #endif
 
 static osg::ApplicationUsageProxy Registry_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BUILD_KDTREES on/off","Enable/disable the automatic building of KdTrees for each loaded Geometry.");
+static osg::ApplicationUsageProxy Registry_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_PLUGIN_MANIFEST <file>","Plugin manifest, written by osgconv --plugin-manifest, used to find plugins without searching the library paths.");
+static osg::ApplicationUsageProxy Registry_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_PRELOAD_PLUGINS <ext>[ ext]..|ALL","Load the plugins of the listed extensions, or all the plugins of the manifest, on a background thread at startup.");
 
 
 // from MimeTypes.cpp
 extern const char* builtinMimeTypeExtMappings[];
 
 
+struct Registry::ReaderWriterTable : public osg::Referenced
+{
+    typedef std::vector<ReaderWriter*> ReaderWriters;
+    typedef std::map<std::string, ReaderWriter*> ExtensionMap;
+
+    // Raw pointers as the ReaderWriters must still be destroyed when their plugin is unloaded.
+    ReaderWriters           readerWriters;
+    ExtensionMap            extensions;
+    RegisteredProtocolsSet  protocols;
+};
+
 class Registry::AvailableReaderWriterIterator
 {
 public:
-    AvailableReaderWriterIterator(Registry::ReaderWriterList& rwList, OpenThreads::ReentrantMutex& pluginMutex):
-        _rwList(rwList),
-        _pluginMutex(pluginMutex) {}
+    AvailableReaderWriterIterator(const Registry& registry):
+        _registry(registry) {}
 
 
     ReaderWriter& operator * () { return *get(); }
@@ -92,20 +109,20 @@ protected:
 
     AvailableReaderWriterIterator& operator = (const AvailableReaderWriterIterator&) { return *this; }
 
-    Registry::ReaderWriterList&     _rwList;
-    OpenThreads::ReentrantMutex&    _pluginMutex;
+    const Registry&                 _registry;
 
     std::set<ReaderWriter*>         _rwUsed;
 
     ReaderWriter* get()
     {
-        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
-        Registry::ReaderWriterList::iterator itr=_rwList.begin();
-        for(;itr!=_rwList.end();++itr)
+        // use the latest table so that ReaderWriters of plugins loaded meanwhile are included.
+        const Registry::ReaderWriterTable* table = _registry.getReaderWriterTable();
+        Registry::ReaderWriterTable::ReaderWriters::const_iterator itr=table->readerWriters.begin();
+        for(;itr!=table->readerWriters.end();++itr)
         {
-            if (_rwUsed.find(itr->get())==_rwUsed.end())
+            if (_rwUsed.find(*itr)==_rwUsed.end())
             {
-                return itr->get();
+                return *itr;
             }
         }
         return 0;
@@ -113,6 +130,36 @@ protected:
 
 };
 
+class Registry::PreloadPluginsThread : public osg::Referenced, public OpenThreads::Thread
+{
+public:
+    PreloadPluginsThread(Registry* registry, const std::vector<std::string>& libraryNames):
+        _registry(registry),
+        _libraryNames(libraryNames) {}
+
+    virtual void run()
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        for(std::vector<std::string>::const_iterator itr=_libraryNames.begin(); itr!=_libraryNames.end(); ++itr)
+        {
+            if (_registry->loadLibrary(*itr)==NOT_LOADED)
+            {
+                OSG_INFO<<"Registry : unable to preload "<<*itr<<std::endl;
+            }
+        }
+
+        OSG_INFO<<"Registry : preloaded "<<_libraryNames.size()<<" plugins in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms"<<std::endl;
+    }
+
+protected:
+
+    virtual ~PreloadPluginsThread() {}
+
+    Registry*                   _registry;
+    std::vector<std::string>    _libraryNames;
+};
+
 class Registry::AvailableArchiveIterator
 {
 public:
@@ -224,6 +271,8 @@ Registry::Registry()
     // comment out because it was causing problems under OSX - causing it to crash osgconv when constructing ostream in osg::notify().
     // OSG_INFO << "Constructing osg::Registry"<<std::endl;
 
+    updateReaderWriterTable();
+
     _buildKdTreesHint = Options::NO_PREFERENCE;
     _kdTreeBuilder = new osg::KdTreeBuilder;
 
@@ -476,6 +525,29 @@ Registry::Registry()
 
     _objectWrapperManager = new ObjectWrapperManager;
     _deprecatedDotOsgWrapperManager = new DeprecatedDotOsgWrapperManager;
+
+    // Registry::instance() can't be used until the constructor returns, so the manifest has to be given
+    // by its path rather than being searched for.
+    const char* manifest_str = getenv("OSG_PLUGIN_MANIFEST");
+    if (manifest_str)
+    {
+        if (fileExists(manifest_str)) readPluginManifest(manifest_str);
+        else OSG_WARN<<"Registry : can't find plugin manifest \""<<manifest_str<<"\"."<<std::endl;
+    }
+
+    const char* preload_str = getenv("OSG_PRELOAD_PLUGINS");
+    if (preload_str)
+    {
+        bool preloadAll = (strcmp(preload_str, "ALL")==0 || strcmp(preload_str, "all")==0);
+
+        std::vector<std::string> extensions;
+        std::istringstream iss(preload_str);
+        std::string ext;
+        while(!preloadAll && iss >> ext) extensions.push_back(ext);
+
+        // the thread waits on the first use of Registry::instance() until the constructor has returned.
+        if (preloadAll || !extensions.empty()) preloadPlugins(extensions, true);
+    }
 }
 
 
@@ -488,6 +560,9 @@ void Registry::destruct()
 {
     // OSG_NOTICE<<"Registry::destruct()"<<std::endl;
 
+    // the plugins can't be unloaded while they are still being loaded.
+    waitForPreloadedPlugins();
+
     // clean up the SharedStateManager
     _sharedStateManager = 0;
 
@@ -614,6 +689,7 @@ void Registry::addReaderWriter(ReaderWriter* rw)
 
     _rwList.push_back(rw);
 
+    updateReaderWriterTable();
 }
 
 
@@ -629,10 +705,34 @@ void Registry::removeReaderWriter(ReaderWriter* rw)
     if (rwitr!=_rwList.end())
     {
         _rwList.erase(rwitr);
+
+        updateReaderWriterTable();
     }
 
 }
 
+void Registry::updateReaderWriterTable()
+{
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+
+    ReaderWriterTable* table = new ReaderWriterTable;
+    for(ReaderWriterList::iterator itr=_rwList.begin(); itr!=_rwList.end(); ++itr)
+    {
+        table->readerWriters.push_back(itr->get());
+    }
+    table->protocols = _registeredProtocols;
+
+    publishReaderWriterTable(table);
+}
+
+void Registry::publishReaderWriterTable(ReaderWriterTable* table)
+{
+    // Other threads may still be looking at the previous tables without holding a reference,
+    // so they are all kept until the Registry is destructed.
+    _rwTables.push_back(table);
+    _rwTable.assign(table, _rwTable.get());
+}
+
 ImageProcessor* Registry::getImageProcessor()
 {
     {
@@ -642,7 +742,14 @@ ImageProcessor* Registry::getImageProcessor()
             return _ipList.front().get();
         }
     }
-    return getImageProcessorForExtension("nvtt");
+
+    ImageProcessor* ip = getImageProcessorForExtension("nvtt");
+    if (ip) return ip;
+
+    // fallback to the built in block compressor when no ImageProcessor plugin is available
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+    if (!_defaultImageProcessor) _defaultImageProcessor = new BlockCompressionImageProcessor;
+    return _defaultImageProcessor.get();
 }
 
 ImageProcessor* Registry::getImageProcessorForExtension(const std::string& ext)
@@ -751,6 +858,122 @@ bool Registry::readPluginAliasConfigurationFile( const std::string& file )
     return true;
 }
 
+bool Registry::readPluginManifest( const std::string& file )
+{
+    std::string fileName = fileExists( file ) ? file : osgDB::findDataFile( file );
+    if (fileName.empty())
+    {
+        OSG_NOTIFY( osg::WARN) << "Can't find plugin manifest \"" << file << "\"." << std::endl;
+        return false;
+    }
+
+    osgDB::ifstream ifs;
+    ifs.open( fileName.c_str() );
+    if (!ifs.good())
+    {
+        OSG_NOTIFY( osg::WARN) << "Can't open plugin manifest \"" << fileName << "\"." << std::endl;
+        return false;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+
+    int lineNum( 0 );
+    while (ifs.good())
+    {
+        std::string raw;
+        ++lineNum;
+        std::getline( ifs, raw );
+        std::string ln = trim( raw );
+        if (ln.empty()) continue;
+        if (ln[0] == '#') continue;
+
+        // library name, library file and extensions are separated by tabs as the file may contain spaces.
+        std::string::size_type nameEnd = ln.find( '\t' );
+        std::string::size_type fileEnd = (nameEnd == ln.npos) ? ln.npos : ln.find( '\t', nameEnd+1 );
+        if (nameEnd == ln.npos)
+        {
+            OSG_NOTIFY( osg::WARN) << file << ", line " << lineNum << ": Syntax error: missing tab in \"" << raw << "\"." << std::endl;
+            continue;
+        }
+
+        const std::string libraryName = trim( ln.substr( 0, nameEnd ) );
+        const std::string libraryFile = trim( ln.substr( nameEnd+1, fileEnd == ln.npos ? ln.npos : fileEnd-nameEnd-1 ) );
+        _manifestLibraries[libraryName] = libraryFile;
+
+        if (fileEnd == ln.npos) continue;
+
+        std::istringstream extensions( ln.substr( fileEnd+1 ) );
+        std::string ext;
+        while (extensions >> ext)
+        {
+            std::vector<std::string>& libraries = _manifestExtensions[ext];
+            if (std::find( libraries.begin(), libraries.end(), libraryName ) == libraries.end()) libraries.push_back( libraryName );
+        }
+    }
+
+    OSG_INFO << "Read plugin manifest \"" << fileName << "\" of " << _manifestLibraries.size() << " plugins." << std::endl;
+    return true;
+}
+
+void Registry::preloadPlugins(const std::vector<std::string>& extensions, bool inBackground)
+{
+    std::vector<std::string> libraryNames;
+    if (extensions.empty())
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+            for(PluginManifestLibraryMap::const_iterator itr=_manifestLibraries.begin(); itr!=_manifestLibraries.end(); ++itr)
+            {
+                libraryNames.push_back(itr->first);
+            }
+        }
+
+        if (libraryNames.empty())
+        {
+            OSG_NOTICE<<"Registry::preloadPlugins() no plugin manifest to take the plugins from."<<std::endl;
+        }
+    }
+    else
+    {
+        for(std::vector<std::string>::const_iterator itr=extensions.begin(); itr!=extensions.end(); ++itr)
+        {
+            std::string libraryName = createLibraryNameForExtension(*itr);
+            if (std::find(libraryNames.begin(), libraryNames.end(), libraryName)==libraryNames.end()) libraryNames.push_back(libraryName);
+        }
+    }
+
+    if (libraryNames.empty()) return;
+
+    osg::ref_ptr<PreloadPluginsThread> thread = new PreloadPluginsThread(this, libraryNames);
+    if (inBackground)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+            _preloadPluginsThreads.push_back(thread.get());
+        }
+        thread->startThread();
+    }
+    else
+    {
+        thread->run();
+    }
+}
+
+void Registry::waitForPreloadedPlugins()
+{
+    std::vector< osg::ref_ptr<osg::Referenced> > threads;
+    {
+        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+        threads.swap(_preloadPluginsThreads);
+    }
+
+    // join without the _pluginMutex, which the threads need to load the plugins.
+    for(std::vector< osg::ref_ptr<osg::Referenced> >::iterator itr=threads.begin(); itr!=threads.end(); ++itr)
+    {
+        static_cast<PreloadPluginsThread*>(itr->get())->join();
+    }
+}
+
 std::string Registry::trim( const std::string& str )
 {
     if (!str.size()) return str;
@@ -782,17 +1005,26 @@ std::string Registry::createLibraryNameForExtension(const std::string& ext)
     std::string prepend = std::string("osgPlugins-")+std::string(osgGetVersion())+std::string("/");
 
 #if defined(__CYGWIN__)
-    return prepend+"cygwin_"+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+".dll";
+    std::string libraryName = prepend+"cygwin_"+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+".dll";
 #elif defined(__MINGW32__)
-    return prepend+"mingw_"+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+".dll";
+    std::string libraryName = prepend+"mingw_"+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+".dll";
 #elif defined(WIN32)
-    return prepend+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+".dll";
+    std::string libraryName = prepend+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+".dll";
 #elif macintosh
-    return prepend+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES;
+    std::string libraryName = prepend+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES;
 #else
-    return prepend+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+ADDQUOTES(OSG_PLUGIN_EXTENSION);
+    std::string libraryName = prepend+"osgdb_"+lowercase_ext+OSG_LIBRARY_POSTFIX_WITH_QUOTES+ADDQUOTES(OSG_PLUGIN_EXTENSION);
 #endif
 
+    // when the plugin named after the extension isn't installed, use one the manifest lists as supporting it.
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+    if (!_manifestLibraries.empty() && _manifestLibraries.count(libraryName)==0)
+    {
+        PluginManifestExtensionMap::const_iterator mitr = _manifestExtensions.find(lowercase_ext);
+        if (mitr!=_manifestExtensions.end() && !mitr->second.empty()) return mitr->second.front();
+    }
+
+    return libraryName;
 }
 
 std::string Registry::createLibraryNameForNodeKit(const std::string& name)
@@ -819,7 +1051,11 @@ Registry::LoadStatus Registry::loadLibrary(const std::string& fileName)
 
     _openingLibrary=true;
 
-    DynamicLibrary* dl = DynamicLibrary::loadLibrary(fileName);
+    // plugins listed in the manifest are opened straight from their file without searching the library file path.
+    PluginManifestLibraryMap::const_iterator mitr = _manifestLibraries.find(fileName);
+    DynamicLibrary* dl = (mitr!=_manifestLibraries.end()) ?
+        DynamicLibrary::loadLibrary(fileName, mitr->second) :
+        DynamicLibrary::loadLibrary(fileName);
     _openingLibrary=false;
 
     if (dl)
@@ -870,37 +1106,57 @@ DynamicLibrary* Registry::getLibrary(const std::string& fileName)
 
 ReaderWriter* Registry::getReaderWriterForExtension(const std::string& ext)
 {
+    // extensions that have been resolved before are found without locking.
+    {
+        const ReaderWriterTable* table = getReaderWriterTable();
+        ReaderWriterTable::ExtensionMap::const_iterator itr = table->extensions.find(ext);
+        if (itr!=table->extensions.end()) return itr->second;
+    }
+
     // record the existing reader writer.
     std::set<ReaderWriter*> rwOriginal;
 
     OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
 
+    ReaderWriter* result = NULL;
+
     // first attempt one of the installed loaders
     for(ReaderWriterList::iterator itr=_rwList.begin();
-        itr!=_rwList.end();
+        itr!=_rwList.end() && !result;
         ++itr)
     {
         rwOriginal.insert(itr->get());
-        if((*itr)->acceptsExtension(ext)) return (*itr).get();
+        if((*itr)->acceptsExtension(ext)) result = (*itr).get();
     }
 
     // now look for a plug-in to load the file.
-    std::string libraryName = createLibraryNameForExtension(ext);
-    OSG_NOTIFY(INFO) << "Now checking for plug-in "<<libraryName<< std::endl;
-    if (loadLibrary(libraryName)==LOADED)
+    if (!result)
     {
-        for(ReaderWriterList::iterator itr=_rwList.begin();
-            itr!=_rwList.end();
-            ++itr)
+        std::string libraryName = createLibraryNameForExtension(ext);
+        OSG_NOTIFY(INFO) << "Now checking for plug-in "<<libraryName<< std::endl;
+        if (loadLibrary(libraryName)==LOADED)
         {
-            if (rwOriginal.find(itr->get())==rwOriginal.end())
+            for(ReaderWriterList::iterator itr=_rwList.begin();
+                itr!=_rwList.end() && !result;
+                ++itr)
             {
-                if((*itr)->acceptsExtension(ext)) return (*itr).get();
+                if (rwOriginal.find(itr->get())==rwOriginal.end())
+                {
+                    if((*itr)->acceptsExtension(ext)) result = (*itr).get();
+                }
             }
         }
     }
 
-    return NULL;
+    if (result)
+    {
+        // publish a copy of the table that also maps the extension to the ReaderWriter.
+        ReaderWriterTable* table = new ReaderWriterTable(*getReaderWriterTable());
+        table->extensions[ext] = result;
+        publishReaderWriterTable(table);
+    }
+
+    return result;
 
 }
 
@@ -1187,7 +1443,7 @@ ReaderWriter::ReadResult Registry::read(const ReadFunctor& readFunctor)
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::ReadResult rr = readFunctor.doRead(*itr);
@@ -1343,7 +1599,7 @@ ReaderWriter::WriteResult Registry::writeObjectImplementation(const Object& obj,
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeObject(obj,fileName,options);
@@ -1389,7 +1645,7 @@ ReaderWriter::WriteResult Registry::writeImageImplementation(const Image& image,
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeImage(image,fileName,options);
@@ -1434,7 +1690,7 @@ ReaderWriter::WriteResult Registry::writeHeightFieldImplementation(const HeightF
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeHeightField(HeightField,fileName,options);
@@ -1491,7 +1747,7 @@ ReaderWriter::WriteResult Registry::writeNodeImplementation(const Node& node,con
     Results results;
 
     // first attempt to write the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeNode(node,fileName,options);
@@ -1537,7 +1793,7 @@ ReaderWriter::WriteResult Registry::writeShaderImplementation(const Shader& shad
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeShader(shader,fileName,options);
@@ -1584,7 +1840,7 @@ ReaderWriter::WriteResult Registry::writeScriptImplementation(const Script& imag
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeScript(image,fileName,options);
@@ -1707,18 +1963,26 @@ SharedStateManager* Registry::getOrCreateSharedStateManager()
 
 void Registry::registerProtocol(const std::string& protocol)
 {
-    _registeredProtocols.insert( convertToLowerCase(protocol) );
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+
+    if (_registeredProtocols.insert( convertToLowerCase(protocol) ).second)
+    {
+        updateReaderWriterTable();
+    }
 }
 
 bool Registry::isProtocolRegistered(const std::string& protocol)
 {
-    return (_registeredProtocols.find( convertToLowerCase(protocol) ) != _registeredProtocols.end());
+    const RegisteredProtocolsSet& protocols = getReaderWriterTable()->protocols;
+    return (protocols.find( convertToLowerCase(protocol) ) != protocols.end());
 }
 
 void Registry::getReaderWriterListForProtocol(const std::string& protocol, ReaderWriterList& results) const
 {
-    for(ReaderWriterList::const_iterator i = _rwList.begin(); i != _rwList.end(); ++i)
-    {        if ((*i)->acceptsProtocol(protocol))
+    const ReaderWriterTable* table = getReaderWriterTable();
+    for(ReaderWriterTable::ReaderWriters::const_iterator i = table->readerWriters.begin(); i != table->readerWriters.end(); ++i)
+    {
+        if ((*i)->acceptsProtocol(protocol))
             results.push_back(*i);
     }
 }
@@ -129,13 +129,11 @@ void XmlNode::Input::attach(std::istream& fin)
 
 void XmlNode::Input::readAllDataIntoBuffer()
 {
+    char buffer[4096];
     while(_fin)
     {
-        int c = _fin.get();
-        if (c>=0 && c<=255)
-        {
-            _buffer.push_back(c);
-        }
+        _fin.read(buffer, sizeof(buffer));
+        _buffer.append(buffer, static_cast<std::string::size_type>(_fin.gcount()));
     }
 }
 
@@ -415,7 +413,12 @@ bool XmlNode::read(Input& input)
             }
             else
             {
-                input.copyCharacterToString(contents);
+                // copy the run of characters up to the next tag or control, which can be very long
+                // for the arrays written in the .osgx format
+                while((c=input[0])>=0 && c!='<' && c!='&')
+                {
+                    input.copyCharacterToString(contents);
+                }
             }
 
         }
@@ -482,25 +485,42 @@ bool XmlNode::write(const ControlMap& controlMap, std::ostream& fout, const std:
 
 bool XmlNode::writeString(const ControlMap& controlMap, std::ostream& fout, const std::string& str) const
 {
-    for(std::string::const_iterator itr = str.begin();
-        itr != str.end();
-        ++itr)
+    std::string controlCharacters;
+    for(ControlMap::CharacterToControlMap::const_iterator citr = controlMap._characterToControlMap.begin();
+        citr != controlMap._characterToControlMap.end();
+        ++citr)
+    {
+        // only controls for the values a char converts to are ever matched
+        if (static_cast<int>(static_cast<char>(citr->first)) == citr->first) controlCharacters.push_back(static_cast<char>(citr->first));
+    }
+
+    // write the runs of characters between the ones replaced by controls in one go
+    std::string::size_type start = 0;
+    while(start < str.size())
     {
-        int c = *itr;
-        ControlMap::CharacterToControlMap::const_iterator citr = controlMap._characterToControlMap.find(c);
-        if (citr != controlMap._characterToControlMap.end()) fout << citr->second;
-        else fout.put(c);
+        std::string::size_type end = str.find_first_of(controlCharacters, start);
+        if (end == std::string::npos) end = str.size();
+
+        fout.write(str.data()+start, end-start);
+
+        if (end < str.size())
+        {
+            int c = str[end];
+            fout << controlMap._characterToControlMap.find(c)->second;
+            ++end;
+        }
+        start = end;
     }
     return true;
 }
 
-bool XmlNode::writeChildren(const ControlMap& /*controlMap*/, std::ostream& fout, const std::string& indent) const
+bool XmlNode::writeChildren(const ControlMap& controlMap, std::ostream& fout, const std::string& indent) const
 {
     for(Children::const_iterator citr = children.begin();
         citr != children.end();
         ++citr)
     {
-        if (!(*citr)->write(fout, indent))
+        if (!(*citr)->write(controlMap, fout, indent))
             return false;
     }
 
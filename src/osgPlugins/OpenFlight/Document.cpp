@@ -33,6 +33,8 @@ Document::Document() :
     _doUnitsConversion(true),
     _readObjectRecordData(false),
     _preserveNonOsgAttrsAsUserData(false),
+    _lightPointsOnGPU(false),
+    _mergeGeometry(false),
     _desiredUnits(METERS),
     _keepExternalReferences(false),
     _done(false),
@@ -63,6 +65,10 @@ void Document::pushLevel()
 
 void Document::popLevel()
 {
+    // No more faces are added below the record, so its merged geometries are complete.
+    if (!_mergedGeometryPools.empty() && !_levelStack.empty())
+        _mergedGeometryPools.erase(_levelStack.back().get());
+
     _levelStack.pop_back();
 
     if (!_levelStack.empty())
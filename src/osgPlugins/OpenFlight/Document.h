@@ -169,6 +169,9 @@ class Document
         ShaderPool* getOrCreateShaderPool();
         bool getShaderPoolParent() const { return _shaderPoolParent; }
 
+        // Merged geometries of the faces below parent, only used with the mergeGeometry option.
+        MergedGeometryPool* getOrCreateMergedGeometryPool(PrimaryRecord* parent);
+
         void setSubSurfacePolygonOffset(int level, osg::PolygonOffset* po);
         osg::PolygonOffset* getSubSurfacePolygonOffset(int level);
 
@@ -205,6 +208,12 @@ class Document
         void setPreserveNonOsgAttrsAsUserData(bool flag) { _preserveNonOsgAttrsAsUserData = flag; }
         bool getPreserveNonOsgAttrsAsUserData() const { return _preserveNonOsgAttrsAsUserData; }
 
+        void setLightPointsOnGPU(bool flag) { _lightPointsOnGPU = flag; }
+        bool getLightPointsOnGPU() const { return _lightPointsOnGPU; }
+
+        void setMergeGeometry(bool flag) { _mergeGeometry = flag; }
+        bool getMergeGeometry() const { return _mergeGeometry; }
+
     protected:
 
         // Options
@@ -219,6 +228,8 @@ class Document
         bool                        _doUnitsConversion;
         bool                        _readObjectRecordData;
         bool                        _preserveNonOsgAttrsAsUserData;
+        bool                        _lightPointsOnGPU;
+        bool                        _mergeGeometry;
         CoordUnits                  _desiredUnits;
 
         bool                        _keepExternalReferences;
@@ -242,6 +253,9 @@ class Document
         osg::ref_ptr<LightPointAnimationPool> _lightPointAnimationPool;
         osg::ref_ptr<ShaderPool> _shaderPool;
 
+        typedef std::map<PrimaryRecord*, osg::ref_ptr<MergedGeometryPool> > MergedGeometryPoolMap;
+        MergedGeometryPoolMap _mergedGeometryPools;
+
         typedef std::map<int, osg::ref_ptr<osg::PolygonOffset> > SubSurfacePolygonOffsets;
         SubSurfacePolygonOffsets _subsurfacePolygonOffsets;
         osg::ref_ptr<osg::Depth> _subsurfaceDepth;
@@ -312,6 +326,15 @@ inline ShaderPool* Document::getOrCreateShaderPool()
 }
 
 
+inline MergedGeometryPool* Document::getOrCreateMergedGeometryPool(PrimaryRecord* parent)
+{
+    osg::ref_ptr<MergedGeometryPool>& pool = _mergedGeometryPools[parent];
+    if (!pool.valid())
+        pool = new MergedGeometryPool;
+    return pool.get();
+}
+
+
 inline PrimaryRecord* Document::getTopOfLevelStack()
 {
     // Anything on the level stack?
@@ -156,6 +156,13 @@ class Face : public PrimaryRecord
     osg::ref_ptr<osg::Geode> _geode;
     osg::ref_ptr<osg::Geometry> _geometry;
 
+    // With the mergeGeometry option the vertices are collected here and the face
+    // is appended to the merged geometry of its parent in dispose().
+    bool                _mergeFace;
+    std::vector<Vertex> _vertices;
+    std::vector<uint32> _poolOffsets;
+    unsigned int        _numVertexUVs[Vertex::MAX_LAYERS];
+
 public:
 
     Face() :
@@ -164,16 +171,27 @@ public:
         _template(FIXED_NO_ALPHA_BLENDING),
         _transparency(0),
         _flags(0),
-        _lightMode(FACE_COLOR)
+        _lightMode(FACE_COLOR),
+        _mergeFace(false)
     {
+        for (int layer=0; layer<Vertex::MAX_LAYERS; layer++)
+            _numVertexUVs[layer] = 0;
     }
 
     META_Record(Face)
 
     META_setID(_geode)
-    META_setComment(_geode)
     META_setMultitexture(_geode)
 
+    virtual void setComment(const std::string& comment)
+    {
+        // Keep the comment with the face.
+        unmergeFace();
+
+        if (_geode.valid())
+            _geode->addDescription(comment);
+    }
+
     // draw mode
     enum DrawMode
     {
@@ -240,8 +258,27 @@ public:
             _parent->addChild(child);
     }
 
+    virtual void addPoolVertex(Vertex& vertex, unsigned int poolOffset)
+    {
+        if (_mergeFace)
+        {
+            _vertices.push_back(vertex);
+            _poolOffsets.push_back(poolOffset);
+            return;
+        }
+
+        addVertex(vertex);
+    }
+
     virtual void addVertex(Vertex& vertex)
     {
+        if (_mergeFace)
+        {
+            _vertices.push_back(vertex);
+            _poolOffsets.push_back(MergedGeometry::NO_POOL_OFFSET);
+            return;
+        }
+
         osg::Vec3Array* vertices = getOrCreateVertexArray(*_geometry);
         vertices->push_back(vertex._coord);
 
@@ -304,12 +341,28 @@ public:
 
     virtual void addVertexUV(int unit, const osg::Vec2& uv)
     {
+        if (_mergeFace)
+        {
+            if (unit>=0 && unit<Vertex::MAX_LAYERS && _numVertexUVs[unit]<_vertices.size())
+            {
+                // The uv isn't part of the vertex palette entry so the vertex can't be shared.
+                unsigned int index = _numVertexUVs[unit]++;
+                _vertices[index].setUV(unit,uv);
+                _poolOffsets[index] = MergedGeometry::NO_POOL_OFFSET;
+                return;
+            }
+
+            unmergeFace();
+        }
+
         osg::Vec2Array* UVs = getOrCreateTextureArray(*_geometry,unit);
         UVs->push_back(uv);
     }
 
     virtual void addMorphVertex(Vertex& vertex0, Vertex& /*vertex100*/)
     {
+        unmergeFace();
+
         osg::Vec3Array* vertices = getOrCreateVertexArray(*_geometry);
         vertices->push_back(vertex0._coord);
 
@@ -405,9 +458,20 @@ protected:
         _geode->setDataVariance(osg::Object::STATIC);
         _geode->setName(id);
 
-        _geometry = new osg::Geometry;
-        _geometry->setDataVariance(osg::Object::STATIC);
-        _geode->addDrawable(_geometry.get());
+        // Solid faces without billboarding or per face user values can share geometry with their siblings,
+        // unless the parent gives each child a meaning of its own such as a switch mask bit.
+        _mergeFace = document.getMergeGeometry() && _parent.valid() && !_parent->hasIndexedChildren() &&
+                     _template!=AXIAL_ROTATE_WITH_ALPHA_BLENDING && _template!=POINT_ROTATE_WITH_ALPHA_BLENDING &&
+                     !isHidden() && !document.getPreserveNonOsgAttrsAsUserData() &&
+                     (_drawFlag==SOLID_BACKFACED || _drawFlag==SURROUND_ALTERNATE_COLOR ||
+                      (_drawFlag==SOLID_NO_BACKFACE && !document.getReplaceDoubleSidedPolys()));
+
+        if (!_mergeFace)
+        {
+            _geometry = new osg::Geometry;
+            _geometry->setDataVariance(osg::Object::STATIC);
+            _geode->addDrawable(_geometry.get());
+        }
 
         // StateSet
         osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet;
@@ -544,11 +608,147 @@ protected:
 
         _geode->setStateSet(stateset.get());
 
-        // Add to parent.
+        // Add to parent, merged faces are added in dispose().
+        if (_parent.valid() && !_mergeFace)
+            _parent->addChild(*_geode);
+    }
+
+    // Give the face its own geometry after all, adding the vertices collected so far.
+    void unmergeFace()
+    {
+        if (!_mergeFace)
+            return;
+
+        _mergeFace = false;
+
+        _geometry = new osg::Geometry;
+        _geometry->setDataVariance(osg::Object::STATIC);
+        _geode->addDrawable(_geometry.get());
+
+        for (std::vector<Vertex>::iterator itr=_vertices.begin(); itr!=_vertices.end(); ++itr)
+            addVertex(*itr);
+
+        _vertices.clear();
+        _poolOffsets.clear();
+
         if (_parent.valid())
             _parent->addChild(*_geode);
     }
 
+    // Polygons with more than four vertices are only merged when convex, so they can be split into a triangle fan.
+    bool isConvex() const
+    {
+        unsigned int numVertices = _vertices.size();
+        if (numVertices<=4)
+            return true;
+
+        // Newell's method for the polygon normal.
+        osg::Vec3 normal;
+        for (unsigned int i=0; i<numVertices; ++i)
+        {
+            const osg::Vec3& v0 = _vertices[i]._coord;
+            const osg::Vec3& v1 = _vertices[(i+1)%numVertices]._coord;
+            normal.x() += (v0.y()-v1.y())*(v0.z()+v1.z());
+            normal.y() += (v0.z()-v1.z())*(v0.x()+v1.x());
+            normal.z() += (v0.x()-v1.x())*(v0.y()+v1.y());
+        }
+
+        for (unsigned int i=0; i<numVertices; ++i)
+        {
+            const osg::Vec3& v0 = _vertices[i]._coord;
+            const osg::Vec3& v1 = _vertices[(i+1)%numVertices]._coord;
+            const osg::Vec3& v2 = _vertices[(i+2)%numVertices]._coord;
+            if (((v1-v0)^(v2-v1))*normal < 0.0f)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool mergeFace(Document& document)
+    {
+        if (_matrix.valid() || _vertices.size()<3 || !isConvex())
+            return false;
+
+        osg::StateSet* stateset = _geode->getOrCreateStateSet();
+        setTransparencyState(document,*stateset);
+
+        bool created = false;
+        MergedGeometryPool* pool = document.getOrCreateMergedGeometryPool(_parent.get());
+        MergedGeometry* mergedGeometry = pool->getOrCreateMergedGeometry(stateset,created);
+        if (created)
+            _parent->addChild(*mergedGeometry->getGeode());
+
+        osg::Vec4 faceColor = getPrimaryColor();
+        faceColor[3] = 1.0f - getTransparency();
+
+        std::vector<unsigned int> indices(_vertices.size());
+        osg::Vec3 normal(0,0,1);
+        for (unsigned int i=0; i<_vertices.size(); ++i)
+        {
+            const Vertex& vertex = _vertices[i];
+            uint32 poolOffset = _poolOffsets[i];
+
+            // Same color rules as addVertex() and the face color binding in dispose().
+            osg::Vec4 color = (isGouraud() && vertex.validColor()) ? vertex._color : faceColor;
+
+            if (isLit())
+            {
+                // Use previous normal if the vertex has none, the vertex then depends on the face so isn't shared.
+                if (vertex.validNormal())
+                    normal = vertex._normal;
+                else
+                    poolOffset = MergedGeometry::NO_POOL_OFFSET;
+            }
+
+            indices[i] = mergedGeometry->addVertex(vertex, color, isLit() ? &normal : NULL, poolOffset);
+        }
+
+        for (unsigned int i=1; i+1<indices.size(); ++i)
+            mergedGeometry->addTriangle(indices[0],indices[i],indices[i+1]);
+
+        _vertices.clear();
+        _poolOffsets.clear();
+
+        return true;
+    }
+
+    void setTransparencyState(Document& document, osg::StateSet& stateset)
+    {
+        // Translucent image?
+        bool isImageTranslucent = false;
+        if (document.getUseTextureAlphaForTransparancyBinning())
+        {
+            for (unsigned int i=0; i<stateset.getTextureAttributeList().size(); ++i)
+            {
+                osg::StateAttribute* sa = stateset.getTextureAttribute(i,osg::StateAttribute::TEXTURE);
+                osg::Texture2D* texture = dynamic_cast<osg::Texture2D*>(sa);
+                if (texture)
+                {
+                    osg::Image* image = texture->getImage();
+                    if (image && image->isImageTranslucent())
+                        isImageTranslucent = true;
+                }
+            }
+        }
+
+        // Transparent Material?
+        bool isMaterialTransparent = false;
+        osg::Material* material = dynamic_cast<osg::Material*>(stateset.getAttribute(osg::StateAttribute::MATERIAL));
+        if (material)
+        {
+            isMaterialTransparent = material->getDiffuse(osg::Material::FRONT).a() < 0.99f;
+        }
+
+        // Enable alpha blend?
+        if (isAlphaBlend() || isTransparent() || isImageTranslucent || isMaterialTransparent)
+        {
+            static osg::ref_ptr<osg::BlendFunc> blendFunc = new osg::BlendFunc(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
+            stateset.setAttributeAndModes(blendFunc.get(), osg::StateAttribute::ON);
+            stateset.setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        }
+    }
+
     osg::PrimitiveSet::Mode getPrimitiveSetMode(int numVertices)
     {
         switch(getDrawMode())
@@ -580,6 +780,14 @@ protected:
     {
         if (_geode.valid())
         {
+            if (_mergeFace)
+            {
+                if (mergeFace(document))
+                    return;
+
+                unmergeFace();
+            }
+
             // Insert transform(s)
             if (_matrix.valid())
             {
@@ -635,40 +843,7 @@ protected:
                 addDrawableAndReverseWindingOrder( _geode.get() );
             }
 
-            osg::StateSet* stateset =  _geode->getOrCreateStateSet();
-
-            // Translucent image?
-            bool isImageTranslucent = false;
-            if (document.getUseTextureAlphaForTransparancyBinning())
-            {
-                for (unsigned int i=0; i<stateset->getTextureAttributeList().size(); ++i)
-                {
-                    osg::StateAttribute* sa = stateset->getTextureAttribute(i,osg::StateAttribute::TEXTURE);
-                    osg::Texture2D* texture = dynamic_cast<osg::Texture2D*>(sa);
-                    if (texture)
-                    {
-                        osg::Image* image = texture->getImage();
-                        if (image && image->isImageTranslucent())
-                            isImageTranslucent = true;
-                    }
-                }
-            }
-
-            // Transparent Material?
-            bool isMaterialTransparent = false;
-            osg::Material* material = dynamic_cast<osg::Material*>(stateset->getAttribute(osg::StateAttribute::MATERIAL));
-            if (material)
-            {
-                isMaterialTransparent = material->getDiffuse(osg::Material::FRONT).a() < 0.99f;
-            }
-
-            // Enable alpha blend?
-            if (isAlphaBlend() || isTransparent() || isImageTranslucent || isMaterialTransparent)
-            {
-                static osg::ref_ptr<osg::BlendFunc> blendFunc = new osg::BlendFunc(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
-                stateset->setAttributeAndModes(blendFunc.get(), osg::StateAttribute::ON);
-                stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
-            }
+            setTransparencyState(document,*_geode->getOrCreateStateSet());
 
             if (document.getUseBillboardCenter())
             {
@@ -704,17 +879,23 @@ REGISTER_FLTRECORD(Face, FACE_OP)
   */
 class VertexListRecord : public PrimaryRecord
 {
+    // Offset of the vertex currently read from the vertex palette.
+    uint32 _poolOffset;
+
 public:
 
-    VertexListRecord() {}
+    VertexListRecord() :
+        _poolOffset(0)
+    {
+    }
 
     META_Record(VertexListRecord)
 
     virtual void addVertex(Vertex& vertex)
     {
-        // forward vertex to parent.
+        // forward vertex and its palette offset to parent.
         if (_parent.valid())
-            _parent->addVertex(vertex);
+            _parent->addPoolVertex(vertex,_poolOffset);
     }
 
     virtual void addVertexUV(int layer,const osg::Vec2& uv)
@@ -741,6 +922,7 @@ protected:
             {
                 // Get position of vertex.
                 uint32 pos = in.readUInt32();
+                _poolOffset = pos;
 
                 // Get vertex from vertex pool.
                 inVP.seekg((std::istream::pos_type)pos);
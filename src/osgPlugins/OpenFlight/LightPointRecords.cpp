@@ -260,6 +260,7 @@ protected:
 
         _lpn = new osgSim::LightPointNode;
         _lpn->setName(id);
+        if (document.getLightPointsOnGPU()) _lpn->setComputeMode(osgSim::LightPointNode::COMPUTE_ON_GPU);
         _lpn->setMinPixelSize(_minPixelSize);
         _lpn->setMaxPixelSize(_maxPixelSize);
 
@@ -423,6 +424,7 @@ protected:
 
         _lpn = new osgSim::LightPointNode;
         _lpn->setName(id);
+        if (document.getLightPointsOnGPU()) _lpn->setComputeMode(osgSim::LightPointNode::COMPUTE_ON_GPU);
 
         if (_appearance.valid())
         {
@@ -494,6 +494,10 @@ protected:
             return;
         }
 
+        // The texture and its attributes are baked into a cached file.
+        flt::Registry::instance()->addDependency(pathname);
+        flt::Registry::instance()->addDependency(pathname + ".attr");
+
         // Is texture in local cache?
         osg::ref_ptr<osg::StateSet> stateset = flt::Registry::instance()->getTextureFromLocalCache(pathname);
 
@@ -904,6 +908,8 @@ protected:
                 std::string vertexProgramFilePath = osgDB::findDataFile(vertexProgramFilename,document.getOptions());
                 if (!vertexProgramFilePath.empty())
                 {
+                    flt::Registry::instance()->addDependency(vertexProgramFilePath);
+
                     osg::ref_ptr<osg::Shader> vertexShader = osgDB::readRefShaderFile(osg::Shader::VERTEX, vertexProgramFilePath);
                     if (vertexShader)
                         program->addShader( vertexShader );
@@ -918,6 +924,8 @@ protected:
                 std::string fragmentProgramFilePath = osgDB::findDataFile(fragmentProgramFilename,document.getOptions());
                 if (!fragmentProgramFilePath.empty())
                 {
+                    flt::Registry::instance()->addDependency(fragmentProgramFilePath);
+
                     osg::ref_ptr<osg::Shader> fragmentShader = osgDB::readRefShaderFile(osg::Shader::FRAGMENT, fragmentProgramFilePath);
                     if (fragmentShader)
                         program->addShader( fragmentShader );
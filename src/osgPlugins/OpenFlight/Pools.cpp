@@ -138,3 +138,98 @@ osg::Material* MaterialPool::getOrCreateMaterial(int index, const osg::Vec4& fac
 
     return material;
 }
+
+const uint32 MergedGeometry::NO_POOL_OFFSET;
+
+MergedGeometry::MergedGeometry(osg::StateSet* stateset)
+{
+    _geode = new osg::Geode;
+    _geode->setDataVariance(osg::Object::STATIC);
+    _geode->setStateSet(stateset);
+
+    _geometry = new osg::Geometry;
+    _geometry->setDataVariance(osg::Object::STATIC);
+
+    _vertices = new osg::Vec3Array;
+    _geometry->setVertexArray(_vertices.get());
+
+    _colors = new osg::Vec4Array;
+    _geometry->setColorArray(_colors.get(), osg::Array::BIND_PER_VERTEX);
+
+    _triangles = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
+    _geometry->addPrimitiveSet(_triangles.get());
+
+    _geode->addDrawable(_geometry.get());
+}
+
+unsigned int MergedGeometry::addVertex(const Vertex& vertex, const osg::Vec4& color, const osg::Vec3* normal, uint32 poolOffset)
+{
+    if (poolOffset!=NO_POOL_OFFSET)
+    {
+        VertexIndexMap::iterator itr = _vertexIndexMap.find(std::make_pair(poolOffset,color));
+        if (itr != _vertexIndexMap.end())
+            return itr->second;
+    }
+
+    unsigned int index = _vertices->size();
+    _vertices->push_back(vertex._coord);
+    _colors->push_back(color);
+
+    osg::Vec3Array* normals = dynamic_cast<osg::Vec3Array*>(_geometry->getNormalArray());
+    if (normal && !normals)
+    {
+        normals = new osg::Vec3Array;
+        _geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+    }
+    if (normals)
+    {
+        // Keep the normal array the same length as the vertex array.
+        normals->resize(index, osg::Vec3(0.0f,0.0f,1.0f));
+        normals->push_back(normal ? *normal : osg::Vec3(0.0f,0.0f,1.0f));
+    }
+
+    for (int layer=0; layer<Vertex::MAX_LAYERS; layer++)
+    {
+        if (vertex.validUV(layer))
+        {
+            osg::Vec2Array* UVs = dynamic_cast<osg::Vec2Array*>(_geometry->getTexCoordArray(layer));
+            if (!UVs)
+            {
+                UVs = new osg::Vec2Array;
+                _geometry->setTexCoordArray(layer, UVs, osg::Array::BIND_PER_VERTEX);
+            }
+            UVs->resize(index);
+            UVs->push_back(vertex._uv[layer]);
+        }
+    }
+
+    // Keep the arrays of layers this vertex doesn't use the same length as the vertex array.
+    for (unsigned int layer=0; layer<_geometry->getNumTexCoordArrays(); ++layer)
+    {
+        osg::Vec2Array* UVs = dynamic_cast<osg::Vec2Array*>(_geometry->getTexCoordArray(layer));
+        if (UVs && UVs->size()<=index)
+            UVs->resize(index+1);
+    }
+
+    if (poolOffset!=NO_POOL_OFFSET)
+        _vertexIndexMap[std::make_pair(poolOffset,color)] = index;
+
+    _geometry->dirtyBound();
+
+    return index;
+}
+
+MergedGeometry* MergedGeometryPool::getOrCreateMergedGeometry(osg::StateSet* stateset, bool& created)
+{
+    MergedGeometryMap::iterator itr = _mergedGeometryMap.find(stateset);
+    if (itr != _mergedGeometryMap.end())
+    {
+        created = false;
+        return itr->second.get();
+    }
+
+    MergedGeometry* mergedGeometry = new MergedGeometry(stateset);
+    _mergedGeometryMap[stateset] = mergedGeometry;
+    created = true;
+    return mergedGeometry;
+}
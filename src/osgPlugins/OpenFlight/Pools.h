@@ -28,7 +28,10 @@
 #include <osg/Material>
 #include <osg/Light>
 #include <osg/Program>
+#include <osg/Geode>
+#include <osg/Geometry>
 #include "Types.h"
+#include "Vertex.h"
 
 
 namespace flt {
@@ -307,6 +310,72 @@ protected:
 };
 
 
+// Geometry shared by the faces of one parent record that end up with the same state,
+// used by the mergeGeometry reader option. Faces are appended as indexed triangles and
+// a vertex palette entry referenced with the same color is only stored once.
+class MergedGeometry : public osg::Referenced
+{
+public:
+
+    static const uint32 NO_POOL_OFFSET = 0xffffffffu;
+
+    explicit MergedGeometry(osg::StateSet* stateset);
+
+    osg::Geode* getGeode() { return _geode.get(); }
+
+    // Returns the index of the vertex, normal may be NULL for unlit faces.
+    // Vertices with a poolOffset of NO_POOL_OFFSET are never shared.
+    unsigned int addVertex(const Vertex& vertex, const osg::Vec4& color, const osg::Vec3* normal, uint32 poolOffset);
+
+    void addTriangle(unsigned int i0, unsigned int i1, unsigned int i2)
+    {
+        _triangles->push_back(i0);
+        _triangles->push_back(i1);
+        _triangles->push_back(i2);
+    }
+
+protected:
+
+    virtual ~MergedGeometry() {}
+
+    osg::ref_ptr<osg::Geode>            _geode;
+    osg::ref_ptr<osg::Geometry>         _geometry;
+    osg::ref_ptr<osg::Vec3Array>        _vertices;
+    osg::ref_ptr<osg::Vec4Array>        _colors;
+    osg::ref_ptr<osg::DrawElementsUInt> _triangles;
+
+    typedef std::map<std::pair<uint32,osg::Vec4>, unsigned int> VertexIndexMap;
+    VertexIndexMap _vertexIndexMap;
+};
+
+
+// The merged geometries of one parent record, keyed on the contents of their StateSet.
+class MergedGeometryPool : public osg::Referenced
+{
+public:
+
+    MergedGeometryPool() {}
+
+    // created is set to true if a new MergedGeometry had to be added for the stateset.
+    MergedGeometry* getOrCreateMergedGeometry(osg::StateSet* stateset, bool& created);
+
+protected:
+
+    virtual ~MergedGeometryPool() {}
+
+    struct LessStateSet
+    {
+        bool operator() (const osg::ref_ptr<osg::StateSet>& lhs, const osg::ref_ptr<osg::StateSet>& rhs) const
+        {
+            return lhs->compare(*rhs,true) < 0;
+        }
+    };
+
+    typedef std::map<osg::ref_ptr<osg::StateSet>, osg::ref_ptr<MergedGeometry>, LessStateSet> MergedGeometryMap;
+    MergedGeometryMap _mergedGeometryMap;
+};
+
+
 // This object records parent palettes for external record support.
 // When an external record is parsed, this object is instantiated and populated with
 // the parent model's palettes, then stored as UserData on the ProxyNode.
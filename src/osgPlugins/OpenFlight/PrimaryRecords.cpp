@@ -195,6 +195,8 @@ public:
 
     bool hasAnimation() const { return _forwardAnim || _backwardAnim; }
 
+    virtual bool hasIndexedChildren() const { return hasAnimation(); }
+
 protected:
 
     void readRecord(RecordInputStream& in, Document& document)
@@ -626,6 +628,8 @@ public:
         }
     }
 
+    virtual bool hasIndexedChildren() const { return true; }
+
 protected:
 
     virtual ~Switch() {}
@@ -0,0 +1,323 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+//
+// OpenFlight loader for OpenSceneGraph
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include <osg/Notify>
+#include <osg/NodeVisitor>
+#include <osg/ProxyNode>
+#include <osg/Version>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
+#include <osgDB/Registry>
+
+#include "ReadCache.h"
+
+using namespace flt;
+
+namespace
+{
+
+const char EXTERNAL_DESCRIPTION[] = "OpenFlight external: ";
+
+typedef unsigned long long Hash;
+
+// FNV-1a
+inline Hash hashBytes(Hash hash, const char* data, size_t size)
+{
+    for (size_t i=0; i<size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Size and modification time of a file, or "-" if it doesn't exist.
+std::string getFileStamp(const std::string& fileName)
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat)!=0)
+        return "-";
+
+    std::ostringstream str;
+    str << static_cast<unsigned long long>(fileStat.st_size) << " " << static_cast<long long>(fileStat.st_mtime);
+    return str.str();
+}
+
+// The osgb ProxyNode serializer doesn't write the children that were loaded from file,
+// so while writing the externals are turned into plain children, their file names being
+// kept in a description that is used to restore them after reading the cache back.
+class ExternalFileNamesVisitor : public osg::NodeVisitor
+{
+public:
+
+    ExternalFileNamesVisitor() :
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {}
+
+    virtual void apply(osg::ProxyNode& node)
+    {
+        for (unsigned int pos=0; pos<node.getNumFileNames() && pos<node.getNumChildren(); pos++)
+        {
+            const std::string& fileName = node.getFileName(pos);
+            if (fileName.empty())
+                continue;
+
+            std::ostringstream description;
+            description << EXTERNAL_DESCRIPTION << pos << " " << fileName;
+            node.addDescription(description.str());
+
+            _externals.push_back(External(&node, pos, fileName));
+            node.setFileName(pos, "");
+        }
+
+        traverse(node);
+    }
+
+    // Undo the changes made to the scene graph by the traversal.
+    void restore()
+    {
+        for (Externals::iterator itr=_externals.begin(); itr!=_externals.end(); ++itr)
+        {
+            itr->node->setFileName(itr->pos, itr->fileName);
+
+            osg::Node::DescriptionList& descriptions = itr->node->getDescriptions();
+            descriptions.erase(std::remove_if(descriptions.begin(), descriptions.end(), isExternalDescription), descriptions.end());
+        }
+        _externals.clear();
+    }
+
+    static bool isExternalDescription(const std::string& description)
+    {
+        return description.compare(0, sizeof(EXTERNAL_DESCRIPTION)-1, EXTERNAL_DESCRIPTION)==0;
+    }
+
+protected:
+
+    struct External
+    {
+        External(osg::ProxyNode* n, unsigned int p, const std::string& f) : node(n), pos(p), fileName(f) {}
+
+        osg::ref_ptr<osg::ProxyNode> node;
+        unsigned int pos;
+        std::string fileName;
+    };
+
+    typedef std::vector<External> Externals;
+    Externals _externals;
+};
+
+class RestoreExternalFileNamesVisitor : public osg::NodeVisitor
+{
+public:
+
+    RestoreExternalFileNamesVisitor() :
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {}
+
+    virtual void apply(osg::ProxyNode& node)
+    {
+        osg::Node::DescriptionList& descriptions = node.getDescriptions();
+        for (osg::Node::DescriptionList::iterator itr=descriptions.begin(); itr!=descriptions.end(); ++itr)
+        {
+            if (!ExternalFileNamesVisitor::isExternalDescription(*itr))
+                continue;
+
+            std::istringstream description(itr->substr(sizeof(EXTERNAL_DESCRIPTION)-1));
+            unsigned int pos = 0;
+            description >> pos;
+            description.get();
+
+            std::string fileName;
+            std::getline(description, fileName);
+            node.setFileName(pos, fileName);
+        }
+
+        descriptions.erase(std::remove_if(descriptions.begin(), descriptions.end(), ExternalFileNamesVisitor::isExternalDescription), descriptions.end());
+
+        traverse(node);
+    }
+};
+
+} // end namespace
+
+
+ReadCache::ReadCache(const std::string& cacheDirectory, const std::string& fileName, const osgDB::Options* options)
+{
+    if (cacheDirectory.empty())
+        return;
+
+    osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin)
+        return;
+
+    Hash hash = 14695981039346656037ULL;
+
+    std::vector<char> buffer(65536);
+    while (fin)
+    {
+        fin.read(&buffer[0], buffer.size());
+        hash = hashBytes(hash, &buffer[0], static_cast<size_t>(fin.gcount()));
+    }
+
+    // The location of the file, as textures and externals are found relative to it,
+    // the options and the version of the loader change the result too.
+    std::string key = osgDB::getRealPath(fileName) + osgGetVersion();
+    if (options)
+        key += options->getOptionString();
+    hash = hashBytes(hash, key.c_str(), key.size());
+
+    char hashString[32];
+    sprintf(hashString, "%016llx", hash);
+
+    std::string baseName = osgDB::concatPaths(cacheDirectory, osgDB::getStrippedName(fileName) + "-" + hashString);
+    _cacheFileName = baseName + ".osgb";
+    _dependencyFileName = baseName + ".deps";
+}
+
+std::string ReadCache::getCacheDirectory(const osgDB::Options* options)
+{
+    if (options)
+    {
+        const std::string& optionString = options->getOptionString();
+        std::string::size_type pos = optionString.find("cacheDirectory=");
+        if (pos!=std::string::npos)
+        {
+            pos += 15;
+            std::string::size_type end = optionString.find_first_of(" \t", pos);
+            return optionString.substr(pos, end==std::string::npos ? std::string::npos : end-pos);
+        }
+    }
+
+    const char* cacheDirectory = getenv("OSG_FLT_CACHE_DIRECTORY");
+    return cacheDirectory ? std::string(cacheDirectory) : std::string();
+}
+
+osg::ref_ptr<osg::Node> ReadCache::read(const osgDB::Options* options, Registry::DependencySet* dependencies) const
+{
+    if (!valid())
+        return NULL;
+
+    // Check the files the entry was built from.
+    Registry::DependencySet entryDependencies;
+    {
+        osgDB::ifstream fin(_dependencyFileName.c_str());
+        if (!fin)
+            return NULL;
+
+        std::string line;
+        while (std::getline(fin, line))
+        {
+            std::string::size_type tab = line.find('\t');
+            if (tab==std::string::npos)
+                return NULL;
+
+            if (getFileStamp(line.substr(tab+1))!=line.substr(0, tab))
+            {
+                OSG_INFO << "flt cache: " << line.substr(tab+1) << " has changed, not using " << _cacheFileName << std::endl;
+                return NULL;
+            }
+
+            entryDependencies.insert(line.substr(tab+1));
+        }
+    }
+
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    if (!rw)
+        return NULL;
+
+    osgDB::ReaderWriter::ReadResult rr = rw->readNode(_cacheFileName, options);
+    osg::ref_ptr<osg::Node> node = rr.getNode();
+    if (!node)
+        return NULL;
+
+    RestoreExternalFileNamesVisitor rfnv;
+    node->accept(rfnv);
+
+    OSG_INFO << "flt cache: read " << _cacheFileName << std::endl;
+
+    if (dependencies)
+        dependencies->swap(entryDependencies);
+
+    return node;
+}
+
+bool ReadCache::write(osg::Node& node, const Registry::DependencySet& dependencies) const
+{
+    if (!valid())
+        return false;
+
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    if (!rw)
+        return false;
+
+    if (!osgDB::makeDirectoryForFile(_cacheFileName))
+    {
+        OSG_WARN << "flt cache: could not create directory for " << _cacheFileName << std::endl;
+        return false;
+    }
+
+    // Write to temporary files and rename them so that readers never see partial entries.
+    std::string tmpDependencyFileName = _dependencyFileName + ".tmp";
+    {
+        osgDB::ofstream fout(tmpDependencyFileName.c_str());
+        for (Registry::DependencySet::const_iterator itr=dependencies.begin(); itr!=dependencies.end(); ++itr)
+        {
+            fout << getFileStamp(*itr) << "\t" << *itr << "\n";
+        }
+        if (!fout)
+            return false;
+    }
+
+    // Images are referred to by file name, they are not duplicated in the cache.
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options("WriteImageHint=UseExternal");
+
+    std::string tmpCacheFileName = _cacheFileName + ".tmp.osgb";
+
+    ExternalFileNamesVisitor efnv;
+    node.accept(efnv);
+    osgDB::ReaderWriter::WriteResult wr = rw->writeNode(node, tmpCacheFileName, options.get());
+    efnv.restore();
+
+    if (!wr.success())
+    {
+        OSG_WARN << "flt cache: could not write " << _cacheFileName << ", " << wr.message() << std::endl;
+        remove(tmpCacheFileName.c_str());
+        remove(tmpDependencyFileName.c_str());
+        return false;
+    }
+
+    remove(_cacheFileName.c_str());
+    remove(_dependencyFileName.c_str());
+    if (rename(tmpCacheFileName.c_str(), _cacheFileName.c_str())!=0 ||
+        rename(tmpDependencyFileName.c_str(), _dependencyFileName.c_str())!=0)
+    {
+        remove(tmpCacheFileName.c_str());
+        remove(tmpDependencyFileName.c_str());
+        return false;
+    }
+
+    OSG_INFO << "flt cache: wrote " << _cacheFileName << std::endl;
+
+    return true;
+}
@@ -0,0 +1,62 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+//
+// OpenFlight loader for OpenSceneGraph
+//
+
+#ifndef FLT_READCACHE_H
+#define FLT_READCACHE_H 1
+
+#include <string>
+#include <osg/Node>
+#include <osgDB/Options>
+
+#include "Registry.h"
+
+namespace flt {
+
+// Cache of parsed OpenFlight files, stored as .osgb files in a cache directory.
+// An entry is named after a hash of the file contents and the reader options, with the
+// externals it references loaded into it. A .deps file next to it lists the size and
+// modification time of every other file read to build it (externals, textures, .attr
+// and shader files) and the entry is ignored as soon as one of them has changed.
+class ReadCache
+{
+public:
+
+    ReadCache(const std::string& cacheDirectory, const std::string& fileName, const osgDB::Options* options);
+
+    // Returns the cache directory from the cacheDirectory=<path> option or the
+    // OSG_FLT_CACHE_DIRECTORY environment variable, empty if caching is off.
+    static std::string getCacheDirectory(const osgDB::Options* options);
+
+    bool valid() const { return !_cacheFileName.empty(); }
+
+    const std::string& getCacheFileName() const { return _cacheFileName; }
+
+    // Returns NULL if there is no up to date entry, otherwise fills dependencies, when
+    // given, with the files the entry was built from.
+    osg::ref_ptr<osg::Node> read(const osgDB::Options* options, Registry::DependencySet* dependencies=NULL) const;
+
+    bool write(osg::Node& node, const Registry::DependencySet& dependencies) const;
+
+protected:
+
+    std::string _cacheFileName;
+    std::string _dependencyFileName;
+};
+
+} // end namespace
+
+#endif
@@ -33,6 +33,7 @@
 #include "DataOutputStream.h"
 #include "FltExportVisitor.h"
 #include "ExportOptions.h"
+#include "ReadCache.h"
 
 #define SERIALIZER() OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_serializerMutex)
 
@@ -177,6 +178,9 @@ public:
             osg::ref_ptr<osg::Node> external = osgDB::readRefNodeFile(filename,_options.get());
             if (external.valid())
             {
+                // An external taken from the object cache isn't read by the plugin, so add the files it was read from here.
+                flt::Registry::instance()->addDependenciesOf(osgDB::findDataFile(filename,_options.get()));
+
                 if (_cloneExternalReferences)
                     external = dynamic_cast<osg::Node*>(external->clone(osg::CopyOp(osg::CopyOp::DEEP_COPY_NODES)));
 
@@ -237,6 +241,9 @@ class FLTReaderWriter : public ReaderWriter
             supportsOption("noTextureAlphaForTransparancyBinning","Import option");
             supportsOption("readObjectRecordData","Import option");
             supportsOption("preserveNonOsgAttrsAsUserData","Import option: If present in the Options string, following OpenFlight specific attributes will be stored as UserValue: surface: <UA:SMC>, feature: <UA:FID>, IRColor: <UA:IRC>");
+            supportsOption("lightPointsOnGPU","Import option: If present in the Options string, light points are evaluated in shaders using osgSim::LightPointNode::COMPUTE_ON_GPU");
+            supportsOption("mergeGeometry","Import option: If present in the Options string, faces with the same state are appended to one indexed triangle geometry per parent as they are read, sharing the vertices of the vertex palette, instead of creating a Geode per face");
+            supportsOption("cacheDirectory=<path>","Import option: Keep the parsed files, with their externals, as .osgb files in the directory and read them from there while the files and the textures and externals they use are unchanged. The OSG_FLT_CACHE_DIRECTORY environment variable sets the default directory");
             supportsOption("noUnitsConversion","Import option");
             supportsOption("convertToFeet","Import option");
             supportsOption("convertToInches","Import option");
@@ -274,17 +281,56 @@ class FLTReaderWriter : public ReaderWriter
             std::string fileName = osgDB::findDataFile(file, options);
             if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
+            // An external of a file being read into the read cache is part of its entry.
+            flt::Registry::instance()->addDependency(fileName);
+
             // in local cache?
             {
                 osg::ref_ptr<osg::Node> node = flt::Registry::instance()->getExternalFromLocalCache(fileName);
                 if (node.valid())
+                {
+                    flt::Registry::instance()->addDependenciesOf(fileName);
                     return ReadResult(node, ReaderWriter::ReadResult::FILE_LOADED_FROM_CACHE);
+                }
             }
 
             // setting up the database path so that internally referenced file are searched for on relative paths.
             osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
             local_opt->getDatabasePathList().push_front(osgDB::getFilePath(fileName));
 
+            bool keepExternalReferences = false;
+            if (options)
+                keepExternalReferences = (options->getOptionString().find("keepExternalReferences")!=std::string::npos);
+
+            // Use the read cache, unless the file is read as an external of a file being cached
+            // or uses the palettes of its parent.
+            bool useReadCache = !keepExternalReferences &&
+                                !flt::Registry::instance()->getDependencies() &&
+                                !(options && dynamic_cast<const ParentPools*>(options->getUserData()));
+
+            ReadCache readCache(useReadCache ? ReadCache::getCacheDirectory(options) : std::string(), fileName, options);
+            if (readCache.valid())
+            {
+                flt::Registry::DependencySet dependencies;
+                osg::ref_ptr<osg::Node> node = readCache.read(local_opt.get(), &dependencies);
+                if (node.valid())
+                {
+                    flt::Registry::instance()->setDependenciesOf(fileName, dependencies);
+                    flt::Registry::instance()->addExternalToLocalCache(fileName,node.get());
+
+                    osg::ConfigureBufferObjectsVisitor cbov;
+                    node->accept(cbov);
+
+                    return ReadResult(node, ReaderWriter::ReadResult::FILE_LOADED_FROM_CACHE);
+                }
+            }
+
+            // Record the files the result depends on, for the read cache and for reading the file
+            // again from the object cache as an external of a file being cached.
+            flt::Registry::DependencySet* parentDependencies = flt::Registry::instance()->getDependencies();
+            flt::Registry::DependencySet dependencies;
+            flt::Registry::instance()->setDependencies(&dependencies);
+
             ReadResult rr;
 
             // read file
@@ -304,11 +350,6 @@ class FLTReaderWriter : public ReaderWriter
                 // add to local cache.
                 flt::Registry::instance()->addExternalToLocalCache(fileName,rr.getNode());
 
-                bool keepExternalReferences = false;
-                if (options)
-                    keepExternalReferences = (options->getOptionString().find("keepExternalReferences")!=std::string::npos);
-
-
                 if ( !keepExternalReferences )
                 {
                     OSG_DEBUG << "keepExternalReferences not found, so externals will be re-readed"<<std::endl;
@@ -325,6 +366,17 @@ class FLTReaderWriter : public ReaderWriter
                 }
             }
 
+            flt::Registry::instance()->setDependencies(parentDependencies);
+
+            if (rr.getNode())
+                flt::Registry::instance()->setDependenciesOf(fileName, dependencies);
+
+            if (parentDependencies)
+                parentDependencies->insert(dependencies.begin(), dependencies.end());
+
+            if (readCache.valid() && rr.getNode())
+                readCache.write(*rr.getNode(), dependencies);
+
             if (rr.getNode())
             {
                 osg::ConfigureBufferObjectsVisitor cbov;
@@ -379,6 +431,12 @@ class FLTReaderWriter : public ReaderWriter
                 document.setPreserveNonOsgAttrsAsUserData((options->getOptionString().find("preserveNonOsgAttrsAsUserData")!=std::string::npos));
                 OSG_DEBUG << readerMsg << "preserveNonOsgAttrsAsUserData=" << document.getPreserveNonOsgAttrsAsUserData() << std::endl;
 
+                document.setLightPointsOnGPU((options->getOptionString().find("lightPointsOnGPU")!=std::string::npos));
+                OSG_DEBUG << readerMsg << "lightPointsOnGPU=" << document.getLightPointsOnGPU() << std::endl;
+
+                document.setMergeGeometry(!document.getPreserveFace() && options->getOptionString().find("mergeGeometry")!=std::string::npos);
+                OSG_DEBUG << readerMsg << "mergeGeometry=" << document.getMergeGeometry() << std::endl;
+
                 document.setDoUnitsConversion((options->getOptionString().find("noUnitsConversion")==std::string::npos)); // default to true, unless noUnitsConversion is specified.
                 OSG_DEBUG << readerMsg << "noUnitsConversion=" << !document.getDoUnitsConversion() << std::endl;
 
@@ -84,10 +84,15 @@ public:
     virtual void setMultitexture(osg::StateSet& /*multitexture*/) {}
     virtual void addChild(osg::Node& /*child*/) {}
     virtual void addVertex(Vertex& /*vertex*/) {}
+    virtual void addPoolVertex(Vertex& vertex, unsigned int /*poolOffset*/) { addVertex(vertex); }
     virtual void addVertexUV(int /*layer*/,const osg::Vec2& /*uv*/) {}
     virtual void addMorphVertex(Vertex& /*vertex0*/, Vertex& /*vertex100*/) {}
     virtual void setMultiSwitchValueName(unsigned int /*switchSet*/, const std::string& /*name*/) {}
 
+    // True if the position of a child among its siblings has a meaning, as the mask bits of a switch
+    // or the frames of an animation have, in which case faces can't be merged into shared geometry.
+    virtual bool hasIndexedChildren() const { return false; }
+
     void setNumberOfReplications(int num) { _numberOfReplications = num; }
     void setMatrix(const osg::Matrix& matrix) { _matrix = new osg::RefMatrix(matrix); }
 
@@ -22,7 +22,8 @@
 
 using namespace flt;
 
-Registry::Registry()
+Registry::Registry() :
+    _dependencies(NULL)
 {
 }
 
@@ -22,6 +22,7 @@
 
 #include <queue>
 #include <map>
+#include <set>
 #include <osg/ref_ptr>
 #include <osgDB/ObjectCache>
 #include <osgDB/Registry>
@@ -54,6 +55,16 @@ class Registry : public osg::Referenced
         void addTextureToLocalCache(const std::string& filename, osg::StateSet* stateset);
         osg::StateSet* getTextureFromLocalCache(const std::string& filename);
 
+        // Files read while a file is parsed for the .osgb read cache, NULL when not caching.
+        typedef std::set<std::string> DependencySet;
+        void setDependencies(DependencySet* dependencies) { _dependencies = dependencies; }
+        DependencySet* getDependencies() { return _dependencies; }
+        void addDependency(const std::string& filename);
+
+        // Files each file read depended on, added again when the file is taken from a cache rather than read.
+        void setDependenciesOf(const std::string& filename, const DependencySet& dependencies);
+        void addDependenciesOf(const std::string& filename);
+
     protected:
 
         Registry();
@@ -62,6 +73,11 @@ class Registry : public osg::Referenced
         RecordProtoMap     _recordProtoMap;
 
         ExternalQueue      _externalReadQueue;
+
+        DependencySet*     _dependencies;
+
+        typedef std::map<std::string, DependencySet> DependencyMap;
+        DependencyMap      _dependenciesOf;
 };
 
 inline void Registry::addToExternalReadQueue(const std::string& filename, osg::Group* parent)
@@ -89,6 +105,26 @@ inline osg::StateSet* Registry::getTextureFromLocalCache(const std::string& file
     return dynamic_cast<osg::StateSet*>(osgDB::Registry::instance()->getFromObjectCache(filename));
 }
 
+inline void Registry::addDependency(const std::string& filename)
+{
+    if (_dependencies && !filename.empty())
+        _dependencies->insert(filename);
+}
+
+inline void Registry::setDependenciesOf(const std::string& filename, const DependencySet& dependencies)
+{
+    _dependenciesOf[filename] = dependencies;
+}
+
+inline void Registry::addDependenciesOf(const std::string& filename)
+{
+    addDependency(filename);
+
+    DependencyMap::const_iterator itr = _dependenciesOf.find(filename);
+    if (_dependencies && itr!=_dependenciesOf.end())
+        _dependencies->insert(itr->second.begin(), itr->second.end());
+}
+
 /** Proxy class for automatic registration of reader/writers with the Registry.*/
 template<class T>
 class RegisterRecordProxy
@@ -16,6 +16,7 @@
 #include <osgDB/WriteFile>
 #include <osgDB/Registry>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -303,6 +304,11 @@ void EasyCurl::setOptions(const std::string& proxyAddress, const std::string& fi
 }
 
 osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const std::string& proxyAddress, const std::string& fileName, StreamObject& sp)
+{
+    return processResponse(_curl, res, proxyAddress, fileName, sp._resultMimeType);
+}
+
+osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURL* curl, CURLcode res, const std::string& proxyAddress, const std::string& fileName, std::string& mimeType)
 {
     if (res==0)
     {
@@ -311,11 +317,11 @@ osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const st
         long code;
         if(!proxyAddress.empty())
         {
-            curl_easy_getinfo(_curl, CURLINFO_HTTP_CONNECTCODE, &code);
+            curl_easy_getinfo(curl, CURLINFO_HTTP_CONNECTCODE, &code);
         }
         else
         {
-            curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, &code);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
         }
 
         //If the code is greater than 400, there was an error
@@ -350,9 +356,9 @@ osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const st
         // Store the mime-type, if any. (Note: CURL manages the buffer returned by
         // this call.)
         char* ctbuf = NULL;
-        if ( curl_easy_getinfo(_curl, CURLINFO_CONTENT_TYPE, &ctbuf) == 0 && ctbuf )
+        if ( curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &ctbuf) == 0 && ctbuf )
         {
-            sp._resultMimeType = ctbuf;
+            mimeType = ctbuf;
         }
 
 
@@ -371,6 +377,329 @@ osgDB::ReaderWriter::ReadResult EasyCurl::processResponse(CURLcode res, const st
     }
 }
 
+#ifdef OSG_CURL_MULTI
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  MultiCurl
+//
+MultiCurl::Request::Request():
+    _httpAuthentication(0),
+    _connectTimeout(0),
+    _timeout(0),
+    _sslVerifyPeer(1L),
+    _numWaiting(0),
+    _cancelled(false),
+    _done(false),
+    _curl(0)
+{
+}
+
+MultiCurl::MultiCurl():
+    _maximumNumOfRequestsInFlight(0),
+    _done(false)
+{
+    OSG_INFO<<"MultiCurl::MultiCurl()"<<std::endl;
+
+    _multi = curl_multi_init();
+
+    // let requests to the same HTTP/2 server share a connection.
+    curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+}
+
+MultiCurl::~MultiCurl()
+{
+    OSG_INFO<<"MultiCurl::~MultiCurl()"<<std::endl;
+
+    cancel();
+
+    for(std::vector<CURL*>::iterator itr = _easyHandles.begin();
+        itr != _easyHandles.end();
+        ++itr)
+    {
+        curl_easy_cleanup(*itr);
+    }
+
+    if (_multi) curl_multi_cleanup(_multi);
+
+    _multi = 0;
+}
+
+void MultiCurl::raiseMaximumNumOfRequestsInFlight(unsigned int numRequests)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    if (numRequests<=_maximumNumOfRequestsInFlight) return;
+
+    _maximumNumOfRequestsInFlight = numRequests;
+    curl_multi_wakeup(_multi);
+}
+
+int MultiCurl::cancel()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _done = true;
+        curl_multi_wakeup(_multi);
+    }
+
+    if (isRunning()) join();
+
+    return 0;
+}
+
+size_t MultiCurl::writeCallback(void *ptr, size_t size, size_t nmemb, void *data)
+{
+    size_t realsize = size * nmemb;
+    Request* request = (Request*)data;
+
+    request->_data.append((const char*)ptr, realsize);
+
+    return realsize;
+}
+
+osgDB::ReaderWriter::ReadResult MultiCurl::read(const std::string& proxyAddress, const std::string& fileName, long connectTimeout, long timeout, long sslVerifyPeer,
+                                                std::string& data, std::string& mimeType, const osgDB::ReaderWriter::Options *options)
+{
+    const osgDB::AuthenticationMap* authenticationMap = (options && options->getAuthenticationMap()) ?
+            options->getAuthenticationMap() :
+            osgDB::Registry::instance()->getAuthenticationMap();
+
+    const osgDB::AuthenticationDetails* details = authenticationMap ?
+        authenticationMap->getAuthenticationDetails(fileName) :
+        0;
+
+    std::string userPassword;
+    long httpAuthentication = 0;
+    if (details)
+    {
+        userPassword = details->username + ":" + details->password;
+        httpAuthentication = details->httpAuthentication;
+    }
+
+    // reads may only share a transfer if it is done the same way for each of them.
+    std::stringstream key;
+    key<<fileName<<"\n"<<proxyAddress<<"\n"<<userPassword<<"\n"<<httpAuthentication<<"\n"<<sslVerifyPeer;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    if (_done) return osgDB::ReaderWriter::ReadResult::FILE_NOT_HANDLED;
+
+    osg::ref_ptr<Request> request;
+    RequestMap::iterator itr = _requestMap.find(key.str());
+    if (itr != _requestMap.end())
+    {
+        OSG_INFO<<"MultiCurl::read("<<fileName<<") sharing transfer already requested."<<std::endl;
+        request = itr->second;
+    }
+    else
+    {
+        request = new Request;
+        request->_key = key.str();
+        request->_fileName = fileName;
+        request->_proxyAddress = proxyAddress;
+        request->_userPassword = userPassword;
+        request->_httpAuthentication = httpAuthentication;
+        request->_connectTimeout = connectTimeout;
+        request->_timeout = timeout;
+        request->_sslVerifyPeer = sslVerifyPeer;
+
+        _requestMap[request->_key] = request;
+        _pendingRequests.push_back(request);
+
+        curl_multi_wakeup(_multi);
+    }
+
+    ++(request->_numWaiting);
+
+    while (!request->_done)
+    {
+        if (options && options->isReadCancelled(fileName))
+        {
+            OSG_INFO<<"MultiCurl::read("<<fileName<<") cancelled."<<std::endl;
+
+            if (--(request->_numWaiting)==0)
+            {
+                // nobody else wants the file so stop transferring it, a new request is needed to read it again.
+                request->_cancelled = true;
+
+                itr = _requestMap.find(request->_key);
+                if (itr != _requestMap.end() && itr->second==request) _requestMap.erase(itr);
+
+                curl_multi_wakeup(_multi);
+            }
+
+            return osgDB::ReaderWriter::ReadResult("read of "+fileName+" cancelled.");
+        }
+
+        // wake up regularly to check whether the read has been cancelled.
+        _completed.wait(&_mutex, 100);
+    }
+
+    if (--(request->_numWaiting)==0) data.swap(request->_data);
+    else data = request->_data;
+
+    mimeType = request->_mimeType;
+
+    return request->_result;
+}
+
+void MultiCurl::startRequest(Request* request)
+{
+    CURL* curl = 0;
+    if (_easyHandles.empty())
+    {
+        curl = curl_easy_init();
+    }
+    else
+    {
+        // the connections are owned by the multi handle, so reused handles only save on allocations.
+        curl = _easyHandles.back();
+        _easyHandles.pop_back();
+        curl_easy_reset(curl);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)request);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)request);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_URL, request->_fileName.c_str());
+
+    // use HTTP/2 where the server supports it, and wait for a connection that can be multiplexed
+    // rather than opening a new one for each request.
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+
+    if (request->_connectTimeout > 0)
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, request->_connectTimeout);
+    if (request->_timeout > 0)
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, request->_timeout);
+
+    if (!request->_proxyAddress.empty())
+    {
+        OSG_INFO<<"Setting proxy: "<<request->_proxyAddress<<std::endl;
+        curl_easy_setopt(curl, CURLOPT_PROXY, request->_proxyAddress.c_str());
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, request->_sslVerifyPeer);
+
+    if (!request->_userPassword.empty())
+        curl_easy_setopt(curl, CURLOPT_USERPWD, request->_userPassword.c_str());
+    if (request->_httpAuthentication != 0)
+        curl_easy_setopt(curl, CURLOPT_HTTPAUTH, request->_httpAuthentication);
+
+    request->_curl = curl;
+    curl_multi_add_handle(_multi, curl);
+}
+
+void MultiCurl::completeRequest(RequestList::iterator itr, const osgDB::ReaderWriter::ReadResult& result)
+{
+    osg::ref_ptr<Request> request = *itr;
+    _activeRequests.erase(itr);
+
+    if (request->_curl)
+    {
+        curl_multi_remove_handle(_multi, request->_curl);
+        _easyHandles.push_back(request->_curl);
+        request->_curl = 0;
+    }
+
+    RequestMap::iterator mitr = _requestMap.find(request->_key);
+    if (mitr != _requestMap.end() && mitr->second==request) _requestMap.erase(mitr);
+
+    request->_result = result;
+    request->_done = true;
+
+    if (request->_cancelled) request->_data.clear();
+}
+
+void MultiCurl::run()
+{
+    OSG_INFO<<"MultiCurl::run()"<<std::endl;
+
+    while(true)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+            if (_done) break;
+
+            // abort the transfers that nobody is waiting for anymore.
+            for(RequestList::iterator itr = _activeRequests.begin();
+                itr != _activeRequests.end();
+                )
+            {
+                RequestList::iterator current = itr++;
+                if ((*current)->_cancelled) completeRequest(current, osgDB::ReaderWriter::ReadResult::FILE_NOT_HANDLED);
+            }
+
+            for(RequestList::iterator itr = _pendingRequests.begin();
+                itr != _pendingRequests.end();
+                )
+            {
+                if ((*itr)->_cancelled) itr = _pendingRequests.erase(itr);
+                else ++itr;
+            }
+
+            while(!_pendingRequests.empty() && _activeRequests.size()<_maximumNumOfRequestsInFlight)
+            {
+                startRequest(_pendingRequests.front().get());
+                _activeRequests.push_back(_pendingRequests.front());
+                _pendingRequests.pop_front();
+            }
+        }
+
+        int numRunning = 0;
+        curl_multi_perform(_multi, &numRunning);
+
+        int numMessages = 0;
+        while(CURLMsg* message = curl_multi_info_read(_multi, &numMessages))
+        {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            CURL* curl = message->easy_handle;
+            CURLcode responseCode = message->data.result;
+
+            char* privateData = 0;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, &privateData);
+            Request* request = (Request*)privateData;
+
+            osgDB::ReaderWriter::ReadResult result = EasyCurl::processResponse(curl, responseCode, request->_proxyAddress, request->_fileName, request->_mimeType);
+
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+            RequestList::iterator itr = std::find(_activeRequests.begin(), _activeRequests.end(), request);
+            if (itr != _activeRequests.end()) completeRequest(itr, result);
+
+            _completed.broadcast();
+        }
+
+        curl_multi_poll(_multi, NULL, 0, 1000, NULL);
+    }
+
+    // fail the reads still waiting.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+    while(!_activeRequests.empty())
+    {
+        completeRequest(_activeRequests.begin(), osgDB::ReaderWriter::ReadResult::FILE_NOT_HANDLED);
+    }
+
+    for(RequestList::iterator itr = _pendingRequests.begin();
+        itr != _pendingRequests.end();
+        ++itr)
+    {
+        (*itr)->_done = true;
+    }
+
+    _pendingRequests.clear();
+    _requestMap.clear();
+
+    _completed.broadcast();
+}
+
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  ReaderWriterCURL
@@ -393,6 +722,9 @@ ReaderWriterCURL::ReaderWriterCURL()
     supportsOption("OSG_CURL_CONNECTTIMEOUT","Specify the connection timeout duration in seconds [default = 0 = not set].");
     supportsOption("OSG_CURL_TIMEOUT","Specify the timeout duration of the whole transfer in seconds [default = 0 = not set].");
     supportsOption("OSG_CURL_SSL_VERIFYPEER","Specify ssl verification peer [default = 1 = set].");
+#ifdef OSG_CURL_MULTI
+    supportsOption("OSG_CURL_MAX_IN_FLIGHT","Specify the maximum number of transfers run at once by the fetcher shared by all reading threads, 0 reads on a connection of the calling thread instead [default = 32].");
+#endif
 }
 
 ReaderWriterCURL::~ReaderWriterCURL()
@@ -401,6 +733,11 @@ ReaderWriterCURL::~ReaderWriterCURL()
 
     _threadCurlMap.clear();
 
+#ifdef OSG_CURL_MULTI
+    if (_multiCurl.valid()) _multiCurl->cancel();
+    _multiCurl = 0;
+#endif
+
     // clean up curl
     curl_global_cleanup();
 }
@@ -522,6 +859,24 @@ void ReaderWriterCURL::getConnectionOptions(const osgDB::ReaderWriter::Options *
 
 }
 
+unsigned int ReaderWriterCURL::getMaximumNumOfRequestsInFlight(const osgDB::ReaderWriter::Options *options) const
+{
+    if (options)
+    {
+        std::istringstream iss(options->getOptionString());
+        std::string opt;
+        while (iss >> opt)
+        {
+            int index = opt.find( "=" );
+            if( opt.substr( 0, index ) == "OSG_CURL_MAX_IN_FLIGHT" )
+                return static_cast<unsigned int>(atoi(opt.substr( index+1 ).c_str()));
+        }
+    }
+
+    const char* maxInFlight = getenv("OSG_CURL_MAX_IN_FLIGHT");
+    return maxInFlight ? static_cast<unsigned int>(atoi(maxInFlight)) : 32;
+}
+
 osgDB::ReaderWriter::ReadResult ReaderWriterCURL::readFile(ObjectType objectType, const std::string& fullFileName, const osgDB::ReaderWriter::Options *options) const
 {
     std::string fileName(fullFileName);
@@ -590,16 +945,34 @@ osgDB::ReaderWriter::ReadResult ReaderWriterCURL::readFile(ObjectType objectType
     }
 
     std::stringstream buffer;
+    std::string mimeType;
+    ReadResult curlResult;
 
-    EasyCurl::StreamObject sp(&buffer, NULL, std::string());
-    EasyCurl& easyCurl = getEasyCurl();
+#ifdef OSG_CURL_MULTI
+    unsigned int maxInFlight = getMaximumNumOfRequestsInFlight(options);
+    if (maxInFlight>0)
+    {
+        MultiCurl& multiCurl = getMultiCurl();
+        multiCurl.raiseMaximumNumOfRequestsInFlight(maxInFlight);
 
-    // setup the timeouts:
-    easyCurl.setConnectionTimeout(connectTimeout);
-    easyCurl.setTimeout(timeout);
-    easyCurl.setSSLVerifyPeer(sslVerifyPeer);
+        std::string data;
+        curlResult = multiCurl.read(proxyAddress, fileName, connectTimeout, timeout, sslVerifyPeer, data, mimeType, options);
+        buffer.str(data);
+    }
+    else
+#endif
+    {
+        EasyCurl::StreamObject sp(&buffer, NULL, std::string());
+        EasyCurl& easyCurl = getEasyCurl();
 
-    ReadResult curlResult = easyCurl.read(proxyAddress, fileName, sp, options);
+        // setup the timeouts:
+        easyCurl.setConnectionTimeout(connectTimeout);
+        easyCurl.setTimeout(timeout);
+        easyCurl.setSSLVerifyPeer(sslVerifyPeer);
+
+        curlResult = easyCurl.read(proxyAddress, fileName, sp, options);
+        mimeType = easyCurl.getResultMimeType(sp);
+    }
 
     if (curlResult.status()==ReadResult::FILE_LOADED)
     {
@@ -614,7 +987,6 @@ osgDB::ReaderWriter::ReadResult ReaderWriterCURL::readFile(ObjectType objectType
         // mime-type:
         if ( !reader )
         {
-            std::string mimeType = easyCurl.getResultMimeType(sp);
             OSG_INFO << "CURL: Looking up extension for mime-type " << mimeType << std::endl;
             if ( mimeType.length() > 0 )
             {
@@ -17,6 +17,16 @@
 #include <osgDB/ReaderWriter>
 #include <osgDB/FileNameUtils>
 
+#include <OpenThreads/Condition>
+#include <OpenThreads/Thread>
+
+#include <list>
+
+// curl_multi_poll() and curl_multi_wakeup() were added in 7.68.0
+#if LIBCURL_VERSION_NUM >= 0x074400
+    #define OSG_CURL_MULTI 1
+#endif
+
 namespace osg_curl
 {
 
@@ -76,6 +86,9 @@ class EasyCurl : public osg::Referenced
         std::string getMimeTypeForExtension(const std::string& ext) const;
         static std::string getFileNameFromURL(const std::string& url);
 
+        /** Convert the result of a transfer done with curl to a ReadResult, returning the mime type of the retrieved data in mimeType.*/
+        static osgDB::ReaderWriter::ReadResult processResponse(CURL* curl, CURLcode responseCode, const std::string& proxyAddress, const std::string& fileName, std::string& mimeType);
+
     protected:
 
         virtual ~EasyCurl();
@@ -96,6 +109,84 @@ class EasyCurl : public osg::Referenced
         long            _sslVerifyPeer;
 };
 
+#ifdef OSG_CURL_MULTI
+
+/** Fetches the files read by all the threads using the plugin, typically the DatabasePager's http threads, over a single
+  * curl multi handle serviced by its own thread. The connections are kept open between requests and, with servers
+  * supporting HTTP/2, requests to the same host are multiplexed over one connection rather than each paying for its own.
+  * At most getMaximumNumOfRequestsInFlight() transfers run at once, the others being queued in request order. Concurrent
+  * reads of the same URL share a single transfer, and reads whose Options report them as cancelled return immediately,
+  * their transfer being aborted once no other read is waiting on it.*/
+class MultiCurl : public osg::Referenced, public OpenThreads::Thread
+{
+    public:
+
+        MultiCurl();
+
+        /** Raise the maximum number of transfers run at once to numRequests. The reads sharing the MultiCurl may
+          * pass different limits in their Options, the largest of those requested so far being kept rather than
+          * the limit changing with each read.*/
+        void raiseMaximumNumOfRequestsInFlight(unsigned int numRequests);
+        unsigned int getMaximumNumOfRequestsInFlight() const { return _maximumNumOfRequestsInFlight; }
+
+        /** Perform HTTP GET to download data from web server, blocking the calling thread till the transfer has completed or the read is cancelled.*/
+        osgDB::ReaderWriter::ReadResult read(const std::string& proxyAddress, const std::string& fileName, long connectTimeout, long timeout, long sslVerifyPeer,
+                                             std::string& data, std::string& mimeType, const osgDB::ReaderWriter::Options *options);
+
+        /** Stop the fetching thread, failing any outstanding reads.*/
+        virtual int cancel();
+
+        virtual void run();
+
+    protected:
+
+        virtual ~MultiCurl();
+
+        struct Request : public osg::Referenced
+        {
+            Request();
+
+            std::string     _key;
+            std::string     _fileName;
+            std::string     _proxyAddress;
+            std::string     _userPassword;
+            long            _httpAuthentication;
+            long            _connectTimeout;
+            long            _timeout;
+            long            _sslVerifyPeer;
+
+            unsigned int    _numWaiting;
+            bool            _cancelled;
+            bool            _done;
+            CURL*           _curl;
+
+            std::string     _data;
+            std::string     _mimeType;
+            osgDB::ReaderWriter::ReadResult _result;
+        };
+
+        typedef std::map< std::string, osg::ref_ptr<Request> >  RequestMap;
+        typedef std::list< osg::ref_ptr<Request> >              RequestList;
+
+        static size_t writeCallback(void *ptr, size_t size, size_t nmemb, void *data);
+
+        void startRequest(Request* request);
+        void completeRequest(RequestList::iterator itr, const osgDB::ReaderWriter::ReadResult& result);
+
+        CURLM*                  _multi;
+        std::vector<CURL*>      _easyHandles;
+
+        OpenThreads::Mutex      _mutex;
+        OpenThreads::Condition  _completed;
+        unsigned int            _maximumNumOfRequestsInFlight;
+        RequestMap              _requestMap;
+        RequestList             _pendingRequests;
+        RequestList             _activeRequests;
+        bool                    _done;
+};
+
+#endif
+
 
 class ReaderWriterCURL : public osgDB::ReaderWriter
 {
@@ -171,15 +262,36 @@ class ReaderWriterCURL : public osgDB::ReaderWriter
             return *ec;
         }
 
+#ifdef OSG_CURL_MULTI
+        MultiCurl& getMultiCurl() const
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex>  lock(_threadCurlMapMutex);
+
+            if (!_multiCurl)
+            {
+                _multiCurl = new MultiCurl;
+                _multiCurl->startThread();
+            }
+
+            return *_multiCurl;
+        }
+#endif
+
         bool read(std::istream& fin, std::string& destination) const;
 
     protected:
         void getConnectionOptions(const osgDB::ReaderWriter::Options *options, std::string& proxyAddress, long& connectTimeout, long& timeout, long& sslVerifyPeer) const;
 
+        unsigned int getMaximumNumOfRequestsInFlight(const osgDB::ReaderWriter::Options *options) const;
+
         typedef std::map< OpenThreads::Thread*, osg::ref_ptr<EasyCurl> >    ThreadCurlMap;
 
         mutable OpenThreads::Mutex          _threadCurlMapMutex;
         mutable ThreadCurlMap               _threadCurlMap;
+
+#ifdef OSG_CURL_MULTI
+        mutable osg::ref_ptr<MultiCurl>     _multiCurl;
+#endif
 };
 
 }
@@ -412,6 +412,16 @@ static unsigned int ComputeImageSizeInBytes( int width, int height, int depth,
     return osg::Image::computeImageSizeInBytes(width, height, depth, pixelFormat, pixelType, packing, slice_packing, image_packing);
 }
 
+// Read numRows rows of rowSize bytes, placing the first row read at the bottom of data.
+static bool ReadFlippedRows(std::istream& _istream, unsigned char* data, unsigned int rowSize, int numRows)
+{
+    for(int row = numRows-1; row >= 0; --row)
+    {
+        if (!_istream.read( (char*)data + row*rowSize, rowSize )) return false;
+    }
+    return true;
+}
+
 osg::Image* ReadDDSFile(std::istream& _istream, bool flipDDSRead)
 {
     DDSURFACEDESC2 ddsd;
@@ -1001,60 +1011,92 @@ osg::Image* ReadDDSFile(std::istream& _istream, bool flipDDSRead)
         }
     }
 
-    unsigned char* imageData = new unsigned char [sizeWithMipmaps];
+    const bool paletted = (ddsd.ddpfPixelFormat.dwFlags & DDPF_PALETTEINDEXED8)!=0;
+
+    // paletted images are expanded to 4 bytes per pixel, their indices are read into the last quarter of
+    // the image data and expanded in place from the front, so no intermediate buffer is needed.
+    unsigned int allocatedSize = paletted ? sizeWithMipmaps*4 : sizeWithMipmaps;
+    unsigned char* imageData = new unsigned char [allocatedSize];
     if(!imageData)
     {
         OSG_WARN << "ReadDDSFile warning: imageData == NULL" << std::endl;
         return NULL;
     }
+    unsigned char* readData = imageData + (allocatedSize - sizeWithMipmaps);
+
+    // uncompressed 2D images are flipped while reading, by reading each row straight into its flipped position.
+    bool flipWhileReading = flipDDSRead && !paletted && r==1 && !osg::Texture::isCompressedInternalFormat(pixelFormat);
 
     // Read pixels in two chunks. First main image, next mipmaps.
-    if ( !_istream.read( (char*)imageData, size ) )
+    bool readSucceeded = flipWhileReading ?
+        ReadFlippedRows(_istream, readData, osg::Image::computeRowWidthInBytes(s, pixelFormat, dataType, packing), t) :
+        !_istream.read( (char*)readData, size ).fail();
+
+    if ( !readSucceeded )
     {
         delete [] imageData;
         OSG_WARN << "ReadDDSFile warning: couldn't read imageData" << std::endl;
         return NULL;
     }
 
-    // If loading mipmaps in second chunk fails we may still use main image
-    if ( size < sizeWithMipmaps && !_istream.read( (char*)imageData + size, sizeWithMipmaps - size ) )
+    if ( size < sizeWithMipmaps )
     {
-        sizeWithMipmaps = size;
-        mipmap_offsets.resize( 0 );
-        OSG_WARN << "ReadDDSFile warning: couldn't read mipmapData" << std::endl;
+        if (flipWhileReading)
+        {
+            int mip_width = s;
+            int mip_height = t;
+            for( unsigned int k = 0; k < mipmap_offsets.size() && readSucceeded; ++k )
+            {
+                mip_width = osg::maximum( mip_width >> 1, 1 );
+                mip_height = osg::maximum( mip_height >> 1, 1 );
+                readSucceeded = ReadFlippedRows(_istream, readData + mipmap_offsets[k], osg::Image::computeRowWidthInBytes(mip_width, pixelFormat, dataType, packing), mip_height);
+            }
+        }
+        else
+        {
+            readSucceeded = !_istream.read( (char*)readData + size, sizeWithMipmaps - size ).fail();
+        }
+
+        // If loading mipmaps in second chunk fails we may still use main image
+        if ( !readSucceeded )
+        {
+            sizeWithMipmaps = size;
+            mipmap_offsets.resize( 0 );
+            OSG_WARN << "ReadDDSFile warning: couldn't read mipmapData" << std::endl;
 
-        // if mipmaps read failed we leave some not used overhead memory allocated past main image
-        // this memory will not be used but it will not cause leak in worst meaning of this word.
+            // if mipmaps read failed we leave some not used overhead memory allocated past main image
+            // this memory will not be used but it will not cause leak in worst meaning of this word.
+        }
     }
 
-    if (ddsd.ddpfPixelFormat.dwFlags & DDPF_PALETTEINDEXED8)
+    if (paletted)
     {
-        // Now we need to substitute the indexed image data with full RGBA image data.
-        unsigned char* convertedData = new unsigned char [sizeWithMipmaps * 4];
+        // Now we need to substitute the indexed image data with full RGBA image data, each index is read
+        // before the 4 bytes it expands to can overwrite it.
+        unsigned int palette32[256];
+        memcpy(palette32, palette, sizeof(palette32));
         for (unsigned int i = 0; i < sizeWithMipmaps; i++)
         {
-            convertedData[i * 4 + 0] = palette[imageData[i] * 4 + 0];
-            convertedData[i * 4 + 1] = palette[imageData[i] * 4 + 1];
-            convertedData[i * 4 + 2] = palette[imageData[i] * 4 + 2];
-            convertedData[i * 4 + 3] = palette[imageData[i] * 4 + 3];
+            unsigned int index = readData[i];
+            memcpy(imageData + i * 4, palette32 + index, 4);
         }
-        delete [] imageData;
         for (unsigned int i = 0; i < mipmap_offsets.size(); i++)
             mipmap_offsets[i] *= 4;
         internalFormat = GL_RGBA;
         pixelFormat = GL_RGBA;
-        osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, convertedData, osg::Image::USE_NEW_DELETE, packing);
-    }
-    else
-    {
-        osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, imageData, osg::Image::USE_NEW_DELETE, packing);
     }
 
+    osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, imageData, osg::Image::USE_NEW_DELETE, packing);
+
     if (mipmap_offsets.size()>0) osgImage->setMipmapLevels(mipmap_offsets);
 
     if (flipDDSRead) {
         osgImage->setOrigin(osg::Image::BOTTOM_LEFT);
-        if (!isDXTC || ((s>4 && s%4==0 && t>4 && t%4==0) || s<=4)) // Flip may crash (access violation) or fail for non %4 dimensions (except for s<4). Tested with revision trunk 2013-02-22.
+        if (flipWhileReading)
+        {
+            OSG_INFO<<"Flipped dds rows while loading"<<std::endl;
+        }
+        else if (!isDXTC || t<=4 || t%4==0) // DXTC blocks can only be flipped when the height is a multiple of 4, or fits in one row of blocks.
         {
             OSG_INFO<<"Flipping dds on load"<<std::endl;
             osgImage->flipVertical();
@@ -1317,9 +1359,8 @@ bool WriteDDSFile(const osg::Image *img, std::ostream& fout, bool autoFlipDDSWri
         OSG_INFO<<"Flipping dds image on write"<<std::endl;
 
         osg::ref_ptr<osg::Image> copy( new osg::Image(*img,osg::CopyOp::DEEP_COPY_ALL) );
-        const int s(copy->s());
         const int t(copy->t());
-        if (!isDXTC || ((s>4 && s%4==0 && t>4 && t%4==0) || s<=4)) // Flip may crash (access violation) or fail for non %4 dimensions (except for s<4). Tested with revision trunk 2013-02-22.
+        if (!isDXTC || t<=4 || t%4==0) // DXTC blocks can only be flipped when the height is a multiple of 4, or fits in one row of blocks.
         {
             copy->flipVertical();
         }
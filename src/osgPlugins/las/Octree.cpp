@@ -0,0 +1,879 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <float.h>
+#include <math.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/Notify>
+#include <osg/PagedLOD>
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
+
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Thread>
+
+#include <liblas/liblas.hpp>
+#include <liblas/reader.hpp>
+#include <liblas/point.hpp>
+
+#include "Octree.h"
+
+using namespace las;
+
+namespace
+{
+
+const char INDEX_MAGIC[8] = { 'O', 'S', 'G', 'L', 'A', 'S', 'O', 'T' };
+const unsigned int INDEX_VERSION = 1;
+
+// The points are counted on a grid of at most 2^16 cells along each axis, so that the cell codes fit in 48 bits.
+const unsigned int MAXIMUM_LEVEL = 16;
+
+// Number of points a build thread buffers before writing them to the index file.
+const unsigned int MAXIMUM_BUFFERED_POINTS = 1<<20;
+
+// Each thread decodes at least this many points, so that small files aren't split across threads.
+const unsigned long long MINIMUM_POINTS_PER_THREAD = 1<<20;
+
+struct PointRecord
+{
+    float           x, y, z;
+    unsigned char   r, g, b, a;
+};
+
+template<typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return !in.fail();
+}
+
+bool getFileStamp(const std::string& fileName, unsigned long long& size, long long& modificationTime)
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat)!=0)
+        return false;
+
+    size = static_cast<unsigned long long>(fileStat.st_size);
+    modificationTime = static_cast<long long>(fileStat.st_mtime);
+    return true;
+}
+
+// Pseudo random value in [0,1) of a point, from its index in the file so that every pass draws the same one.
+inline double getRandomValue(unsigned long long index)
+{
+    // splitmix64 finalizer
+    unsigned long long z = index + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    return static_cast<double>(z >> 11) * (1.0/9007199254740992.0);
+}
+
+inline unsigned int getCellCoordinate(double value, unsigned int numCells)
+{
+    if (!(value>0.0)) return 0;
+    if (value>=static_cast<double>(numCells)) return numCells-1;
+    return static_cast<unsigned int>(value);
+}
+
+// The cell of a node at a coarser level is found by shifting the code right by three bits per level.
+inline unsigned long long interleave(unsigned int x, unsigned int y, unsigned int z, unsigned int level)
+{
+    unsigned long long code = 0;
+    for(unsigned int bit=level; bit>0; --bit)
+    {
+        code = (code<<3) | (((x>>(bit-1))&1)<<2) | (((y>>(bit-1))&1)<<1) | ((z>>(bit-1))&1);
+    }
+    return code;
+}
+
+inline void deinterleave(unsigned long long code, unsigned int level, unsigned int& x, unsigned int& y, unsigned int& z)
+{
+    x = y = z = 0;
+    for(unsigned int bit=0; bit<level; ++bit)
+    {
+        x |= static_cast<unsigned int>((code>>(3*bit+2))&1)<<bit;
+        y |= static_cast<unsigned int>((code>>(3*bit+1))&1)<<bit;
+        z |= static_cast<unsigned int>((code>>(3*bit))&1)<<bit;
+    }
+}
+
+struct Cell
+{
+    Cell() : count(0), leaf(0) {}
+
+    unsigned long long  count;
+    unsigned int        leaf;
+};
+
+typedef std::map<unsigned long long, Cell> CellMap;
+
+struct BuildContext
+{
+    std::string         fileName;
+    std::string         indexFileName;
+    osg::Vec3d          origin;
+    double              halfSize;
+    unsigned int        maxLevel;
+    unsigned long long  pointsOffset;
+
+    CellMap             cells;
+    Octree::NodeList    nodes;
+
+    // A point is given to the first node of the path from the root to its leaf whose threshold is above the
+    // point's random value. The threshold of a node is nodePoints divided by the number of points in its cell,
+    // which increases down the path, so a node receives on average at most nodePoints of the points left by its
+    // ancestors.
+    std::vector<double> thresholds;
+};
+
+enum BuildPass
+{
+    COUNT_CELLS,
+    COUNT_NODES,
+    WRITE_POINTS
+};
+
+// A range of the points of the file, decoded by one thread.
+struct BuildPart
+{
+    BuildPart() : first(0), last(0), ok(true) {}
+
+    unsigned long long                  first;
+    unsigned long long                  last;
+    CellMap                             cells;
+    std::vector<unsigned long long>     nodeCounts;
+    std::vector<unsigned long long>     nodeCursors;
+    bool                                ok;
+};
+
+inline unsigned long long getCellCode(const BuildContext& context, double x, double y, double z)
+{
+    const unsigned int numCells = 1u << context.maxLevel;
+    const double scale = static_cast<double>(numCells) / (2.0*context.halfSize);
+    return interleave(getCellCoordinate((x - context.origin.x() + context.halfSize)*scale, numCells),
+                      getCellCoordinate((y - context.origin.y() + context.halfSize)*scale, numCells),
+                      getCellCoordinate((z - context.origin.z() + context.halfSize)*scale, numCells),
+                      context.maxLevel);
+}
+
+inline unsigned int getNode(const BuildContext& context, unsigned int leaf, unsigned long long pointIndex)
+{
+    double value = getRandomValue(pointIndex);
+    if (value<context.thresholds[0]) return 0;
+
+    unsigned int path[MAXIMUM_LEVEL+1];
+    unsigned int depth = 0;
+    for(unsigned int node=leaf; node!=0; node=context.nodes[node].parent)
+    {
+        path[depth++] = node;
+    }
+
+    for(unsigned int i=depth; i>0; --i)
+    {
+        if (value<context.thresholds[path[i-1]]) return path[i-1];
+    }
+    return leaf;
+}
+
+bool flushPoints(const BuildContext& context, std::ostream& out, std::vector< std::vector<PointRecord> >& buffers, BuildPart& part)
+{
+    for(unsigned int node=0; node<buffers.size(); ++node)
+    {
+        std::vector<PointRecord>& buffer = buffers[node];
+        if (buffer.empty()) continue;
+
+        out.seekp(context.pointsOffset + part.nodeCursors[node]*sizeof(PointRecord));
+        out.write(reinterpret_cast<const char*>(&buffer.front()), buffer.size()*sizeof(PointRecord));
+        part.nodeCursors[node] += buffer.size();
+        buffer.clear();
+    }
+    return !out.fail();
+}
+
+bool processPart(const BuildContext& context, BuildPass pass, BuildPart& part)
+{
+    try
+    {
+        std::ifstream ifs;
+        if (!liblas::Open(ifs, context.fileName)) return false;
+
+        liblas::ReaderFactory factory;
+        liblas::Reader reader = factory.CreateWithStream(ifs);
+        if (part.first!=0 && !reader.Seek(static_cast<std::size_t>(part.first))) return false;
+
+        osgDB::ofstream out;
+        std::vector< std::vector<PointRecord> > buffers;
+        unsigned int numBuffered = 0;
+        if (pass==WRITE_POINTS)
+        {
+            out.open(context.indexFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+            if (!out) return false;
+            buffers.resize(context.nodes.size());
+        }
+        else if (pass==COUNT_NODES)
+        {
+            part.nodeCounts.assign(context.nodes.size(), 0);
+        }
+
+        // Consecutive points mostly fall in the same cell, so the last cell looked up is remembered.
+        unsigned long long lastCode = ~0ULL;
+        CellMap::iterator cellItr = part.cells.end();
+        CellMap::const_iterator leafItr = context.cells.end();
+
+        for(unsigned long long i=part.first; i<part.last; ++i)
+        {
+            if (!reader.ReadNextPoint()) return false;
+
+            liblas::Point const& p = reader.GetPoint();
+            unsigned long long code = getCellCode(context, p.GetX(), p.GetY(), p.GetZ());
+
+            if (pass==COUNT_CELLS)
+            {
+                if (code!=lastCode)
+                {
+                    cellItr = part.cells.insert(CellMap::value_type(code, Cell())).first;
+                    lastCode = code;
+                }
+                ++(cellItr->second.count);
+                continue;
+            }
+
+            if (code!=lastCode)
+            {
+                leafItr = context.cells.find(code);
+                if (leafItr==context.cells.end()) return false;
+                lastCode = code;
+            }
+
+            unsigned int node = getNode(context, leafItr->second.leaf, i);
+            if (pass==COUNT_NODES)
+            {
+                ++part.nodeCounts[node];
+                continue;
+            }
+
+            liblas::Color c = p.GetColor();
+
+            PointRecord record;
+            record.x = static_cast<float>(p.GetX() - context.origin.x());
+            record.y = static_cast<float>(p.GetY() - context.origin.y());
+            record.z = static_cast<float>(p.GetZ() - context.origin.z());
+            record.r = static_cast<unsigned char>(c.GetRed() >> 8);
+            record.g = static_cast<unsigned char>(c.GetGreen() >> 8);
+            record.b = static_cast<unsigned char>(c.GetBlue() >> 8);
+            record.a = 255;
+            buffers[node].push_back(record);
+
+            if (++numBuffered>=MAXIMUM_BUFFERED_POINTS)
+            {
+                if (!flushPoints(context, out, buffers, part)) return false;
+                numBuffered = 0;
+            }
+        }
+
+        if (pass==WRITE_POINTS)
+        {
+            return flushPoints(context, out, buffers, part);
+        }
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        OSG_WARN << "las octree: error reading " << context.fileName << ", " << e.what() << std::endl;
+        return false;
+    }
+}
+
+class BuildThread : public OpenThreads::Thread
+{
+public:
+    BuildThread(const BuildContext& context, BuildPass pass, BuildPart& part):
+        _context(context),
+        _pass(pass),
+        _part(part) {}
+
+    virtual void run()
+    {
+        _part.ok = processPart(_context, _pass, _part);
+    }
+
+protected:
+    const BuildContext& _context;
+    BuildPass           _pass;
+    BuildPart&          _part;
+};
+
+bool runPass(const BuildContext& context, BuildPass pass, std::vector<BuildPart>& parts)
+{
+    std::vector<BuildThread*> threads;
+    for(unsigned int i=1; i<parts.size(); ++i)
+    {
+        BuildThread* thread = new BuildThread(context, pass, parts[i]);
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    parts[0].ok = processPart(context, pass, parts[0]);
+
+    bool ok = parts[0].ok;
+    for(unsigned int i=0; i<threads.size(); ++i)
+    {
+        threads[i]->join();
+        delete threads[i];
+        ok = ok && parts[i+1].ok;
+    }
+    return ok;
+}
+
+// Breadth first, so that the children of a node are next to each other, subdividing the cells holding more than
+// nodePoints points down to the grid the points were counted on.
+void buildNodes(BuildContext& context, unsigned long long numPoints, unsigned int nodePoints)
+{
+    context.nodes.clear();
+    context.thresholds.clear();
+
+    Octree::Node root;
+    context.nodes.push_back(root);
+
+    std::vector<unsigned long long> counts(1, numPoints);
+
+    for(unsigned int index=0; index<context.nodes.size(); ++index)
+    {
+        unsigned int level = context.nodes[index].level;
+        unsigned long long code = context.nodes[index].code;
+        unsigned int shift = 3*(context.maxLevel-level);
+
+        CellMap::iterator first = context.cells.lower_bound(code<<shift);
+        CellMap::iterator last = context.cells.lower_bound((code+1)<<shift);
+
+        if (counts[index]<=nodePoints || level==context.maxLevel)
+        {
+            for(CellMap::iterator itr=first; itr!=last; ++itr)
+            {
+                itr->second.leaf = index;
+            }
+            context.thresholds.push_back(2.0);
+            continue;
+        }
+
+        context.thresholds.push_back(static_cast<double>(nodePoints)/static_cast<double>(counts[index]));
+
+        unsigned int firstChild = static_cast<unsigned int>(context.nodes.size());
+        unsigned int childShift = shift-3;
+        CellMap::iterator itr = first;
+        while(itr!=last)
+        {
+            Octree::Node child;
+            child.level = level+1;
+            child.code = itr->first >> childShift;
+            child.parent = index;
+
+            unsigned long long count = 0;
+            for(; itr!=last && (itr->first >> childShift)==child.code; ++itr)
+            {
+                count += itr->second.count;
+            }
+
+            context.nodes.push_back(child);
+            counts.push_back(count);
+        }
+
+        context.nodes[index].firstChild = firstChild;
+        context.nodes[index].numChildren = static_cast<unsigned int>(context.nodes.size()) - firstChild;
+    }
+}
+
+// Fixed part of the index file before the node table.
+void writeHeader(std::ostream& out, unsigned long long fileSize, long long modificationTime, unsigned int nodePoints,
+                 unsigned long long numPoints, const osg::Vec3d& origin, double halfSize, unsigned int numNodes)
+{
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    writeValue(out, INDEX_VERSION);
+    writeValue(out, fileSize);
+    writeValue(out, modificationTime);
+    writeValue(out, nodePoints);
+    writeValue(out, numPoints);
+    writeValue(out, origin.x());
+    writeValue(out, origin.y());
+    writeValue(out, origin.z());
+    writeValue(out, halfSize);
+    writeValue(out, numNodes);
+}
+
+}
+
+
+OctreeSettings::OctreeSettings(const osgDB::Options* options):
+    threshold(5000000),
+    nodePoints(65536),
+    numThreads(0),
+    lodScale(4.0f)
+{
+    const char* cacheDirectoryEnv = getenv("OSG_LAS_OCTREE_DIRECTORY");
+    if (cacheDirectoryEnv) cacheDirectory = cacheDirectoryEnv;
+
+    if (!options) return;
+
+    std::istringstream iss(options->getOptionString());
+    std::string opt;
+    while (iss >> opt)
+    {
+        std::string::size_type pos = opt.find('=');
+        if (pos==std::string::npos) continue;
+
+        std::string key = opt.substr(0, pos);
+        std::istringstream value(opt.substr(pos+1));
+        if (key=="octreeThreshold") value >> threshold;
+        else if (key=="octreeNodePoints") value >> nodePoints;
+        else if (key=="octreeThreads") value >> numThreads;
+        else if (key=="octreeLODScale") value >> lodScale;
+        else if (key=="octreeCacheDirectory") cacheDirectory = opt.substr(pos+1);
+    }
+
+    if (nodePoints<1024) nodePoints = 1024;
+}
+
+
+Octree::Octree(const std::string& fileName, const std::string& indexFileName):
+    _fileName(fileName),
+    _indexFileName(indexFileName),
+    _numPoints(0),
+    _halfSize(1.0),
+    _pointsOffset(0)
+{
+}
+
+unsigned long long Octree::getNumPoints(const std::string& fileName)
+{
+    try
+    {
+        std::ifstream ifs;
+        if (!liblas::Open(ifs, fileName)) return 0;
+
+        liblas::ReaderFactory factory;
+        liblas::Reader reader = factory.CreateWithStream(ifs);
+        return reader.GetHeader().GetPointRecordsCount();
+    }
+    catch (std::exception const&)
+    {
+        return 0;
+    }
+}
+
+std::string Octree::getIndexFileName(const std::string& fileName, const OctreeSettings& settings)
+{
+    if (settings.cacheDirectory.empty())
+        return fileName + ".lasoctree";
+
+    // Point clouds of the same name in different directories share the cache directory.
+    std::string realPath = osgDB::getRealPath(fileName);
+    unsigned long long hash = 14695981039346656037ULL;
+    for(std::string::const_iterator itr=realPath.begin(); itr!=realPath.end(); ++itr)
+    {
+        hash ^= static_cast<unsigned char>(*itr);
+        hash *= 1099511628211ULL;
+    }
+
+    char hashString[32];
+    sprintf(hashString, "%016llx", hash);
+
+    return osgDB::concatPaths(settings.cacheDirectory, osgDB::getSimpleFileName(fileName) + "-" + hashString + ".lasoctree");
+}
+
+osg::ref_ptr<Octree> Octree::open(const std::string& fileName, const OctreeSettings& settings)
+{
+    osg::ref_ptr<Octree> octree = new Octree(fileName, getIndexFileName(fileName, settings));
+    if (octree->read(settings.nodePoints))
+    {
+        OSG_INFO << "las octree: read " << octree->_indexFileName << std::endl;
+        return octree;
+    }
+
+    if (!octree->build(settings))
+        return NULL;
+
+    return octree;
+}
+
+bool Octree::read(unsigned int nodePoints)
+{
+    osgDB::ifstream& in = _index;
+    in.open(_indexFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (in.fail() || memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))!=0) return false;
+
+    unsigned int version = 0;
+    if (!readValue(in, version) || version!=INDEX_VERSION) return false;
+
+    // The index is rebuilt as soon as the point cloud changes.
+    unsigned long long fileSize = 0, indexFileSize = 0;
+    long long modificationTime = 0, indexModificationTime = 0;
+    if (!getFileStamp(_fileName, fileSize, modificationTime)) return false;
+    if (!readValue(in, indexFileSize) || !readValue(in, indexModificationTime)) return false;
+    if (indexFileSize!=fileSize || indexModificationTime!=modificationTime) return false;
+
+    unsigned int indexNodePoints = 0;
+    if (!readValue(in, indexNodePoints) || indexNodePoints!=nodePoints) return false;
+
+    double x, y, z;
+    unsigned int numNodes = 0;
+    if (!readValue(in, _numPoints) ||
+        !readValue(in, x) || !readValue(in, y) || !readValue(in, z) ||
+        !readValue(in, _halfSize) ||
+        !readValue(in, numNodes) || numNodes==0)
+    {
+        return false;
+    }
+    _origin.set(x, y, z);
+
+    _nodes.resize(numNodes);
+    for(NodeList::iterator itr=_nodes.begin(); itr!=_nodes.end(); ++itr)
+    {
+        if (!readValue(in, itr->level) ||
+            !readValue(in, itr->code) ||
+            !readValue(in, itr->parent) ||
+            !readValue(in, itr->firstChild) ||
+            !readValue(in, itr->numChildren) ||
+            !readValue(in, itr->firstPoint) ||
+            !readValue(in, itr->numPoints))
+        {
+            _nodes.clear();
+            return false;
+        }
+    }
+
+    _pointsOffset = static_cast<unsigned long long>(in.tellg());
+    return true;
+}
+
+bool Octree::build(const OctreeSettings& settings)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    // Let go of the out of date index read() may have opened.
+    _index.close();
+    _index.clear();
+
+    BuildContext context;
+    context.fileName = _fileName;
+    context.indexFileName = _indexFileName + ".tmp";
+
+    unsigned long long fileSize = 0;
+    long long modificationTime = 0;
+    if (!getFileStamp(_fileName, fileSize, modificationTime)) return false;
+
+    try
+    {
+        std::ifstream ifs;
+        if (!liblas::Open(ifs, _fileName)) return false;
+
+        liblas::ReaderFactory factory;
+        liblas::Reader reader = factory.CreateWithStream(ifs);
+        liblas::Header const& h = reader.GetHeader();
+
+        _numPoints = h.GetPointRecordsCount();
+
+        osg::Vec3d minimum(h.GetMinX(), h.GetMinY(), h.GetMinZ());
+        osg::Vec3d maximum(h.GetMaxX(), h.GetMaxY(), h.GetMaxZ());
+        if (_numPoints==0 || !(minimum.x()<=maximum.x() && minimum.y()<=maximum.y() && minimum.z()<=maximum.z()))
+        {
+            OSG_WARN << "las octree: invalid header in " << _fileName << std::endl;
+            return false;
+        }
+
+        // Points outside of the header bounds are clamped to the border cells.
+        _origin = (minimum + maximum)*0.5;
+        _halfSize = osg::maximum(osg::maximum(maximum.x()-minimum.x(), maximum.y()-minimum.y()), maximum.z()-minimum.z())*0.5;
+        _halfSize = _halfSize>0.0 ? _halfSize*(1.0+1e-6) : 1.0;
+    }
+    catch (std::exception const& e)
+    {
+        OSG_WARN << "las octree: error reading " << _fileName << ", " << e.what() << std::endl;
+        return false;
+    }
+
+    context.origin = _origin;
+    context.halfSize = _halfSize;
+
+    // Count on a grid fine enough for the leaves of a surface like cloud to hold a fraction of nodePoints,
+    // as the number of occupied cells of an airborne survey grows by four rather than eight per level.
+    double ratio = static_cast<double>(_numPoints)/static_cast<double>(settings.nodePoints);
+    context.maxLevel = 2;
+    while(ratio>1.0 && context.maxLevel<MAXIMUM_LEVEL)
+    {
+        ratio /= 4.0;
+        ++context.maxLevel;
+    }
+
+    unsigned int numThreads = settings.numThreads!=0 ? settings.numThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+    unsigned long long numParts = osg::clampBetween(_numPoints/MINIMUM_POINTS_PER_THREAD, 1ULL, static_cast<unsigned long long>(numThreads));
+
+    std::vector<BuildPart> parts(static_cast<unsigned int>(numParts));
+    for(unsigned int i=0; i<parts.size(); ++i)
+    {
+        parts[i].first = _numPoints*i/numParts;
+        parts[i].last = _numPoints*(i+1)/numParts;
+    }
+
+    OSG_NOTICE << "las octree: building " << _indexFileName << " for " << _numPoints << " points using " << parts.size() << " threads" << std::endl;
+
+    // First pass, count the points per grid cell and derive the octree from the counts.
+    if (!runPass(context, COUNT_CELLS, parts)) return false;
+
+    for(unsigned int i=0; i<parts.size(); ++i)
+    {
+        for(CellMap::const_iterator itr=parts[i].cells.begin(); itr!=parts[i].cells.end(); ++itr)
+        {
+            context.cells[itr->first].count += itr->second.count;
+        }
+        CellMap().swap(parts[i].cells);
+    }
+
+    buildNodes(context, _numPoints, settings.nodePoints);
+
+    // Second pass, count the points each part gives to every node to know where it writes them.
+    if (!runPass(context, COUNT_NODES, parts)) return false;
+
+    unsigned long long firstPoint = 0;
+    for(unsigned int node=0; node<context.nodes.size(); ++node)
+    {
+        context.nodes[node].firstPoint = firstPoint;
+        for(unsigned int i=0; i<parts.size(); ++i)
+        {
+            parts[i].nodeCursors.push_back(firstPoint);
+            firstPoint += parts[i].nodeCounts[node];
+        }
+        context.nodes[node].numPoints = static_cast<unsigned int>(firstPoint - context.nodes[node].firstPoint);
+    }
+
+    {
+        osgDB::ofstream out(context.indexFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            OSG_WARN << "las octree: could not write " << context.indexFileName << std::endl;
+            return false;
+        }
+
+        writeHeader(out, fileSize, modificationTime, settings.nodePoints, _numPoints, _origin, _halfSize, static_cast<unsigned int>(context.nodes.size()));
+        for(NodeList::const_iterator itr=context.nodes.begin(); itr!=context.nodes.end(); ++itr)
+        {
+            writeValue(out, itr->level);
+            writeValue(out, itr->code);
+            writeValue(out, itr->parent);
+            writeValue(out, itr->firstChild);
+            writeValue(out, itr->numChildren);
+            writeValue(out, itr->firstPoint);
+            writeValue(out, itr->numPoints);
+        }
+
+        // Size the file up front, the threads write the points of their nodes in place.
+        context.pointsOffset = static_cast<unsigned long long>(out.tellp());
+        if (firstPoint>0)
+        {
+            out.seekp(context.pointsOffset + firstPoint*sizeof(PointRecord) - 1);
+            out.put(0);
+        }
+
+        if (!out)
+        {
+            OSG_WARN << "las octree: could not write " << context.indexFileName << std::endl;
+            remove(context.indexFileName.c_str());
+            return false;
+        }
+    }
+
+    // Third pass, write the points.
+    if (!runPass(context, WRITE_POINTS, parts))
+    {
+        OSG_WARN << "las octree: could not write " << context.indexFileName << std::endl;
+        remove(context.indexFileName.c_str());
+        return false;
+    }
+
+    // Octrees still reading the index being replaced keep it open, where that prevents replacing
+    // it the new index is discarded and the previous one kept.
+    remove(_indexFileName.c_str());
+    if (rename(context.indexFileName.c_str(), _indexFileName.c_str())!=0)
+    {
+        OSG_WARN << "las octree: could not write " << _indexFileName << std::endl;
+        remove(context.indexFileName.c_str());
+        return false;
+    }
+
+    _index.open(_indexFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!_index)
+    {
+        OSG_WARN << "las octree: could not read " << _indexFileName << std::endl;
+        return false;
+    }
+
+    _nodes.swap(context.nodes);
+    _pointsOffset = context.pointsOffset;
+
+    OSG_NOTICE << "las octree: built " << _nodes.size() << " nodes in " << osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick()) << "s" << std::endl;
+
+    return true;
+}
+
+bool Octree::readPoints(unsigned long long firstPoint, unsigned long long numPoints, std::vector<char>& points) const
+{
+    points.resize(static_cast<size_t>(numPoints*sizeof(PointRecord)));
+    if (points.empty()) return true;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_indexMutex);
+
+    _index.clear();
+    _index.seekg(_pointsOffset + firstPoint*sizeof(PointRecord));
+    _index.read(&points.front(), points.size());
+    return !_index.fail();
+}
+
+std::string Octree::getChildrenFileName(unsigned int index) const
+{
+    std::ostringstream str;
+    str << _fileName << "." << index << ".lasnode";
+    return str.str();
+}
+
+bool Octree::parseChildrenFileName(const std::string& childrenFileName, std::string& fileName, unsigned int& index)
+{
+    std::string nodeFileName = osgDB::getNameLessExtension(childrenFileName);
+    std::istringstream str(osgDB::getFileExtension(nodeFileName));
+    if (!(str >> index)) return false;
+
+    fileName = osgDB::getNameLessExtension(nodeFileName);
+    return !fileName.empty();
+}
+
+osg::Node* Octree::createNode(unsigned int index, const std::vector<char>& points, unsigned long long firstPoint, osgDB::Options* databaseOptions, const OctreeSettings& settings) const
+{
+    const Node& node = _nodes[index];
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    if (node.numPoints>0)
+    {
+        const PointRecord* records = reinterpret_cast<const PointRecord*>(&points.front()) + (node.firstPoint - firstPoint);
+
+        osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(node.numPoints);
+        osg::ref_ptr<osg::Vec4ubArray> colours = new osg::Vec4ubArray(node.numPoints);
+
+        bool singleColor = true;
+        for(unsigned int i=0; i<node.numPoints; ++i)
+        {
+            const PointRecord& record = records[i];
+            (*vertices)[i].set(record.x, record.y, record.z);
+            (*colours)[i].set(record.r, record.g, record.b, record.a);
+            singleColor = singleColor && (*colours)[i]==(*colours)[0];
+        }
+
+        osg::Geometry* geometry = new osg::Geometry;
+        geometry->setUseDisplayList(false);
+        geometry->setUseVertexBufferObjects(true);
+        geometry->setVertexArray(vertices.get());
+        if (singleColor)
+        {
+            colours->resize(1);
+            geometry->setColorArray(colours.get(), osg::Array::BIND_OVERALL);
+        }
+        else
+        {
+            geometry->setColorArray(colours.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, node.numPoints));
+
+        geode->addDrawable(geometry);
+    }
+
+    if (node.numChildren==0)
+        return geode.release();
+
+    unsigned int x, y, z;
+    deinterleave(node.code, node.level, x, y, z);
+    double cellSize = 2.0*_halfSize/static_cast<double>(1u << node.level);
+    osg::Vec3d center = osg::Vec3d(x+0.5, y+0.5, z+0.5)*cellSize - osg::Vec3d(_halfSize, _halfSize, _halfSize);
+    float radius = static_cast<float>(cellSize*0.5*sqrt(3.0));
+
+    // The points of the node stay drawn once its children are loaded, they only add to them.
+    osg::PagedLOD* plod = new osg::PagedLOD;
+    plod->setCenterMode(osg::LOD::USER_DEFINED_CENTER);
+    plod->setCenter(center);
+    plod->setRadius(radius);
+    plod->addChild(geode.get(), 0.0f, FLT_MAX);
+    plod->setFileName(1, getChildrenFileName(index));
+    plod->setRange(1, 0.0f, radius*settings.lodScale);
+    plod->setDatabaseOptions(databaseOptions);
+
+    return plod;
+}
+
+osg::Node* Octree::createScene(const osgDB::Options* options, const OctreeSettings& settings) const
+{
+    std::vector<char> points;
+    if (!readPoints(_nodes[0].firstPoint, _nodes[0].numPoints, points))
+        return NULL;
+
+    osg::ref_ptr<osgDB::Options> databaseOptions = options ? options->cloneOptions() : NULL;
+
+    osg::MatrixTransform* mt = new osg::MatrixTransform;
+    mt->setDataVariance(osg::Object::STATIC);
+    mt->setMatrix(osg::Matrix::translate(_origin));
+    mt->addChild(createNode(0, points, _nodes[0].firstPoint, databaseOptions.get(), settings));
+    return mt;
+}
+
+osg::Node* Octree::createChildren(unsigned int index, const osgDB::Options* options, const OctreeSettings& settings) const
+{
+    if (index>=_nodes.size() || _nodes[index].numChildren==0)
+        return NULL;
+
+    const Node& first = _nodes[_nodes[index].firstChild];
+    const Node& last = _nodes[_nodes[index].firstChild + _nodes[index].numChildren - 1];
+
+    // The points of all the children follow each other in the index file.
+    std::vector<char> points;
+    if (!readPoints(first.firstPoint, last.firstPoint + last.numPoints - first.firstPoint, points))
+        return NULL;
+
+    osg::ref_ptr<osgDB::Options> databaseOptions = options ? options->cloneOptions() : NULL;
+
+    osg::Group* group = new osg::Group;
+    for(unsigned int i=0; i<_nodes[index].numChildren; ++i)
+    {
+        group->addChild(createNode(_nodes[index].firstChild + i, points, first.firstPoint, databaseOptions.get(), settings));
+    }
+    return group;
+}
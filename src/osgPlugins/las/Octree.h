@@ -0,0 +1,139 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#ifndef LAS_OCTREE_H
+#define LAS_OCTREE_H 1
+
+#include <string>
+#include <vector>
+
+#include <osg/Referenced>
+#include <osg/Group>
+#include <osg/Vec3d>
+#include <osgDB/Options>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Mutex>
+
+namespace las {
+
+// Settings of the paged octree, read from the plugin options.
+struct OctreeSettings
+{
+    OctreeSettings(const osgDB::Options* options);
+
+    // Files with more points than this are loaded as a paged octree, 0 always does.
+    unsigned long long threshold;
+
+    // Average maximum number of points of a node, only exceeded by the leaves of cells denser than the
+    // resolution the points are counted at.
+    unsigned int nodePoints;
+
+    // Number of threads decoding the points while building the index, 0 uses as many as there are processors.
+    unsigned int numThreads;
+
+    // The children of a node are paged in once the eye is closer than lodScale times its radius.
+    float lodScale;
+
+    // Directory the index files are written to, next to the point cloud if empty.
+    std::string cacheDirectory;
+};
+
+// Out of core spatial index of a LAS/LAZ point cloud, stored in a .lasoctree file.
+//
+// Every point is given to exactly one node: the root holds a random subsample of the whole cloud, its children
+// a subsample of what is left in their cell, and so on down to the leaves, so that drawing the nodes of a path
+// from the root adds detail to what the coarser nodes already show. The points are stored in the index file
+// converted to floats relative to the centre of the octree and grouped by node, with the nodes in breadth first
+// order, so the children of a node are read back with a single read.
+//
+// The index is built by reading the point cloud three times, from several threads each decoding its own part
+// of the file: once to count the points per cell of a fine grid, from which the octree is derived, once to
+// count the points given to each node and finally to write them.
+//
+// The index file stays open for the lifetime of the Octree, so that the points of the nodes it pages in are read
+// from the file its nodes were read from even once the index has been rebuilt and replaced on disk.
+class Octree : public osg::Referenced
+{
+public:
+
+    struct Node
+    {
+        Node() : level(0), code(0), parent(0), firstChild(0), numChildren(0), firstPoint(0), numPoints(0) {}
+
+        unsigned int        level;
+        unsigned long long  code;       // interleaved x, y and z cell coordinates at the node's level
+        unsigned int        parent;
+        unsigned int        firstChild;
+        unsigned int        numChildren;
+        unsigned long long  firstPoint;
+        unsigned int        numPoints;
+    };
+
+    typedef std::vector<Node> NodeList;
+
+    // Returns the number of point records of a LAS/LAZ file, 0 if it can't be read.
+    static unsigned long long getNumPoints(const std::string& fileName);
+
+    // Returns the index of a point cloud, reading it from the cache directory or building it if it is missing
+    // or older than the point cloud. Returns NULL if the index couldn't be built.
+    static osg::ref_ptr<Octree> open(const std::string& fileName, const OctreeSettings& settings);
+
+    // Returns the root of the paged hierarchy, a MatrixTransform placing the octree in the point cloud's coordinates.
+    osg::Node* createScene(const osgDB::Options* options, const OctreeSettings& settings) const;
+
+    // Returns a Group with a PagedLOD for each of the children of a node, loaded by the PagedLOD of the node.
+    osg::Node* createChildren(unsigned int index, const osgDB::Options* options, const OctreeSettings& settings) const;
+
+    // File name of the PagedLOD children of a node, "<point cloud>.<node index>.lasnode".
+    std::string getChildrenFileName(unsigned int index) const;
+
+    // Splits a file name returned by getChildrenFileName().
+    static bool parseChildrenFileName(const std::string& childrenFileName, std::string& fileName, unsigned int& index);
+
+    const std::string& getFileName() const { return _fileName; }
+
+    const NodeList& getNodes() const { return _nodes; }
+
+protected:
+
+    Octree(const std::string& fileName, const std::string& indexFileName);
+
+    virtual ~Octree() {}
+
+    static std::string getIndexFileName(const std::string& fileName, const OctreeSettings& settings);
+
+    bool read(unsigned int nodePoints);
+
+    bool build(const OctreeSettings& settings);
+
+    osg::Node* createNode(unsigned int index, const std::vector<char>& points, unsigned long long firstPoint, osgDB::Options* databaseOptions, const OctreeSettings& settings) const;
+
+    bool readPoints(unsigned long long firstPoint, unsigned long long numPoints, std::vector<char>& points) const;
+
+    std::string         _fileName;
+    std::string         _indexFileName;
+
+    unsigned long long  _numPoints;
+    osg::Vec3d          _origin;
+    double              _halfSize;
+    unsigned long long  _pointsOffset;
+    NodeList            _nodes;
+
+    mutable OpenThreads::Mutex  _indexMutex;
+    mutable osgDB::ifstream     _index;
+};
+
+}
+
+#endif
@@ -7,9 +7,11 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
 #include <osgDB/fstream>
+#include <osgDB/PagedIndexCache>
 #include <osgDB/Registry>
 
 #include <iostream>
+#include <map>
 #include <iomanip>
 #include <stdio.h>
 #include <string.h>
@@ -19,6 +21,8 @@
 #include <liblas/point.hpp>
 #include <liblas/detail/timer.hpp>
 
+#include "Octree.h"
+
 class ReaderWriterLAS : public osgDB::ReaderWriter
 {
     public:
@@ -27,9 +31,15 @@ class ReaderWriterLAS : public osgDB::ReaderWriter
         {
             supportsExtension("las", "LAS point cloud format");
             supportsExtension("laz", "compressed LAS point cloud format");
+            supportsExtension("lasnode", "children of a node of a paged LAS point cloud");
             supportsOption("v", "Verbose output");
             supportsOption("noScale", "don't scale vertices according to las haeder - put schale in matixTransform");
             supportsOption("noReCenter", "don't transform vertex coords to re-center the pointcloud");
+            supportsOption("octreeThreshold=<n>", "load point clouds of more than n points as a paged octree, 0 always does (default 5000000)");
+            supportsOption("octreeNodePoints=<n>", "maximum number of points of an octree node (default 65536)");
+            supportsOption("octreeThreads=<n>", "number of threads decoding the points while building the octree index, 0 uses all the processors");
+            supportsOption("octreeLODScale=<f>", "the children of an octree node are loaded within f times its radius (default 4)");
+            supportsOption("octreeCacheDirectory=<path>", "directory of the octree index files, next to the point cloud by default. The OSG_LAS_OCTREE_DIRECTORY environment variable sets it too");
         }
 
         virtual const char* className() const { return "LAS point cloud reader"; }
@@ -44,10 +54,37 @@ class ReaderWriterLAS : public osgDB::ReaderWriter
             std::string ext = osgDB::getLowerCaseFileExtension(file);
             if (!acceptsExtension(ext)) return ReadResult::FILE_NOT_HANDLED;
 
+            las::OctreeSettings octreeSettings(options);
+
+            if (ext == "lasnode")
+            {
+                std::string lasFileName;
+                unsigned int index = 0;
+                if (!las::Octree::parseChildrenFileName(file, lasFileName, index)) return ReadResult::FILE_NOT_HANDLED;
+
+                osg::ref_ptr<las::Octree> octree = _octrees.get(lasFileName, octreeSettings, false);
+                if (!octree) return ReadResult::ERROR_IN_READING_FILE;
+
+                osg::Node* node = octree->createChildren(index, options, octreeSettings);
+                if (!node) return ReadResult::ERROR_IN_READING_FILE;
+                return node;
+            }
+
             std::string fileName = osgDB::findDataFile(file, options);
             if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
             OSG_INFO << "Reading file " << fileName << std::endl;
+
+            // Large point clouds are paged in from a spatial index rather than read in full.
+            if (las::Octree::getNumPoints(fileName) > octreeSettings.threshold)
+            {
+                osg::ref_ptr<las::Octree> octree = _octrees.get(fileName, octreeSettings, true);
+                osg::Node* node = octree.valid() ? octree->createScene(options, octreeSettings) : 0;
+                if (node) return node;
+
+                OSG_WARN << "Could not build the octree of " << fileName << ", reading all its points" << std::endl;
+            }
+
             std::ifstream ifs;
             if (!liblas::Open(ifs, file))
             {
@@ -291,6 +328,12 @@ class ReaderWriterLAS : public osgDB::ReaderWriter
 
             return mt;
         }
+
+    protected:
+
+        // The octrees of the point clouds, opened by the first thread reading a file of a point cloud without
+        // stopping the threads reading the nodes of other point clouds.
+        mutable osgDB::PagedIndexCache<las::Octree, las::OctreeSettings> _octrees;
 };
 
 // now register with Registry to instantiate the above
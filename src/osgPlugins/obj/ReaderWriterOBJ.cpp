@@ -63,6 +63,7 @@ public:
         supportsOption("noTriStripPolygons","Do not do the default tri stripping of polygons");
         supportsOption("generateFacetNormals","generate facet normals for vertices without normals");
         supportsOption("noReverseFaces","avoid to reverse faces when normals and triangles orientation are reversed");
+        supportsOption("parseThreads=<num>","Number of threads parsing the file, 0 uses as many as there are processors (default)");
 
         supportsOption("DIFFUSE=<unit>", "Set texture unit for diffuse texture");
         supportsOption("AMBIENT=<unit>", "Set texture unit for ambient texture");
@@ -170,6 +171,7 @@ protected:
         int precision;
         bool outputTextureFiles;
         int specularExponent;
+        unsigned int parseThreads;
 
         ObjOptionsStruct()
         {
@@ -182,6 +184,7 @@ protected:
             precision = std::numeric_limits<double>::digits10 + 2;
             outputTextureFiles = false;
             specularExponent = -1;
+            parseThreads = 0;
         }
     };
 
@@ -661,6 +664,11 @@ osg::Geometry* ReaderWriterOBJ::convertElementListToGeometry(obj::Model& model,
         #ifdef USE_DRAWARRAYLENGTHS
             osg::DrawArrayLengths* drawArrayLengths = new osg::DrawArrayLengths(GL_POLYGON,startPos);
             geometry->addPrimitiveSet(drawArrayLengths);
+        #else
+            // the primitive sets are added together at the end, as Geometry::addPrimitiveSet() goes through
+            // the primitive sets already added, which is quadratic in the number of faces.
+            osg::Geometry::PrimitiveSetList primitiveSets = geometry->getPrimitiveSetList();
+            primitiveSets.reserve(primitiveSets.size()+numPolygonElements);
         #endif
 
         for(itr=elementList.begin();
@@ -677,13 +685,13 @@ osg::Geometry* ReaderWriterOBJ::convertElementListToGeometry(obj::Model& model,
                     {
                         osg::DrawArrays* drawArrays = new osg::DrawArrays(GL_POLYGON,startPos,element.vertexIndices.size());
                         startPos += element.vertexIndices.size();
-                        geometry->addPrimitiveSet(drawArrays);
+                        primitiveSets.push_back(drawArrays);
                     }
                     else
                     {
                         osg::DrawArrays* drawArrays = new osg::DrawArrays(GL_TRIANGLE_FAN,startPos,element.vertexIndices.size());
                         startPos += element.vertexIndices.size();
-                        geometry->addPrimitiveSet(drawArrays);
+                        primitiveSets.push_back(drawArrays);
                     }
                 #endif
 
@@ -761,6 +769,10 @@ osg::Geometry* ReaderWriterOBJ::convertElementListToGeometry(obj::Model& model,
                 }
             }
         }
+
+        #ifndef USE_DRAWARRAYLENGTHS
+            geometry->setPrimitiveSetList(primitiveSets);
+        #endif
     }
 
     if(hasReversedFaces)
@@ -913,6 +925,11 @@ ReaderWriterOBJ::ObjOptionsStruct ReaderWriterOBJ::parseOptions(const osgDB::Rea
                 int value = atoi(post_equals.c_str());
                 localOptions.specularExponent = value ;
             }
+            else if (pre_equals == "parseThreads")
+            {
+                int value = atoi(post_equals.c_str());
+                localOptions.parseThreads = value>0 ? value : 0;
+            }
             else if (post_equals.length()>0)
             {
                 obj::Material::Map::TextureMapType type = obj::Material::Map::UNKNOWN;
@@ -949,19 +966,22 @@ osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(const std::string& fil
     if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
 
-    osgDB::ifstream fin(fileName.c_str());
-    if (fin)
+    // the file is parsed from memory on several threads.
+    obj::MappedFile mappedFile;
+    if (mappedFile.open(fileName))
     {
 
         // code for setting up the database path so that internally referenced file are searched for on relative paths.
         osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
         local_opt->getDatabasePathList().push_front(osgDB::getFilePath(fileName));
 
+        ObjOptionsStruct localOptions = parseOptions(options);
+
         obj::Model model;
         model.setDatabasePath(osgDB::getFilePath(fileName.c_str()));
-        model.readOBJ(fin, local_opt.get());
+        model.readOBJ(mappedFile.begin(), mappedFile.end(), local_opt.get(), localOptions.parseThreads);
 
-        ObjOptionsStruct localOptions = parseOptions(options);
+        mappedFile.close();
 
         osg::Node* node = convertModelToSceneGraph(model, localOptions, local_opt.get());
         return node;
@@ -976,11 +996,11 @@ osgDB::ReaderWriter::ReadResult ReaderWriterOBJ::readNode(std::istream& fin, con
     {
         fin.imbue(std::locale::classic());
 
-        obj::Model model;
-        model.readOBJ(fin, options);
-
         ObjOptionsStruct localOptions = parseOptions(options);
 
+        obj::Model model;
+        model.readOBJ(fin, options, localOptions.parseThreads);
+
         osg::Node* node = convertModelToSceneGraph(model, localOptions, options);
         return node;
     }
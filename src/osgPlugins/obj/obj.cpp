@@ -16,17 +16,39 @@
 #include <fstream>
 #include <string>
 #include <stdio.h>
+#include <stdlib.h>
 #include <functional>
+#include <algorithm>
 
 #include "obj.h"
 
+#include <osg/Config>
+#include <osg/Math>
 #include <osg/Notify>
 
+#include <osgDB/ConvertUTF>
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
 
 #include <string.h>
 
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #define WIN32_LEAN_AND_MEAN
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
 using namespace obj;
 
 
@@ -558,267 +580,793 @@ std::string trim(const std::string& s)
   return std::string(s, b, e - b + 1);
 }
 
-inline bool isZBrushColorField(char* line)
+inline bool isZBrushColorField(const char* line, const char* end)
 {
-    return strncmp(line, "#MRGB", 5) == 0;
+    return end-line>=5 && strncmp(line, "#MRGB", 5) == 0;
 }
 
-bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options)
+namespace
 {
-    OSG_INFO<<"Reading OBJ file"<<std::endl;
 
-    const int LINE_SIZE = 4096;
-    char line[LINE_SIZE];
-    float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
-    float r,g,b,a;
+inline bool startsWith(const char* line, const char* end, const char* prefix, size_t length)
+{
+    return static_cast<size_t>(end-line)>=length && strncmp(line, prefix, length)==0;
+}
 
-    while (fin)
+inline bool isDigit(char c) { return c>='0' && c<='9'; }
+
+inline void skipBlanks(const char*& ptr, const char* end)
+{
+    while (ptr<end && (*ptr==' ' || *ptr=='\t')) ++ptr;
+}
+
+// Converts the rare numbers that parseFloat() doesn't handle itself, such as nan, inf, or
+// exponents out of the range of exactly representable powers of ten, with strtod.
+bool parseFloatWithStrtod(const char*& ptr, const char* end, float& value)
+{
+    // the data isn't null terminated, copy the number out of it.
+    char buffer[64];
+    size_t length = 0;
+    while (ptr+length<end && length<sizeof(buffer)-1 && ptr[length]!=' ' && ptr[length]!='\t' && ptr[length]!='\r' && ptr[length]!='\n')
     {
-        readline(fin,line,LINE_SIZE);
-        if ((line[0]=='#' && !isZBrushColorField(line)) || line[0]=='$')
+        buffer[length] = ptr[length];
+        ++length;
+    }
+    buffer[length] = 0;
+
+    char* numberEnd = 0;
+    double result = strtod(buffer, &numberEnd);
+    if (numberEnd==buffer) return false;
+
+    value = static_cast<float>(result);
+    ptr += numberEnd-buffer;
+    return true;
+}
+
+// Parses a decimal floating point number, skipping leading blanks, in the way sscanf's %f does.
+bool parseFloat(const char*& ptr, const char* end, float& value)
+{
+    static const double powersOfTen[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    skipBlanks(ptr, end);
+
+    const char* p = ptr;
+    bool negative = false;
+    if (p<end && (*p=='-' || *p=='+'))
+    {
+        negative = (*p=='-');
+        ++p;
+    }
+
+    // the significant digits beyond the 19 that fit in the mantissa don't change a float.
+    unsigned long long mantissa = 0;
+    int numDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for(; p<end && isDigit(*p); ++p)
+    {
+        hasDigits = true;
+        if (numDigits<19)
         {
-            // comment line
-            // OSG_NOTICE <<"Comment: "<<line<<std::endl;
+            mantissa = mantissa*10 + (*p-'0');
+            if (mantissa!=0) ++numDigits;
         }
-        else if(isZBrushColorField(line))
+        else ++exponent;
+    }
+
+    if (p<end && *p=='.')
+    {
+        for(++p; p<end && isDigit(*p); ++p)
         {
-            // Get the zBrush vertex colors given in comments under the form :
-            // * #MRGB MMRRGGBB MMRRGGBB ... (up to 64 hexadecimal color fields)
-            std::string colorFields(line + 6);
-            while (colorFields.size() >= 8)
+            hasDigits = true;
+            if (numDigits<19)
+            {
+                mantissa = mantissa*10 + (*p-'0');
+                if (mantissa!=0) ++numDigits;
+                --exponent;
+            }
+        }
+    }
+
+    if (!hasDigits) return parseFloatWithStrtod(ptr, end, value);
+
+    if (p<end && (*p=='e' || *p=='E'))
+    {
+        const char* e = p+1;
+        bool negativeExponent = false;
+        if (e<end && (*e=='-' || *e=='+'))
+        {
+            negativeExponent = (*e=='-');
+            ++e;
+        }
+
+        // as with strtod, an 'e' that isn't followed by digits isn't part of the number.
+        if (e<end && isDigit(*e))
+        {
+            int explicitExponent = 0;
+            for(; e<end && isDigit(*e); ++e)
             {
-                std::string currentValue;
+                if (explicitExponent<10000) explicitExponent = explicitExponent*10 + (*e-'0');
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            p = e;
+        }
+    }
+
+    if (mantissa==0)
+    {
+        value = negative ? -0.0f : 0.0f;
+    }
+    else if (exponent>=-22 && exponent<=22)
+    {
+        double result = static_cast<double>(mantissa);
+        result = exponent<0 ? result/powersOfTen[-exponent] : result*powersOfTen[exponent];
+        value = static_cast<float>(negative ? -result : result);
+    }
+    else
+    {
+        return parseFloatWithStrtod(ptr, end, value);
+    }
+
+    ptr = p;
+    return true;
+}
+
+// Parses a decimal integer, skipping leading blanks, in the way sscanf's %d does.
+bool parseInt(const char*& ptr, const char* end, int& value)
+{
+    skipBlanks(ptr, end);
 
-                // Skipping the MM component
-                colorFields = colorFields.substr(2);
+    const char* p = ptr;
+    bool negative = false;
+    if (p<end && (*p=='-' || *p=='+'))
+    {
+        negative = (*p=='-');
+        ++p;
+    }
 
-                currentValue = colorFields.substr(0,2);
-                r = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
-                colorFields = colorFields.substr(2);
+    if (p>=end || !isDigit(*p)) return false;
 
-                currentValue = colorFields.substr(0,2);
-                g = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
-                colorFields = colorFields.substr(2);
+    int result = 0;
+    for(; p<end && isDigit(*p); ++p)
+    {
+        result = result*10 + (*p-'0');
+    }
 
-                currentValue = colorFields.substr(0,2);
-                b = static_cast<float>(strtol(currentValue.c_str(), NULL, 16)) / 255.;
-                colorFields = colorFields.substr(2);
+    value = negative ? -result : result;
+    ptr = p;
+    return true;
+}
 
-                colors.push_back(osg::Vec4(r, g, b, 1.0));
+// Returns the value of the leading hexadecimal digits of a two character field, as strtol does.
+float parseColorComponent(const char* ptr)
+{
+    int value = 0;
+    for(int i=0; i<2; ++i)
+    {
+        char c = ptr[i];
+        if (c>='0' && c<='9') value = value*16 + (c-'0');
+        else if (c>='a' && c<='f') value = value*16 + (c-'a'+10);
+        else if (c>='A' && c<='F') value = value*16 + (c-'A'+10);
+        else break;
+    }
+    return static_cast<float>(value) / 255.;
+}
+
+// Calls processor.line(key, begin, end) for each line between begin and end in the way that Model::readline()
+// splits them: lines ending with a backslash are joined, blanks at the start and spaces at the end are removed.
+// The key is the position of the line in the data and identifies it across calls.
+template<class LineProcessor>
+void processLines(const char* begin, const char* end, LineProcessor& processor)
+{
+    std::string joinedLine;
+
+    const char* ptr = begin;
+    while (ptr<end)
+    {
+        const char* key = ptr;
+        const char* lineEnd = ptr;
+        while (lineEnd<end && *lineEnd!='\n' && *lineEnd!='\r') ++lineEnd;
+
+        const char* next = lineEnd;
+        if (next<end && *next=='\r') ++next;
+        if (next<end && *next=='\n' && (next==lineEnd || *lineEnd=='\r')) ++next;
+
+        const char* lineBegin = ptr;
+        if (lineEnd>lineBegin && *(lineEnd-1)=='\\' && lineEnd<end)
+        {
+            // continuation lines, the backslash and line ending are replaced by a space.
+            joinedLine.assign(lineBegin, lineEnd-1);
+            while (lineEnd>lineBegin && *(lineEnd-1)=='\\' && lineEnd<end)
+            {
+                joinedLine += ' ';
+
+                lineBegin = next;
+                lineEnd = next;
+                while (lineEnd<end && *lineEnd!='\n' && *lineEnd!='\r') ++lineEnd;
+
+                next = lineEnd;
+                if (next<end && *next=='\r') ++next;
+                if (next<end && *next=='\n' && (next==lineEnd || *lineEnd=='\r')) ++next;
+
+                if (lineEnd>lineBegin && *(lineEnd-1)=='\\' && lineEnd<end) joinedLine.append(lineBegin, lineEnd-1);
+                else joinedLine.append(lineBegin, lineEnd);
             }
+
+            lineBegin = joinedLine.data();
+            lineEnd = lineBegin + joinedLine.size();
         }
-        else if (strlen(line)>0)
+
+        skipBlanks(lineBegin, lineEnd);
+        while (lineEnd>lineBegin && *(lineEnd-1)==' ') --lineEnd;
+
+        processor.line(key, lineBegin, lineEnd);
+
+        ptr = next;
+    }
+}
+
+// Line aligned part of the data, parsed in two passes: the first reads the vertices, normals, texture coordinates
+// and colours, from which the position of each chunk's coordinates in the model is known, the second reads the
+// faces, that may reference the coordinates of previous chunks, and the changes of element state.
+struct Chunk
+{
+    struct Command
+    {
+        enum Type
         {
-            if (strncmp(line,"v ",2)==0)
-            {
-                unsigned int fieldsRead = sscanf(line+2,"%f %f %f %f %f %f %f", &x, &y, &z, &w, &g, &b, &a);
+            USE_MATERIAL,
+            MATERIAL_LIBRARY,
+            OBJECT,
+            GROUP,
+            SMOOTHING_GROUP
+        };
 
-                if (fieldsRead==1)
-                    vertices.push_back(osg::Vec3(x,0.0f,0.0f));
-                else if (fieldsRead==2)
-                    vertices.push_back(osg::Vec3(x,y,0.0f));
-                else if (fieldsRead==3)
-                    vertices.push_back(osg::Vec3(x,y,z));
-                else if (fieldsRead == 4)
-                    vertices.push_back(osg::Vec3(x/w,y/w,z/w));
-                else if (fieldsRead == 6)
-                {
-                    vertices.push_back(osg::Vec3(x,y,z));
-                    colors.push_back(osg::Vec4(w, g, b, 1.0));
-                }
-                else if ( fieldsRead == 7 )
-                {
-                    vertices.push_back(osg::Vec3(x,y,z));
-                    colors.push_back(osg::Vec4(w, g, b, a));
-                }
+        Command(Type t, unsigned int n) : type(t), value(0), numElements(n) {}
+
+        Type            type;
+        std::string     name;
+        int             value;
+        unsigned int    numElements;    // the command applies after that many elements of the chunk
+    };
+
+    typedef std::vector<Command> CommandList;
+    typedef std::vector<const char*> LineList;
+
+    Chunk() : begin(0), end(0), vertexOffset(0), normalOffset(0), texCoordOffset(0), colorOffset(0) {}
+
+    const char*             begin;
+    const char*             end;
+
+    Model::Vec3Array        vertices;
+    Model::Vec3Array        normals;
+    Model::Vec2Array        texcoords;
+    Model::Vec4Array        colors;
+
+    // Keys of the v, vn and vt lines that didn't define a coordinate, so that the second pass,
+    // which only counts them, knows the index of the coordinates referenced by the faces.
+    LineList                skippedVertexLines;
+    LineList                skippedNormalLines;
+    LineList                skippedTexCoordLines;
+
+    unsigned int            vertexOffset;
+    unsigned int            normalOffset;
+    unsigned int            texCoordOffset;
+    unsigned int            colorOffset;
+
+    Model::ElementList      elements;
+    CommandList             commands;
+};
+
+typedef std::vector<Chunk> ChunkList;
+
+class CoordinateParser
+{
+public:
+    CoordinateParser(Chunk& chunk) : _chunk(chunk) {}
+
+    void line(const char* key, const char* line, const char* end)
+    {
+        if (line==end) return;
+
+        float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
+
+        if ((line[0]=='#' && !isZBrushColorField(line, end)) || line[0]=='$')
+        {
+            // comment line
+        }
+        else if (isZBrushColorField(line, end))
+        {
+            float r,g,b;
+            // Get the zBrush vertex colors given in comments under the form :
+            // * #MRGB MMRRGGBB MMRRGGBB ... (up to 64 hexadecimal color fields)
+            // Skipping the MM component
+            for(const char* field = line+6; field+8<=end; field+=8)
+            {
+                r = parseColorComponent(field+2);
+                g = parseColorComponent(field+4);
+                b = parseColorComponent(field+6);
+                _chunk.colors.push_back(osg::Vec4(r, g, b, 1.0));
             }
-            else if (strncmp(line,"vn ",3)==0)
+        }
+        else if (startsWith(line, end, "v ", 2))
+        {
+            const char* ptr = line+2;
+            float values[7] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+            unsigned int fieldsRead = 0;
+            while (fieldsRead<7 && parseFloat(ptr, end, values[fieldsRead])) ++fieldsRead;
+
+            x = values[0]; y = values[1]; z = values[2]; w = values[3];
+            float g = values[4], b = values[5], a = values[6];
+
+            if (fieldsRead==1)
+                _chunk.vertices.push_back(osg::Vec3(x,0.0f,0.0f));
+            else if (fieldsRead==2)
+                _chunk.vertices.push_back(osg::Vec3(x,y,0.0f));
+            else if (fieldsRead==3)
+                _chunk.vertices.push_back(osg::Vec3(x,y,z));
+            else if (fieldsRead == 4)
+                _chunk.vertices.push_back(osg::Vec3(x/w,y/w,z/w));
+            else if (fieldsRead == 6)
             {
-                unsigned int fieldsRead = sscanf(line+3,"%f %f %f", &x, &y, &z);
-
-                if (fieldsRead==1) normals.push_back(osg::Vec3(x,0.0f,0.0f));
-                else if (fieldsRead==2) normals.push_back(osg::Vec3(x,y,0.0f));
-                else if (fieldsRead==3) normals.push_back(osg::Vec3(x,y,z));
+                _chunk.vertices.push_back(osg::Vec3(x,y,z));
+                _chunk.colors.push_back(osg::Vec4(w, g, b, 1.0));
             }
-            else if (strncmp(line,"vt ",3)==0)
+            else if ( fieldsRead == 7 )
             {
-                unsigned int fieldsRead = sscanf(line+3,"%f %f %f", &x, &y, &z);
-
-                if (fieldsRead==1) texcoords.push_back(osg::Vec2(x,0.0f));
-                else if (fieldsRead==2) texcoords.push_back(osg::Vec2(x,y));
-                else if (fieldsRead==3) texcoords.push_back(osg::Vec2(x,y));
+                _chunk.vertices.push_back(osg::Vec3(x,y,z));
+                _chunk.colors.push_back(osg::Vec4(w, g, b, a));
             }
-            else if (strncmp(line,"l ",2)==0 ||
-                     strncmp(line,"p ",2)==0 ||
-                     strncmp(line,"f ",2)==0)
+            else
             {
-                char* ptr = line+2;
+                _chunk.skippedVertexLines.push_back(key);
+            }
+        }
+        else if (startsWith(line, end, "vn ", 3))
+        {
+            const char* ptr = line+3;
+            if (!parseFloat(ptr, end, x)) _chunk.skippedNormalLines.push_back(key);
+            else if (!parseFloat(ptr, end, y)) _chunk.normals.push_back(osg::Vec3(x,0.0f,0.0f));
+            else if (!parseFloat(ptr, end, z)) _chunk.normals.push_back(osg::Vec3(x,y,0.0f));
+            else _chunk.normals.push_back(osg::Vec3(x,y,z));
+        }
+        else if (startsWith(line, end, "vt ", 3))
+        {
+            const char* ptr = line+3;
+            if (!parseFloat(ptr, end, x)) _chunk.skippedTexCoordLines.push_back(key);
+            else if (!parseFloat(ptr, end, y)) _chunk.texcoords.push_back(osg::Vec2(x,0.0f));
+            else _chunk.texcoords.push_back(osg::Vec2(x,y));
+        }
+    }
 
-                Element* element = new Element( (line[0]=='p') ? Element::POINTS :
-                                                (line[0]=='l') ? Element::POLYLINE :
-                                                Element::POLYGON );
+protected:
+    Chunk& _chunk;
+};
 
-                // OSG_NOTICE<<"face"<<ptr<<std::endl;
+class ElementParser
+{
+public:
+    ElementParser(Chunk& chunk) :
+        _chunk(chunk),
+        _numVertices(chunk.vertexOffset),
+        _numNormals(chunk.normalOffset),
+        _numTexCoords(chunk.texCoordOffset),
+        _skippedVertexLine(0),
+        _skippedNormalLine(0),
+        _skippedTexCoordLine(0) {}
+
+    int remapVertexIndex(int vi) { return (vi<0) ? _numVertices+vi : vi-1; }
+    int remapNormalIndex(int vi) { return (vi<0) ? _numNormals+vi : vi-1; }
+    int remapTexCoordIndex(int vi) { return (vi<0) ? _numTexCoords+vi : vi-1; }
+
+    void countLine(const char* key, unsigned int& count, const Chunk::LineList& skippedLines, unsigned int& skippedLine)
+    {
+        if (skippedLine<skippedLines.size() && skippedLines[skippedLine]==key) ++skippedLine;
+        else ++count;
+    }
 
-                int vi=0, ti=0, ni=0;
-                while(*ptr!=0)
+    void addCommand(Chunk::Command::Type type, const std::string& name, int value=0)
+    {
+        _chunk.commands.push_back(Chunk::Command(type, static_cast<unsigned int>(_chunk.elements.size())));
+        _chunk.commands.back().name = name;
+        _chunk.commands.back().value = value;
+    }
+
+    void line(const char* key, const char* line, const char* end)
+    {
+        if (line==end) return;
+
+        if ((line[0]=='#' && !isZBrushColorField(line, end)) || line[0]=='$')
+        {
+            // comment line
+        }
+        else if (isZBrushColorField(line, end))
+        {
+            // read with the coordinates
+        }
+        else if (startsWith(line, end, "v ", 2))
+        {
+            countLine(key, _numVertices, _chunk.skippedVertexLines, _skippedVertexLine);
+        }
+        else if (startsWith(line, end, "vn ", 3))
+        {
+            countLine(key, _numNormals, _chunk.skippedNormalLines, _skippedNormalLine);
+        }
+        else if (startsWith(line, end, "vt ", 3))
+        {
+            countLine(key, _numTexCoords, _chunk.skippedTexCoordLines, _skippedTexCoordLine);
+        }
+        else if (startsWith(line, end, "l ", 2) ||
+                 startsWith(line, end, "p ", 2) ||
+                 startsWith(line, end, "f ", 2))
+        {
+            const char* ptr = line+2;
+
+            osg::ref_ptr<Element> element = new Element( (line[0]=='p') ? Element::POINTS :
+                                                         (line[0]=='l') ? Element::POLYLINE :
+                                                         Element::POLYGON );
+
+            unsigned int numFields = 0;
+            for(const char* p=ptr; p<end; ++p)
+            {
+                if (*p!=' ' && (p==ptr || *(p-1)==' ')) ++numFields;
+            }
+            element->vertexIndices.reserve(numFields);
+
+            int vi=0, ti=0, ni=0;
+            while(ptr<end)
+            {
+                // skip white space
+                while(ptr<end && *ptr==' ') ++ptr;
+                if (ptr==end) break;
+
+                // vi/ti/ni, vi//ni, vi/ti or vi, with the same fallbacks as trying each with sscanf in turn.
+                const char* p = ptr;
+                if (parseInt(p, end, vi))
                 {
-                    // skip white space
-                    while(*ptr==' ') ++ptr;
+                    bool hasTexCoord = false, hasNormal = false;
+                    if (p<end && *p=='/')
+                    {
+                        ++p;
+                        if (p<end && *p=='/')
+                        {
+                            ++p;
+                            hasNormal = parseInt(p, end, ni);
+                        }
+                        else if (parseInt(p, end, ti))
+                        {
+                            hasTexCoord = true;
+                            if (p<end && *p=='/')
+                            {
+                                ++p;
+                                hasNormal = parseInt(p, end, ni);
+                            }
+                        }
+                    }
 
-                    if (sscanf(ptr, "%d/%d/%d", &vi, &ti, &ni) == 3)
+                    element->vertexIndices.push_back(remapVertexIndex(vi));
+                    if (hasTexCoord && hasNormal)
                     {
-                        // OSG_NOTICE<<"   vi="<<vi<<"/ti="<<ti<<"/ni="<<ni<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
                         element->normalIndices.push_back(remapNormalIndex(ni));
                         element->texCoordIndices.push_back(remapTexCoordIndex(ti));
                     }
-                    else if (sscanf(ptr, "%d//%d", &vi, &ni) == 2)
+                    else if (hasNormal)
                     {
-                        // OSG_NOTICE<<"   vi="<<vi<<"//ni="<<ni<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                        if (remapNormalIndex(ni) < static_cast<int>(normals.size()))
+                        if (remapNormalIndex(ni) < static_cast<int>(_numNormals))
                             element->normalIndices.push_back(remapNormalIndex(ni));
                     }
-                    else if (sscanf(ptr, "%d/%d", &vi, &ti) == 2)
+                    else if (hasTexCoord)
                     {
-                        // OSG_NOTICE<<"   vi="<<vi<<"/ti="<<ti<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                        if (remapTexCoordIndex(ti) < static_cast<int>(texcoords.size()))
+                        if (remapTexCoordIndex(ti) < static_cast<int>(_numTexCoords))
                             element->texCoordIndices.push_back(remapTexCoordIndex(ti));
                     }
-                    else if (sscanf(ptr, "%d", &vi) == 1)
-                    {
-                        // OSG_NOTICE<<"   vi="<<vi<<std::endl;
-                        element->vertexIndices.push_back(remapVertexIndex(vi));
-                    }
-
-                    // skip to white space or end of line
-                    while(*ptr!=' ' && *ptr!=0) ++ptr;
-
-                }
-
-                if (!element->normalIndices.empty() && element->normalIndices.size() != element->vertexIndices.size())
-                {
-                    element->normalIndices.clear();
-                }
-
-                if (!element->texCoordIndices.empty() && element->texCoordIndices.size() != element->vertexIndices.size())
-                {
-                    element->texCoordIndices.clear();
-                }
-
-                if (!element->vertexIndices.empty())
-                {
-                    Element::CoordinateCombination coordateCombination = element->getCoordinateCombination();
-                    if (coordateCombination!=currentElementState.coordinateCombination)
-                    {
-                        currentElementState.coordinateCombination = coordateCombination;
-                        currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                    }
-                    addElement(element);
-                }
-                else
-                {
-                    // empty element, don't both adding, just unref to delete it.
-                    element->unref();
                 }
 
+                // skip to white space or end of line
+                while(ptr<end && *ptr!=' ') ++ptr;
             }
-            else if (strncmp(line,"usemtl ",7)==0)
+
+            if (!element->normalIndices.empty() && element->normalIndices.size() != element->vertexIndices.size())
             {
-                std::string materialName( line+7 );
-                if (currentElementState.materialName != materialName)
-                {
-                    currentElementState.materialName = materialName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                element->normalIndices.clear();
             }
-            else if (strncmp(line,"mtllib ",7)==0)
+
+            if (!element->texCoordIndices.empty() && element->texCoordIndices.size() != element->vertexIndices.size())
             {
-                std::string materialFileName = trim( line+7 );
-                std::string fullPathFileName = osgDB::findDataFile( materialFileName, options );
-                if (!fullPathFileName.empty())
-                {
-                    osgDB::ifstream mfin( fullPathFileName.c_str() );
-                    if (mfin)
-                    {
-                        OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
-                        readMTL(mfin);
-                    }
-                    else
-                    {
-                        OSG_WARN << "Obj unable to load mtllib '" << fullPathFileName << "'\n";
-                    }
-                }
-                else
-                {
-                    OSG_WARN << "Obj unable to find mtllib '" << materialFileName << "'\n";
-                }
+                element->texCoordIndices.clear();
             }
-            else if (strncmp(line,"o ",2)==0)
+
+            // empty elements aren't added.
+            if (!element->vertexIndices.empty())
             {
-                std::string objectName(line+2);
-                if (currentElementState.objectName != objectName)
-                {
-                    currentElementState.objectName = objectName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                _chunk.elements.push_back(element);
             }
-            else if (strcmp(line,"o")==0)
+        }
+        else if (startsWith(line, end, "usemtl ", 7))
+        {
+            addCommand(Chunk::Command::USE_MATERIAL, std::string(line+7, end));
+        }
+        else if (startsWith(line, end, "mtllib ", 7))
+        {
+            addCommand(Chunk::Command::MATERIAL_LIBRARY, trim(std::string(line+7, end)));
+        }
+        else if (startsWith(line, end, "o ", 2))
+        {
+            addCommand(Chunk::Command::OBJECT, std::string(line+2, end));
+        }
+        else if (end-line==1 && line[0]=='o')
+        {
+            addCommand(Chunk::Command::OBJECT, std::string()); // empty name
+        }
+        else if (startsWith(line, end, "g ", 2))
+        {
+            addCommand(Chunk::Command::GROUP, std::string(line+2, end));
+        }
+        else if (end-line==1 && line[0]=='g')
+        {
+            addCommand(Chunk::Command::GROUP, std::string()); // empty name
+        }
+        else if (startsWith(line, end, "s ", 2))
+        {
+            int smoothingGroup=0;
+            const char* ptr = line+2;
+            if (startsWith(ptr, end, "off", 3)) smoothingGroup = 0;
+            else if (!parseInt(ptr, end, smoothingGroup))
             {
-                std::string objectName(""); // empty name
-                if (currentElementState.objectName != objectName)
-                {
-                    currentElementState.objectName = objectName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                OSG_NOTICE <<"*** error reading smoothing group ***"<<std::endl;
             }
-            else if (strncmp(line,"g ",2)==0)
+
+            addCommand(Chunk::Command::SMOOTHING_GROUP, std::string(), smoothingGroup);
+        }
+        else
+        {
+            OSG_NOTICE <<"*** line not handled *** :"<<std::string(line, end)<<std::endl;
+        }
+    }
+
+protected:
+    Chunk&          _chunk;
+    unsigned int    _numVertices;
+    unsigned int    _numNormals;
+    unsigned int    _numTexCoords;
+    unsigned int    _skippedVertexLine;
+    unsigned int    _skippedNormalLine;
+    unsigned int    _skippedTexCoordLine;
+};
+
+enum ParsePass
+{
+    PARSE_COORDINATES,
+    PARSE_ELEMENTS
+};
+
+struct ParseContext
+{
+    ParseContext(Model& m, ChunkList& c, ParsePass p) : model(m), chunks(c), pass(p) {}
+
+    Model&                  model;
+    ChunkList&              chunks;
+    ParsePass               pass;
+    OpenThreads::Atomic     nextChunk;
+};
+
+void parseChunks(ParseContext& context)
+{
+    for(;;)
+    {
+        unsigned int index = (++context.nextChunk) - 1;
+        if (index>=context.chunks.size()) break;
+
+        Chunk& chunk = context.chunks[index];
+        if (context.pass==PARSE_COORDINATES)
+        {
+            CoordinateParser parser(chunk);
+            processLines(chunk.begin, chunk.end, parser);
+        }
+        else
+        {
+            // move the coordinates of the chunk into their place in the model.
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(), context.model.vertices.begin()+chunk.vertexOffset);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), context.model.normals.begin()+chunk.normalOffset);
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), context.model.texcoords.begin()+chunk.texCoordOffset);
+            std::copy(chunk.colors.begin(), chunk.colors.end(), context.model.colors.begin()+chunk.colorOffset);
+            Model::Vec3Array().swap(chunk.vertices);
+            Model::Vec3Array().swap(chunk.normals);
+            Model::Vec2Array().swap(chunk.texcoords);
+            Model::Vec4Array().swap(chunk.colors);
+
+            ElementParser parser(chunk);
+            processLines(chunk.begin, chunk.end, parser);
+        }
+    }
+}
+
+class ParseThread : public OpenThreads::Thread
+{
+public:
+    ParseThread(ParseContext& context):
+        _context(context) {}
+
+    virtual void run()
+    {
+        parseChunks(_context);
+    }
+
+protected:
+    ParseContext& _context;
+};
+
+void runPass(ParseContext& context, unsigned int numThreads)
+{
+    numThreads = osg::minimum(numThreads, static_cast<unsigned int>(context.chunks.size()));
+
+    std::vector<ParseThread*> threads;
+    for(unsigned int i=1; i<numThreads; ++i)
+    {
+        ParseThread* thread = new ParseThread(context);
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    parseChunks(context);
+
+    for(std::vector<ParseThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+}
+
+}
+
+bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options, unsigned int numThreads)
+{
+    std::vector<char> data;
+    char buffer[65536];
+    while (fin)
+    {
+        fin.read(buffer, sizeof(buffer));
+        data.insert(data.end(), buffer, buffer+fin.gcount());
+    }
+
+    if (data.empty()) return true;
+
+    return readOBJ(&data.front(), &data.front()+data.size(), options, numThreads);
+}
+
+bool Model::readOBJ(const char* begin, const char* end, const osgDB::ReaderWriter::Options* options, unsigned int numThreads)
+{
+    OSG_INFO<<"Reading OBJ file"<<std::endl;
+
+    if (numThreads==0) numThreads = static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+
+    // Split the data into a few chunks per thread to balance the load, but keep them large enough for the
+    // cost of the threads to be negligible. A chunk starts after a line ending not escaped by a backslash.
+    const size_t minimumChunkSize = 1<<20;
+    size_t chunkSize = osg::maximum(minimumChunkSize, static_cast<size_t>(end-begin)/(numThreads*4)+1);
+
+    ChunkList chunks;
+    for(const char* chunkBegin = begin; chunkBegin<end; )
+    {
+        const char* chunkEnd = end;
+        if (static_cast<size_t>(end-chunkBegin)>chunkSize)
+        {
+            chunkEnd = chunkBegin+chunkSize;
+            for(;;)
             {
-                std::string groupName(line+2);
-                if (currentElementState.groupName != groupName)
-                {
-                    currentElementState.groupName = groupName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
+                chunkEnd = std::find(chunkEnd, end, '\n');
+                if (chunkEnd==end) break;
+
+                const char* previous = chunkEnd;
+                if (previous>chunkBegin && *(previous-1)=='\r') --previous;
+                ++chunkEnd;
+                if (previous==chunkBegin || *(previous-1)!='\\') break;
             }
-            else if (strcmp(line,"g")==0)
+        }
+
+        chunks.push_back(Chunk());
+        chunks.back().begin = chunkBegin;
+        chunks.back().end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    {
+        ParseContext context(*this, chunks, PARSE_COORDINATES);
+        runPass(context, numThreads);
+    }
+
+    unsigned int numVertices = vertices.size();
+    unsigned int numNormals = normals.size();
+    unsigned int numTexCoords = texcoords.size();
+    unsigned int numColors = colors.size();
+    for(ChunkList::iterator itr=chunks.begin(); itr!=chunks.end(); ++itr)
+    {
+        itr->vertexOffset = numVertices;
+        itr->normalOffset = numNormals;
+        itr->texCoordOffset = numTexCoords;
+        itr->colorOffset = numColors;
+        numVertices += itr->vertices.size();
+        numNormals += itr->normals.size();
+        numTexCoords += itr->texcoords.size();
+        numColors += itr->colors.size();
+    }
+
+    vertices.resize(numVertices);
+    normals.resize(numNormals);
+    texcoords.resize(numTexCoords);
+    colors.resize(numColors);
+
+    {
+        ParseContext context(*this, chunks, PARSE_ELEMENTS);
+        runPass(context, numThreads);
+    }
+
+    // Apply the changes of element state and add the elements in the order of the file.
+    for(ChunkList::iterator itr=chunks.begin(); itr!=chunks.end(); ++itr)
+    {
+        Chunk& chunk = *itr;
+        Chunk::CommandList::const_iterator command = chunk.commands.begin();
+        for(unsigned int i=0; i<=chunk.elements.size(); ++i)
+        {
+            for(; command!=chunk.commands.end() && command->numElements==i; ++command)
             {
-                std::string groupName(""); // empty name
-                if (currentElementState.groupName != groupName)
+                switch(command->type)
                 {
-                    currentElementState.groupName = groupName;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+                    case(Chunk::Command::USE_MATERIAL):
+                        if (currentElementState.materialName != command->name)
+                        {
+                            currentElementState.materialName = command->name;
+                            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+                        }
+                        break;
+                    case(Chunk::Command::MATERIAL_LIBRARY):
+                        readMTLFile(command->name, options);
+                        break;
+                    case(Chunk::Command::OBJECT):
+                        if (currentElementState.objectName != command->name)
+                        {
+                            currentElementState.objectName = command->name;
+                            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+                        }
+                        break;
+                    case(Chunk::Command::GROUP):
+                        if (currentElementState.groupName != command->name)
+                        {
+                            currentElementState.groupName = command->name;
+                            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+                        }
+                        break;
+                    case(Chunk::Command::SMOOTHING_GROUP):
+                        if (currentElementState.smoothingGroup != command->value)
+                        {
+                            currentElementState.smoothingGroup = command->value;
+                            currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
+                        }
+                        break;
                 }
             }
-            else if (strncmp(line,"s ",2)==0)
-            {
-                int smoothingGroup=0;
-                if (strncmp(line+2,"off",3)==0) smoothingGroup = 0;
-                else
-                {
-                    int result = sscanf(line+2,"%d",&smoothingGroup);
-                    if (result!=1)
-                    {
-                        OSG_NOTICE <<"*** error reading smoothing group ***"<<std::endl;
-                    }
-                }
 
-                if (currentElementState.smoothingGroup != smoothingGroup)
-                {
-                    currentElementState.smoothingGroup = smoothingGroup;
-                    currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
-                }
-            }
-            else
+            if (i==chunk.elements.size()) break;
+
+            Element* element = chunk.elements[i].get();
+            Element::CoordinateCombination coordateCombination = element->getCoordinateCombination();
+            if (coordateCombination!=currentElementState.coordinateCombination)
             {
-                OSG_NOTICE <<"*** line not handled *** :"<<line<<std::endl;
+                currentElementState.coordinateCombination = coordateCombination;
+                currentElementList = 0; // reset the element list to force a recompute of which ElementList to use
             }
-
+            addElement(element);
         }
 
+        Model::ElementList().swap(chunk.elements);
     }
+
 #if 0
     OSG_NOTICE <<"vertices :"<<vertices.size()<<std::endl;
     OSG_NOTICE <<"normals :"<<normals.size()<<std::endl;
@@ -845,6 +1393,28 @@ bool Model::readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* optio
     return true;
 }
 
+void Model::readMTLFile(const std::string& materialFileName, const osgDB::ReaderWriter::Options* options)
+{
+    std::string fullPathFileName = osgDB::findDataFile( materialFileName, options );
+    if (!fullPathFileName.empty())
+    {
+        osgDB::ifstream mfin( fullPathFileName.c_str() );
+        if (mfin)
+        {
+            OSG_INFO << "Obj reading mtllib '" << fullPathFileName << "'\n";
+            readMTL(mfin);
+        }
+        else
+        {
+            OSG_WARN << "Obj unable to load mtllib '" << fullPathFileName << "'\n";
+        }
+    }
+    else
+    {
+        OSG_WARN << "Obj unable to find mtllib '" << materialFileName << "'\n";
+    }
+}
+
 
 void Model::addElement(Element* element)
 {
@@ -892,3 +1462,125 @@ bool Model::needReverse(const Element& element) const
 
     return computeNormal(element)*averageNormal(element) < 0.0f;
 }
+
+
+MappedFile::MappedFile():
+    _data(0),
+    _size(0),
+    _mapped(false)
+#if defined(WIN32) && !defined(__CYGWIN__)
+    ,_fileHandle(INVALID_HANDLE_VALUE),
+    _mappingHandle(0)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #ifdef OSG_USE_UTF8_FILENAME
+        _fileHandle = CreateFileW(osgDB::convertUTF8toUTF16(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    #else
+        _fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    #endif
+    if (_fileHandle!=INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(_fileHandle, &fileSize))
+        {
+            if (fileSize.QuadPart==0)
+            {
+                close();
+                return true;
+            }
+
+            _mappingHandle = CreateFileMapping(_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (_mappingHandle)
+            {
+                _data = static_cast<const char*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+                if (_data)
+                {
+                    _size = static_cast<size_t>(fileSize.QuadPart);
+                    _mapped = true;
+                    return true;
+                }
+            }
+        }
+    }
+    close();
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd>=0)
+    {
+        struct stat fileStat;
+        if (fstat(fd, &fileStat)==0 && S_ISREG(fileStat.st_mode))
+        {
+            if (fileStat.st_size==0)
+            {
+                ::close(fd);
+                return true;
+            }
+
+            void* data = mmap(0, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data!=MAP_FAILED)
+            {
+            #ifdef POSIX_MADV_SEQUENTIAL
+                posix_madvise(data, static_cast<size_t>(fileStat.st_size), POSIX_MADV_SEQUENTIAL);
+            #endif
+                ::close(fd);
+                _data = static_cast<const char*>(data);
+                _size = static_cast<size_t>(fileStat.st_size);
+                _mapped = true;
+                return true;
+            }
+        }
+        ::close(fd);
+    }
+#endif
+
+    // fall back to reading the whole file.
+    osgDB::ifstream fin(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fin) return false;
+
+    char buffer[65536];
+    while (fin)
+    {
+        fin.read(buffer, sizeof(buffer));
+        _buffer.insert(_buffer.end(), buffer, buffer+fin.gcount());
+    }
+
+    _data = _buffer.empty() ? 0 : &_buffer.front();
+    _size = _buffer.size();
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_mapped)
+    {
+#if defined(WIN32) && !defined(__CYGWIN__)
+        UnmapViewOfFile(_data);
+#else
+        munmap(const_cast<char*>(_data), _size);
+#endif
+    }
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    if (_mappingHandle) CloseHandle(_mappingHandle);
+    if (_fileHandle!=INVALID_HANDLE_VALUE) CloseHandle(_fileHandle);
+    _mappingHandle = 0;
+    _fileHandle = INVALID_HANDLE_VALUE;
+#endif
+
+    std::vector<char>().swap(_buffer);
+    _data = 0;
+    _size = 0;
+    _mapped = false;
+}
@@ -196,9 +196,14 @@ public:
 
     std::string lastComponent(const char* linep);
     bool readMTL(std::istream& fin);
-    bool readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options);
+    bool readOBJ(std::istream& fin, const osgDB::ReaderWriter::Options* options, unsigned int numThreads=0);
+
+    /** Read the OBJ data held in memory between begin and end. The data is split into line aligned chunks
+      * parsed on numThreads threads, the calling thread included, 0 using as many threads as there are processors.*/
+    bool readOBJ(const char* begin, const char* end, const osgDB::ReaderWriter::Options* options, unsigned int numThreads=0);
 
     bool readline(std::istream& fin, char* line, const int LINE_SIZE);
+    void readMTLFile(const std::string& materialFileName, const osgDB::ReaderWriter::Options* options);
     void addElement(Element* element);
 
     osg::Vec3 averageNormal(const Element& element) const;
@@ -232,6 +237,36 @@ public:
 
 };
 
+/** Read only view of the contents of a file, memory mapped where the platform supports it
+  * and otherwise read into memory.*/
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& fileName);
+    void close();
+
+    const char* begin() const { return _data; }
+    const char* end() const { return _data+_size; }
+    size_t size() const { return _size; }
+
+protected:
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator = (const MappedFile&);
+
+    const char*         _data;
+    size_t              _size;
+    bool                _mapped;
+    std::vector<char>   _buffer;
+#if defined(WIN32) && !defined(__CYGWIN__)
+    void*               _fileHandle;
+    void*               _mappingHandle;
+#endif
+};
+
 }
 
 #endif
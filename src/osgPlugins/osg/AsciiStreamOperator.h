@@ -4,6 +4,8 @@
 #include <ostream>
 #include <osgDB/StreamOperator>
 
+#include "TextStreamNumbers.h"
+
 class AsciiOutputIterator : public osgDB::OutputIterator
 {
 public:
@@ -26,51 +28,54 @@ public:
     }
 
     virtual void writeChar( char c )
-    { indentIfRequired(); *_out << (short)c << ' '; }
+    { writeNumber( (short)c ); }
 
     virtual void writeUChar( unsigned char c )
-    { indentIfRequired(); *_out << (unsigned short)c << ' '; }
+    { writeNumber( (unsigned short)c ); }
 
     virtual void writeShort( short s )
-    { indentIfRequired(); *_out << s << ' '; }
+    { writeNumber( s ); }
 
     virtual void writeUShort( unsigned short s )
-    { indentIfRequired(); *_out << s << ' '; }
+    { writeNumber( s ); }
 
     virtual void writeInt( int i )
-    { indentIfRequired(); *_out << i << ' '; }
+    { writeNumber( i ); }
 
     virtual void writeUInt( unsigned int i )
-    { indentIfRequired(); *_out << i << ' '; }
+    { writeNumber( i ); }
 
     virtual void writeLong( long l )
-    { indentIfRequired(); *_out << l << ' '; }
+    { writeNumber( l ); }
 
     virtual void writeULong( unsigned long l )
-    { indentIfRequired(); *_out << l << ' '; }
+    { writeNumber( l ); }
 
     virtual void writeInt64( GLint64 ll )
-    { indentIfRequired(); *_out << ll << ' '; }
+    { writeNumber( ll ); }
 
     virtual void writeUInt64( GLuint64 ull )
-    { indentIfRequired(); *_out << ull << ' '; }
+    { writeNumber( ull ); }
 
     virtual void writeFloat( float f )
-    { indentIfRequired(); *_out << f << ' '; }
+    { writeNumber( f ); }
 
     virtual void writeDouble( double d )
-    { indentIfRequired(); *_out << d << ' '; }
+    { writeNumber( d ); }
 
     virtual void writeString( const std::string& s )
     { indentIfRequired(); *_out << s << ' '; }
 
     virtual void writeStream( std::ostream& (*fn)(std::ostream&) )
     {
-        indentIfRequired(); *_out << fn;
+        indentIfRequired();
         if ( isEndl( fn ) )
         {
+            // end the line without the flush of std::endl, the stream being flushed once written
+            TextStreamNumbers::write( *_out, "\n", 1 );
             _readyForIndent = true;
         }
+        else *_out << fn;
     }
 
     virtual void writeBase( std::ios_base& (*fn)(std::ios_base&) )
@@ -124,12 +129,29 @@ public:
 
 protected:
 
+    template<typename T>
+    void writeNumber( T value )
+    {
+        indentIfRequired();
+
+        char buffer[TextStreamNumbers::BUFFER_SIZE+1];
+        unsigned int length = TextStreamNumbers::format( buffer, value, *_out );
+        if ( length>0 )
+        {
+            buffer[length++] = ' ';
+            TextStreamNumbers::write( *_out, buffer, length );
+        }
+        else *_out << value << ' ';
+    }
+
     inline void indentIfRequired()
     {
         if ( _readyForIndent )
         {
-            for (int i=0; i<_indent; ++i)
-                *_out << ' ';
+            static const char spaces[] = "                                ";
+            const int numSpaces = sizeof(spaces)-1;
+            for (int i=0; i<_indent; i+=numSpaces)
+                TextStreamNumbers::write( *_out, spaces, (_indent-i<numSpaces) ? _indent-i : numSpaces );
             _readyForIndent = false;
         }
     }
@@ -176,33 +198,33 @@ public:
     }
 
     virtual void readShort( short& s )
-    { std::string str; readString(str); s = static_cast<short>(strtol(str.c_str(), NULL, 0)); }
+    { s = static_cast<short>(strtol(readNumber(), NULL, 0)); }
 
     virtual void readUShort( unsigned short& s )
-    { std::string str; readString(str); s = static_cast<unsigned short>(strtoul(str.c_str(), NULL, 0)); }
+    { s = static_cast<unsigned short>(strtoul(readNumber(), NULL, 0)); }
 
     virtual void readInt( int& i )
-    { std::string str; readString(str); i = static_cast<int>(strtol(str.c_str(), NULL, 0)); }
+    { i = static_cast<int>(strtol(readNumber(), NULL, 0)); }
 
     virtual void readUInt( unsigned int& i )
-    { std::string str; readString(str); i = static_cast<unsigned int>(strtoul(str.c_str(), NULL, 0)); }
+    { i = static_cast<unsigned int>(strtoul(readNumber(), NULL, 0)); }
 
     virtual void readLong( long& l )
-    { std::string str; readString(str); l = strtol(str.c_str(), NULL, 0); }
+    { l = strtol(readNumber(), NULL, 0); }
 
     virtual void readULong( unsigned long& l )
-    { std::string str; readString(str); l = strtoul(str.c_str(), NULL, 0); }
+    { l = strtoul(readNumber(), NULL, 0); }
 
     virtual void readFloat( float& f )
-    { std::string str; readString(str); f = osg::asciiToFloat(str.c_str()); }
+    { f = osg::asciiToFloat(readNumber()); }
 
     virtual void readDouble( double& d )
-    { std::string str; readString(str); d = osg::asciiToDouble(str.c_str()); }
+    { d = osg::asciiToDouble(readNumber()); }
 
     virtual void readString( std::string& s )
     {
         if ( _preReadString.empty() )
-            *_in >> s;
+            TextStreamNumbers::readToken( *_in, s );
         else
         {
             s = _preReadString;
@@ -256,7 +278,7 @@ public:
 
     virtual void readWrappedString( std::string& str )
     {
-        char ch;
+        char ch = 0;
         getCharacter( ch );
 
         // skip white space
@@ -295,7 +317,7 @@ public:
     virtual bool matchString( const std::string& str )
     {
         if ( _preReadString.empty() )
-            *_in >> _preReadString;
+            TextStreamNumbers::readToken( *_in, _preReadString );
 
         if ( _preReadString==str )
         {
@@ -325,6 +347,12 @@ public:
     }
 
 protected:
+    const char* readNumber()
+    {
+        readString( _token );
+        return _token.c_str();
+    }
+
     void getCharacter( char& ch )
     {
         if ( !_preReadString.empty() )
@@ -334,12 +362,18 @@ protected:
         }
         else
         {
-            _in->get( ch );
+            // take the character straight from the stream buffer, as wrapped strings such as the
+            // Base64 encoded image data can be very long
+            std::streambuf* sb = _in->rdbuf();
+            int c = (_in->good() && sb) ? sb->sbumpc() : std::char_traits<char>::eof();
+            if ( c!=std::char_traits<char>::eof() ) ch = static_cast<char>(c);
+            else _in->setstate( _in->good() ? (std::ios_base::eofbit | std::ios_base::failbit) : std::ios_base::failbit );
             checkStream();
         }
     }
 
     std::string _preReadString;
+    std::string _token;
 };
 
 #endif
@@ -0,0 +1,269 @@
+#ifndef OSGDB_TEXTSTREAMNUMBERS
+#define OSGDB_TEXTSTREAMNUMBERS
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Formatting and tokenizing of the numbers of the ascii and XML formats straight to and from the
+// stream buffers. The formatted stream operators construct a sentry and go through the num_put
+// and ctype facets of the locale for every value, which is most of the time spent writing and
+// reading large arrays. The numbers are written as the stream operators would with the default
+// format flags, so that the files are unchanged, and the stream operators are still used when a
+// serializer has switched the stream to hex or any other format.
+namespace TextStreamNumbers
+{
+    // Large enough for any integer, and for doubles printed with up to MAX_PRECISION digits
+    const unsigned int BUFFER_SIZE = 64;
+    const std::streamsize MAX_PRECISION = 40;
+
+    inline bool isPlainDecimal( const std::ios_base& stream )
+    {
+        const std::ios_base::fmtflags nonDefaultFlags = std::ios_base::oct | std::ios_base::hex |
+            std::ios_base::showpos | std::ios_base::showpoint | std::ios_base::uppercase | std::ios_base::floatfield;
+        return (stream.flags() & nonDefaultFlags)==0 && stream.width()==0;
+    }
+
+    inline unsigned int formatUnsigned( char* buffer, unsigned long long value )
+    {
+        char digits[24];
+        unsigned int numDigits = 0;
+        do
+        {
+            digits[numDigits++] = static_cast<char>('0' + value%10);
+            value /= 10;
+        } while ( value>0 );
+
+        for ( unsigned int i=0; i<numDigits; ++i )
+            buffer[i] = digits[numDigits-1-i];
+        return numDigits;
+    }
+
+    inline unsigned int formatSigned( char* buffer, long long value )
+    {
+        if ( value>=0 ) return formatUnsigned( buffer, static_cast<unsigned long long>(value) );
+
+        // negate in unsigned arithmetic so that the smallest long long doesn't overflow
+        buffer[0] = '-';
+        return 1 + formatUnsigned( buffer+1, 0ull - static_cast<unsigned long long>(value) );
+    }
+
+    // Format a double as printf's %.*g does, using integer arithmetic for the common values whose
+    // rounding to the given number of digits can be done exactly in 64 bits, and returning 0 for
+    // the others.
+    inline unsigned int formatGeneral( char* buffer, double value, int precision )
+    {
+        static const unsigned long long powersOf10[20] =
+        {
+            1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+            1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+            100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+            1000000000000000000ull, 10000000000000000000ull
+        };
+
+        if ( precision<1 || precision>17 ) return 0;
+
+        unsigned long long bits = 0;
+        memcpy( &bits, &value, sizeof(bits) );
+
+        int biasedExponent = static_cast<int>((bits>>52) & 0x7ff);
+        unsigned long long mantissa = bits & ((1ull<<52)-1);
+        if ( biasedExponent==0x7ff || (biasedExponent==0 && mantissa!=0) ) return 0; // inf, nan and denormals
+
+        char* ptr = buffer;
+        if ( bits>>63 ) *ptr++ = '-';
+        if ( biasedExponent==0 )
+        {
+            *ptr++ = '0';
+            return static_cast<unsigned int>(ptr-buffer);
+        }
+
+        // value = mantissa * 2^exponent, with the trailing zero bits of the mantissa removed
+        mantissa |= 1ull<<52;
+        int exponent = biasedExponent - 1075;
+        while ( (mantissa & 0xff)==0 ) { mantissa >>= 8; exponent += 8; }
+        while ( (mantissa & 0x1)==0 ) { mantissa >>= 1; ++exponent; }
+
+        // digits = round(value / 10^(decimalExponent-precision+1)) as numerator/denominator, trying
+        // again with the next decimal exponent if the estimate from log10() was one out
+        int decimalExponent = static_cast<int>(floor(log10(fabs(value))));
+        for ( int attempt=0; attempt<3; ++attempt )
+        {
+            int scale = decimalExponent - (precision-1);
+            if ( scale<-19 || scale>19 || exponent<-62 || exponent>62 ) return 0;
+
+            unsigned long long numerator = mantissa, denominator = 1;
+            if ( exponent>=0 )
+            {
+                if ( (numerator>>(62-exponent))!=0 ) return 0;
+                numerator <<= exponent;
+            }
+            else denominator <<= -exponent;
+
+            if ( scale<0 )
+            {
+                if ( numerator>(~0ull>>1)/powersOf10[-scale] ) return 0;
+                numerator *= powersOf10[-scale];
+            }
+            else if ( scale>0 )
+            {
+                if ( denominator>(~0ull>>2)/powersOf10[scale] ) return 0;
+                denominator *= powersOf10[scale];
+            }
+
+            // round to nearest, ties to even as printf does
+            unsigned long long digits = numerator/denominator;
+            unsigned long long remainder = numerator%denominator;
+            if ( remainder*2>denominator || (remainder*2==denominator && (digits & 1)) ) ++digits;
+
+            if ( digits>=powersOf10[precision] ) { ++decimalExponent; continue; }
+            if ( digits<powersOf10[precision-1] ) { --decimalExponent; continue; }
+
+            char digitChars[20];
+            for ( int i=precision-1; i>=0; --i )
+            {
+                digitChars[i] = static_cast<char>('0' + digits%10);
+                digits /= 10;
+            }
+
+            int numDigits = precision;
+            while ( numDigits>1 && digitChars[numDigits-1]=='0' ) --numDigits;
+
+            if ( decimalExponent<-4 || decimalExponent>=precision )
+            {
+                *ptr++ = digitChars[0];
+                if ( numDigits>1 )
+                {
+                    *ptr++ = '.';
+                    for ( int i=1; i<numDigits; ++i ) *ptr++ = digitChars[i];
+                }
+                *ptr++ = 'e';
+                *ptr++ = decimalExponent<0 ? '-' : '+';
+                int absExponent = decimalExponent<0 ? -decimalExponent : decimalExponent;
+                if ( absExponent>=100 ) *ptr++ = static_cast<char>('0' + absExponent/100);
+                *ptr++ = static_cast<char>('0' + (absExponent/10)%10);
+                *ptr++ = static_cast<char>('0' + absExponent%10);
+            }
+            else if ( decimalExponent>=0 )
+            {
+                for ( int i=0; i<=decimalExponent; ++i ) *ptr++ = digitChars[i];
+                if ( numDigits>decimalExponent+1 )
+                {
+                    *ptr++ = '.';
+                    for ( int i=decimalExponent+1; i<numDigits; ++i ) *ptr++ = digitChars[i];
+                }
+            }
+            else
+            {
+                *ptr++ = '0';
+                *ptr++ = '.';
+                for ( int i=-1; i>decimalExponent; --i ) *ptr++ = '0';
+                for ( int i=0; i<numDigits; ++i ) *ptr++ = digitChars[i];
+            }
+            return static_cast<unsigned int>(ptr-buffer);
+        }
+        return 0;
+    }
+
+    inline unsigned int formatDouble( char* buffer, double value, std::streamsize precision )
+    {
+        if ( precision<0 ) precision = 6;
+        if ( precision>MAX_PRECISION ) return 0;
+
+        unsigned int generalLength = formatGeneral( buffer, value, precision>0 ? static_cast<int>(precision) : 1 );
+        if ( generalLength>0 ) return generalLength;
+
+        int length = snprintf( buffer, BUFFER_SIZE, "%.*g", static_cast<int>(precision), value );
+        if ( length<=0 || length>=static_cast<int>(BUFFER_SIZE) ) return 0;
+
+        // snprintf() uses the decimal point of the C locale, whereas the streams use the classic one
+        for ( int i=0; i<length; ++i )
+        {
+            if ( buffer[i]==',' ) buffer[i] = '.';
+            else if ( buffer[i] & 0x80 ) return 0;
+        }
+        return static_cast<unsigned int>(length);
+    }
+
+    // Format a number into the buffer as stream<<value would, returning its length, or 0 when the
+    // flags of the stream ask for another format than the default one.
+    inline unsigned int format( char* buffer, short value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatSigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, unsigned short value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatUnsigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, int value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatSigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, unsigned int value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatUnsigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, long value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatSigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, unsigned long value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatUnsigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, long long value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatSigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, unsigned long long value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatUnsigned(buffer, value) : 0; }
+
+    inline unsigned int format( char* buffer, float value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatDouble(buffer, value, stream.precision()) : 0; }
+
+    inline unsigned int format( char* buffer, double value, const std::ios_base& stream )
+    { return isPlainDecimal(stream) ? formatDouble(buffer, value, stream.precision()) : 0; }
+
+    // Write characters straight to the buffer of the stream.
+    inline void write( std::ostream& out, const char* buffer, unsigned int length )
+    {
+        std::streambuf* sb = out.rdbuf();
+        if ( !out.good() || !sb )
+            out.setstate( std::ios_base::failbit );
+        else if ( sb->sputn(buffer, length)!=static_cast<std::streamsize>(length) )
+            out.setstate( std::ios_base::badbit );
+    }
+
+    inline bool isSpace( int ch )
+    { return ch==' ' || ch=='\n' || ch=='\t' || ch=='\r' || ch=='\v' || ch=='\f'; }
+
+    // Read the next white space separated string of the stream, as stream>>str does, setting the
+    // eof and fail bits of the stream in the same way.
+    inline void readToken( std::istream& in, std::string& str )
+    {
+        str.clear();
+
+        std::streambuf* sb = in.rdbuf();
+        if ( !in.good() || !sb )
+        {
+            in.setstate( std::ios_base::failbit );
+            return;
+        }
+
+        const int eof = std::char_traits<char>::eof();
+        int ch = sb->sgetc();
+        while ( ch!=eof && isSpace(ch) ) ch = sb->snextc();
+
+        if ( ch==eof )
+        {
+            in.setstate( std::ios_base::eofbit | std::ios_base::failbit );
+            return;
+        }
+
+        do
+        {
+            str += static_cast<char>(ch);
+            ch = sb->snextc();
+        } while ( ch!=eof && !isSpace(ch) );
+
+        if ( ch==eof ) in.setstate( std::ios_base::eofbit );
+    }
+}
+
+#endif
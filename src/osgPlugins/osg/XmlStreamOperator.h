@@ -5,6 +5,8 @@
 #include <osgDB/XmlParser>
 #include <sstream>
 
+#include "TextStreamNumbers.h"
+
 class XmlOutputIterator : public osgDB::OutputIterator
 {
 public:
@@ -36,46 +38,46 @@ public:
     { addToCurrentNode( b ? std::string("TRUE") : std::string("FALSE") ); }
 
     virtual void writeChar( char c )
-    { _sstream << (short)c; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( (short)c ); }
 
     virtual void writeUChar( unsigned char c )
-    { _sstream << (unsigned short)c; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( (unsigned short)c ); }
 
     virtual void writeShort( short s )
-    { _sstream << s; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( s ); }
 
     virtual void writeUShort( unsigned short s )
-    { _sstream << s; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( s ); }
 
     virtual void writeInt( int i )
-    { _sstream << i; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( i ); }
 
     virtual void writeUInt( unsigned int i )
-    { _sstream << i; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( i ); }
 
     virtual void writeLong( long l )
-    { _sstream << l; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( l ); }
 
     virtual void writeULong( unsigned long l )
-    { _sstream << l; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( l ); }
 
     virtual void writeUInt64(uint64_t ull)
-    {_sstream << ull; addToCurrentNode( _sstream.str() ); _sstream.str("");}
+    { writeNumber( ull ); }
 
     virtual void writeInt64(int64_t ll)
-    {_sstream << ll; addToCurrentNode( _sstream.str() ); _sstream.str("");}
+    { writeNumber( ll ); }
 
     virtual void writeInt( unsigned long long ull )
-    { _sstream << ull; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( ull ); }
 
     virtual void writeUInt( long long ll )
-    { _sstream << ll; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( ll ); }
 
     virtual void writeFloat( float f )
-    { _sstream << f; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( f ); }
 
     virtual void writeDouble( double d )
-    { _sstream << d; addToCurrentNode( _sstream.str() ); _sstream.str(""); }
+    { writeNumber( d ); }
 
     virtual void writeString( const std::string& s )
     { addToCurrentNode( s, true ); }
@@ -188,6 +190,21 @@ public:
     }
 
 protected:
+    template<typename T>
+    void writeNumber( T value )
+    {
+        char buffer[TextStreamNumbers::BUFFER_SIZE];
+        unsigned int length = TextStreamNumbers::format( buffer, value, _sstream );
+        if ( length>0 )
+            addToCurrentNode( std::string(buffer, length) );
+        else
+        {
+            _sstream << value;
+            addToCurrentNode( _sstream.str() );
+            _sstream.str("");
+        }
+    }
+
     void addToCurrentNode( const std::string& str, bool isString=false )
     {
         if ( _readLineType==FIRST_LINE )
@@ -211,7 +228,8 @@ protected:
         if ( _readLineType==TEXT_LINE )
         {
             std::string& text = _nodePath.back()->properties["text"];
-            text += str + ' ';
+            text += str;
+            text += ' ';
         }
         else if ( _nodePath.size()>0 )
         {
@@ -362,32 +380,32 @@ public:
     }
 
     virtual void readShort( short& s )
-    { std::string str; if (prepareStream()) _sstream >> str; s = static_cast<short>(strtol(str.c_str(), NULL, 0)); }
+    { s = static_cast<short>(strtol(readNumber(), NULL, 0)); }
 
     virtual void readUShort( unsigned short& s )
-    { std::string str; if (prepareStream()) _sstream >> str; s = static_cast<unsigned short>(strtoul(str.c_str(), NULL, 0)); }
+    { s = static_cast<unsigned short>(strtoul(readNumber(), NULL, 0)); }
 
     virtual void readInt( int& i )
-    { std::string str; if (prepareStream()) _sstream >> str; i = static_cast<int>(strtol(str.c_str(), NULL, 0)); }
+    { i = static_cast<int>(strtol(readNumber(), NULL, 0)); }
 
     virtual void readUInt( unsigned int& i )
-    { std::string str; if (prepareStream()) _sstream >> str; i = static_cast<unsigned int>(strtoul(str.c_str(), NULL, 0)); }
+    { i = static_cast<unsigned int>(strtoul(readNumber(), NULL, 0)); }
 
     virtual void readLong( long& l )
-    { std::string str; if (prepareStream()) _sstream >> str; l = strtol(str.c_str(), NULL, 0); }
+    { l = strtol(readNumber(), NULL, 0); }
 
     virtual void readULong( unsigned long& l )
-    { std::string str; if (prepareStream()) _sstream >> str; l = strtoul(str.c_str(), NULL, 0); }
+    { l = strtoul(readNumber(), NULL, 0); }
 
     virtual void readFloat( float& f )
-    { std::string str; if (prepareStream()) _sstream >> str; f = osg::asciiToFloat(str.c_str()); }
+    { f = osg::asciiToFloat(readNumber()); }
 
     virtual void readDouble( double& d )
-    { std::string str; if (prepareStream()) _sstream >> str; d = osg::asciiToDouble(str.c_str()); }
+    { d = osg::asciiToDouble(readNumber()); }
 
     virtual void readString( std::string& s )
     {
-        if ( prepareStream() ) _sstream >> s;
+        if ( prepareStream() ) TextStreamNumbers::readToken( _sstream, s );
 
         // Replace '--' to '::' to get correct wrapper class
         std::string::size_type pos = s.find("--");
@@ -508,6 +526,13 @@ public:
     virtual void advanceToCurrentEndBracket() {}
 
 protected:
+    const char* readNumber()
+    {
+        _token.clear();
+        if ( prepareStream() ) TextStreamNumbers::readToken( _sstream, _token );
+        return _token.c_str();
+    }
+
     bool isReadable() const { return _sstream.rdbuf()->in_avail()>0; }
 
     bool prepareStream()
@@ -560,6 +585,7 @@ protected:
 
     osg::ref_ptr<osgDB::XmlNode> _root;
     std::stringstream _sstream;
+    std::string _token;
 };
 
 #endif
@@ -3,6 +3,26 @@
 
 #include <osgDB/Registry>
 #include <osgDB/FileNameUtils>
+#include <osgDB/ConvertUTF>
+
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/types.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
 
 #include "OSGA_Archive.h"
 
@@ -318,6 +338,129 @@ void OSGA_Archive::IndexBlock::setPositionNextIndexBlock(pos_type position)
     _requiresWrite = true;
 }
 
+#if defined(_WIN32) && !defined(__CYGWIN__)
+
+OSGA_Archive::FileReader::FileReader():
+    _handle(INVALID_HANDLE_VALUE)
+{
+}
+
+bool OSGA_Archive::FileReader::open(const std::string& filename)
+{
+    close();
+
+#ifdef OSG_USE_UTF8_FILENAME
+    _handle = CreateFileW(osgDB::convertUTF8toUTF16(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+#else
+    _handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+#endif
+    return valid();
+}
+
+void OSGA_Archive::FileReader::close()
+{
+    if (valid()) CloseHandle(_handle);
+    _handle = INVALID_HANDLE_VALUE;
+}
+
+bool OSGA_Archive::FileReader::valid() const
+{
+    return _handle!=INVALID_HANDLE_VALUE;
+}
+
+bool OSGA_Archive::FileReader::read(pos_type position, size_type size, char* data) const
+{
+    while(size>0)
+    {
+        // ReadFile with an OVERLAPPED offset on a synchronous handle reads from that position without relying on the shared file pointer
+        OVERLAPPED overlapped;
+        memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.Offset = static_cast<DWORD>(position & 0xffffffff);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+        DWORD numToRead = static_cast<DWORD>(std::min(size, size_type(1<<30)));
+        DWORD numRead = 0;
+        if (!ReadFile(_handle, data, numToRead, &numRead, &overlapped) || numRead==0) return false;
+
+        position += numRead;
+        size -= numRead;
+        data += numRead;
+    }
+    return true;
+}
+
+#else
+
+OSGA_Archive::FileReader::FileReader():
+    _fd(-1)
+{
+}
+
+bool OSGA_Archive::FileReader::open(const std::string& filename)
+{
+    close();
+
+    _fd = ::open(filename.c_str(), O_RDONLY);
+    return valid();
+}
+
+void OSGA_Archive::FileReader::close()
+{
+    if (valid()) ::close(_fd);
+    _fd = -1;
+}
+
+bool OSGA_Archive::FileReader::valid() const
+{
+    return _fd>=0;
+}
+
+bool OSGA_Archive::FileReader::read(pos_type position, size_type size, char* data) const
+{
+    while(size>0)
+    {
+        ssize_t numRead = ::pread(_fd, data, static_cast<size_t>(std::min(size, size_type(1<<30))), static_cast<off_t>(position));
+        if (numRead<0 && errno==EINTR) continue;
+        if (numRead<=0) return false;
+
+        position += numRead;
+        size -= numRead;
+        data += numRead;
+    }
+    return true;
+}
+
+#endif
+
+OSGA_Archive::FileReader::~FileReader()
+{
+    close();
+}
+
+osg::ref_ptr<OSGA_Archive::FileReader> OSGA_Archive::getFileReader() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_fileReaderMutex);
+    return _fileReader;
+}
+
+void OSGA_Archive::setFileReader(FileReader* fileReader)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_fileReaderMutex);
+    _fileReader = fileReader;
+}
+
+osg::ref_ptr<const OSGA_Archive::ReadIndex> OSGA_Archive::getReadIndex() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_fileReaderMutex);
+    return _readIndex;
+}
+
+void OSGA_Archive::setReadIndex(const ReadIndex* readIndex)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_fileReaderMutex);
+    _readIndex = readIndex;
+}
+
 OSGA_Archive::OSGA_Archive():
     _version(0.0f),
     _status(READ)
@@ -341,7 +484,17 @@ bool OSGA_Archive::open(const std::string& filename, ArchiveStatus status, unsig
         _status = status;
         _input.open(filename.c_str(), std::ios_base::binary | std::ios_base::in);
 
-        return _open(_input);
+        if (!_open(_input)) return false;
+
+        // the index is complete so files can now be read concurrently through positional reads,
+        // leaving _input and the _serializerMutex as the fallback if the file can't be opened that way.
+        setReadIndex(new ReadIndex(_indexMap));
+
+        osg::ref_ptr<FileReader> fileReader = new FileReader;
+        if (fileReader->open(filename)) setFileReader(fileReader.get());
+        else OSG_INFO<<"OSGA_Archive::open("<<filename<<") positional reads not available, reads will be serialized."<<std::endl;
+
+        return true;
     }
     else
     {
@@ -377,6 +530,9 @@ bool OSGA_Archive::open(const std::string& filename, ArchiveStatus status, unsig
             _input.close();
             _status = WRITE;
 
+            setReadIndex(0);
+            setFileReader(0);
+
             osgDB::open(_output, filename.c_str(), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
 
             OSG_INFO<<"File position after open = "<<ARCHIVE_POS( _output.tellp() )<<" is_open "<<_output.is_open()<<std::endl;
@@ -495,6 +651,9 @@ void OSGA_Archive::close()
 
     _input.close();
 
+    // reads in progress hold their own reference to the FileReader, the file is closed once the last of them finishes.
+    setFileReader(0);
+
     if (_status==WRITE)
     {
         writeIndexBlocks();
@@ -509,12 +668,20 @@ std::string OSGA_Archive::getMasterFileName() const
 
 osgDB::FileType OSGA_Archive::getFileType(const std::string& filename) const
 {
-    if (_indexMap.count(filename)!=0) return osgDB::REGULAR_FILE;
+    PositionSizePair positionSize;
+    if (findFileReference(filename, positionSize)) return osgDB::REGULAR_FILE;
     return osgDB::FILE_NOT_FOUND;
 }
 
 bool OSGA_Archive::getFileNames(FileNameList& fileNameList) const
 {
+    osg::ref_ptr<const ReadIndex> readIndex = getReadIndex();
+    if (readIndex.valid())
+    {
+        readIndex->getFileNames(fileNameList);
+        return !fileNameList.empty();
+    }
+
     SERIALIZER();
 
     fileNameList.clear();
@@ -548,7 +715,53 @@ void OSGA_Archive::writeIndexBlocks()
 
 bool OSGA_Archive::fileExists(const std::string& filename) const
 {
-    return (_indexMap.count(filename)!=0);
+    PositionSizePair positionSize;
+    return findFileReference(filename, positionSize);
+}
+
+struct FileNameLess
+{
+    bool operator() (const OSGA_Archive::FileNamePositionList::value_type& lhs, const std::string& rhs) const { return lhs.first < rhs; }
+};
+
+OSGA_Archive::ReadIndex::ReadIndex(const FileNamePositionMap& indexMap):
+    _entries(indexMap.begin(), indexMap.end())
+{
+}
+
+bool OSGA_Archive::ReadIndex::find(const std::string& fileName, PositionSizePair& positionSize) const
+{
+    FileNamePositionList::const_iterator itr = std::lower_bound(_entries.begin(), _entries.end(), fileName, FileNameLess());
+    if (itr==_entries.end() || itr->first!=fileName) return false;
+
+    positionSize = itr->second;
+    return true;
+}
+
+void OSGA_Archive::ReadIndex::getFileNames(FileNameList& fileNameList) const
+{
+    fileNameList.clear();
+    fileNameList.reserve(_entries.size());
+    for(FileNamePositionList::const_iterator itr=_entries.begin();
+        itr!=_entries.end();
+        ++itr)
+    {
+        fileNameList.push_back(itr->first);
+    }
+}
+
+bool OSGA_Archive::findFileReference(const std::string& fileName, PositionSizePair& positionSize) const
+{
+    osg::ref_ptr<const ReadIndex> readIndex = getReadIndex();
+    if (readIndex.valid()) return readIndex->find(fileName, positionSize);
+
+    SERIALIZER();
+
+    FileNamePositionMap::const_iterator itr = _indexMap.find(fileName);
+    if (itr==_indexMap.end()) return false;
+
+    positionSize = itr->second;
+    return true;
 }
 
 bool OSGA_Archive::addFileReference(pos_type position, size_type size, const std::string& fileName)
@@ -724,8 +937,89 @@ struct OSGA_Archive::ReadShaderFunctor : public OSGA_Archive::ReadFunctor
     virtual ReaderWriter::ReadResult doRead(ReaderWriter& rw, std::istream& input) const { return rw.readShader(input, _options); }
 };
 
+// streambuffer class to read a file held in memory, used for files fetched with positional reads.
+
+class memory_streambuf : public std::streambuf
+{
+public:
+
+    memory_streambuf(char* data, std::streamoff size)
+    {
+        setg(data, data, data+size);
+    }
+
+protected:
+
+    virtual std::streampos seekoff (std::streamoff off, std::ios_base::seekdir way,
+                   std::ios_base::openmode which = std::ios_base::in)
+    {
+        if (!(which & std::ios_base::in)) return -1;
+
+        std::streamoff newpos;
+        if ( way == std::ios_base::beg ) newpos = off;
+        else if ( way == std::ios_base::cur ) newpos = (gptr()-eback()) + off;
+        else if ( way == std::ios_base::end ) newpos = (egptr()-eback()) + off;
+        else return -1;
+
+        if ( newpos<0 || newpos>(egptr()-eback()) ) return -1;
+        setg(eback(), eback()+newpos, egptr());
+        return newpos;
+    }
+
+    virtual std::streampos seekpos (std::streampos sp, std::ios_base::openmode which = std::ios_base::in)
+    {
+        return seekoff(sp, std::ios_base::beg, which);
+    }
+};
+
+ReaderWriter::ReadResult OSGA_Archive::readConcurrently(const FileReader& fileReader, const ReadFunctor& readFunctor, const PositionSizePair& positionSize) const
+{
+    if (positionSize.second<0 || static_cast<unsigned long long>(positionSize.second)>static_cast<unsigned long long>(std::numeric_limits<size_t>::max()))
+    {
+        OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed, file too large to read."<<std::endl;
+        return ReadResult(ReadResult::ERROR_IN_READING_FILE);
+    }
+
+    ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension(getLowerCaseFileExtension(readFunctor._filename));
+    if (!rw)
+    {
+        OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed to find appropriate plugin to read file."<<std::endl;
+        return ReadResult(ReadResult::FILE_NOT_HANDLED);
+    }
+
+    OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<")"<<std::endl;
+
+    // fetch the whole file in one positional read so the plugin parses from memory rather than going through the one character proxy_streambuf.
+    std::vector<char> data(static_cast<size_t>(positionSize.second));
+    if (!data.empty() && !fileReader.read(positionSize.first, positionSize.second, &data.front()))
+    {
+        OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed to read file data from archive."<<std::endl;
+        return ReadResult(ReadResult::ERROR_IN_READING_FILE);
+    }
+
+    memory_streambuf streambuf(data.empty() ? 0 : &data.front(), static_cast<std::streamoff>(data.size()));
+    std::istream input(&streambuf);
+
+    return readFunctor.doRead(*rw, input);
+}
+
 ReaderWriter::ReadResult OSGA_Archive::read(const ReadFunctor& readFunctor)
 {
+    // once opened for READ the index is immutable, so reads don't need to be serialized.
+    osg::ref_ptr<const ReadIndex> readIndex = getReadIndex();
+    osg::ref_ptr<FileReader> fileReader = getFileReader();
+    if (readIndex.valid() && fileReader.valid())
+    {
+        PositionSizePair positionSize;
+        if (!readIndex->find(readFunctor._filename, positionSize))
+        {
+            OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed, file not found in archive"<<std::endl;
+            return ReadResult(ReadResult::FILE_NOT_FOUND);
+        }
+
+        return readConcurrently(*fileReader, readFunctor, positionSize);
+    }
+
     SERIALIZER();
 
     if (_status!=READ)
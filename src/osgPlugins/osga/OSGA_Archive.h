@@ -16,6 +16,7 @@
 #include <osgDB/FileNameUtils>
 
 #include <OpenThreads/ScopedLock>
+#include <OpenThreads/Mutex>
 #include <OpenThreads/ReentrantMutex>
 
 #define SERIALIZER() OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_serializerMutex)
@@ -100,11 +101,39 @@ class OSGA_Archive : public osgDB::Archive
 
         typedef std::pair<pos_type, size_type> PositionSizePair;
         typedef std::map<std::string, PositionSizePair> FileNamePositionMap;
+        typedef std::vector< std::pair<std::string, PositionSizePair> > FileNamePositionList;
 
     protected:
 
         mutable OpenThreads::ReentrantMutex _serializerMutex;
 
+        /** Reads portions of the archive file at absolute positions without a shared file pointer,
+          * using pread() or overlapped ReadFile(), so that any number of threads may read from it at once.*/
+        class FileReader : public osg::Referenced
+        {
+        public:
+            FileReader();
+
+            bool open(const std::string& filename);
+
+            void close();
+
+            bool valid() const;
+
+            /** Read size bytes starting at position into data, return false if they could not all be read.*/
+            bool read(pos_type position, size_type size, char* data) const;
+
+        protected:
+
+            virtual ~FileReader();
+
+            #if defined(_WIN32) && !defined(__CYGWIN__)
+            void*   _handle;
+            #else
+            int     _fd;
+            #endif
+        };
+
         class IndexBlock;
         friend class IndexBlock;
 
@@ -209,6 +238,41 @@ class OSGA_Archive : public osgDB::Archive
 
         bool _open(std::istream& fin);
 
+        /** Sorted copy of the _indexMap of an archive opened for READ, never modified once published so that
+          * files can be looked up without the _serializerMutex. Reopening the archive for WRITE publishes no
+          * index rather than clearing this one, lookups in progress keeping their own reference to it.*/
+        class ReadIndex : public osg::Referenced
+        {
+        public:
+            ReadIndex(const FileNamePositionMap& indexMap);
+
+            bool find(const std::string& fileName, PositionSizePair& positionSize) const;
+
+            void getFileNames(FileNameList& fileNameList) const;
+
+        protected:
+            virtual ~ReadIndex() {}
+
+            FileNamePositionList _entries;
+        };
+
+        /** Find the position and size of a file, in READ mode through the ReadIndex so it may be called without locking.*/
+        bool findFileReference(const std::string& fileName, PositionSizePair& positionSize) const;
+
+        /** Read a file from the archive with positional reads without taking the _serializerMutex.*/
+        osgDB::ReaderWriter::ReadResult readConcurrently(const FileReader& fileReader, const ReadFunctor& readFunctor, const PositionSizePair& positionSize) const;
+
+        /** Return the FileReader of an archive opened for READ, NULL if positional reads aren't available.
+          * Each read holds a reference to it so that close() only releases the file once the last read has finished.*/
+        osg::ref_ptr<FileReader> getFileReader() const;
+
+        void setFileReader(FileReader* fileReader);
+
+        /** Return the ReadIndex of an archive opened for READ, NULL otherwise.*/
+        osg::ref_ptr<const ReadIndex> getReadIndex() const;
+
+        void setReadIndex(const ReadIndex* readIndex);
+
         void writeIndexBlocks();
 
         bool addFileReference(pos_type position, size_type size, const std::string& fileName);
@@ -224,6 +288,11 @@ class OSGA_Archive : public osgDB::Archive
         IndexBlockList      _indexBlockList;
         FileNamePositionMap _indexMap;
 
+        // guards swapping the _readIndex and _fileReader used by the reads that don't take the _serializerMutex
+        mutable OpenThreads::Mutex      _fileReaderMutex;
+        osg::ref_ptr<const ReadIndex>   _readIndex;
+        osg::ref_ptr<FileReader>        _fileReader;
+
 
         template <typename T>
         static inline void _write(char* ptr, const T& value)
@@ -23,6 +23,8 @@
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
 
+#include <sstream>
+#include <stdlib.h>
 
 #include "vertexData.h"
 
@@ -42,6 +44,7 @@ public:
     ReaderWriterPLY()
     {
         supportsExtension("ply","Stanford Triangle Format");
+        supportsOption("chunkSize=<num>","Maximum number of faces, or of points without faces, per geometry. Larger meshes are split into several geometries. Default 0 only splits meshes too large for a single buffer object.");
     }
 
     virtual const char* className() const { return "ReaderWriterPLY"; }
@@ -78,6 +81,21 @@ osgDB::ReaderWriter::ReadResult ReaderWriterPLY::readNode(const std::string& fil
 
     //Instance of vertex data which will read the ply file and convert in to osg::Node
     ply::VertexData vertexData;
+
+    if (options)
+    {
+        std::istringstream iss(options->getOptionString());
+        std::string opt;
+        while (iss >> opt)
+        {
+            std::string::size_type pos = opt.find('=');
+            if (pos != std::string::npos && opt.substr(0, pos) == "chunkSize")
+            {
+                vertexData.setChunkSize(atoi(opt.substr(pos + 1).c_str()));
+            }
+        }
+    }
+
     osg::Node* node = vertexData.readPlyFile(fileName.c_str());
 
     if (node)
@@ -13,7 +13,9 @@
 #include "ply.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <osg/Endian>
 #include <osg/Geometry>
 #include <osg/Geode>
 #include <osg/io_utils>
@@ -24,13 +26,395 @@
 #include <osgDB/ReadFile>
 #include <osg/Texture2D>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+    #define PLY_USE_SSE2 1
+    #include <emmintrin.h>
+#endif
+
 using namespace std;
 using namespace ply;
 
 
+namespace ply
+{
+    /*  Buffered reader of the data that follows the header of a binary file.  */
+    class BinaryReader
+    {
+    public:
+        BinaryReader( FILE* fp, const bool swap )
+            : _fp( fp ), _swap( swap ), _buffer( 4*1024*1024 ), _pos( 0 ), _end( 0 ) {}
+
+        // true if the byte order of the file is not the one of the machine
+        bool swap() const { return _swap; }
+
+        // Makes size bytes available at data(), returns false if the file
+        // ends before.
+        inline bool request( const size_t size )
+        {
+            return _end - _pos >= size || fill( size );
+        }
+
+        unsigned char* data() { return &_buffer[0] + _pos; }
+
+        void advance( const size_t size ) { _pos += size; }
+
+        // Skips size bytes, returns false if the file ends before.
+        bool skip( size_t size )
+        {
+            while( size > 0 )
+            {
+                const size_t blockSize = std::min( size, _buffer.size() );
+                if( !request( blockSize ) )
+                    return false;
+                advance( blockSize );
+                size -= blockSize;
+            }
+            return true;
+        }
+
+    private:
+        bool fill( const size_t size )
+        {
+            // keep the bytes left and read as many as fit after them
+            if( _pos > 0 )
+            {
+                memmove( &_buffer[0], &_buffer[0] + _pos, _end - _pos );
+                _end -= _pos;
+                _pos = 0;
+            }
+            if( size > _buffer.size() )
+                _buffer.resize( size );
+            _end += fread( &_buffer[0] + _end, 1, _buffer.size() - _end, _fp );
+            return _end >= size;
+        }
+
+        FILE*                       _fp;
+        bool                        _swap;
+        std::vector<unsigned char>  _buffer;
+        size_t                      _pos;
+        size_t                      _end;
+    };
+}
+
+
+namespace
+{
+    // Number of bytes of vertex records converted at once, small enough for
+    // the records to stay in the cache while their columns are converted.
+    const unsigned int VERTEX_BLOCK_SIZE = 64*1024;
+
+    // Number of faces per geometry of meshes too large for a single geometry.
+    const unsigned int DEFAULT_CHUNK_SIZE = 16*1024*1024;
+
+    bool isValidType( const int type )
+    {
+        return type > PLY_START_TYPE && type < PLY_END_TYPE;
+    }
+
+    unsigned int getTypeSize( const int type )
+    {
+        switch( type )
+        {
+            case PLY_CHAR:
+            case PLY_UCHAR:
+            case PLY_UINT8:
+                return 1;
+            case PLY_SHORT:
+            case PLY_USHORT:
+                return 2;
+            case PLY_DOUBLE:
+                return 8;
+            default:
+                return 4;
+        }
+    }
+
+    bool isIntegerType( const int type )
+    {
+        return type != PLY_FLOAT && type != PLY_FLOAT32 && type != PLY_DOUBLE;
+    }
+
+    // Reads a value of type T from a possibly unaligned location, reversing
+    // its bytes if Swap is true.
+    template<typename T, bool Swap>
+    inline T load( const unsigned char* ptr )
+    {
+        unsigned char bytes[sizeof(T)];
+        for( unsigned int i = 0; i < sizeof(T); ++i )
+            bytes[i] = ptr[Swap ? sizeof(T) - 1 - i : i];
+
+        T value;
+        memcpy( &value, bytes, sizeof(T) );
+        return value;
+    }
+
+    // Reverses the bytes of numWords 4 byte words, four words at a time with SSE2.
+    void swapBytes4( unsigned char* data, const size_t numWords )
+    {
+        size_t i = 0;
+    #if defined(PLY_USE_SSE2)
+        for( ; i + 4 <= numWords; i += 4 )
+        {
+            __m128i* ptr = reinterpret_cast<__m128i*>( data + i*4 );
+            __m128i words = _mm_loadu_si128( ptr );
+            // swap the bytes of each 16 bit half, then the two halves
+            words = _mm_or_si128( _mm_srli_epi16( words, 8 ), _mm_slli_epi16( words, 8 ) );
+            words = _mm_shufflelo_epi16( words, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+            words = _mm_shufflehi_epi16( words, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+            _mm_storeu_si128( ptr, words );
+        }
+    #endif
+        for( ; i < numWords; ++i )
+        {
+            unsigned char* word = data + i*4;
+            std::swap( word[0], word[3] );
+            std::swap( word[1], word[2] );
+        }
+    }
+
+    // Converts a property of count records to floats, the same way as the
+    // generic reader stores a float, or an unsigned char color component
+    // scaled to [0,1].
+    template<typename T, bool Swap, bool Color>
+    void convertColumn( const unsigned char* src, const unsigned int stride,
+                        float* dst, const unsigned int dstStride,
+                        const unsigned int count )
+    {
+        for( unsigned int i = 0; i < count; ++i, src += stride, dst += dstStride )
+        {
+            const T value = load<T, Swap>( src );
+            if( Color )
+                *dst = static_cast<unsigned int>( static_cast<unsigned char>( static_cast<unsigned int>( value ) ) ) / 255.0;
+            else
+                *dst = static_cast<float>( value );
+        }
+    }
+
+    template<bool Color>
+    void convertColumn( const int type, const bool swap,
+                        const unsigned char* src, const unsigned int stride,
+                        float* dst, const unsigned int dstStride,
+                        const unsigned int count )
+    {
+        switch( type )
+        {
+            case PLY_CHAR:
+                convertColumn<signed char, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_UCHAR:
+            case PLY_UINT8:
+                convertColumn<unsigned char, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_SHORT:
+                if( swap ) convertColumn<short, true, Color>( src, stride, dst, dstStride, count );
+                else convertColumn<short, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_USHORT:
+                if( swap ) convertColumn<unsigned short, true, Color>( src, stride, dst, dstStride, count );
+                else convertColumn<unsigned short, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_INT:
+            case PLY_INT32:
+                if( swap ) convertColumn<int, true, Color>( src, stride, dst, dstStride, count );
+                else convertColumn<int, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_UINT:
+                if( swap ) convertColumn<unsigned int, true, Color>( src, stride, dst, dstStride, count );
+                else convertColumn<unsigned int, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_FLOAT:
+            case PLY_FLOAT32:
+                if( swap ) convertColumn<float, true, Color>( src, stride, dst, dstStride, count );
+                else convertColumn<float, false, Color>( src, stride, dst, dstStride, count );
+                break;
+            case PLY_DOUBLE:
+                if( swap ) convertColumn<double, true, Color>( src, stride, dst, dstStride, count );
+                else convertColumn<double, false, Color>( src, stride, dst, dstStride, count );
+                break;
+        }
+    }
+
+    // A vertex property converted into a component of one of the arrays.
+    struct Column
+    {
+        int             type;
+        unsigned int    offset;
+        float*          dst;
+        unsigned int    dstStride;
+        bool            color;
+    };
+
+    // Adds a column for each of the named properties found in the element,
+    // the i-th name going to the i-th component of the array elements.
+    void addColumns( std::vector<Column>& columns, PlyElement* elem,
+                     const std::vector<unsigned int>& offsets,
+                     const char* const* names, const unsigned int numNames,
+                     float* dst, const unsigned int dstStride, const bool color )
+    {
+        for( unsigned int i = 0; i < numNames; ++i )
+        {
+            for( int j = 0; j < elem->nprops; ++j )
+            {
+                if( equal_strings( elem->props[j]->name, names[i] ) )
+                {
+                    Column column = { elem->props[j]->external_type, offsets[j], dst + i, dstStride, color };
+                    columns.push_back( column );
+                    break;
+                }
+            }
+        }
+    }
+
+    typedef int (*IntLoader)( const unsigned char* );
+
+    template<typename T, bool Swap>
+    int loadInt( const unsigned char* ptr )
+    {
+        return static_cast<int>( load<T, Swap>( ptr ) );
+    }
+
+    template<typename T>
+    IntLoader getIntLoader( const bool swap )
+    {
+        return swap ? &loadInt<T, true> : &loadInt<T, false>;
+    }
+
+    // Returns a function reading a value of the given type as the generic
+    // reader converts it to an int.
+    IntLoader getIntLoader( const int type, const bool swap )
+    {
+        switch( type )
+        {
+            case PLY_CHAR: return getIntLoader<signed char>( false );
+            case PLY_UCHAR:
+            case PLY_UINT8: return getIntLoader<unsigned char>( false );
+            case PLY_SHORT: return getIntLoader<short>( swap );
+            case PLY_USHORT: return getIntLoader<unsigned short>( swap );
+            case PLY_UINT: return getIntLoader<unsigned int>( swap );
+            case PLY_FLOAT:
+            case PLY_FLOAT32: return getIntLoader<float>( swap );
+            case PLY_DOUBLE: return getIntLoader<double>( swap );
+            default: return getIntLoader<int>( swap );
+        }
+    }
+
+    // Layout of a property in the records of an element.
+    struct PropertyLayout
+    {
+        bool            isList;
+        unsigned int    size;       // size of the value, or of the list items
+        unsigned int    countSize;
+        IntLoader       loadCount;
+        IntLoader       loadValue;
+    };
+
+    // Returns the layout of the records of an element, and their size if
+    // they have no list properties, 0 otherwise.
+    std::vector<PropertyLayout> getLayout( PlyElement* elem, const bool swap,
+                                           unsigned int& recordSize )
+    {
+        std::vector<PropertyLayout> layout( elem->nprops );
+        recordSize = 0;
+        bool fixedSize = true;
+        for( int j = 0; j < elem->nprops; ++j )
+        {
+            PlyProperty* prop = elem->props[j];
+            layout[j].isList = prop->is_list == PLY_LIST;
+            layout[j].size = getTypeSize( prop->external_type );
+            layout[j].loadValue = getIntLoader( prop->external_type, swap );
+            if( layout[j].isList )
+            {
+                layout[j].countSize = getTypeSize( prop->count_external );
+                layout[j].loadCount = getIntLoader( prop->count_external, swap );
+                fixedSize = false;
+            }
+            else
+            {
+                layout[j].countSize = 0;
+                layout[j].loadCount = NULL;
+                recordSize += layout[j].size;
+            }
+        }
+        if( !fixedSize )
+            recordSize = 0;
+        return layout;
+    }
+
+    // Reads a list count, returns the size of the list items in bytes.
+    inline bool readListCount( const PropertyLayout& layout, BinaryReader& reader,
+                               int& count, size_t& size )
+    {
+        if( !reader.request( layout.countSize ) )
+            return false;
+        count = layout.loadCount( reader.data() );
+        reader.advance( layout.countSize );
+        size = count > 0 ? static_cast<size_t>( count ) * layout.size : 0;
+        return reader.request( size );
+    }
+
+    // Skips over the records of an element that isn't read.
+    bool skipRecords( PlyElement* elem, BinaryReader& reader )
+    {
+        unsigned int recordSize;
+        const std::vector<PropertyLayout> layout = getLayout( elem, reader.swap(), recordSize );
+        if( recordSize > 0 )
+            return reader.skip( static_cast<size_t>( elem->num ) * recordSize );
+
+        for( int i = 0; i < elem->num; ++i )
+        {
+            for( std::vector<PropertyLayout>::const_iterator itr = layout.begin(); itr != layout.end(); ++itr )
+            {
+                size_t size = itr->size;
+                int count;
+                if( itr->isList && !readListCount( *itr, reader, count, size ) )
+                    return false;
+                if( !reader.skip( size ) )
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template<class ArrayType>
+    ArrayType* copyRange( const ArrayType* array, const unsigned int first, const unsigned int last )
+    {
+        return array ? new ArrayType( array->begin() + first, array->begin() + last ) : NULL;
+    }
+
+    /*  Add the normals of the faces, weighted by their area, to the sums of
+        the vertices they use.  The normal of a quad is taken across its
+        diagonals.  */
+    void addFaceNormals( const osg::Vec3Array& vertices,
+                         const osg::DrawElementsUInt& primitives,
+                         const unsigned int nIndices,
+                         osg::Vec3Array& normalSums )
+    {
+        const unsigned int nVertices = vertices.size();
+        unsigned int indices[4];
+        for( unsigned int i = 0; i + nIndices <= primitives.size(); i += nIndices )
+        {
+            for( unsigned int j = 0; j < nIndices; ++j )
+                indices[j] = primitives[i + j] < nVertices ? primitives[i + j] : 0;
+
+            osg::Vec3 normal;
+            if( nIndices == 3 )
+                normal = ( vertices[indices[1]] - vertices[indices[0]] ) ^ ( vertices[indices[2]] - vertices[indices[0]] );
+            else
+                normal = ( vertices[indices[2]] - vertices[indices[0]] ) ^ ( vertices[indices[3]] - vertices[indices[1]] );
+
+            for( unsigned int j = 0; j < nIndices; ++j )
+                normalSums[indices[j]] += normal;
+        }
+    }
+}
+
+
 /*  Constructor.  */
 VertexData::VertexData()
-    : _invertFaces( false )
+    : _invertFaces( false ),
+      _chunkSize( 0 ),
+      _facesPerChunk( 0 ),
+      _numChunkFaces( 0 )
 {
     // Initialize the members
     _vertices = NULL;
@@ -229,15 +613,7 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
 
     ply_get_property( file, "face", &faceProps[0] );
 
-    if(!_triangles.valid())
-        _triangles = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
-
-    if(!_quads.valid())
-        _quads = new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
-
-
-    const char NUM_VERTICES_TRIANGLE(3);
-    const char NUM_VERTICES_QUAD(4);
+    startTriangles( nFaces > 0 ? nFaces : 0 );
 
     // read the faces, reversing the reading direction if _invertFaces is true
     for( int i = 0 ; i < nFaces; i++ )
@@ -249,22 +625,480 @@ void VertexData::readTriangles( PlyFile* file, const int nFaces )
         ply_get_element( file, static_cast< void* >( &face ) );
         if (face.vertices)
         {
-            if (face.nVertices == NUM_VERTICES_TRIANGLE ||  face.nVertices == NUM_VERTICES_QUAD)
+            addFace( reinterpret_cast< const unsigned int* >( face.vertices ), face.nVertices );
+
+            // free the memory that was allocated by ply_get_element
+            free( face.vertices );
+        }
+    }
+}
+
+
+/*  Prepare the primitive sets for the faces and decide whether the mesh is
+    split into chunks.  */
+void VertexData::startTriangles( const unsigned int nFaces )
+{
+    if(!_triangles.valid())
+        _triangles = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
+
+    if(!_quads.valid())
+        _quads = new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+
+    // the faces can only be split once the vertices they use are known
+    const unsigned int nVertices = _vertices.valid() ? _vertices->size() : 0;
+    if( nVertices == 0 || _chunks.valid() )
+        return;
+
+    _facesPerChunk = _chunkSize;
+    if( _facesPerChunk == 0 )
+    {
+        // split meshes with arrays larger than a buffer object can hold
+        const unsigned long long maxBytes = 0xffffffffull;
+        const unsigned long long vertexBytes = getColors() ? sizeof( osg::Vec4 ) : sizeof( osg::Vec3 );
+        if( nVertices * vertexBytes > maxBytes ||
+            static_cast< unsigned long long >( nFaces ) * 4 * sizeof( GLuint ) > maxBytes )
+            _facesPerChunk = DEFAULT_CHUNK_SIZE;
+    }
+
+    if( _facesPerChunk > 0 && nFaces > _facesPerChunk )
+    {
+        _chunkVertexIndices.assign( nVertices, ~0u );
+        _chunks = new osg::Geode;
+
+        // smoothing each chunk on its own would leave seams along its edges
+        if( !_normals.valid() )
+            _normalSums = new osg::Vec3Array( nVertices );
+    }
+    else
+    {
+        _facesPerChunk = 0;
+    }
+
+    // most meshes are made of triangles
+    _triangles->reserve( _triangles->size() + 3 * ( _facesPerChunk > 0 ? _facesPerChunk : nFaces ) );
+}
+
+
+/*  Add a triangle or a quad to the primitive sets.  */
+inline void VertexData::addFace( const unsigned int* indices,
+                                 const unsigned int nIndices )
+{
+    if( nIndices != 3 && nIndices != 4 )
+        return;
+
+    osg::DrawElementsUInt* primitives = ( nIndices == 4 ? _quads.get() : _triangles.get() );
+    for( unsigned int j = 0; j < nIndices; ++j )
+        primitives->push_back( indices[_invertFaces ? nIndices - 1 - j : j] );
+
+    if( _facesPerChunk > 0 && ++_numChunkFaces >= _facesPerChunk )
+        flushChunk();
+}
+
+
+/*  Move the faces read so far into a geometry using a copy of the vertices
+    they index.  */
+void VertexData::flushChunk()
+{
+    if( _numChunkFaces == 0 )
+        return;
+
+    osg::Vec4Array* colors = getColors();
+    osg::Vec2Array* texcoord = colors ? NULL : _texcoord.get();
+
+    osg::ref_ptr<osg::Vec3Array> chunkVertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> chunkNormals = ( _normals.valid() || _normalSums.valid() ) ? new osg::Vec3Array : NULL;
+    osg::ref_ptr<osg::Vec4Array> chunkColors = colors ? new osg::Vec4Array : NULL;
+    osg::ref_ptr<osg::Vec2Array> chunkTexcoord = texcoord ? new osg::Vec2Array : NULL;
+
+    const unsigned int nVertices = _vertices->size();
+    std::vector<unsigned int> used;
+
+    if( _normalSums.valid() )
+    {
+        addFaceNormals( *_vertices, *_triangles, 3, *_normalSums );
+        addFaceNormals( *_vertices, *_quads, 4, *_normalSums );
+    }
+
+    osg::DrawElementsUInt* primitiveSets[] = { _triangles.get(), _quads.get() };
+    for( unsigned int p = 0; p < 2; ++p )
+    {
+        osg::DrawElementsUInt& primitives = *primitiveSets[p];
+        for( osg::DrawElementsUInt::iterator itr = primitives.begin(); itr != primitives.end(); ++itr )
+        {
+            const unsigned int index = *itr < nVertices ? *itr : 0;
+            unsigned int& chunkIndex = _chunkVertexIndices[index];
+            if( chunkIndex == ~0u )
             {
-                unsigned short index;
-                for(int j = 0 ; j < face.nVertices ; j++)
+                chunkIndex = chunkVertices->size();
+                used.push_back( index );
+
+                chunkVertices->push_back( (*_vertices)[index] );
+                if( chunkNormals.valid() )
+                    chunkNormals->push_back( _normals.valid() && index < _normals->size() ? (*_normals)[index] : osg::Vec3() );
+                if( chunkColors.valid() )
+                    chunkColors->push_back( index < colors->size() ? (*colors)[index] : osg::Vec4() );
+                if( chunkTexcoord.valid() )
+                    chunkTexcoord->push_back( index < texcoord->size() ? (*texcoord)[index] : osg::Vec2() );
+            }
+            *itr = chunkIndex;
+        }
+    }
+
+    for( std::vector<unsigned int>::const_iterator itr = used.begin(); itr != used.end(); ++itr )
+        _chunkVertexIndices[*itr] = ~0u;
+
+    if( _normalSums.valid() )
+    {
+        _chunkNormals.push_back( ChunkNormals( chunkNormals, std::vector<unsigned int>() ) );
+        _chunkNormals.back().second.swap( used );
+    }
+
+    _chunks->addDrawable( createGeometry( chunkVertices.get(), chunkNormals.get(),
+                                          chunkColors.get(), chunkTexcoord.get(),
+                                          _triangles.get(), _quads.get() ) );
+
+    _triangles = new osg::DrawElementsUInt(osg::PrimitiveSet::TRIANGLES);
+    _triangles->reserve( 3 * _facesPerChunk );
+    _quads = new osg::DrawElementsUInt(osg::PrimitiveSet::QUADS);
+    _numChunkFaces = 0;
+}
+
+
+/*  Set the normals of the chunks from the normals summed over the whole
+    mesh.  */
+void VertexData::assignChunkNormals()
+{
+    if( !_normalSums.valid() )
+        return;
+
+    for( std::vector<ChunkNormals>::iterator itr = _chunkNormals.begin(); itr != _chunkNormals.end(); ++itr )
+    {
+        osg::Vec3Array& normals = *itr->first;
+        const std::vector<unsigned int>& indices = itr->second;
+        for( unsigned int i = 0; i < indices.size() && i < normals.size(); ++i )
+        {
+            normals[i] = (*_normalSums)[indices[i]];
+            normals[i].normalize();
+        }
+    }
+
+    _normalSums = NULL;
+    _chunkNormals.clear();
+}
+
+
+/*  Return the vertex fields found in the properties of the vertex element.  */
+int VertexData::getVertexFields( PlyProperty** props, const int nProps,
+                                 const bool ignoreColors ) const
+{
+    int fields = NONE;
+    // determine if the file stores vertex colors
+    for( int j = 0; j < nProps; ++j )
+    {
+        // if the string have the red means color info is there
+        if( equal_strings( props[j]->name, "x" ) )
+            fields |= XYZ;
+        if( equal_strings( props[j]->name, "nx" ) )
+            fields |= NORMALS;
+        if( equal_strings( props[j]->name, "alpha" ) )
+            fields |= RGBA;
+        if ( equal_strings( props[j]->name, "red" ) )
+            fields |= RGB;
+        if( equal_strings( props[j]->name, "ambient" ) )
+            fields |= AMBIENT;
+        if( equal_strings( props[j]->name, "diffuse_red" ) )
+            fields |= DIFFUSE;
+        if (equal_strings(props[j]->name, "specular_red"))
+            fields |= SPECULAR;
+        if (equal_strings(props[j]->name, "texture_u"))
+            fields |= TEXCOORD;
+        if (equal_strings(props[j]->name, "texture_v"))
+            fields |= TEXCOORD;
+    }
+
+    if( ignoreColors )
+    {
+        fields &= ~(XYZ | NORMALS);
+            MESHINFO << "Colors in PLY file ignored per request." << endl;
+    }
+
+    return fields;
+}
+
+
+/*  Read the vertex and face elements of a binary file without going through
+    ply_get_element(), converting blocks of records at once.  */
+bool VertexData::readBinaryElements( PlyFile* file, const bool ignoreColors,
+                                     bool& result )
+{
+    if( file->file_type != PLY_BINARY_BE && file->file_type != PLY_BINARY_LE )
+        return false;
+
+    // leave the files with types the generic reader doesn't know about, or
+    // with vertex lists, to it.
+    for( int i = 0; i < file->nelems; ++i )
+    {
+        PlyElement* elem = file->elems[i];
+        for( int j = 0; j < elem->nprops; ++j )
+        {
+            PlyProperty* prop = elem->props[j];
+            if( !isValidType( prop->external_type ) )
+                return false;
+            if( prop->is_list == PLY_LIST &&
+                ( !isValidType( prop->count_external ) || equal_strings( elem->name, "vertex" ) ) )
+                return false;
+        }
+    }
+
+    const bool bigEndian = osg::getCpuByteOrder() == osg::BigEndian;
+    BinaryReader reader( file->fp, ( file->file_type == PLY_BINARY_BE ) != bigEndian );
+
+    bool readVertices = false;
+    bool readFaces = false;
+    for( int i = 0; i < file->nelems && !( readVertices && readFaces ); ++i )
+    {
+        PlyElement* elem = file->elems[i];
+
+        bool ok;
+        if( !readVertices && equal_strings( elem->name, "vertex" ) )
+        {
+            ok = readBinaryVertices( elem, getVertexFields( elem->props, elem->nprops, ignoreColors ), reader );
+            readVertices = true;
+        }
+        else if( !readFaces && equal_strings( elem->name, "face" ) )
+        {
+            ok = readBinaryTriangles( elem, reader );
+            readFaces = true;
+        }
+        else
+        {
+            ok = skipRecords( elem, reader );
+        }
+
+        if( !ok )
+        {
+            MESHERROR << "Unable to read PLY file, the " << elem->name
+                      << " element is truncated." << endl;
+            result = false;
+            return true;
+        }
+    }
+
+    result = readVertices || readFaces;
+    return true;
+}
+
+
+/*  Read the vertices of a binary file, converting each property of a block
+    of records in a loop of its own.  */
+bool VertexData::readBinaryVertices( PlyElement* elem, const int fields,
+                                     BinaryReader& reader )
+{
+    const unsigned int nVertices = elem->num > 0 ? elem->num : 0;
+
+    std::vector<unsigned int> offsets( elem->nprops );
+    unsigned int recordSize = 0;
+    bool wordsOnly = true;
+    for( int j = 0; j < elem->nprops; ++j )
+    {
+        offsets[j] = recordSize;
+        recordSize += getTypeSize( elem->props[j]->external_type );
+        wordsOnly = wordsOnly && getTypeSize( elem->props[j]->external_type ) == 4;
+    }
+
+    if( !_vertices.valid() )
+        _vertices = new osg::Vec3Array;
+    if( ( fields & NORMALS ) && !_normals.valid() )
+        _normals = new osg::Vec3Array;
+    if( ( fields & RGB || fields & RGBA ) && !_colors.valid() )
+        _colors = new osg::Vec4Array;
+    if( ( fields & AMBIENT ) && !_ambient.valid() )
+        _ambient = new osg::Vec4Array;
+    if( ( fields & DIFFUSE ) && !_diffuse.valid() )
+        _diffuse = new osg::Vec4Array;
+    if( ( fields & SPECULAR ) && !_specular.valid() )
+        _specular = new osg::Vec4Array;
+    if( ( fields & TEXCOORD ) && !_texcoord.valid() )
+        _texcoord = new osg::Vec2Array;
+
+    if( nVertices == 0 )
+        return true;
+
+    // the properties missing from the file are left to 0, and alpha to 1
+    const unsigned int first = _vertices->size();
+    std::vector<Column> columns;
+
+    static const char* const xyz[] = { "x", "y", "z" };
+    _vertices->resize( first + nVertices );
+    addColumns( columns, elem, offsets, xyz, 3, (*_vertices)[first].ptr(), 3, false );
+
+    if( fields & NORMALS )
+    {
+        static const char* const normals[] = { "nx", "ny", "nz" };
+        _normals->resize( first + nVertices );
+        addColumns( columns, elem, offsets, normals, 3, (*_normals)[first].ptr(), 3, false );
+    }
+
+    if( fields & RGB || fields & RGBA )
+    {
+        static const char* const rgba[] = { "red", "green", "blue", "alpha" };
+        _colors->resize( first + nVertices, osg::Vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+        addColumns( columns, elem, offsets, rgba, ( fields & RGBA ) ? 4 : 3, (*_colors)[first].ptr(), 4, true );
+    }
+
+    if( fields & AMBIENT )
+    {
+        static const char* const ambient[] = { "ambient_red", "ambient_green", "ambient_blue" };
+        _ambient->resize( first + nVertices, osg::Vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+        addColumns( columns, elem, offsets, ambient, 3, (*_ambient)[first].ptr(), 4, true );
+    }
+
+    if( fields & DIFFUSE )
+    {
+        static const char* const diffuse[] = { "diffuse_red", "diffuse_green", "diffuse_blue" };
+        _diffuse->resize( first + nVertices, osg::Vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+        addColumns( columns, elem, offsets, diffuse, 3, (*_diffuse)[first].ptr(), 4, true );
+    }
+
+    if( fields & SPECULAR )
+    {
+        static const char* const specular[] = { "specular_red", "specular_green", "specular_blue" };
+        _specular->resize( first + nVertices, osg::Vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+        addColumns( columns, elem, offsets, specular, 3, (*_specular)[first].ptr(), 4, true );
+    }
+
+    if( fields & TEXCOORD )
+    {
+        static const char* const texcoord[] = { "texture_u", "texture_v" };
+        _texcoord->resize( first + nVertices );
+        addColumns( columns, elem, offsets, texcoord, 2, (*_texcoord)[first].ptr(), 2, false );
+    }
+
+    // records of 4 byte properties only are byte swapped as a whole
+    const bool swapWords = reader.swap() && wordsOnly;
+    const bool swapColumns = reader.swap() && !wordsOnly;
+
+    const unsigned int blockVertices = std::max( VERTEX_BLOCK_SIZE / std::max( recordSize, 1u ), 1u );
+    for( unsigned int i = 0; i < nVertices; )
+    {
+        const unsigned int count = std::min( blockVertices, nVertices - i );
+        const size_t blockSize = static_cast<size_t>( count ) * recordSize;
+        if( !reader.request( blockSize ) )
+            return false;
+
+        unsigned char* records = reader.data();
+        if( swapWords )
+            swapBytes4( records, blockSize / 4 );
+
+        for( std::vector<Column>::const_iterator itr = columns.begin(); itr != columns.end(); ++itr )
+        {
+            float* dst = itr->dst + static_cast<size_t>( i ) * itr->dstStride;
+            if( itr->color )
+                convertColumn<true>( itr->type, swapColumns, records + itr->offset, recordSize, dst, itr->dstStride, count );
+            else
+                convertColumn<false>( itr->type, swapColumns, records + itr->offset, recordSize, dst, itr->dstStride, count );
+        }
+
+        reader.advance( blockSize );
+        i += count;
+    }
+
+    return true;
+}
+
+
+/*  Read the faces of a binary file, with a dedicated loop for the usual
+    face records holding only an unsigned char count and 4 byte indices.  */
+bool VertexData::readBinaryTriangles( PlyElement* elem, BinaryReader& reader )
+{
+    const unsigned int nFaces = elem->num > 0 ? elem->num : 0;
+
+    // the property the generic reader is asked for, "vertex_indices|vertex_index"
+    int indexProp = -1;
+    static const char* const indexNames[] = { "vertex_indices", "vertex_index" };
+    for( unsigned int n = 0; n < 2 && indexProp < 0; ++n )
+    {
+        for( int j = 0; j < elem->nprops && indexProp < 0; ++j )
+        {
+            if( elem->props[j]->is_list == PLY_LIST && equal_strings( elem->props[j]->name, indexNames[n] ) )
+                indexProp = j;
+        }
+    }
+
+    startTriangles( nFaces );
+
+    unsigned int indices[4];
+
+    if( elem->nprops == 1 && indexProp == 0 &&
+        getTypeSize( elem->props[0]->count_external ) == 1 && elem->props[0]->count_external != PLY_CHAR &&
+        getTypeSize( elem->props[0]->external_type ) == 4 && isIntegerType( elem->props[0]->external_type ) )
+    {
+        const bool swap = reader.swap();
+        for( unsigned int i = 0; i < nFaces; ++i )
+        {
+            if( !reader.request( 1 ) )
+                return false;
+            const unsigned int count = reader.data()[0];
+            const size_t recordSize = 1 + count * 4;
+            if( !reader.request( recordSize ) )
+                return false;
+
+            if( count == 3 || count == 4 )
+            {
+                const unsigned char* src = reader.data() + 1;
+                for( unsigned int j = 0; j < count; ++j, src += 4 )
+                    indices[j] = swap ? load<unsigned int, true>( src ) : load<unsigned int, false>( src );
+                addFace( indices, count );
+            }
+            reader.advance( recordSize );
+        }
+        return true;
+    }
+
+    unsigned int recordSize;
+    const std::vector<PropertyLayout> layout = getLayout( elem, reader.swap(), recordSize );
+    for( unsigned int i = 0; i < nFaces; ++i )
+    {
+        for( unsigned int j = 0; j < layout.size(); ++j )
+        {
+            size_t size = layout[j].size;
+            int count = 0;
+            if( layout[j].isList && !readListCount( layout[j], reader, count, size ) )
+                return false;
+            if( !reader.request( size ) )
+                return false;
+
+            if( static_cast<int>( j ) == indexProp )
+            {
+                // the generic reader stores the count in an unsigned char
+                const unsigned int nIndices = static_cast<unsigned char>( count );
+                if( nIndices == 3 || nIndices == 4 )
                 {
-                    index = ( _invertFaces ? face.nVertices - 1 - j : j );
-                    if(face.nVertices == 4)
-                        _quads->push_back(face.vertices[index]);
-                    else
-                        _triangles->push_back(face.vertices[index]);
+                    const unsigned char* src = reader.data();
+                    for( unsigned int k = 0; k < nIndices; ++k, src += layout[j].size )
+                        indices[k] = static_cast<unsigned int>( layout[j].loadValue( src ) );
+                    addFace( indices, nIndices );
                 }
             }
-            // free the memory that was allocated by ply_get_element
-            free( face.vertices );
+            reader.advance( size );
         }
     }
+    return true;
+}
+
+
+/*  Return the array used for the colors of the geometry.  */
+osg::Vec4Array* VertexData::getColors() const
+{
+    // at the moment this is a kludge because we only use one kind and apply
+    // them all the same way. Also, the priority order is completely arbitrary
+    if( _colors.valid() )
+        return _colors.get();
+    if( _ambient.valid() )
+        return _ambient.get();
+    if( _diffuse.valid() )
+        return _diffuse.get();
+    return _specular.get();
 }
 
 
@@ -329,7 +1163,37 @@ osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColor
             }
         }
     }
-    for( int i = 0; i < nPlyElems; ++i )
+
+    osg::ref_ptr<osg::Image> image;
+    if (!textureFile.empty() && (image = osgDB::readRefImageFile(textureFile)) != NULL)
+    {
+        osg::Texture2D *texture = new osg::Texture2D;
+        texture->setImage(image.get());
+        texture->setResizeNonPowerOfTwoHint(false);
+
+        osg::TexEnv *texenv = new osg::TexEnv;
+        texenv->setMode(osg::TexEnv::REPLACE);
+
+        _stateset = new osg::StateSet;
+        _stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+        _stateset->setTextureAttribute(0, texenv);
+    }
+
+    // binary files are read by the fast path unless their layout isn't supported
+    bool readBinary = false;
+    try
+    {
+        readBinary = readBinaryElements( file, ignoreColors, result );
+    }
+    catch( exception& e )
+    {
+        MESHERROR << "Unable to read PLY file, an exception occurred:  "
+                  << e.what() << endl;
+        readBinary = true;
+        result = false;
+    }
+
+    for( int i = 0; i < nPlyElems && !readBinary; ++i )
     {
         int nElems;
         int nProps;
@@ -359,36 +1223,7 @@ osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColor
         // if the string is vertex means vertex data is started
         if( equal_strings( elemNames[i], "vertex" ) )
         {
-            int fields = NONE;
-            // determine if the file stores vertex colors
-            for( int j = 0; j < nProps; ++j )
-            {
-                // if the string have the red means color info is there
-                if( equal_strings( props[j]->name, "x" ) )
-                    fields |= XYZ;
-                if( equal_strings( props[j]->name, "nx" ) )
-                    fields |= NORMALS;
-                if( equal_strings( props[j]->name, "alpha" ) )
-                    fields |= RGBA;
-                if ( equal_strings( props[j]->name, "red" ) )
-                    fields |= RGB;
-                if( equal_strings( props[j]->name, "ambient" ) )
-                    fields |= AMBIENT;
-                if( equal_strings( props[j]->name, "diffuse_red" ) )
-                    fields |= DIFFUSE;
-                if (equal_strings(props[j]->name, "specular_red"))
-                    fields |= SPECULAR;
-                if (equal_strings(props[j]->name, "texture_u"))
-                    fields |= TEXCOORD;
-                if (equal_strings(props[j]->name, "texture_v"))
-                    fields |= TEXCOORD;
-            }
-
-            if( ignoreColors )
-            {
-                fields &= ~(XYZ | NORMALS);
-                    MESHINFO << "Colors in PLY file ignored per request." << endl;
-            }
+            int fields = getVertexFields( props, nProps, ignoreColors );
 
             try {
                 // Read vertices and store in a std::vector array
@@ -474,91 +1309,115 @@ osg::Node* VertexData::readPlyFile( const char* filename, const bool ignoreColor
    // If the result is true means the ply file is successfully read
    if(result)
    {
-        // Create geometry node
-        osg::Geometry* geom  =  new osg::Geometry;
+        osg::ref_ptr<osg::Geode> geode;
 
-        // set the vertex array
-        geom->setVertexArray(_vertices.get());
+        osg::Vec4Array* colors = getColors();
+        osg::Vec2Array* texcoord = colors ? NULL : _texcoord.get();
 
-        // Add the primitive set
-        bool hasTriOrQuads = false;
-        if (_triangles.valid() && _triangles->size() > 0 )
-        {
-            geom->addPrimitiveSet(_triangles.get());
-            hasTriOrQuads = true;
-        }
+        const bool hasFaces = _triangles.valid() && (_triangles->size() > 0 || _quads->size() > 0);
+        const unsigned int nVertices = _vertices.valid() ? _vertices->size() : 0;
 
-        if (_quads.valid() && _quads->size() > 0 )
-        {
-            geom->addPrimitiveSet(_quads.get());
-            hasTriOrQuads = true;
-        }
+        unsigned int pointsPerChunk = _chunkSize;
+        if (pointsPerChunk == 0 && static_cast<unsigned long long>(nVertices) * (colors ? sizeof(osg::Vec4) : sizeof(osg::Vec3)) > 0xffffffffull)
+            pointsPerChunk = DEFAULT_CHUNK_SIZE;
 
-        // Print points if the file contains unsupported primitives
-        if(!hasTriOrQuads)
-            geom->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, _vertices->size()));
-
-
-        // Apply the colours to the model; at the moment this is a
-        // kludge because we only use one kind and apply them all the
-        // same way. Also, the priority order is completely arbitrary
-
-        if(_colors.valid())
-        {
-            geom->setColorArray(_colors.get(), osg::Array::BIND_PER_VERTEX );
-        }
-        else if(_ambient.valid())
+        if (_chunks.valid())
         {
-            geom->setColorArray(_ambient.get(), osg::Array::BIND_PER_VERTEX );
+            // add the faces read after the last chunk
+            flushChunk();
+            assignChunkNormals();
+            geode = _chunks;
+            _chunks = NULL;
         }
-        else if(_diffuse.valid())
+        else if (!hasFaces && pointsPerChunk > 0 && nVertices > pointsPerChunk)
         {
-            geom->setColorArray(_diffuse.get(), osg::Array::BIND_PER_VERTEX );
-        }
-        else if(_specular.valid())
-        {
-            geom->setColorArray(_specular.get(), osg::Array::BIND_PER_VERTEX );
+            // split point clouds in consecutive ranges of points
+            geode = new osg::Geode;
+            for (unsigned int first = 0; first < nVertices; first += pointsPerChunk)
+            {
+                const unsigned int last = std::min(nVertices - first, pointsPerChunk) + first;
+                geode->addDrawable(createGeometry(copyRange(_vertices.get(), first, last),
+                                                  copyRange(_normals.get(), first, last),
+                                                  copyRange(colors, first, last),
+                                                  copyRange(texcoord, first, last),
+                                                  NULL, NULL));
+            }
         }
-        else if (_texcoord.valid())
+        else
         {
-            geom->setTexCoordArray(0, _texcoord.get());
+            geode = new osg::Geode;
+            geode->addDrawable(createGeometry(_vertices.get(), _normals.get(), colors, texcoord,
+                                              _triangles.get(), _quads.get()));
         }
 
-        // If the model has normals, add them to the geometry
-        if(_normals.valid())
-        {
-            geom->setNormalArray(_normals.get(), osg::Array::BIND_PER_VERTEX);
-        }
-        else
-        {   // If not, use the smoothing visitor to generate them
-            // (quads will be triangulated by the smoothing visitor)
-            osgUtil::SmoothingVisitor::smooth((*geom), osg::PI/2);
-        }
+        return geode.release();
+    }
+
+    return NULL;
+}
 
-        // set flage true to activate the vertex buffer object of drawable
-        geom->setUseVertexBufferObjects(true);
 
-        osg::ref_ptr<osg::Image> image;
-        if (!textureFile.empty() && (image = osgDB::readRefImageFile(textureFile)) != NULL)
-        {
-            osg::Texture2D *texture = new osg::Texture2D;
-            texture->setImage(image.get());
-            texture->setResizeNonPowerOfTwoHint(false);
+/*  Create a geometry from the vertex arrays and the primitive sets, points
+    if there are no faces.  */
+osg::Geometry* VertexData::createGeometry( osg::Vec3Array* vertices,
+                                           osg::Vec3Array* normals,
+                                           osg::Vec4Array* colors,
+                                           osg::Vec2Array* texcoord,
+                                           osg::DrawElementsUInt* triangles,
+                                           osg::DrawElementsUInt* quads ) const
+{
+    // Create geometry node
+    osg::Geometry* geom  =  new osg::Geometry;
 
-            osg::TexEnv *texenv = new osg::TexEnv;
-            texenv->setMode(osg::TexEnv::REPLACE);
+    // set the vertex array
+    geom->setVertexArray(vertices);
 
-            osg::StateSet *stateset = geom->getOrCreateStateSet();
-            stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
-            stateset->setTextureAttribute(0, texenv);
-        }
+    // Add the primitive set
+    bool hasTriOrQuads = false;
+    if (triangles && triangles->size() > 0 )
+    {
+        geom->addPrimitiveSet(triangles);
+        hasTriOrQuads = true;
+    }
 
-        osg::Geode* geode = new osg::Geode;
-        geode->addDrawable(geom);
-        return geode;
+    if (quads && quads->size() > 0 )
+    {
+        geom->addPrimitiveSet(quads);
+        hasTriOrQuads = true;
     }
 
-    return NULL;
-}
+    // Print points if the file contains unsupported primitives
+    if(!hasTriOrQuads)
+        geom->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
 
+    // Apply the colours to the model, the texture coordinates are only used
+    // without colours
+    if(colors)
+    {
+        geom->setColorArray(colors, osg::Array::BIND_PER_VERTEX );
+    }
+    else if (texcoord)
+    {
+        geom->setTexCoordArray(0, texcoord);
+    }
 
+    // If the model has normals, add them to the geometry
+    if(normals)
+    {
+        geom->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
+    }
+    else
+    {   // If not, use the smoothing visitor to generate them
+        // (quads will be triangulated by the smoothing visitor)
+        osgUtil::SmoothingVisitor::smooth((*geom), osg::PI/2);
+    }
+
+    // set flage true to activate the vertex buffer object of drawable
+    geom->setUseVertexBufferObjects(true);
+
+    if (_stateset.valid())
+        geom->setStateSet(_stateset.get());
+
+    return geom;
+}
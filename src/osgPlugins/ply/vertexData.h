@@ -15,6 +15,8 @@
 
 #include <osg/Node>
 #include <osg/PrimitiveSet>
+#include <osg/Geode>
+#include <osg/StateSet>
 
 #include <vector>
 
@@ -27,9 +29,13 @@
 
 // defined elsewhere
 struct PlyFile;
+struct PlyProperty;
+struct PlyElement;
 
 namespace ply
 {
+    class BinaryReader;
+
     /*  Holds the flat data and offers routines to read, scale and sort it.  */
     class VertexData
     {
@@ -44,6 +50,13 @@ namespace ply
         // to set the flag for using inverted face
         void useInvertedFaces() { _invertFaces = true; }
 
+        // Maximum number of faces, or of points if the file has no faces, per
+        // geometry. Larger meshes are split into several geometries, each
+        // with its own copy of the vertices it uses, while the faces are read.
+        // 0 only splits meshes with vertex or index arrays too large for a
+        // single buffer object.
+        void setChunkSize( unsigned int chunkSize ) { _chunkSize = chunkSize; }
+
     private:
 
         enum VertexFields
@@ -67,8 +80,64 @@ namespace ply
         // Reads the triangle indices from the ply file
         void readTriangles( PlyFile* file, const int nFaces );
 
+        // Returns the VertexFields of the vertex element properties
+        int getVertexFields( PlyProperty** props, const int nProps,
+                             const bool ignoreColors ) const;
+
+        // Reads the vertex and face elements of a binary file straight from
+        // blocks of records, returns false without reading anything if the
+        // layout of the file isn't supported.
+        bool readBinaryElements( PlyFile* file, const bool ignoreColors,
+                                 bool& result );
+
+        bool readBinaryVertices( PlyElement* elem,
+                                 const int fields, BinaryReader& reader );
+
+        bool readBinaryTriangles( PlyElement* elem,
+                                  BinaryReader& reader );
+
+        // Sets the number of faces after which a chunk is created, once the
+        // number of faces of the file is known
+        void startTriangles( const unsigned int nFaces );
+
+        // Adds a face to the current chunk
+        inline void addFace( const unsigned int* indices,
+                             const unsigned int nIndices );
+
+        // Moves the faces read so far into a geometry of their own
+        void flushChunk();
+
+        // Assigns the normals summed over the whole mesh to the chunks, once
+        // all the faces have been read
+        void assignChunkNormals();
+
+        // Returns the color array used for the geometry, the first one read
+        // of colors, ambient, diffuse and specular
+        osg::Vec4Array* getColors() const;
+
+        osg::Geometry* createGeometry( osg::Vec3Array* vertices,
+                                       osg::Vec3Array* normals,
+                                       osg::Vec4Array* colors,
+                                       osg::Vec2Array* texcoord,
+                                       osg::DrawElementsUInt* triangles,
+                                       osg::DrawElementsUInt* quads ) const;
+
         bool        _invertFaces;
 
+        unsigned int                _chunkSize;
+        unsigned int                _facesPerChunk;
+        unsigned int                _numChunkFaces;
+        std::vector<unsigned int>   _chunkVertexIndices;
+        osg::ref_ptr<osg::Geode>    _chunks;
+
+        // Without normals in the file the face normals of the chunks are summed
+        // per vertex of the mesh, so that normals are smooth across the chunks
+        typedef std::pair< osg::ref_ptr<osg::Vec3Array>, std::vector<unsigned int> > ChunkNormals;
+        osg::ref_ptr<osg::Vec3Array>    _normalSums;
+        std::vector<ChunkNormals>       _chunkNormals;
+
+        osg::ref_ptr<osg::StateSet> _stateset;
+
         // Vertex array in osg format
         osg::ref_ptr<osg::Vec3Array>   _vertices;
         // Color array in osg format
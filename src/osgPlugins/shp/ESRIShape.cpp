@@ -6,6 +6,7 @@
     namespace esri
     {
         int read(int fd, void * buf, size_t nbytes) { return _read(fd, buf, static_cast<unsigned int>(nbytes)); }
+        bool seek(int fd, long long offset, int whence) { return _lseeki64(fd, offset, whence) != -1; }
     }
 
 #else
@@ -14,6 +15,7 @@
     namespace esri
     {
         int read(int fd, void * buf, size_t nbytes) { return ::read(fd, buf, nbytes); }
+        bool seek(int fd, long long offset, int whence) { return ::lseek(fd, static_cast<off_t>(offset), whence) != -1; }
     }
 
 #endif
@@ -21,11 +23,83 @@
 #include "ESRIShape.h"
 
 #include <float.h>
+#include <string.h>
 
 using namespace ESRIShape ;
 
 #define SAFE_DELETE_ARRAY( ptr ) delete[] ptr; ptr = 0L;
 
+RecordReader::RecordReader( int fd ):
+    _fd(fd),
+    _buffer(1<<18),
+    _data(0L),
+    _size(0),
+    _pos(0)
+{}
+
+RecordReader::RecordReader( const char *data, size_t size ):
+    _fd(-1),
+    _data(data),
+    _size(size),
+    _pos(0)
+{}
+
+bool RecordReader::fill()
+{
+    if( _fd < 0 )
+        return false;
+
+    int nbytes = esri::read( _fd, &_buffer.front(), _buffer.size() );
+    if( nbytes <= 0 )
+        return false;
+
+    _data = &_buffer.front();
+    _size = nbytes;
+    _pos = 0;
+    return true;
+}
+
+int RecordReader::read( void *buf, size_t nbytes )
+{
+    size_t copied = 0;
+    while( copied < nbytes )
+    {
+        if( _pos == _size && fill() == false )
+            break;
+
+        size_t n = _size - _pos < nbytes - copied ? _size - _pos : nbytes - copied;
+        memcpy( static_cast<char*>(buf) + copied, _data + _pos, n );
+        _pos += n;
+        copied += n;
+    }
+    return static_cast<int>(copied);
+}
+
+bool RecordReader::skip( size_t nbytes )
+{
+    if( nbytes <= _size - _pos )
+    {
+        _pos += nbytes;
+        return true;
+    }
+
+    if( _fd < 0 )
+        return false;
+
+    nbytes -= _size - _pos;
+    _pos = _size;
+    return esri::seek( _fd, static_cast<long long>(nbytes), SEEK_CUR );
+}
+
+bool RecordReader::seek( long long offset )
+{
+    if( _fd < 0 )
+        return false;
+
+    _pos = _size;
+    return esri::seek( _fd, offset, SEEK_SET );
+}
+
 template <class T>
 inline void swapBytes(  T &s )
 {
@@ -50,10 +124,10 @@ inline ByteOrder getByteOrder()
 }
 
 template <class T>
-inline bool readVal( int fd, T &val, ByteOrder bo = LittleEndian )
+inline bool readVal( RecordReader &in, T &val, ByteOrder bo = LittleEndian )
 {
     int nbytes = 0;
-    if( (nbytes = esri::read( fd, &val, sizeof(T))) <= 0 )
+    if( (nbytes = in.read( &val, sizeof(T))) <= 0 )
         return false;
 
     if( getByteOrder() != bo )
@@ -64,10 +138,10 @@ inline bool readVal( int fd, T &val, ByteOrder bo = LittleEndian )
 
 
 template <class T>
-inline bool readPositiveVal( int fd, T &val, ByteOrder bo = LittleEndian )
+inline bool readPositiveVal( RecordReader &in, T &val, ByteOrder bo = LittleEndian )
 {
     int nbytes = 0;
-    if( (nbytes = esri::read( fd, &val, sizeof(T))) <= 0 )
+    if( (nbytes = in.read( &val, sizeof(T))) <= 0 )
         return false;
 
     if( getByteOrder() != bo )
@@ -102,16 +176,16 @@ inline void printType( ShapeType type )
 }
 
 
-bool BoundingBox::read( int fd )
+bool BoundingBox::read( RecordReader &in )
 {
-    if( readVal<Double>(fd, Xmin, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Ymin, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Xmax, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Ymax, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Zmin, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Zmax, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Mmin, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, Mmax, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Xmin, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Ymin, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Xmax, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Ymax, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Zmin, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Zmax, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Mmin, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, Mmax, LittleEndian ) == false ) return false;
 
     return true;
 }
@@ -129,14 +203,14 @@ void BoundingBox::print()
 }
 
 
-bool ShapeHeader::read(int fd)
+bool ShapeHeader::read(RecordReader &in)
 {
-    if( readVal<Integer>( fd, fileCode, BigEndian ) == false ) return false;
-    if( esri::read( fd, _unused_0, sizeof(_unused_0)) <= 0 ) return false;
-    if( readVal<Integer>( fd, fileLength, BigEndian ) == false ) return false;
-    if( readVal<Integer>( fd, version, LittleEndian ) == false ) return false;
-    if( readVal<Integer>( fd, shapeType, LittleEndian ) == false ) return false;
-    bbox.read(fd);
+    if( readVal<Integer>( in, fileCode, BigEndian ) == false ) return false;
+    if( in.read( _unused_0, sizeof(_unused_0)) <= 0 ) return false;
+    if( readVal<Integer>( in, fileLength, BigEndian ) == false ) return false;
+    if( readVal<Integer>( in, version, LittleEndian ) == false ) return false;
+    if( readVal<Integer>( in, shapeType, LittleEndian ) == false ) return false;
+    bbox.read(in);
     return true;
 }
 
@@ -156,10 +230,10 @@ RecordHeader::RecordHeader():
 {
 }
 
-bool RecordHeader::read( int fd )
+bool RecordHeader::read( RecordReader &in )
 {
-    if( readVal<Integer>( fd, recordNumber, BigEndian ) == false ) return false;
-    if( readVal<Integer>( fd, contentLength, BigEndian ) == false ) return false;
+    if( readVal<Integer>( in, recordNumber, BigEndian ) == false ) return false;
+    if( readVal<Integer>( in, contentLength, BigEndian ) == false ) return false;
     return true;
 }
 
@@ -171,13 +245,48 @@ void RecordHeader::print()
 
 
 
+bool RecordExtents::read( RecordReader &in )
+{
+    if( readVal<Integer>( in, recordNumber, BigEndian ) == false ) return false;
+    if( readVal<Integer>( in, contentLength, BigEndian ) == false ) return false;
+    if( readVal<Integer>( in, shapeType, LittleEndian ) == false ) return false;
+
+    Integer contentRead = 4;
+    switch( shapeType )
+    {
+        case ShapeTypeNullShape:
+            bbox = Box();
+            break;
+
+        case ShapeTypePoint:
+        case ShapeTypePointM:
+        case ShapeTypePointZ:
+            if( readVal<Double>( in, bbox.Xmin, LittleEndian ) == false ) return false;
+            if( readVal<Double>( in, bbox.Ymin, LittleEndian ) == false ) return false;
+            bbox.Xmax = bbox.Xmin;
+            bbox.Ymax = bbox.Ymin;
+            contentRead += 16;
+            break;
+
+        default:
+            if( bbox.read( in ) == false ) return false;
+            contentRead += 32;
+            break;
+    }
+
+    if( contentLength*2 < contentRead )
+        return false;
+
+    return in.skip( contentLength*2 - contentRead );
+}
+
 NullRecord::NullRecord():
     shapeType(ShapeTypeNullShape)
 {}
 
-bool NullRecord::read( int fd )
+bool NullRecord::read( RecordReader &in )
 {
-    if( readVal<Integer>( fd, shapeType, LittleEndian ) == false ) return false;
+    if( readVal<Integer>( in, shapeType, LittleEndian ) == false ) return false;
     return true;
 }
 
@@ -196,22 +305,31 @@ Box::Box(const Box &b ):
     Ymax(b.Ymax)
     {}
 
-bool Box::read( int fd )
+Box &Box::operator=(const Box &b )
+{
+    Xmin = b.Xmin;
+    Ymin = b.Ymin;
+    Xmax = b.Xmax;
+    Ymax = b.Ymax;
+    return *this;
+}
+
+bool Box::read( RecordReader &in )
 {
-    if( readVal<Double>(fd, Xmin, LittleEndian) == false ) return false;
-    if( readVal<Double>(fd, Ymin, LittleEndian) == false ) return false;
-    if( readVal<Double>(fd, Xmax, LittleEndian) == false ) return false;
-    if( readVal<Double>(fd, Ymax, LittleEndian) == false ) return false;
+    if( readVal<Double>(in, Xmin, LittleEndian) == false ) return false;
+    if( readVal<Double>(in, Ymin, LittleEndian) == false ) return false;
+    if( readVal<Double>(in, Xmax, LittleEndian) == false ) return false;
+    if( readVal<Double>(in, Ymax, LittleEndian) == false ) return false;
     return true;
 }
 
 Range::Range():min(DBL_MAX), max(-DBL_MAX) {}
 Range::Range( const Range &r ): min(r.min), max(r.max) {}
 
-bool Range::read( int fd )
+bool Range::read( RecordReader &in )
 {
-    if( readVal<Double>(fd, min, LittleEndian ) == false ) return false;
-    if( readVal<Double>(fd, max, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, min, LittleEndian ) == false ) return false;
+    if( readVal<Double>(in, max, LittleEndian ) == false ) return false;
     return true;
 }
 
@@ -238,29 +356,29 @@ Point::Point(const Point &p):
 
 Point::~Point() {}
 
-bool Point::read( int fd )
+bool Point::read( RecordReader &in )
 {
 
-    if( readVal<Double>( fd, x, LittleEndian ) == false ) return false;
-    if( readVal<Double>( fd, y, LittleEndian ) == false ) return false;
+    if( readVal<Double>( in, x, LittleEndian ) == false ) return false;
+    if( readVal<Double>( in, y, LittleEndian ) == false ) return false;
 
     return true;
 }
 
-bool PointRecord::read( int fd )
+bool PointRecord::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     Integer shapeType;
-    if( readVal<Integer>(fd, shapeType, LittleEndian ) == false )
+    if( readVal<Integer>(in, shapeType, LittleEndian ) == false )
         return false;
 
     if( shapeType != ShapeTypePoint )
         return false;
 
-    return point.read(fd);
+    return point.read(in);
 }
 
 void Point::print()
@@ -288,31 +406,31 @@ MultiPoint::~MultiPoint()
     delete[] points;
 }
 
-bool MultiPoint::read( int fd )
+bool MultiPoint::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( points );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypeMultiPoint )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     points = new struct Point[numPoints];
     for( Integer i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd) == false )
+        if( points[i].read(in) == false )
             return false;
     }
     return true;
@@ -355,43 +473,43 @@ PolyLine::~PolyLine()
     delete [] points;
 }
 
-bool PolyLine::read( int fd )
+bool PolyLine::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
     SAFE_DELETE_ARRAY( points );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePolyLine )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
 
     }
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
     return true;
@@ -427,42 +545,42 @@ Polygon::~Polygon()
 }
 
 
-bool Polygon::read( int fd )
+bool Polygon::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
     SAFE_DELETE_ARRAY( points );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePolygon )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
     }
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
     return true;
@@ -486,11 +604,11 @@ PointM::PointM(const PointM &p):
 
 PointM::~PointM() {}
 
-bool PointM::read( int fd )
+bool PointM::read( RecordReader &in )
 {
-    if( readVal<Double>( fd, x, LittleEndian ) == false ) return false;
-    if( readVal<Double>( fd, y, LittleEndian ) == false ) return false;
-    if( readVal<Double>( fd, m, LittleEndian ) == false ) return false;
+    if( readVal<Double>( in, x, LittleEndian ) == false ) return false;
+    if( readVal<Double>( in, y, LittleEndian ) == false ) return false;
+    if( readVal<Double>( in, m, LittleEndian ) == false ) return false;
 
     return true;
 }
@@ -500,20 +618,20 @@ void PointM::print()
     printf( "    %G %G (%G)\n", x, y, m );
 }
 
-bool PointMRecord::read( int fd )
+bool PointMRecord::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     Integer shapeType;
-    if( readVal<Integer>(fd, shapeType, LittleEndian ) == false )
+    if( readVal<Integer>(in, shapeType, LittleEndian ) == false )
         return false;
 
     if( shapeType != ShapeTypePointM )
         return false;
 
-    return pointM.read(fd);
+    return pointM.read(in);
 }
 
 
@@ -545,46 +663,46 @@ MultiPointM::~MultiPointM()
     delete [] mArray;
 }
 
-bool MultiPointM::read( int fd )
+bool MultiPointM::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( points );
     SAFE_DELETE_ARRAY( mArray );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypeMultiPointM )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     points = new struct Point[numPoints];
     Integer i;
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd) == false )
+        if( points[i].read(in) == false )
             return false;
     }
 
     int X = 40 + (16 * numPoints);
     if( rh.contentLength*2 > X )
     {
-        if( mRange.read(fd) == false )
+        if( mRange.read(in) == false )
             return false;
 
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++ )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -637,10 +755,10 @@ PolyLineM::~PolyLineM()
     delete [] mArray;
 }
 
-bool PolyLineM::read( int fd )
+bool PolyLineM::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
@@ -648,33 +766,33 @@ bool PolyLineM::read( int fd )
     SAFE_DELETE_ARRAY( mArray );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePolyLineM )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
 
     }
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
 
@@ -683,11 +801,11 @@ bool PolyLineM::read( int fd )
 
     if( rh.contentLength*2 > Y )
     {
-        mRange.read(fd);
+        mRange.read(in);
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++  )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -735,10 +853,10 @@ PolygonM::~PolygonM()
 }
 
 
-bool PolygonM::read( int fd )
+bool PolygonM::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
@@ -746,32 +864,32 @@ bool PolygonM::read( int fd )
     SAFE_DELETE_ARRAY( mArray );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePolygonM )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
     }
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
 
@@ -780,13 +898,13 @@ bool PolygonM::read( int fd )
 
     if( rh.contentLength*2 > Y )
     {
-        if( mRange.read(fd) == false )
+        if( mRange.read(in) == false )
             return false;
 
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++ )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -815,31 +933,31 @@ PointZ::PointZ(const PointZ &p):
 
 PointZ::~PointZ() {}
 
-bool PointZ::read( int fd )
+bool PointZ::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePointZ )
         return false;
 
-    if( readVal<Double>( fd, x, LittleEndian ) == false )
+    if( readVal<Double>( in, x, LittleEndian ) == false )
         return false;
 
-    if( readVal<Double>( fd, y, LittleEndian ) == false )
+    if( readVal<Double>( in, y, LittleEndian ) == false )
         return false;
 
-    if( readVal<Double>( fd, z, LittleEndian ) == false )
+    if( readVal<Double>( in, z, LittleEndian ) == false )
         return false;
 
     // Sometimes, M field is not supplied
     if( rh.contentLength*2 >= 18 )
-        if( readVal<Double>( fd, m, LittleEndian ) == false )
+        if( readVal<Double>( in, m, LittleEndian ) == false )
             return false;
 
     return true;
@@ -883,10 +1001,10 @@ MultiPointZ::~MultiPointZ()
     delete [] mArray;
 }
 
-bool MultiPointZ::read( int fd )
+bool MultiPointZ::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( points );
@@ -894,33 +1012,33 @@ bool MultiPointZ::read( int fd )
     SAFE_DELETE_ARRAY( mArray );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypeMultiPointZ )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     points = new struct Point[numPoints];
     Integer i;
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd) == false )
+        if( points[i].read(in) == false )
             return false;
     }
 
-    if( zRange.read(fd) == false )
+    if( zRange.read(in) == false )
         return false;
 
     zArray = new Double[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( readVal<Double>(fd, zArray[i], LittleEndian) == false )
+        if( readVal<Double>(in, zArray[i], LittleEndian) == false )
             return false;
     }
 
@@ -928,13 +1046,13 @@ bool MultiPointZ::read( int fd )
     int Y = X + 16 + (8*numPoints);
     if( rh.contentLength*2 > Y )
     {
-        if( mRange.read(fd) == false )
+        if( mRange.read(in) == false )
             return false;
 
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++ )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -999,10 +1117,10 @@ PolyLineZ::~PolyLineZ()
     delete [] mArray;
 }
 
-bool PolyLineZ::read( int fd )
+bool PolyLineZ::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
@@ -1011,41 +1129,41 @@ bool PolyLineZ::read( int fd )
     SAFE_DELETE_ARRAY( mArray );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePolyLineZ )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readPositiveVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readPositiveVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
 
     }
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
 
-    zRange.read(fd);
+    zRange.read(in);
     zArray = new Double[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( readVal<Double>(fd, zArray[i], LittleEndian ) == false )
+        if( readVal<Double>(in, zArray[i], LittleEndian ) == false )
             return false;
     }
 
@@ -1055,11 +1173,11 @@ bool PolyLineZ::read( int fd )
 
     if( rh.contentLength*2 != Z )
     {
-        mRange.read(fd);
+        mRange.read(in);
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++ )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -1112,10 +1230,10 @@ PolygonZ::~PolygonZ()
     delete [] mArray;
 }
 
-bool PolygonZ::read( int fd )
+bool PolygonZ::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
@@ -1124,42 +1242,42 @@ bool PolygonZ::read( int fd )
     SAFE_DELETE_ARRAY( mArray );
 
     Integer st;
-    if( readVal<Integer>(fd, st, LittleEndian ) == false )
+    if( readVal<Integer>(in, st, LittleEndian ) == false )
         return false;
 
     if( st != ShapeTypePolygonZ )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
     }
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
 
-    if( zRange.read(fd) == false )
+    if( zRange.read(in) == false )
         return false;
 
     zArray = new Double[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( readVal<Double>(fd, zArray[i], LittleEndian ) == false )
+        if( readVal<Double>(in, zArray[i], LittleEndian ) == false )
             return false;
     }
 
@@ -1168,13 +1286,13 @@ bool PolygonZ::read( int fd )
     int  Z = Y + 16 + (8*numPoints);
     if( rh.contentLength*2 != Z )
     {
-        if( mRange.read(fd) == false )
+        if( mRange.read(in) == false )
             return false;
 
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++ )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -1202,7 +1320,7 @@ struct MultiPatch
     MultiPatch();
     MultiPatch( const MultiPatch &);
     virtual ~MultiPatch();
-    bool read( fd );
+    bool read( in );
 };
 */
 
@@ -1252,10 +1370,10 @@ MultiPatch::~MultiPatch()
     delete [] mArray;
 }
 
-bool MultiPatch::read( int fd )
+bool MultiPatch::read( RecordReader &in )
 {
     RecordHeader rh;
-    if( rh.read(fd) == false )
+    if( rh.read(in) == false )
         return false;
 
     SAFE_DELETE_ARRAY( parts );
@@ -1265,50 +1383,50 @@ bool MultiPatch::read( int fd )
     SAFE_DELETE_ARRAY( mArray );
 
     Integer shapeType;
-    if( readVal<Integer>(fd, shapeType, LittleEndian ) == false )
+    if( readVal<Integer>(in, shapeType, LittleEndian ) == false )
         return false;
 
     if( shapeType != ShapeTypeMultiPatch )
         return false;
 
-    if( bbox.read(fd) == false )
+    if( bbox.read(in) == false )
         return false;
 
-    if( readVal<Integer>(fd, numParts, LittleEndian ) == false )
+    if( readVal<Integer>(in, numParts, LittleEndian ) == false )
         return false;
 
-    if( readVal<Integer>(fd, numPoints, LittleEndian ) == false )
+    if( readVal<Integer>(in, numPoints, LittleEndian ) == false )
         return false;
 
     parts  = new Integer[numParts];
     int i;
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, parts[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, parts[i], LittleEndian ) == false )
             return false;
     }
 
     partTypes = new Integer[numParts];
     for( i = 0; i < numParts; i++ )
     {
-        if( readVal<Integer>(fd, partTypes[i], LittleEndian ) == false )
+        if( readVal<Integer>(in, partTypes[i], LittleEndian ) == false )
             return false;
     }
 
     points = new struct Point[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( points[i].read(fd ) == false )
+        if( points[i].read(in ) == false )
             return false;
     }
 
-    if( zRange.read(fd) == false )
+    if( zRange.read(in) == false )
         return false;
 
     zArray = new Double[numPoints];
     for( i = 0; i < numPoints; i++ )
     {
-        if( readVal<Double>(fd, zArray[i], LittleEndian ) == false )
+        if( readVal<Double>(in, zArray[i], LittleEndian ) == false )
             return false;
     }
 
@@ -1318,13 +1436,13 @@ bool MultiPatch::read( int fd )
     int  Z = Y + 16 + (8 *numPoints);
     if( rh.contentLength*2 > Z )
     {
-        if( mRange.read(fd) == false )
+        if( mRange.read(in) == false )
             return false;
 
         mArray = new Double[numPoints];
         for( i = 0; i < numPoints; i++ )
         {
-            if( readVal<Double>(fd, mArray[i], LittleEndian ) == false )
+            if( readVal<Double>(in, mArray[i], LittleEndian ) == false )
                 return false;
         }
     }
@@ -2,6 +2,7 @@
 #define OSG_SHAPE_H
 
 #include <stdio.h>
+#include <vector>
 #ifndef WIN32
 #include <unistd.h>
 #endif
@@ -43,6 +44,34 @@ enum ShapeType {
     ShapeTypeMultiPatch  = 31
 };
 
+// Source of the records of a .shp file. Reading from a file descriptor goes through a buffer
+// rather than a read() call for every field, reading from memory decodes records that have
+// been read in bulk, such as the records of a tile found through the .shx index.
+class RecordReader
+{
+    public:
+        RecordReader( int fd );
+        RecordReader( const char *data, size_t size );
+
+        // Copies up to nbytes to buf, returns the number of bytes copied, 0 at the end of the data.
+        int read( void *buf, size_t nbytes );
+
+        // Skips nbytes, seeking past what isn't buffered yet.
+        bool skip( size_t nbytes );
+
+        // Moves to an offset of the file, only supported when reading from a file descriptor.
+        bool seek( long long offset );
+
+    private:
+        bool fill();
+
+        int                 _fd;
+        std::vector<char>   _buffer;
+        const char         *_data;
+        size_t              _size;
+        size_t              _pos;
+};
+
 
 struct BoundingBox
 {
@@ -55,7 +84,7 @@ struct BoundingBox
     Double Mmin;
     Double Mmax;
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -71,7 +100,7 @@ struct ShapeHeader
     Integer shapeType;
     BoundingBox bbox;
 
-    bool read(int fd);
+    bool read(RecordReader &in);
 
     void print();
 };
@@ -83,7 +112,7 @@ struct RecordHeader
 
     RecordHeader();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -94,7 +123,7 @@ struct NullRecord
     Integer shapeType;
     NullRecord();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -105,7 +134,8 @@ struct Box
 
     Box();
     Box(const Box &b );
-    bool read( int fd );
+    Box &operator=(const Box &b );
+    bool read( RecordReader &in );
 };
 
 struct Range {
@@ -113,7 +143,19 @@ struct Range {
     Range();
     Range( const Range &r );
 
-    bool read( int fd );
+    bool read( RecordReader &in );
+};
+
+// Record header, shape type and bounding box of a record, the rest of the record is skipped.
+// Points are given an empty box at their location, null shapes an invalid one.
+struct RecordExtents
+{
+    Integer recordNumber;
+    Integer contentLength;
+    Integer shapeType;
+    Box     bbox;
+
+    bool read( RecordReader &in );
 };
 
 struct ShapeObject : public osg::Referenced
@@ -132,14 +174,14 @@ struct Point : public ShapeObject
     Point(const Point &p);
     virtual ~Point();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
     void print();
 };
 
 struct PointRecord
 {
     Point point;
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 struct MultiPoint: public ShapeObject
@@ -154,7 +196,7 @@ struct MultiPoint: public ShapeObject
 
     virtual ~MultiPoint();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -173,7 +215,7 @@ struct PolyLine: public ShapeObject
 
     virtual ~PolyLine();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 
@@ -193,7 +235,7 @@ struct Polygon : public ShapeObject
     virtual ~Polygon();
 
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -207,7 +249,7 @@ struct PointM : public ShapeObject
 
     virtual ~PointM();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -216,7 +258,7 @@ struct PointMRecord
 {
     PointM pointM;
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 
@@ -234,7 +276,7 @@ struct MultiPointM: public ShapeObject
 
     virtual ~MultiPointM();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -256,7 +298,7 @@ struct PolyLineM: public ShapeObject
 
     virtual ~PolyLineM();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 
@@ -276,7 +318,7 @@ struct PolygonM : public ShapeObject
 
     virtual ~PolygonM();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 
@@ -295,7 +337,7 @@ struct PointZ : public ShapeObject
     PointZ(const PointZ &p);
     virtual ~PointZ();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -316,7 +358,7 @@ struct MultiPointZ: public ShapeObject
 
     virtual ~MultiPointZ();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 
     void print();
 };
@@ -341,7 +383,7 @@ struct PolyLineZ: public ShapeObject
 
     virtual ~PolyLineZ();
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 
@@ -364,7 +406,7 @@ struct PolygonZ : public ShapeObject
     virtual ~PolygonZ();
 
 
-    bool read( int fd );
+    bool read( RecordReader &in );
 };
 
 
@@ -387,7 +429,7 @@ struct MultiPatch
     MultiPatch();
     MultiPatch( const MultiPatch &);
     virtual ~MultiPatch();
-    bool read( int );
+    bool read( RecordReader & );
 };
 
 }
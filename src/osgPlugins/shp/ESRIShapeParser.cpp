@@ -2,6 +2,8 @@
 #include <osg/Geometry>
 #include <osg/Notify>
 #include <osgUtil/Tessellator>
+#include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
 
 #if defined(_MSC_VER)
     #include <io.h>
@@ -12,35 +14,205 @@
 
 using namespace ESRIShape;
 
-ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, bool keepSeparatePoints) :
+namespace
+{
+
+const unsigned int SHAPES_PER_BLOCK = 64;
+
+int openShapeFile( const std::string &fileName )
+{
+#ifdef WIN32
+    int fd = open( fileName.c_str(), O_RDONLY | O_BINARY );
+#else
+    int fd = open( fileName.c_str(), O_RDONLY );
+#endif
+    if( fd < 0 )
+        perror( fileName.c_str() );
+    return fd;
+}
+
+// Creates the geometries of the shapes a block at a time, from all the threads running it.
+class GeometryBuilder
+{
+    public:
+        GeometryBuilder( unsigned int numShapes ):
+            _numShapes(numShapes),
+            _geometries(numShapes) {}
+
+        virtual ~GeometryBuilder() {}
+
+        void run()
+        {
+            for(;;)
+            {
+                unsigned int begin = ((++_nextBlock) - 1) * SHAPES_PER_BLOCK;
+                if( begin >= _numShapes ) break;
+
+                unsigned int end = osg::minimum( begin + SHAPES_PER_BLOCK, _numShapes );
+                for( unsigned int i = begin; i < end; i++ )
+                    _geometries[i] = createGeometry( i );
+            }
+        }
+
+        unsigned int getNumBlocks() const { return (_numShapes + SHAPES_PER_BLOCK - 1) / SHAPES_PER_BLOCK; }
+
+        const std::vector< osg::ref_ptr<osg::Geometry> > &getGeometries() const { return _geometries; }
+
+    protected:
+        virtual osg::Geometry *createGeometry( unsigned int index ) const = 0;
+
+        unsigned int                                _numShapes;
+        std::vector< osg::ref_ptr<osg::Geometry> >  _geometries;
+        OpenThreads::Atomic                         _nextBlock;
+};
+
+template<class T>
+class ShapeGeometryBuilder : public GeometryBuilder
+{
+    public:
+        ShapeGeometryBuilder( const ESRIShapeParser &parser, const std::vector<T> &shapes ):
+            GeometryBuilder(shapes.size()),
+            _parser(parser),
+            _shapes(shapes) {}
+
+    protected:
+        virtual osg::Geometry *createGeometry( unsigned int index ) const { return _parser.createGeometry( _shapes[index] ); }
+
+        const ESRIShapeParser   &_parser;
+        const std::vector<T>    &_shapes;
+};
+
+class GeometryBuilderThread : public OpenThreads::Thread
+{
+    public:
+        GeometryBuilderThread( GeometryBuilder &builder ):
+            _builder(builder) {}
+
+        virtual void run() { _builder.run(); }
+
+    protected:
+        GeometryBuilder &_builder;
+};
+
+void runBuilder( GeometryBuilder &builder, unsigned int numThreads )
+{
+    numThreads = osg::minimum( numThreads, builder.getNumBlocks() );
+
+    std::vector<GeometryBuilderThread*> threads;
+    for( unsigned int i = 1; i < numThreads; i++ )
+    {
+        GeometryBuilderThread *thread = new GeometryBuilderThread( builder );
+        thread->start();
+        threads.push_back( thread );
+    }
+
+    builder.run();
+
+    for( std::vector<GeometryBuilderThread*>::iterator itr = threads.begin(); itr != threads.end(); ++itr )
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+}
+
+}
+
+ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, bool keepSeparatePoints, unsigned int numThreads) :
     _valid(false),
     _useDouble(useDouble),
-    _keepSeparatePoints(keepSeparatePoints)
+    _keepSeparatePoints(keepSeparatePoints),
+    _numThreads(numThreads != 0 ? numThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1)))
 {
     int fd = 0;
     if( !fileName.empty() )
     {
-#ifdef WIN32
-        if( (fd = open( fileName.c_str(), O_RDONLY | O_BINARY )) < 0 )
-#else
-        if( (fd = open( fileName.c_str(), O_RDONLY )) < 0 )
-#endif
-        {
-            perror( fileName.c_str() );
+        if( (fd = openShapeFile( fileName )) < 0 )
             return ;
-        }
     }
 
     _valid = true;
 
+    ESRIShape::RecordReader in(fd);
+
     ESRIShape::ShapeHeader head;
-    head.read(fd);
+    head.read(in);
 
     //head.print();
 
     _geode = new osg::Geode;
 
-    switch( head.shapeType )
+    _read( in, head.shapeType );
+
+    if(fd)
+    {
+      close(fd);
+      fd = 0;
+    }
+}
+
+ESRIShapeParser::ESRIShapeParser(const std::string fileName, const RecordLocationList &records, bool useDouble, bool keepSeparatePoints, unsigned int numThreads) :
+    _valid(false),
+    _useDouble(useDouble),
+    _keepSeparatePoints(keepSeparatePoints),
+    _numThreads(numThreads != 0 ? numThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1)))
+{
+    int fd = openShapeFile( fileName );
+    if( fd < 0 )
+        return;
+
+    ESRIShape::RecordReader in(fd);
+
+    ESRIShape::ShapeHeader head;
+    if( head.read(in) )
+    {
+        // Records following each other in the file are read without seeking in between.
+        std::vector<char> data;
+        long long offset = 100;
+        for( RecordLocationList::const_iterator itr = records.begin(); itr != records.end(); ++itr )
+        {
+            if( itr->offset != offset && in.seek( itr->offset ) == false )
+                break;
+
+            size_t size = data.size();
+            data.resize( size + itr->length );
+            if( in.read( &data[size], itr->length ) != static_cast<int>(itr->length) )
+            {
+                OSG_WARN << "ESRIShapeParser - could not read the record at offset " << itr->offset << " of " << fileName << std::endl;
+                data.resize( size );
+                break;
+            }
+            offset = itr->offset + itr->length;
+        }
+
+        _valid = true;
+        _geode = new osg::Geode;
+
+        if( !data.empty() )
+        {
+            ESRIShape::RecordReader recordReader( &data.front(), data.size() );
+            _read( recordReader, head.shapeType );
+        }
+    }
+
+    close(fd);
+}
+
+template<class T>
+void ESRIShapeParser::_process( const std::vector<T> &shapes )
+{
+    if( !_valid ) return;
+
+    ShapeGeometryBuilder<T> builder( *this, shapes );
+    runBuilder( builder, _numThreads );
+
+    const std::vector< osg::ref_ptr<osg::Geometry> > &geometries = builder.getGeometries();
+    for( std::vector< osg::ref_ptr<osg::Geometry> >::const_iterator itr = geometries.begin(); itr != geometries.end(); ++itr )
+        _geode->addDrawable( itr->get() );
+}
+
+void ESRIShapeParser::_read( ESRIShape::RecordReader &in, Integer shapeType )
+{
+    switch( shapeType )
     {
         case ESRIShape::ShapeTypeNullShape  :
             break;
@@ -49,9 +221,11 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
             {
                 std::vector<ESRIShape::Point> pts;
                 ESRIShape::PointRecord pointRecord;
-                while( pointRecord.read(fd) )
+                while( pointRecord.read(in) )
                     pts.push_back( pointRecord.point );
                 _process( pts );
+                if( _geode->getNumDrawables() > 1 )
+                    _combinePointToMultipoint();
             }
             break;
 
@@ -60,7 +234,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::MultiPoint> mpts;
                 ESRIShape::MultiPoint mpoint;
 
-                while( mpoint.read(fd) )
+                while( mpoint.read(in) )
                     mpts.push_back( mpoint );
 
                 _process(  mpts );
@@ -72,7 +246,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::PolyLine> plines;
                 ESRIShape::PolyLine pline;
 
-                while( pline.read(fd) )
+                while( pline.read(in) )
                     plines.push_back( pline );
 
                 _process( plines );
@@ -85,7 +259,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::Polygon> polys;
                 ESRIShape::Polygon poly;
 
-                while( poly.read(fd) )
+                while( poly.read(in) )
                     polys.push_back( poly );
 
                 _process( polys );
@@ -96,9 +270,11 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
             {
                 std::vector<ESRIShape::PointM> ptms;
                 ESRIShape::PointMRecord pointMRecord;
-                while( pointMRecord.read(fd) )
+                while( pointMRecord.read(in) )
                     ptms.push_back( pointMRecord.pointM );
                 _process( ptms );
+                if( _geode->getNumDrawables() > 1 )
+                    _combinePointToMultipoint();
             }
             break;
 
@@ -107,7 +283,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::MultiPointM> mptms;
                 ESRIShape::MultiPointM mpointm;
 
-                while( mpointm.read(fd) )
+                while( mpointm.read(in) )
                     mptms.push_back( mpointm );
 
                 _process(  mptms );
@@ -119,7 +295,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::PolyLineM> plinems;
                 ESRIShape::PolyLineM plinem;
 
-                while( plinem.read(fd) )
+                while( plinem.read(in) )
                     plinems.push_back( plinem );
 
                 _process( plinems );
@@ -131,7 +307,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::PolygonM> polyms;
                 ESRIShape::PolygonM polym;
 
-                while( polym.read(fd) )
+                while( polym.read(in) )
                     polyms.push_back( polym );
 
                 _process( polyms );
@@ -143,9 +319,11 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
             {
                 std::vector<ESRIShape::PointZ> ptzs;
                 ESRIShape::PointZ pointZ;
-                while( pointZ.read( fd ) )
+                while( pointZ.read( in ) )
                     ptzs.push_back( pointZ );
                 _process( ptzs );
+                if( _geode->getNumDrawables() > 1 )
+                    _combinePointToMultipoint();
             }
             break;
 
@@ -154,7 +332,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::MultiPointZ> mptzs;
                 ESRIShape::MultiPointZ mpointz;
 
-                while( mpointz.read(fd) )
+                while( mpointz.read(in) )
                     mptzs.push_back( mpointz );
 
                 _process(  mptzs );
@@ -166,7 +344,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::PolyLineZ> plinezs;
                 ESRIShape::PolyLineZ plinez;
 
-                while( plinez.read(fd) )
+                while( plinez.read(in) )
                     plinezs.push_back( plinez );
 
                 _process( plinezs );
@@ -178,7 +356,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::PolygonZ> polyzs;
                 ESRIShape::PolygonZ polyz;
 
-                while( polyz.read(fd) )
+                while( polyz.read(in) )
                     polyzs.push_back( polyz );
 
                 _process( polyzs );
@@ -191,7 +369,7 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
                 std::vector<ESRIShape::MultiPatch> mpatches;
                 ESRIShape::MultiPatch mpatch;
 
-                while( mpatch.read( fd ) )
+                while( mpatch.read( in ) )
                     mpatches.push_back( mpatch );
 
                 _process(mpatches);
@@ -201,12 +379,6 @@ ESRIShapeParser::ESRIShapeParser(const std::string fileName, bool useDouble, boo
         default:
             break;
     }
-
-    if(fd)
-    {
-      close(fd);
-      fd = 0;
-    }
 }
 
 osg::Geode *ESRIShapeParser::getGeode()
@@ -241,380 +413,303 @@ void ESRIShapeParser::_combinePointToMultipoint()
     _geode->addDrawable( geometry.get() );
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::Point> &pts )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::Point &shape ) const
 {
-    if( !_valid ) return;
+    ArrayHelper coords(_useDouble);
 
-    std::vector<ESRIShape::Point>::const_iterator p;
-    for( p = pts.begin(); p != pts.end(); p++ )
-    {
-        ArrayHelper coords(_useDouble);
+    coords.add( shape.x, shape.y, 0.0 );
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
+    geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 1));
 
-        coords.add( p->x, p->y, 0.0 );
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
-        geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 1));
-        _geode->addDrawable( geometry.get() );
-    }
-    if( _geode->getNumDrawables() > 1 )
-        _combinePointToMultipoint();
+    return geometry.release();
 }
 
-
-void ESRIShapeParser::_process( const std::vector<ESRIShape::MultiPoint> &mpts )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::MultiPoint &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::MultiPoint>::const_iterator p;
-    for( p = mpts.begin(); p != mpts.end(); p++ )
-    {
-        ArrayHelper coords(_useDouble);
+    ArrayHelper coords(_useDouble);
 
-        for( int i = 0; i < p->numPoints ; i++ )
-            coords.add( p->points[i].x, p->points[i].y, 0.0 );
+    for( int i = 0; i < shape.numPoints ; i++ )
+        coords.add( shape.points[i].x, shape.points[i].y, 0.0 );
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
-        geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, coords.size()));
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
+    geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, coords.size()));
 
-        _geode->addDrawable( geometry.get() );
-    }
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process(const std::vector<ESRIShape::PolyLine> &lines )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PolyLine &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::PolyLine>::const_iterator p;
-    for( p = lines.begin(); p != lines.end(); p++ )
-    {
-        ArrayHelper coords(_useDouble);
+    ArrayHelper coords(_useDouble);
 
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords.add( p->points[i].x, p->points[i].y, 0.0 );
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords.add( shape.points[i].x, shape.points[i].y, 0.0 );
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        for( i = 0; i < p->numParts; i++ )
-        {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
 
-            geometry->addPrimitiveSet(
-                    new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, index, len));
-        }
-        _geode->addDrawable( geometry.get() );
+        geometry->addPrimitiveSet(
+                new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, index, len));
     }
+
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::Polygon> &polys )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::Polygon &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::Polygon>::const_iterator p;
-    for( p = polys.begin(); p != polys.end(); p++ )
-    {
-        ArrayHelper coords(_useDouble);
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords.add( p->points[i].x, p->points[i].y, 0.0 );
+    ArrayHelper coords(_useDouble);
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords.add( shape.points[i].x, shape.points[i].y, 0.0 );
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        for( i = 0; i < p->numParts; i++ )
-        {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
 
-            geometry->addPrimitiveSet(
-                    new osg::DrawArrays(osg::PrimitiveSet::POLYGON, index, len));
-        }
+        geometry->addPrimitiveSet(
+                new osg::DrawArrays(osg::PrimitiveSet::POLYGON, index, len));
+    }
 
-        // Use osgUtil::Tessellator to handle concave polygons
-        osg::ref_ptr<osgUtil::Tessellator> tscx=new osgUtil::Tessellator;
-        tscx->setTessellationType(osgUtil::Tessellator::TESS_TYPE_GEOMETRY);
-        tscx->setBoundaryOnly(false);
-        tscx->setWindingType( osgUtil::Tessellator::TESS_WINDING_ODD);
+    // Use osgUtil::Tessellator to handle concave polygons
+    osg::ref_ptr<osgUtil::Tessellator> tscx=new osgUtil::Tessellator;
+    tscx->setTessellationType(osgUtil::Tessellator::TESS_TYPE_GEOMETRY);
+    tscx->setBoundaryOnly(false);
+    tscx->setWindingType( osgUtil::Tessellator::TESS_WINDING_ODD);
 
-        tscx->retessellatePolygons(*(geometry.get()));
+    tscx->retessellatePolygons(*(geometry.get()));
 
-        _geode->addDrawable( geometry.get() );
-    }
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::PointM> &ptms )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PointM &shape ) const
 {
-    if( !_valid ) return;
+    ArrayHelper coords(_useDouble);
+    coords.add( shape.x, shape.y, 0.0 );
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
+    geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 1));
 
-    std::vector<ESRIShape::PointM>::const_iterator p;
-    for( p = ptms.begin(); p != ptms.end(); p++ )
-    {
-        ArrayHelper coords(_useDouble);
-        coords.add( p->x, p->y, 0.0 );
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
-        geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 1));
-        _geode->addDrawable( geometry.get() );
-    }
-    if( _geode->getNumDrawables() > 1 )
-        _combinePointToMultipoint();
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::MultiPointM> &mptms )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::MultiPointM &shape ) const
 {
-    if( !_valid ) return;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
 
-    std::vector<ESRIShape::MultiPointM>::const_iterator p;
-    for( p = mptms.begin(); p != mptms.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
-
-        // Here is where we would use the 'M' (?)
-        for( int i = 0; i < p->numPoints ; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, 0.0 ));
+    // Here is where we would use the 'M' (?)
+    for( int i = 0; i < shape.numPoints ; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, 0.0 ));
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
-        geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, coords->size()));
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
+    geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, coords->size()));
 
-        _geode->addDrawable( geometry.get() );
-    }
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process(const std::vector<ESRIShape::PolyLineM> &linems )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PolyLineM &shape ) const
 {
-    if( !_valid ) return;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
 
-    std::vector<ESRIShape::PolyLineM>::const_iterator p;
-    for( p = linems.begin(); p != linems.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
-
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, 0.0 ));
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, 0.0 ));
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        for( i = 0; i < p->numParts; i++ )
-        {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
 
-            geometry->addPrimitiveSet(
-                    new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, index, len));
-        }
-        _geode->addDrawable( geometry.get() );
+        geometry->addPrimitiveSet(
+                new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, index, len));
     }
+
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::PolygonM> &polyms )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PolygonM &shape ) const
 {
-    if( !_valid ) return;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, 0.0 ));
 
-    std::vector<ESRIShape::PolygonM>::const_iterator p;
-    for( p = polyms.begin(); p != polyms.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, 0.0 ));
-
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        for( i = 0; i < p->numParts; i++ )
-        {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
 
-            geometry->addPrimitiveSet(
-                    new osg::DrawArrays(osg::PrimitiveSet::POLYGON, index, len));
-        }
-        _geode->addDrawable( geometry.get() );
+        geometry->addPrimitiveSet(
+                new osg::DrawArrays(osg::PrimitiveSet::POLYGON, index, len));
     }
+
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::PointZ> &ptzs )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PointZ &shape ) const
 {
-    if( !_valid ) return;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
+    coords->push_back( osg::Vec3( shape.x, shape.y, shape.z ));
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
+    geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 1));
 
-    std::vector<ESRIShape::PointZ>::const_iterator p;
-    for( p = ptzs.begin(); p != ptzs.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
-        coords->push_back( osg::Vec3( p->x, p->y, p->z ));
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
-        geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, 1));
-        _geode->addDrawable( geometry.get() );
-    }
-    if( _geode->getNumDrawables() > 1 )
-        _combinePointToMultipoint();
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::MultiPointZ> &mptzs )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::MultiPointZ &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::MultiPointZ>::const_iterator p;
-    for( p = mptzs.begin(); p != mptzs.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
 
-        // Here is where we would use the 'M' (?)
-        for( int i = 0; i < p->numPoints ; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, p->zArray[i] ));
+    // Here is where we would use the 'M' (?)
+    for( int i = 0; i < shape.numPoints ; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, shape.zArray[i] ));
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
-        geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, coords->size()));
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
+    geometry->addPrimitiveSet( new osg::DrawArrays(osg::PrimitiveSet::POINTS, 0, coords->size()));
 
-        _geode->addDrawable( geometry.get() );
-    }
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process(const std::vector<ESRIShape::PolyLineZ> &linezs )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PolyLineZ &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::PolyLineZ>::const_iterator p;
-    for( p = linezs.begin(); p != linezs.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
 
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, p->zArray[i] ));
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, shape.zArray[i] ));
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        for( i = 0; i < p->numParts; i++ )
-        {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
 
-            geometry->addPrimitiveSet(
-                    new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, index, len));
-        }
-        _geode->addDrawable( geometry.get() );
+        geometry->addPrimitiveSet(
+                new osg::DrawArrays(osg::PrimitiveSet::LINE_STRIP, index, len));
     }
+
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::PolygonZ> &polyzs )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::PolygonZ &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::PolygonZ>::const_iterator p;
-    for( p = polyzs.begin(); p != polyzs.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
 
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, p->zArray[i] ));
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, shape.zArray[i] ));
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        for( i = 0; i < p->numParts; i++ )
-        {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
 
-            geometry->addPrimitiveSet(
-                    new osg::DrawArrays(osg::PrimitiveSet::POLYGON, index, len));
-        }
-        _geode->addDrawable( geometry.get() );
+        geometry->addPrimitiveSet(
+                new osg::DrawArrays(osg::PrimitiveSet::POLYGON, index, len));
     }
+
+    return geometry.release();
 }
 
-void ESRIShapeParser::_process( const std::vector<ESRIShape::MultiPatch> &mpatches )
+osg::Geometry* ESRIShapeParser::createGeometry( const ESRIShape::MultiPatch &shape ) const
 {
-    if( !_valid ) return;
-
-    std::vector<ESRIShape::MultiPatch>::const_iterator p;
-    for( p = mpatches.begin(); p != mpatches.end(); p++ )
-    {
-        osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> coords  = new osg::Vec3Array;
 
-        int i;
-        for( i = 0; i < p->numPoints; i++ )
-            coords->push_back( osg::Vec3( p->points[i].x, p->points[i].y, p->zArray[i] ));
+    int i;
+    for( i = 0; i < shape.numPoints; i++ )
+        coords->push_back( osg::Vec3( shape.points[i].x, shape.points[i].y, shape.zArray[i] ));
 
-        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
-        geometry->setVertexArray(coords.get());
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(coords.get());
 
-        // Lets mark poorly supported primitives with red, otherwise white
-        osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
-        geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX );
+    // Lets mark poorly supported primitives with red, otherwise white
+    osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
+    geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX );
 
-        for( i = 0; i < p->numParts; i++ )
+    for( i = 0; i < shape.numParts; i++ )
+    {
+        int index = shape.parts[i];
+        int len = i < shape.numParts - 1 ?
+                        shape.parts[i+1] - shape.parts[i] :
+                        shape.numPoints  - shape.parts[i];
+
+        int  mode =
+            shape.partTypes[i] == TriangleStrip ? osg::PrimitiveSet::TRIANGLE_STRIP :
+            shape.partTypes[i] == TriangleFan   ? osg::PrimitiveSet::TRIANGLE_FAN :
+            // HACK for now
+            shape.partTypes[i] == OuterRing     ? osg::PrimitiveSet::LINE_STRIP :
+            shape.partTypes[i] == InnerRing     ? osg::PrimitiveSet::LINE_STRIP :
+            shape.partTypes[i] == FirstRing     ? osg::PrimitiveSet::LINE_STRIP :
+            shape.partTypes[i] == Ring          ? osg::PrimitiveSet::LINE_STRIP :
+                                                osg::PrimitiveSet::POINTS ;
+
+        if( shape.partTypes[i] == OuterRing ||
+            shape.partTypes[i] == InnerRing ||
+            shape.partTypes[i] == FirstRing || shape.partTypes[i] == Ring )
         {
-            int index = p->parts[i];
-            int len = i < p->numParts - 1 ?
-                            p->parts[i+1] - p->parts[i] :
-                            p->numPoints  - p->parts[i];
-
-            int  mode =
-                p->partTypes[i] == TriangleStrip ? osg::PrimitiveSet::TRIANGLE_STRIP :
-                p->partTypes[i] == TriangleFan   ? osg::PrimitiveSet::TRIANGLE_FAN :
-                // HACK for now
-                p->partTypes[i] == OuterRing     ? osg::PrimitiveSet::LINE_STRIP :
-                p->partTypes[i] == InnerRing     ? osg::PrimitiveSet::LINE_STRIP :
-                p->partTypes[i] == FirstRing     ? osg::PrimitiveSet::LINE_STRIP :
-                p->partTypes[i] == Ring          ? osg::PrimitiveSet::LINE_STRIP :
-                                                   osg::PrimitiveSet::POINTS ;
-
-            if( p->partTypes[i] == OuterRing ||
-                p->partTypes[i] == InnerRing ||
-                p->partTypes[i] == FirstRing || p->partTypes[i] == Ring )
-            {
-                OSG_WARN << "ESRIShapeParser - MultiPatch type " <<
-                    (p->partTypes[i] == TriangleStrip ? "TriangleStrip":
-                     p->partTypes[i] == TriangleFan   ? "TriangleFan":
-                     p->partTypes[i] == OuterRing     ? "OuterRing":
-                     p->partTypes[i] == InnerRing     ? "InnerRing":
-                     p->partTypes[i] == FirstRing     ? "FirstRing":
-                     p->partTypes[i] == Ring          ? "Ring": "Dunno") <<
-                    " poorly supported.  Will be represented by a red line strip" << std::endl;
-            }
-
-
+            OSG_WARN << "ESRIShapeParser - MultiPatch type " <<
+                (shape.partTypes[i] == TriangleStrip ? "TriangleStrip":
+                 shape.partTypes[i] == TriangleFan   ? "TriangleFan":
+                 shape.partTypes[i] == OuterRing     ? "OuterRing":
+                 shape.partTypes[i] == InnerRing     ? "InnerRing":
+                 shape.partTypes[i] == FirstRing     ? "FirstRing":
+                 shape.partTypes[i] == Ring          ? "Ring": "Dunno") <<
+                " poorly supported.  Will be represented by a red line strip" << std::endl;
+        }
 
-            // Lets mark poorly supported primitives with red, otherwise white
-            osg::Vec4 color =
-                p->partTypes[i] == TriangleStrip ? osg::Vec4(1.0,1.0,1.0,1.0) :
-                p->partTypes[i] == TriangleFan   ? osg::Vec4(1.0,1.0,1.0,1.0) :
-                // HACK for now
-                p->partTypes[i] == OuterRing     ? osg::Vec4(1.0,0.0,0.0,1.0) :
-                p->partTypes[i] == InnerRing     ? osg::Vec4(1.0,0.0,0.0,1.0) :
-                p->partTypes[i] == FirstRing     ? osg::Vec4(1.0,0.0,0.0,1.0) :
-                p->partTypes[i] == Ring          ? osg::Vec4(1.0,0.0,0.0,1.0) :
-                                                   osg::Vec4(1.0,0.0,0.0,1.0) ;
-            for( int j = 0; j < len; j++ )
-                colors->push_back( color );
 
-            geometry->addPrimitiveSet( new osg::DrawArrays(mode, index, len ));
-        }
 
-        _geode->addDrawable( geometry.get() );
+        // Lets mark poorly supported primitives with red, otherwise white
+        osg::Vec4 color =
+            shape.partTypes[i] == TriangleStrip ? osg::Vec4(1.0,1.0,1.0,1.0) :
+            shape.partTypes[i] == TriangleFan   ? osg::Vec4(1.0,1.0,1.0,1.0) :
+            // HACK for now
+            shape.partTypes[i] == OuterRing     ? osg::Vec4(1.0,0.0,0.0,1.0) :
+            shape.partTypes[i] == InnerRing     ? osg::Vec4(1.0,0.0,0.0,1.0) :
+            shape.partTypes[i] == FirstRing     ? osg::Vec4(1.0,0.0,0.0,1.0) :
+            shape.partTypes[i] == Ring          ? osg::Vec4(1.0,0.0,0.0,1.0) :
+                                                osg::Vec4(1.0,0.0,0.0,1.0) ;
+        for( int j = 0; j < len; j++ )
+            colors->push_back( color );
+
+        geometry->addPrimitiveSet( new osg::DrawArrays(mode, index, len ));
     }
+
+    return geometry.release();
 }
@@ -2,6 +2,7 @@
 #define ESRI_SHAPE_PARSER_H
 
 #include <string>
+#include <vector>
 #include <osg/Geode>
 
 #include "ESRIShape.h"
@@ -57,14 +58,48 @@ class ArrayHelper
 };
 
 
+// Offset and length in bytes of a record of a .shp file, record header included.
+struct RecordLocation
+{
+    RecordLocation(): offset(0), length(0) {}
+    RecordLocation(long long o, unsigned int l): offset(o), length(l) {}
+
+    long long       offset;
+    unsigned int    length;
+};
+
+typedef std::vector<RecordLocation> RecordLocationList;
+
+
+// Reads the shapes of a .shp file into a Geode holding a Geometry per shape, created on numThreads
+// threads, the calling thread included, 0 using as many threads as there are processors.
 class ESRIShapeParser
 {
     public:
 
-        ESRIShapeParser( const std::string fileName, bool useDouble, bool keepSeparatePoints);
+        ESRIShapeParser( const std::string fileName, bool useDouble, bool keepSeparatePoints, unsigned int numThreads=0 );
+
+        // Only reads the given records, in the order they are listed.
+        ESRIShapeParser( const std::string fileName, const RecordLocationList &records, bool useDouble, bool keepSeparatePoints, unsigned int numThreads=0 );
 
         osg::Geode *getGeode();
 
+        osg::Geometry *createGeometry( const ESRIShape::Point & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::MultiPoint & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::PolyLine & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::Polygon & ) const;
+
+        osg::Geometry *createGeometry( const ESRIShape::PointM & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::MultiPointM & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::PolyLineM & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::PolygonM & ) const;
+
+        osg::Geometry *createGeometry( const ESRIShape::PointZ & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::MultiPointZ & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::PolyLineZ & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::PolygonZ & ) const;
+        osg::Geometry *createGeometry( const ESRIShape::MultiPatch & ) const;
+
 #if 0
 #if 1
         typedef osg::Vec3d ShapeVec3;
@@ -82,25 +117,16 @@ class ESRIShapeParser
         bool _valid;
         bool _useDouble;
         bool _keepSeparatePoints;
+        unsigned int _numThreads;
 
         osg::ref_ptr<osg::Geode> _geode;
 
+        void _read( ESRIShape::RecordReader &in, Integer shapeType );
+
         void _combinePointToMultipoint();
-        void _process( const std::vector<ESRIShape::Point> &);
-        void _process( const std::vector<ESRIShape::MultiPoint> &);
-        void _process( const std::vector<ESRIShape::PolyLine> &);
-        void _process( const std::vector<ESRIShape::Polygon> &);
-
-        void _process( const std::vector<ESRIShape::PointM> &);
-        void _process( const std::vector<ESRIShape::MultiPointM> &);
-        void _process( const std::vector<ESRIShape::PolyLineM> &);
-        void _process( const std::vector<ESRIShape::PolygonM> &);
-
-        void _process( const std::vector<ESRIShape::PointZ> &);
-        void _process( const std::vector<ESRIShape::MultiPointZ> &);
-        void _process( const std::vector<ESRIShape::PolyLineZ> &);
-        void _process( const std::vector<ESRIShape::PolygonZ> &);
-        void _process( const std::vector<ESRIShape::MultiPatch> &);
+
+        template<class T>
+        void _process( const std::vector<T> &shapes );
 
 };
 
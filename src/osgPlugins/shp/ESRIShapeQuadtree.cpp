@@ -0,0 +1,718 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+#include <sstream>
+
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include <osg/Geode>
+#include <osg/Notify>
+#include <osg/PagedLOD>
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
+
+#include <OpenThreads/Thread>
+
+#include "ESRIShape.h"
+#include "ESRIShapeQuadtree.h"
+#include "XBaseParser.h"
+
+using namespace ESRIShape;
+
+namespace
+{
+
+const char INDEX_MAGIC[8] = { 'O', 'S', 'G', 'S', 'H', 'P', 'Q', 'T' };
+const unsigned int INDEX_VERSION = 1;
+
+const unsigned int MAXIMUM_LEVEL = 24;
+
+// Each thread reads the extents of at least this many records, so that small files aren't split across threads.
+const unsigned int MINIMUM_RECORDS_PER_THREAD = 1<<16;
+
+template<typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return !in.fail();
+}
+
+bool getFileStamp(const std::string& fileName, unsigned long long& size, long long& modificationTime)
+{
+    struct stat fileStat;
+    if (stat(fileName.c_str(), &fileStat)!=0)
+        return false;
+
+    size = static_cast<unsigned long long>(fileStat.st_size);
+    modificationTime = static_cast<long long>(fileStat.st_mtime);
+    return true;
+}
+
+int openFile(const std::string& fileName)
+{
+#ifdef WIN32
+    return open(fileName.c_str(), O_RDONLY | O_BINARY);
+#else
+    return open(fileName.c_str(), O_RDONLY);
+#endif
+}
+
+// Returns the name of the .shx or .dbf file of a shapefile, empty if there is none.
+std::string getSiblingFileName(const std::string& fileName, const std::string& extension)
+{
+    std::string baseName = osgDB::getNameLessExtension(fileName);
+    if (osgDB::fileExists(baseName + "." + extension))
+        return baseName + "." + extension;
+
+    std::string upperCaseExtension = extension;
+    for(std::string::iterator itr=upperCaseExtension.begin(); itr!=upperCaseExtension.end(); ++itr) *itr = toupper(*itr);
+    if (osgDB::fileExists(baseName + "." + upperCaseExtension))
+        return baseName + "." + upperCaseExtension;
+
+    return std::string();
+}
+
+inline unsigned int readBigEndian(const unsigned char* data)
+{
+    return (static_cast<unsigned int>(data[0])<<24) | (static_cast<unsigned int>(data[1])<<16) |
+           (static_cast<unsigned int>(data[2])<<8) | static_cast<unsigned int>(data[3]);
+}
+
+// Reads the offsets and lengths of the records from the .shx file, lengths being stored in 16 bit words
+// without the 8 bytes of the record header.
+bool readShx(const std::string& shxFileName, Quadtree::RecordList& records)
+{
+    osgDB::ifstream in(shxFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!in) return false;
+
+    in.seekg(0, std::ios::end);
+    long long size = static_cast<long long>(in.tellg());
+    if (size<100) return false;
+
+    std::vector<unsigned char> data(static_cast<size_t>(size-100));
+    in.seekg(100);
+    if (!data.empty()) in.read(reinterpret_cast<char*>(&data.front()), data.size());
+    if (in.fail()) return false;
+
+    records.resize(data.size()/8);
+    for(unsigned int i=0; i<records.size(); ++i)
+    {
+        records[i].index = i;
+        records[i].offset = static_cast<long long>(readBigEndian(&data[i*8]))*2;
+        records[i].length = readBigEndian(&data[i*8+4])*2 + 8;
+    }
+    return true;
+}
+
+// Records whose extents are read by a thread, from its own file descriptor.
+struct ScanPart
+{
+    ScanPart() : first(0), last(0), ok(false) {}
+
+    unsigned int    first;
+    unsigned int    last;
+    bool            ok;
+};
+
+bool scanPart(const std::string& fileName, const Quadtree::RecordList& records, std::vector<Box>& boxes, ScanPart& part)
+{
+    int fd = openFile(fileName);
+    if (fd<0) return false;
+
+    RecordReader in(fd);
+    long long position = -1;
+    bool ok = true;
+    for(unsigned int i=part.first; i<part.last && ok; ++i)
+    {
+        const Quadtree::Record& record = records[i];
+        if (record.offset!=position && !in.seek(record.offset))
+        {
+            ok = false;
+            break;
+        }
+
+        RecordExtents extents;
+        if (!extents.read(in))
+        {
+            ok = false;
+            break;
+        }
+
+        if (extents.shapeType!=ShapeTypeNullShape) boxes[i] = extents.bbox;
+        position = record.offset + 8 + extents.contentLength*2;
+    }
+
+    close(fd);
+    return ok;
+}
+
+class ScanThread : public OpenThreads::Thread
+{
+public:
+    ScanThread(const std::string& fileName, const Quadtree::RecordList& records, std::vector<Box>& boxes, ScanPart& part):
+        _fileName(fileName),
+        _records(records),
+        _boxes(boxes),
+        _part(part) {}
+
+    virtual void run()
+    {
+        _part.ok = scanPart(_fileName, _records, _boxes, _part);
+    }
+
+protected:
+    const std::string&              _fileName;
+    const Quadtree::RecordList&     _records;
+    std::vector<Box>&               _boxes;
+    ScanPart&                       _part;
+};
+
+// Reads the extents of the records listed in the .shx file, several threads each reading their own range of records.
+bool scanRecords(const std::string& fileName, const Quadtree::RecordList& records, std::vector<Box>& boxes, unsigned int numThreads)
+{
+    unsigned int numParts = osg::clampBetween(static_cast<unsigned int>(records.size())/MINIMUM_RECORDS_PER_THREAD, 1u, numThreads);
+
+    std::vector<ScanPart> parts(numParts);
+    for(unsigned int i=0; i<numParts; ++i)
+    {
+        parts[i].first = static_cast<unsigned int>(static_cast<unsigned long long>(records.size())*i/numParts);
+        parts[i].last = static_cast<unsigned int>(static_cast<unsigned long long>(records.size())*(i+1)/numParts);
+    }
+
+    std::vector<ScanThread*> threads;
+    for(unsigned int i=1; i<parts.size(); ++i)
+    {
+        ScanThread* thread = new ScanThread(fileName, records, boxes, parts[i]);
+        thread->start();
+        threads.push_back(thread);
+    }
+
+    parts[0].ok = scanPart(fileName, records, boxes, parts[0]);
+
+    bool ok = parts[0].ok;
+    for(unsigned int i=0; i<threads.size(); ++i)
+    {
+        threads[i]->join();
+        delete threads[i];
+        ok = ok && parts[i+1].ok;
+    }
+    return ok;
+}
+
+// Reads the offsets and extents of the records of a shapefile without a .shx file, one record after the other.
+bool scanFile(const std::string& fileName, Quadtree::RecordList& records, std::vector<Box>& boxes)
+{
+    int fd = openFile(fileName);
+    if (fd<0) return false;
+
+    RecordReader in(fd);
+    ShapeHeader head;
+    if (!head.read(in))
+    {
+        close(fd);
+        return false;
+    }
+
+    long long offset = 100;
+    RecordExtents extents;
+    while (extents.read(in))
+    {
+        Quadtree::Record record;
+        record.index = static_cast<unsigned int>(records.size());
+        record.offset = offset;
+        record.length = extents.contentLength*2 + 8;
+        records.push_back(record);
+
+        boxes.push_back(extents.shapeType!=ShapeTypeNullShape ? extents.bbox : Box());
+        offset += record.length;
+    }
+
+    close(fd);
+    return true;
+}
+
+struct LessOffset
+{
+    bool operator() (const Quadtree::Record& lhs, const Quadtree::Record& rhs) const { return lhs.offset < rhs.offset; }
+};
+
+}
+
+
+QuadtreeSettings::QuadtreeSettings(const osgDB::Options* options):
+    useDouble(false),
+    keepSeparatePoints(false),
+    numThreads(0),
+    threshold(100000),
+    tileShapes(4096),
+    lodScale(4.0f)
+{
+    if (!options) return;
+
+    const std::string& optionString = options->getOptionString();
+    useDouble = optionString.find("double")!=std::string::npos;
+    keepSeparatePoints = optionString.find("keepSeparatePoints")!=std::string::npos;
+
+    std::istringstream iss(optionString);
+    std::string opt;
+    while (iss >> opt)
+    {
+        std::string::size_type pos = opt.find('=');
+        if (pos==std::string::npos) continue;
+
+        std::string key = opt.substr(0, pos);
+        std::istringstream value(opt.substr(pos+1));
+        if (key=="parseThreads") value >> numThreads;
+        else if (key=="pagingThreshold") value >> threshold;
+        else if (key=="pagingTileShapes") value >> tileShapes;
+        else if (key=="pagingLODScale") value >> lodScale;
+    }
+
+    if (tileShapes<16) tileShapes = 16;
+}
+
+
+Quadtree::Quadtree(const std::string& fileName):
+    _fileName(fileName),
+    _indexFileName(osgDB::getNameLessExtension(fileName) + ".quadtree"),
+    _zMin(0.0),
+    _zMax(0.0)
+{
+}
+
+unsigned int Quadtree::getNumRecords(const std::string& fileName)
+{
+    std::string shxFileName = getSiblingFileName(fileName, "shx");
+    if (!shxFileName.empty())
+    {
+        unsigned long long size = 0;
+        long long modificationTime = 0;
+        if (getFileStamp(shxFileName, size, modificationTime) && size>=100)
+            return static_cast<unsigned int>((size-100)/8);
+    }
+
+    int fd = openFile(fileName);
+    if (fd<0) return 0;
+
+    RecordReader in(fd);
+    ShapeHeader head;
+    unsigned int numRecords = 0;
+    if (head.read(in))
+    {
+        RecordHeader rh;
+        while (rh.read(in) && rh.contentLength>=0 && in.skip(rh.contentLength*2))
+            ++numRecords;
+    }
+
+    close(fd);
+    return numRecords;
+}
+
+osg::ref_ptr<Quadtree> Quadtree::open(const std::string& fileName, const QuadtreeSettings& settings)
+{
+    osg::ref_ptr<Quadtree> quadtree = new Quadtree(fileName);
+    if (quadtree->read(settings.tileShapes))
+    {
+        OSG_INFO << "shp quadtree: read " << quadtree->_indexFileName << std::endl;
+        return quadtree;
+    }
+
+    if (!quadtree->build(settings))
+        return NULL;
+
+    // The index is kept in memory when it can't be written next to the shapefile.
+    if (!quadtree->write(settings.tileShapes))
+        OSG_INFO << "shp quadtree: could not write " << quadtree->_indexFileName << std::endl;
+
+    return quadtree;
+}
+
+bool Quadtree::read(unsigned int tileShapes)
+{
+    osgDB::ifstream in(_indexFileName.c_str(), std::ios::in | std::ios::binary);
+    if (!in) return false;
+
+    char magic[sizeof(INDEX_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (in.fail() || memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))!=0) return false;
+
+    unsigned int version = 0;
+    if (!readValue(in, version) || version!=INDEX_VERSION) return false;
+
+    // The index is rebuilt as soon as the shapefile changes.
+    unsigned long long fileSize = 0, indexFileSize = 0;
+    long long modificationTime = 0, indexModificationTime = 0;
+    if (!getFileStamp(_fileName, fileSize, modificationTime)) return false;
+    if (!readValue(in, indexFileSize) || !readValue(in, indexModificationTime)) return false;
+    if (indexFileSize!=fileSize || indexModificationTime!=modificationTime) return false;
+
+    unsigned int indexTileShapes = 0;
+    if (!readValue(in, indexTileShapes) || indexTileShapes!=tileShapes) return false;
+
+    unsigned int numNodes = 0, numRecords = 0;
+    if (!readValue(in, _zMin) || !readValue(in, _zMax) ||
+        !readValue(in, numNodes) || numNodes==0 ||
+        !readValue(in, numRecords))
+    {
+        return false;
+    }
+
+    _nodes.resize(numNodes);
+    for(NodeList::iterator itr=_nodes.begin(); itr!=_nodes.end(); ++itr)
+    {
+        if (!readValue(in, itr->xMin) || !readValue(in, itr->yMin) ||
+            !readValue(in, itr->xMax) || !readValue(in, itr->yMax) ||
+            !readValue(in, itr->firstChild) ||
+            !readValue(in, itr->numChildren) ||
+            !readValue(in, itr->firstRecord) ||
+            !readValue(in, itr->numRecords))
+        {
+            _nodes.clear();
+            return false;
+        }
+
+        // A corrupt index is rebuilt rather than indexing past the nodes and records, children
+        // always following their parent so that the tree can't loop back on itself.
+        unsigned int index = static_cast<unsigned int>(itr-_nodes.begin());
+        bool validChildren = itr->numChildren==0 ||
+                             (itr->firstChild>index && itr->firstChild<numNodes && itr->numChildren<=numNodes-itr->firstChild);
+        bool validRecords = itr->firstRecord<=numRecords && itr->numRecords<=numRecords-itr->firstRecord;
+        if (!validChildren || !validRecords)
+        {
+            OSG_INFO << "shp quadtree: " << _indexFileName << " is corrupt, rebuilding it" << std::endl;
+            _nodes.clear();
+            return false;
+        }
+    }
+
+    _records.resize(numRecords);
+    for(RecordList::iterator itr=_records.begin(); itr!=_records.end(); ++itr)
+    {
+        if (!readValue(in, itr->index) || !readValue(in, itr->offset) || !readValue(in, itr->length))
+        {
+            _nodes.clear();
+            _records.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Quadtree::write(unsigned int tileShapes) const
+{
+    unsigned long long fileSize = 0;
+    long long modificationTime = 0;
+    if (!getFileStamp(_fileName, fileSize, modificationTime)) return false;
+
+    // Write to a temporary file and rename it so that readers never see a partial index.
+    std::string tmpIndexFileName = _indexFileName + ".tmp";
+    {
+        osgDB::ofstream out(tmpIndexFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        writeValue(out, INDEX_VERSION);
+        writeValue(out, fileSize);
+        writeValue(out, modificationTime);
+        writeValue(out, tileShapes);
+        writeValue(out, _zMin);
+        writeValue(out, _zMax);
+        writeValue(out, static_cast<unsigned int>(_nodes.size()));
+        writeValue(out, static_cast<unsigned int>(_records.size()));
+
+        for(NodeList::const_iterator itr=_nodes.begin(); itr!=_nodes.end(); ++itr)
+        {
+            writeValue(out, itr->xMin);
+            writeValue(out, itr->yMin);
+            writeValue(out, itr->xMax);
+            writeValue(out, itr->yMax);
+            writeValue(out, itr->firstChild);
+            writeValue(out, itr->numChildren);
+            writeValue(out, itr->firstRecord);
+            writeValue(out, itr->numRecords);
+        }
+
+        for(RecordList::const_iterator itr=_records.begin(); itr!=_records.end(); ++itr)
+        {
+            writeValue(out, itr->index);
+            writeValue(out, itr->offset);
+            writeValue(out, itr->length);
+        }
+
+        if (!out)
+        {
+            out.close();
+            remove(tmpIndexFileName.c_str());
+            return false;
+        }
+    }
+
+    remove(_indexFileName.c_str());
+    if (rename(tmpIndexFileName.c_str(), _indexFileName.c_str())!=0)
+    {
+        remove(tmpIndexFileName.c_str());
+        return false;
+    }
+
+    OSG_INFO << "shp quadtree: wrote " << _indexFileName << std::endl;
+    return true;
+}
+
+bool Quadtree::build(const QuadtreeSettings& settings)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    {
+        int fd = openFile(_fileName);
+        if (fd<0) return false;
+
+        RecordReader in(fd);
+        ShapeHeader head;
+        bool ok = head.read(in);
+        close(fd);
+        if (!ok) return false;
+
+        if (head.bbox.Zmin<=head.bbox.Zmax)
+        {
+            _zMin = head.bbox.Zmin;
+            _zMax = head.bbox.Zmax;
+        }
+    }
+
+    // The .shx file gives where every record starts, so that threads can read the extents of their own range of
+    // records, without it the records are found one after the other.
+    RecordList records;
+    std::vector<Box> boxes;
+    std::string shxFileName = getSiblingFileName(_fileName, "shx");
+    if (!shxFileName.empty() && readShx(shxFileName, records))
+    {
+        unsigned int numThreads = settings.numThreads!=0 ? settings.numThreads : static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+        boxes.resize(records.size());
+        if (!scanRecords(_fileName, records, boxes, numThreads))
+        {
+            OSG_WARN << "shp quadtree: " << shxFileName << " doesn't match " << _fileName << ", ignoring it" << std::endl;
+            records.clear();
+            boxes.clear();
+            if (!scanFile(_fileName, records, boxes)) return false;
+        }
+    }
+    else if (!scanFile(_fileName, records, boxes))
+    {
+        return false;
+    }
+
+    // Null shapes are left out of the tiles.
+    std::vector<unsigned int> shapes;
+    shapes.reserve(records.size());
+    double xMin = DBL_MAX, yMin = DBL_MAX, xMax = -DBL_MAX, yMax = -DBL_MAX;
+    for(unsigned int i=0; i<records.size(); ++i)
+    {
+        const Box& box = boxes[i];
+        if (!(box.Xmin<=box.Xmax && box.Ymin<=box.Ymax)) continue;
+
+        shapes.push_back(i);
+        xMin = osg::minimum(xMin, box.Xmin);
+        yMin = osg::minimum(yMin, box.Ymin);
+        xMax = osg::maximum(xMax, box.Xmax);
+        yMax = osg::maximum(yMax, box.Ymax);
+    }
+
+    if (shapes.empty())
+    {
+        xMin = yMin = 0.0;
+        xMax = yMax = 0.0;
+    }
+
+    // Square tiles, the root one enclosing all the shapes.
+    double halfSize = osg::maximum(xMax-xMin, yMax-yMin)*0.5;
+    halfSize = halfSize>0.0 ? halfSize*(1.0+1e-6) : 1.0;
+    double xCenter = (xMin+xMax)*0.5, yCenter = (yMin+yMax)*0.5;
+
+    Node root;
+    root.xMin = xCenter-halfSize;
+    root.yMin = yCenter-halfSize;
+    root.xMax = xCenter+halfSize;
+    root.yMax = yCenter+halfSize;
+
+    // Breadth first, so that the children of a tile are next to each other, the shapes that fit within
+    // one of the quadrants of a tile holding more than tileShapes shapes being moved down to it.
+    NodeList nodes(1, root);
+    std::vector< std::vector<unsigned int> > nodeShapes(1);
+    nodeShapes[0].swap(shapes);
+    std::vector<unsigned int> levels(1, 0);
+
+    for(unsigned int n=0; n<nodes.size(); ++n)
+    {
+        if (nodeShapes[n].size()<=settings.tileShapes || levels[n]>=MAXIMUM_LEVEL) continue;
+
+        double xMid = (nodes[n].xMin+nodes[n].xMax)*0.5;
+        double yMid = (nodes[n].yMin+nodes[n].yMax)*0.5;
+
+        std::vector<unsigned int> quadrants[4];
+        std::vector<unsigned int> straddling;
+        for(std::vector<unsigned int>::const_iterator itr=nodeShapes[n].begin(); itr!=nodeShapes[n].end(); ++itr)
+        {
+            const Box& box = boxes[*itr];
+            int x = box.Xmax<=xMid ? 0 : (box.Xmin>=xMid ? 1 : -1);
+            int y = box.Ymax<=yMid ? 0 : (box.Ymin>=yMid ? 1 : -1);
+            if (x<0 || y<0) straddling.push_back(*itr);
+            else quadrants[y*2+x].push_back(*itr);
+        }
+
+        if (straddling.size()==nodeShapes[n].size()) continue;
+
+        nodeShapes[n].swap(straddling);
+        nodes[n].firstChild = static_cast<unsigned int>(nodes.size());
+        for(unsigned int q=0; q<4; ++q)
+        {
+            if (quadrants[q].empty()) continue;
+
+            Node child;
+            child.xMin = (q&1) ? xMid : nodes[n].xMin;
+            child.xMax = (q&1) ? nodes[n].xMax : xMid;
+            child.yMin = (q&2) ? yMid : nodes[n].yMin;
+            child.yMax = (q&2) ? nodes[n].yMax : yMid;
+            nodes.push_back(child);
+            nodeShapes.push_back(std::vector<unsigned int>());
+            nodeShapes.back().swap(quadrants[q]);
+            levels.push_back(levels[n]+1);
+            ++nodes[n].numChildren;
+        }
+    }
+
+    // The records of a tile are sorted by offset, so that they are read from the .shp and .dbf files in order.
+    _records.clear();
+    _records.reserve(records.size());
+    for(unsigned int n=0; n<nodes.size(); ++n)
+    {
+        nodes[n].firstRecord = static_cast<unsigned int>(_records.size());
+        for(std::vector<unsigned int>::const_iterator itr=nodeShapes[n].begin(); itr!=nodeShapes[n].end(); ++itr)
+        {
+            _records.push_back(records[*itr]);
+        }
+        nodes[n].numRecords = static_cast<unsigned int>(_records.size()) - nodes[n].firstRecord;
+        std::sort(_records.begin()+nodes[n].firstRecord, _records.end(), LessOffset());
+        std::vector<unsigned int>().swap(nodeShapes[n]);
+    }
+
+    _nodes.swap(nodes);
+
+    OSG_NOTICE << "shp quadtree: built " << _nodes.size() << " tiles of " << _records.size() << " shapes in "
+               << osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick()) << "s" << std::endl;
+
+    return true;
+}
+
+std::string Quadtree::getChildrenFileName(unsigned int index) const
+{
+    std::ostringstream str;
+    str << _fileName << "." << index << ".shptile";
+    return str.str();
+}
+
+bool Quadtree::parseChildrenFileName(const std::string& childrenFileName, std::string& fileName, unsigned int& index)
+{
+    std::string tileFileName = osgDB::getNameLessExtension(childrenFileName);
+    std::istringstream str(osgDB::getFileExtension(tileFileName));
+    if (!(str >> index)) return false;
+
+    fileName = osgDB::getNameLessExtension(tileFileName);
+    return !fileName.empty();
+}
+
+osg::Node* Quadtree::createNode(unsigned int index, osgDB::Options* databaseOptions, const QuadtreeSettings& settings) const
+{
+    const Node& node = _nodes[index];
+
+    RecordLocationList locations;
+    std::vector<unsigned int> recordIndices;
+    locations.reserve(node.numRecords);
+    recordIndices.reserve(node.numRecords);
+    for(unsigned int i=node.firstRecord; i<node.firstRecord+node.numRecords; ++i)
+    {
+        locations.push_back(RecordLocation(_records[i].offset, _records[i].length));
+        recordIndices.push_back(_records[i].index);
+    }
+
+    osg::ref_ptr<osg::Geode> geode;
+    if (!locations.empty())
+    {
+        ESRIShapeParser sp(_fileName, locations, settings.useDouble, settings.keepSeparatePoints, settings.numThreads);
+        geode = sp.getGeode();
+
+        // Only the attributes of the shapes of the tile are read.
+        std::string dbfFileName = getSiblingFileName(_fileName, "dbf");
+        if (geode.valid() && !dbfFileName.empty())
+        {
+            XBaseParser xbp(dbfFileName, recordIndices);
+            const XBaseParser::ShapeAttributeListList& attributes = xbp.getAttributeList();
+            if (!attributes.empty() && geode->getNumDrawables()==attributes.size())
+            {
+                for(unsigned int i=0; i<attributes.size(); ++i)
+                {
+                    geode->getDrawable(i)->setUserData(attributes[i].get());
+                }
+            }
+        }
+    }
+    if (!geode) geode = new osg::Geode;
+
+    if (node.numChildren==0)
+        return geode.release();
+
+    osg::Vec3d center((node.xMin+node.xMax)*0.5, (node.yMin+node.yMax)*0.5, (_zMin+_zMax)*0.5);
+    float radius = static_cast<float>(osg::Vec3d(node.xMax-node.xMin, node.yMax-node.yMin, _zMax-_zMin).length()*0.5);
+
+    // The shapes of a tile stay drawn once its children are loaded, they only add to them.
+    osg::PagedLOD* plod = new osg::PagedLOD;
+    plod->setCenterMode(osg::LOD::USER_DEFINED_CENTER);
+    plod->setCenter(center);
+    plod->setRadius(radius);
+    plod->addChild(geode.get(), 0.0f, FLT_MAX);
+    plod->setFileName(1, getChildrenFileName(index));
+    plod->setRange(1, 0.0f, radius*settings.lodScale);
+    plod->setDatabaseOptions(databaseOptions);
+
+    return plod;
+}
+
+osg::Node* Quadtree::createScene(const osgDB::Options* options, const QuadtreeSettings& settings) const
+{
+    osg::ref_ptr<osgDB::Options> databaseOptions = options ? options->cloneOptions() : NULL;
+
+    return createNode(0, databaseOptions.get(), settings);
+}
+
+osg::Node* Quadtree::createChildren(unsigned int index, const osgDB::Options* options, const QuadtreeSettings& settings) const
+{
+    if (index>=_nodes.size() || _nodes[index].numChildren==0)
+        return NULL;
+
+    osg::ref_ptr<osgDB::Options> databaseOptions = options ? options->cloneOptions() : NULL;
+
+    osg::Group* group = new osg::Group;
+    for(unsigned int i=0; i<_nodes[index].numChildren; ++i)
+    {
+        group->addChild(createNode(_nodes[index].firstChild + i, databaseOptions.get(), settings));
+    }
+    return group;
+}
@@ -0,0 +1,118 @@
+#ifndef ESRI_SHAPE_QUADTREE_H
+#define ESRI_SHAPE_QUADTREE_H
+
+#include <string>
+#include <vector>
+
+#include <osg/Node>
+#include <osg/Referenced>
+#include <osgDB/Options>
+
+#include "ESRIShapeParser.h"
+
+namespace ESRIShape {
+
+// Settings of the reading of shapefiles, from the plugin options.
+struct QuadtreeSettings
+{
+    QuadtreeSettings(const osgDB::Options* options);
+
+    bool useDouble;
+    bool keepSeparatePoints;
+
+    // Number of threads decoding the records, 0 uses as many as there are processors.
+    unsigned int numThreads;
+
+    // Shapefiles with more records than this are loaded as a paged quadtree, 0 always does.
+    unsigned int threshold;
+
+    // Maximum number of shapes of a tile, only exceeded by tiles holding many shapes that
+    // straddle the borders of their children.
+    unsigned int tileShapes;
+
+    // The children of a tile are paged in once the eye is closer than lodScale times its radius.
+    float lodScale;
+};
+
+// Spatial index of the records of a shapefile, stored next to it in a .quadtree file.
+//
+// Every shape is given to the smallest tile that fully contains its bounding box, so that large
+// shapes sit near the root and are drawn from afar while the many small ones are paged in with
+// the leaves. The records of the tiles are found in the .shp file through their offsets, taken
+// from the .shx index when there is one, and their attributes are read from the .dbf file with
+// the tile rather than for the whole file up front.
+class Quadtree : public osg::Referenced
+{
+    public:
+
+        struct Node
+        {
+            Node() : xMin(0.0), yMin(0.0), xMax(0.0), yMax(0.0), firstChild(0), numChildren(0), firstRecord(0), numRecords(0) {}
+
+            double          xMin, yMin, xMax, yMax;
+            unsigned int    firstChild;
+            unsigned int    numChildren;
+            unsigned int    firstRecord;
+            unsigned int    numRecords;
+        };
+
+        struct Record
+        {
+            Record() : index(0), offset(0), length(0) {}
+
+            unsigned int    index;      // record number in the .shp and .dbf files, from 0
+            long long       offset;
+            unsigned int    length;     // record header included
+        };
+
+        typedef std::vector<Node> NodeList;
+        typedef std::vector<Record> RecordList;
+
+        // Returns the number of records of a shapefile, from its .shx index if there is one.
+        static unsigned int getNumRecords(const std::string& fileName);
+
+        // Returns the index of a shapefile, read from its .quadtree file or built if that is
+        // missing or older than the shapefile. Returns NULL if the shapefile can't be read.
+        static osg::ref_ptr<Quadtree> open(const std::string& fileName, const QuadtreeSettings& settings);
+
+        // Returns the root tile, with the children of the tiles paged in by PagedLODs.
+        osg::Node* createScene(const osgDB::Options* options, const QuadtreeSettings& settings) const;
+
+        // Returns a Group of the children of a tile, loaded by the PagedLOD of the tile.
+        osg::Node* createChildren(unsigned int index, const osgDB::Options* options, const QuadtreeSettings& settings) const;
+
+        // File name of the PagedLOD children of a tile, "<shapefile>.<tile index>.shptile".
+        std::string getChildrenFileName(unsigned int index) const;
+
+        // Splits a file name returned by getChildrenFileName().
+        static bool parseChildrenFileName(const std::string& childrenFileName, std::string& fileName, unsigned int& index);
+
+        const std::string& getFileName() const { return _fileName; }
+
+        const NodeList& getNodes() const { return _nodes; }
+
+    protected:
+
+        Quadtree(const std::string& fileName);
+
+        virtual ~Quadtree() {}
+
+        bool read(unsigned int tileShapes);
+
+        bool build(const QuadtreeSettings& settings);
+
+        bool write(unsigned int tileShapes) const;
+
+        osg::Node* createNode(unsigned int index, osgDB::Options* databaseOptions, const QuadtreeSettings& settings) const;
+
+        std::string     _fileName;
+        std::string     _indexFileName;
+
+        double          _zMin, _zMax;
+        NodeList        _nodes;
+        RecordList      _records;
+};
+
+}
+
+#endif
@@ -1,6 +1,9 @@
+#include <map>
+
 #include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
 #include <osgDB/fstream>
+#include <osgDB/PagedIndexCache>
 #include <osgDB/Registry>
 
 #include <osgTerrain/Locator>
@@ -9,6 +12,7 @@
 
 #include "ESRIShape.h"
 #include "ESRIShapeParser.h"
+#include "ESRIShapeQuadtree.h"
 
 #include "XBaseParser.h"
 
@@ -19,15 +23,20 @@ class ESRIShapeReaderWriter : public osgDB::ReaderWriter
         ESRIShapeReaderWriter()
         {
             supportsExtension("shp","Geospatial Shape file format");
+            supportsExtension("shptile","children of a tile of a paged shapefile");
             supportsOption("double","Read x,y,z data as double an stored as geometry in osg::Vec3dArray's.");
             supportsOption("keepSeparatePoints", "Avoid combining point features into multi-point.");
+            supportsOption("parseThreads=<n>", "number of threads decoding the shapes, 0 uses all the processors (default)");
+            supportsOption("pagingThreshold=<n>", "load shapefiles of more than n records as a paged quadtree of tiles, 0 always does (default 100000)");
+            supportsOption("pagingTileShapes=<n>", "maximum number of shapes of a quadtree tile (default 4096)");
+            supportsOption("pagingLODScale=<f>", "the children of a quadtree tile are loaded within f times its radius (default 4)");
         }
 
         virtual const char* className() const { return "ESRI Shape ReaderWriter"; }
 
         virtual bool acceptsExtension(const std::string& extension) const
         {
-            return osgDB::equalCaseInsensitive(extension,"shp");
+            return osgDB::equalCaseInsensitive(extension,"shp") || osgDB::equalCaseInsensitive(extension,"shptile");
         }
 
         virtual ReadResult readObject(const std::string& fileName, const Options* opt) const
@@ -39,50 +48,38 @@ class ESRIShapeReaderWriter : public osgDB::ReaderWriter
             if (!acceptsExtension(ext))
                 return ReadResult::FILE_NOT_HANDLED;
 
-            std::string fileName = osgDB::findDataFile(file, options);
-            if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
-
-            bool useDouble = false;
-            if (options && options->getOptionString().find("double")!=std::string::npos)
-            {
-                useDouble = true;
-            }
+            ESRIShape::QuadtreeSettings settings(options);
 
-            bool keepSeparatePoints = false;
-            if (options && options->getOptionString().find("keepSeparatePoints") != std::string::npos)
+            if (osgDB::equalCaseInsensitive(ext,"shptile"))
             {
-              keepSeparatePoints = true;
-            }
-
+                std::string shpFileName;
+                unsigned int index = 0;
+                if (!ESRIShape::Quadtree::parseChildrenFileName(file, shpFileName, index)) return ReadResult::FILE_NOT_HANDLED;
 
-            ESRIShape::ESRIShapeParser sp(fileName, useDouble, keepSeparatePoints);
+                osg::ref_ptr<ESRIShape::Quadtree> quadtree = _quadtrees.get(shpFileName, settings, false);
+                if (!quadtree) return ReadResult::ERROR_IN_READING_FILE;
 
+                osg::Node* node = quadtree->createChildren(index, options, settings);
+                if (!node) return ReadResult::ERROR_IN_READING_FILE;
+                return node;
+            }
 
-            std::string xbaseFileName(osgDB::getNameLessExtension(fileName) + ".dbf");
-            ESRIShape::XBaseParser xbp(xbaseFileName);
-
+            std::string fileName = osgDB::findDataFile(file, options);
+            if (fileName.empty()) return ReadResult::FILE_NOT_FOUND;
 
-            if (sp.getGeode() && (xbp.getAttributeList().empty() == false))
+            // Shapefiles with more records than the threshold are drawn from a quadtree of tiles.
+            osg::ref_ptr<osg::Node> node;
+            if (ESRIShape::Quadtree::getNumRecords(fileName) > settings.threshold)
             {
-                if (sp.getGeode()->getNumDrawables() != xbp.getAttributeList().size())
-                {
-                    OSG_WARN << "ESRIShape loader : .dbf file containe different record number that .shp file." << std::endl
-                                           << "                   .dbf record skipped." << std::endl;
-                }
-                else
-                {
-                    osg::Geode * geode = sp.getGeode();
-                    unsigned int i = 0;
+                osg::ref_ptr<ESRIShape::Quadtree> quadtree = _quadtrees.get(fileName, settings, true);
+                if (quadtree.valid()) node = quadtree->createScene(options, settings);
 
-                    ESRIShape::XBaseParser::ShapeAttributeListList::const_iterator it, end = xbp.getAttributeList().end();
-                    for (it = xbp.getAttributeList().begin(); it != end; ++it, ++i)
-                    {
-                        geode->getDrawable(i)->setUserData(it->get());
-                    }
-                }
+                if (!node) OSG_WARN << "ESRIShape loader : could not build the quadtree of " << fileName << ", reading all its shapes" << std::endl;
             }
 
-            if (sp.getGeode())
+            if (!node) node = readShapes(fileName, settings);
+
+            if (node.valid())
             {
 
                 std::string projFileName(osgDB::getNameLessExtension(fileName) + ".prj");
@@ -108,7 +105,7 @@ class ESRIShapeReaderWriter : public osgDB::ReaderWriter
                         if (!projstring.empty())
                         {
                             osgTerrain::Locator* locator = new osgTerrain::Locator;
-                            sp.getGeode()->setUserData(locator);
+                            node->setUserData(locator);
 
                             if (projstring.compare(0,6,"GEOCCS")==0)
                             {
@@ -133,8 +130,46 @@ class ESRIShapeReaderWriter : public osgDB::ReaderWriter
 
 
             }
+            return node.get();
+        }
+
+    protected:
+
+        osg::ref_ptr<osg::Geode> readShapes(const std::string& fileName, const ESRIShape::QuadtreeSettings& settings) const
+        {
+            ESRIShape::ESRIShapeParser sp(fileName, settings.useDouble, settings.keepSeparatePoints, settings.numThreads);
+
+
+            std::string xbaseFileName(osgDB::getNameLessExtension(fileName) + ".dbf");
+            ESRIShape::XBaseParser xbp(xbaseFileName);
+
+
+            if (sp.getGeode() && (xbp.getAttributeList().empty() == false))
+            {
+                if (sp.getGeode()->getNumDrawables() != xbp.getAttributeList().size())
+                {
+                    OSG_WARN << "ESRIShape loader : .dbf file containe different record number that .shp file." << std::endl
+                                           << "                   .dbf record skipped." << std::endl;
+                }
+                else
+                {
+                    osg::Geode * geode = sp.getGeode();
+                    unsigned int i = 0;
+
+                    ESRIShape::XBaseParser::ShapeAttributeListList::const_iterator it, end = xbp.getAttributeList().end();
+                    for (it = xbp.getAttributeList().begin(); it != end; ++it, ++i)
+                    {
+                        geode->getDrawable(i)->setUserData(it->get());
+                    }
+                }
+            }
+
             return sp.getGeode();
         }
+
+        // Quadtrees of the paged shapefiles, each built by the first thread that needs it while the tiles
+        // of the other shapefiles carry on loading.
+        mutable osgDB::PagedIndexCache<ESRIShape::Quadtree, ESRIShape::QuadtreeSettings> _quadtrees;
 };
 
 REGISTER_OSGPLUGIN(shp, ESRIShapeReaderWriter)
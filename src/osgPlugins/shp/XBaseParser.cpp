@@ -97,13 +97,35 @@ XBaseParser::XBaseParser(const std::string& fileName):
         }
         else
         {
-            _valid = parse(fd);
+            _valid = parse(fd, 0);
             close(fd);
         }
     }
 }
 
-bool XBaseParser::parse(int fd)
+XBaseParser::XBaseParser(const std::string& fileName, const std::vector<unsigned int>& records):
+    _valid(false)
+{
+    if (!fileName.empty())
+    {
+        int fd = 0;
+#ifdef WIN32
+        if( (fd = open( fileName.c_str(), O_RDONLY | O_BINARY )) < 0 )
+#else
+        if( (fd = ::open( fileName.c_str(), O_RDONLY )) < 0 )
+#endif
+        {
+            perror( fileName.c_str() );
+        }
+        else
+        {
+            _valid = parse(fd, &records);
+            close(fd);
+        }
+    }
+}
+
+bool XBaseParser::parse(int fd, const std::vector<unsigned int>* records)
 {
     int nbytes;
     XBaseHeader _xBaseHeader;
@@ -150,73 +172,43 @@ bool XBaseParser::parse(int fd)
     }
 
 
-    // ** reserve AttributeListList
-    _shapeAttributeListList.reserve(_xBaseHeader._numRecord);
-
-
     // ** read each record and store them in the ShapeAttributeListList
     char* record = new char[_xBaseHeader._recordLength];
 
-    std::vector<XBaseFieldDescriptor>::iterator it, end = _xBaseFieldDescriptorList.end();
-    for (Integer i = 0; i < _xBaseHeader._numRecord; ++i)
+    if (records == 0)
     {
-        if ((nbytes = ::read( fd, record, _xBaseHeader._recordLength)) <= 0) break;
+        // ** reserve AttributeListList
+        _shapeAttributeListList.reserve(_xBaseHeader._numRecord);
 
-        char * recordPtr = record;
-        osgSim::ShapeAttributeList * shapeAttributeList = new osgSim::ShapeAttributeList;
-        shapeAttributeList->reserve(_xBaseFieldDescriptorList.size());
+        for (Integer i = 0; i < _xBaseHeader._numRecord; ++i)
+        {
+            if ((nbytes = ::read( fd, record, _xBaseHeader._recordLength)) <= 0) break;
+
+            _shapeAttributeListList.push_back(createAttributeList(record, _xBaseFieldDescriptorList));
+        }
+    }
+    else
+    {
+        _shapeAttributeListList.reserve(records->size());
 
-        for (it = _xBaseFieldDescriptorList.begin(); it != end; ++it)
+        // ** records are fixed length, seek to the ones that don't follow the previous one
+        long long nextRecord = 0;
+        for (std::vector<unsigned int>::const_iterator itr = records->begin(); itr != records->end(); ++itr)
         {
-            switch (it->_fieldType)
-            {
-            case 'C':
-            {
-                char* str = new char[it->_fieldLength + 1];
-                memcpy(str, recordPtr, it->_fieldLength);
-                str[it->_fieldLength] = 0;
-                shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (char*) str));
-                delete [] str;
-                break;
-            }
-            case 'N':
-            {
-                char* number = new char[it->_fieldLength + 1];
-                memcpy(number, recordPtr, it->_fieldLength);
-                number[it->_fieldLength] = 0;
-                shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, atof(number)));
-                delete [] number;
-                break;
-            }
-            case 'I':
-            {
-                int number;
-                memcpy(&number, record, it->_fieldLength);
-                shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (int) number));
-                break;
-            }
-            case 'O':
-            {
-                double number;
-                memcpy(&number, record, it->_fieldLength);
-                shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (double) number));
-                break;
-            }
-            default:
+            if (*itr >= static_cast<unsigned int>(_xBaseHeader._numRecord)) break;
+
+            if (static_cast<long long>(*itr) != nextRecord &&
+                ::lseek( fd, _xBaseHeader._headerLength + 1 + static_cast<off_t>(*itr) * _xBaseHeader._recordLength, SEEK_SET)==-1)
             {
-                OSG_WARN << "ESRIShape::XBaseParser : record type "
-                                       << it->_fieldType << "not supported, skipped" << std::endl;
-                shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (double) 0));
+                OSG_WARN<<"File parsing failed, lseek return errno="<<errno<<std::endl;
                 break;
             }
 
+            if ((nbytes = ::read( fd, record, _xBaseHeader._recordLength)) <= 0) break;
 
-            }
-
-            recordPtr += it->_fieldLength;
+            _shapeAttributeListList.push_back(createAttributeList(record, _xBaseFieldDescriptorList));
+            nextRecord = static_cast<long long>(*itr) + 1;
         }
-
-        _shapeAttributeListList.push_back(shapeAttributeList);
     }
 
     delete [] record;
@@ -225,6 +217,68 @@ bool XBaseParser::parse(int fd)
 }
 
 
+osgSim::ShapeAttributeList* XBaseParser::createAttributeList(const char* record, const std::vector<XBaseFieldDescriptor>& fieldDescriptors)
+{
+    std::vector<XBaseFieldDescriptor>::const_iterator it, end = fieldDescriptors.end();
+
+    const char * recordPtr = record;
+    osgSim::ShapeAttributeList * shapeAttributeList = new osgSim::ShapeAttributeList;
+    shapeAttributeList->reserve(fieldDescriptors.size());
+
+    for (it = fieldDescriptors.begin(); it != end; ++it)
+    {
+        switch (it->_fieldType)
+        {
+        case 'C':
+        {
+            char* str = new char[it->_fieldLength + 1];
+            memcpy(str, recordPtr, it->_fieldLength);
+            str[it->_fieldLength] = 0;
+            shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (char*) str));
+            delete [] str;
+            break;
+        }
+        case 'N':
+        {
+            char* number = new char[it->_fieldLength + 1];
+            memcpy(number, recordPtr, it->_fieldLength);
+            number[it->_fieldLength] = 0;
+            shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, atof(number)));
+            delete [] number;
+            break;
+        }
+        case 'I':
+        {
+            int number;
+            memcpy(&number, record, it->_fieldLength);
+            shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (int) number));
+            break;
+        }
+        case 'O':
+        {
+            double number;
+            memcpy(&number, record, it->_fieldLength);
+            shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (double) number));
+            break;
+        }
+        default:
+        {
+            OSG_WARN << "ESRIShape::XBaseParser : record type "
+                                   << it->_fieldType << "not supported, skipped" << std::endl;
+            shapeAttributeList->push_back(osgSim::ShapeAttribute((const char *) it->_name, (double) 0));
+            break;
+        }
+
+
+        }
+
+        recordPtr += it->_fieldLength;
+    }
+
+    return shapeAttributeList;
+}
+
+
 }
 
 
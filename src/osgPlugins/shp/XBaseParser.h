@@ -63,6 +63,10 @@ class XBaseParser
         typedef std::vector< osg::ref_ptr<osgSim::ShapeAttributeList> > ShapeAttributeListList;
 
         XBaseParser(const std::string& fileName);
+
+        // Only reads the given records, the attribute lists being in the same order.
+        XBaseParser(const std::string& fileName, const std::vector<unsigned int>& records);
+
         ~XBaseParser() {}
 
         const ShapeAttributeListList & getAttributeList() const { return _shapeAttributeListList; }
@@ -71,7 +75,9 @@ class XBaseParser
 
         XBaseParser();
 
-        bool parse(int fd);
+        bool parse(int fd, const std::vector<unsigned int>* records);
+
+        static osgSim::ShapeAttributeList* createAttributeList(const char* record, const std::vector<XBaseFieldDescriptor>& fieldDescriptors);
 
         ShapeAttributeListList _shapeAttributeListList;
         bool _valid;
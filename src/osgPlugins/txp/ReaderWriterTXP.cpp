@@ -50,8 +50,13 @@ osgDB::ReaderWriter::ReadResult ReaderWriterTXP::local_readNode(const std::strin
         //calling getArchive will create a new TXPArchive if the specified one does not exist
         //we will set our osgdb loader options on the archive and set the appropriate archive on
         //the txpNode.
-        int id = ++_archiveId;
-        osg::ref_ptr< TXPArchive > archive = createArchive(id,osgDB::getFilePath(fileName));
+        osg::ref_ptr< TXPArchive > archive;
+        int id;
+        {
+            OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_serializerMutex);
+            id = ++_archiveId;
+            archive = createArchive(id,osgDB::getFilePath(fileName));
+        }
 
         if (archive != NULL)
         {
@@ -94,9 +99,8 @@ osgDB::ReaderWriter::ReadResult ReaderWriterTXP::local_readNode(const std::strin
             return ReadResult::ERROR_IN_READING_FILE;
         }
 
-        trpgEndian endian = archive->GetEndian();
-        archive->ReadSubArchive( 0, 0, endian);
-        archive->ReadSubArchive( y, x, endian);
+        archive->loadSubArchive( 0, 0 );
+        archive->loadSubArchive( y, x );
 
 //    std::cout << "Attempted " << x << " " << y << std::endl;
 
@@ -593,6 +597,8 @@ std::string ReaderWriterTXP::getArchiveName(const std::string& dir)
 
 osg::ref_ptr< TXPArchive > ReaderWriterTXP::getArchive(int id, const std::string& dir)
 {
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_serializerMutex);
+
     osg::ref_ptr< TXPArchive > archive = NULL;
 
     std::map< int,osg::ref_ptr<TXPArchive> >::iterator iter = _archives.find(id);
@@ -661,6 +667,8 @@ osg::ref_ptr< TXPArchive > ReaderWriterTXP::createArchive(int id, const std::str
 bool ReaderWriterTXP::removeArchive( int id )
 {
     OSG_INFO<<"ReaderWriterTXP::removeArchive(id="<<id<<")"<<std::endl;
+
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_serializerMutex);
     //return (_archives.erase(id) >= 1);
     bool result=_archives.erase(id) >= 1;
     OSG_WARN<<"remove archive " << id << " size " << _archives.size()
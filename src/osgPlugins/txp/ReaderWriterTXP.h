@@ -75,8 +75,7 @@ public:
         if( !acceptsExtension(osgDB::getFileExtension(file) ))
             return ReadResult::FILE_NOT_HANDLED;
 
-        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_serializerMutex);
-
+        // only the archive list is serialized, tiles of an archive are read and parsed concurrently
         return const_cast<ReaderWriterTXP*>(this)->local_readNode(file, options);
     }
 
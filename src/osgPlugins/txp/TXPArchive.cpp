@@ -43,24 +43,117 @@ using namespace txp;
 
 void TXPArchive::SetTexMap(int key,osg::ref_ptr<osg::Texture2D> ref)
 {
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
     _texmap[key] = ref;
 }
 
 osg::ref_ptr<osg::Texture2D> TXPArchive::GetTexMapEntry(int key)
 {
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
     return _texmap[key];
 }
 
 void TXPArchive::SetStatesMap(int key,osg::ref_ptr<osg::StateSet> ref)
 {
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
     _statesMap[key] = ref;
 }
 
 osg::ref_ptr<osg::StateSet> TXPArchive::GetStatesMapEntry(int key)
 {
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
     return _statesMap[key];
 }
 
+osg::ref_ptr<osgText::Font> TXPArchive::getStyle(int style)
+{
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+    std::map<int, osg::ref_ptr<osgText::Font> >::const_iterator itr = _fonts.find(style);
+    return itr != _fonts.end() ? itr->second : osg::ref_ptr<osgText::Font>();
+}
+
+osg::Vec4 TXPArchive::getTextColor(int style)
+{
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+    std::map<int, osg::Vec4 >::const_iterator itr = _fcolors.find(style);
+    return itr != _fcolors.end() ? itr->second : osg::Vec4(0.0f,0.0f,0.0f,0.0f);
+}
+
+TXPArchive::TileReader::TileReader():
+    _tileCache(0)
+{
+}
+
+TXPArchive::TileReader::~TileReader()
+{
+    delete _tileCache;
+}
+
+osg::ref_ptr<TXPArchive::TileReader> TXPArchive::acquireTileReader()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_tileReaderMutex);
+        if (!_tileReaders.empty())
+        {
+            osg::ref_ptr<TileReader> reader = _tileReaders.back();
+            _tileReaders.pop_back();
+            return reader;
+        }
+    }
+
+    osg::ref_ptr<TileReader> reader = new TileReader;
+    reader->_parser = new TXPParser();
+    reader->_parser->setArchive(this);
+
+    // local tiles are read through a file cache of our own rather than the one shared in trpgr_Archive
+    trpgTileTable::TileMode tileMode;
+    tileTable.GetMode(tileMode);
+    if (tileMode == trpgTileTable::Local)
+    {
+        char fullBase[1060];
+        sprintf(fullBase,"%s" PATHSEPERATOR "tileFile",dir);
+        reader->_tileCache = GetNewRAppFileCache(fullBase,"tpf");
+    }
+
+    return reader;
+}
+
+void TXPArchive::releaseTileReader(TileReader* reader)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_tileReaderMutex);
+    _tileReaders.push_back(reader);
+}
+
+bool TXPArchive::loadSubArchive(int row, int col)
+{
+    ScopedTableWriteLock lock(_tableMutex);
+
+    if (!_loadedSubArchives.insert(std::pair<int,int>(row, col)).second) return true;
+
+    return ReadSubArchive(row, col, GetEndian());
+}
+
+osg::ref_ptr<osg::StateSet> TXPArchive::getMaterial(int ix)
+{
+    ScopedTableReadLock tableLock(_tableMutex);
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
+    loadMaterial(ix);
+    return _statesMap[ix];
+}
+
+osg::ref_ptr<osg::Node> TXPArchive::getModel(int ix)
+{
+    ScopedTableReadLock tableLock(_tableMutex);
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
+    OSGModelsMapType::iterator itr = _models.find(ix);
+    if (itr != _models.end() && itr->second.valid()) return itr->second;
+
+    loadModel(ix);
+    return _models[ix];
+}
+
 TXPArchive::TXPArchive():
     trpgr_Archive(),
     _id(-1),
@@ -146,6 +239,9 @@ bool TXPArchive::openFile(const std::string& archiveName)
 
 bool TXPArchive::loadMaterial(int ix)
 {
+    ScopedTableReadLock tableLock(_tableMutex);
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
     int i = ix;
 
 
@@ -250,7 +346,7 @@ bool TXPArchive::loadMaterial(int ix)
             texEnv.GetWrap(wrap_s, wrap_t);
 
             loadTexture(texId);
-            osg::Texture2D* osg_texture = GetTexMapEntry(texId).get();
+            osg::ref_ptr<osg::Texture2D> osg_texture = GetTexMapEntry(texId);
             if(osg_texture)
             {
 
@@ -348,6 +444,9 @@ bool TXPArchive::loadMaterials()
 
 bool TXPArchive::loadTexture(int i)
 {
+    ScopedTableReadLock tableLock(_tableMutex);
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
     if (GetTexMapEntry(i).get())
     return true;
 
@@ -425,6 +524,9 @@ bool TXPArchive::loadTexture(int i)
 
 bool TXPArchive::loadModel(int ix)
 {
+    ScopedTableReadLock tableLock(_tableMutex);
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
     trpgModel *mod = modelTable.GetModelRef(ix);
     int type;
     if(!mod)
@@ -674,6 +776,8 @@ bool TXPArchive::loadTextStyles()
 
 void TXPArchive::addLightAttribute(osgSim::LightPointNode* lpn, osg::StateSet* fallback, const osg::Vec3& att,int light_handle)
 {
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
     DeferredLightAttribute la;
     la.lightPoint = lpn;
     la.fallback = fallback;
@@ -689,6 +793,7 @@ bool TXPArchive::getTileInfo(const TileLocationInfo& loc, TileInfo& info)
     info.center.set(0.f,0.f,0.f);
     info.bbox.set(0.f,0.f,0.f,0.f,0.f,0.f);
 
+    ScopedTableReadLock tableLock(_tableMutex);
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
 
     header.GetLodRange(loc.lod,info.maxRange);
@@ -730,6 +835,8 @@ bool TXPArchive::getTileInfo(const TileLocationInfo& loc, TileInfo& info)
 
 bool TXPArchive::getTileInfo(int x, int y, int lod, TileInfo& info)
 {
+    ScopedTableReadLock tableLock(_tableMutex);
+
     trpgwAppAddress addr;
     float minz = 0.f;
     float maxz = 0.f;
@@ -759,7 +866,10 @@ osg::Group* TXPArchive::getTileContent(
     trpgwAppAddress addr;
     float minz = 0.f;
     float maxz = 0.f;
-    tileTable.GetTile(x, y, lod, addr, minz, maxz);
+    {
+        ScopedTableReadLock tableLock(_tableMutex);
+        tileTable.GetTile(x, y, lod, addr, minz, maxz);
+    }
     TileLocationInfo loc(x,y,lod,addr, minz,maxz);
 
     return getTileContent(loc, realMinRange, realMaxRange, usedMaxRange, tileCenter, childInfoList);
@@ -826,11 +936,11 @@ osg::Group* TXPArchive::getTileContent(
     std::vector<TileLocationInfo>& childInfoList)
 {
 
-    if (_parser.get() == 0)
-    {
-        _parser = new TXPParser();
-        _parser->setArchive(this);
-    }
+    // the tables are only read while parsing, loadSubArchive() waits for the parsing threads to finish before adding to them
+    ScopedTableReadLock tableLock(_tableMutex);
+
+    osg::ref_ptr<TileReader> reader = acquireTileReader();
+    TXPParser* parser = reader->_parser.get();
 
     trpgMemReadBuffer buf(GetEndian());
     bool readStatus;
@@ -839,11 +949,17 @@ osg::Group* TXPArchive::getTileContent(
     if(tileMode == trpgTileTable::External)
     readStatus = ReadExternalTile(loc.x, loc.y, loc.lod, buf);
     else
-    readStatus = ReadTile(loc.addr, buf);
+    {
+    trpgrAppFile *tf = reader->_tileCache ? reader->_tileCache->GetFile(ness,loc.addr.file,loc.addr.col,loc.addr.row) : 0;
+    readStatus = tf && tf->Read(&buf,loc.addr.offset);
+    }
 
     if(!readStatus)
+    {
+    releaseTileReader(reader.get());
     return new osg::Group;
-    trpgTileHeader *tilehdr = _parser->getTileHeaderRef();
+    }
+    trpgTileHeader *tilehdr = parser->getTileHeaderRef();
 
     int majVersion,minVersion;
     GetVersion(majVersion,minVersion);
@@ -860,15 +976,15 @@ osg::Group* TXPArchive::getTileContent(
     }
     }
 
-    osg::Group *tileGroup = _parser->parseScene(buf,_statesMap,_models,realMinRange,realMaxRange,usedMaxRange);
-    tileCenter = _parser->getTileCenter();
+    osg::ref_ptr<osg::Group> tileGroup = parser->parseScene(buf,_statesMap,_models,realMinRange,realMaxRange,usedMaxRange);
+    tileCenter = parser->getTileCenter();
 
-    int nbChild = _parser->GetNbChildrenRef();
+    int nbChild = parser->GetNbChildrenRef();
 
     childInfoList.clear();
     for(int idx = 0; idx < nbChild; idx++)
     {
-    const trpgChildRef *childRef = _parser->GetChildRef(idx);
+    const trpgChildRef *childRef = parser->GetChildRef(idx);
 
     if(childRef)
     {
@@ -881,11 +997,18 @@ osg::Group* TXPArchive::getTileContent(
     }
     }
 
+    parser->releaseScene();
+    releaseTileReader(reader.get());
+
+    if (!tileGroup) return new osg::Group;
+
     // Fix up model MatrixTransform
     ModelVisitor mv(this, loc);
     tileGroup->accept(mv);
 
     // Prune
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
+
     OSGStatesMapType::iterator itr = _statesMap.begin();
     while( itr != _statesMap.end( ) )
     {
@@ -928,7 +1051,7 @@ osg::Group* TXPArchive::getTileContent(
         }
     }
 
-    return tileGroup;
+    return tileGroup.release();
 }
 
 bool TXPArchive::getLODSize(int lod, int& x, int& y)
@@ -49,6 +49,11 @@
 #include <osgText/Font>
 
 #include <OpenThreads/Mutex>
+#include <OpenThreads/ReentrantMutex>
+#include <OpenThreads/Condition>
+#include <OpenThreads/ScopedLock>
+
+#include <set>
 
 namespace txp
 {
@@ -61,6 +66,74 @@ namespace txp
         osg::Vec3 attitude;
     };
 
+    // Lock shared by the threads parsing tiles and taken exclusively to add to the trpg tables.
+    // OpenThreads::ReadWriteMutex can't be used as its lock is released by whichever reader leaves
+    // last, not by the thread that took it. Readers only wait for a writer holding the lock, not for
+    // writers waiting on it, so a thread may take the lock for reading again while it holds it.
+    class TableMutex
+    {
+    public:
+        TableMutex(): _numReaders(0), _writing(false) {}
+
+        void readLock()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            while (_writing) _condition.wait(&_mutex);
+            ++_numReaders;
+        }
+
+        void readUnlock()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            if (--_numReaders == 0) _condition.broadcast();
+        }
+
+        void writeLock()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            while (_writing || _numReaders > 0) _condition.wait(&_mutex);
+            _writing = true;
+        }
+
+        void writeUnlock()
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            _writing = false;
+            _condition.broadcast();
+        }
+
+    protected:
+        TableMutex(const TableMutex&) {}
+        TableMutex& operator = (const TableMutex&) { return *this; }
+
+        OpenThreads::Mutex      _mutex;
+        OpenThreads::Condition  _condition;
+        unsigned int            _numReaders;
+        bool                    _writing;
+    };
+
+    class ScopedTableReadLock
+    {
+    public:
+        ScopedTableReadLock(TableMutex& mutex): _mutex(mutex) { _mutex.readLock(); }
+        ~ScopedTableReadLock() { _mutex.readUnlock(); }
+
+    protected:
+        TableMutex& _mutex;
+        ScopedTableReadLock& operator = (const ScopedTableReadLock&) { return *this; }
+    };
+
+    class ScopedTableWriteLock
+    {
+    public:
+        ScopedTableWriteLock(TableMutex& mutex): _mutex(mutex) { _mutex.writeLock(); }
+        ~ScopedTableWriteLock() { _mutex.writeUnlock(); }
+
+    protected:
+        TableMutex& _mutex;
+        ScopedTableWriteLock& operator = (const ScopedTableWriteLock&) { return *this; }
+    };
+
     class TXPParser;
     class TXPArchive : public trpgr_Archive, public osg::Referenced
     {
@@ -79,6 +152,14 @@ namespace txp
         bool loadModels();
         bool loadModel(int ix);
 
+        // Thread safe access to the shared material and model tables, loading the entry on first use
+        osg::ref_ptr<osg::StateSet> getMaterial(int ix);
+        osg::ref_ptr<osg::Node> getModel(int ix);
+
+        // Read the tables of the block archive at row/col of a 2.2 archive, blocks already read are skipped.
+        // Takes the table lock for writing so it may be called while other threads are parsing tiles.
+        bool loadSubArchive(int row, int col);
+
         // Load the light attribs from the archive
         bool loadLightAttributes();
 
@@ -93,6 +174,10 @@ namespace txp
             return _fcolors;
         }
 
+        // Thread safe lookups of the font and color of a text style, without adding missing styles to the maps
+        osg::ref_ptr<osgText::Font> getStyle(int style);
+        osg::Vec4 getTextColor(int style);
+
         // Add light attrib
         void addLightAttribute(osgSim::LightPointNode* lpn, osg::StateSet* fallback , const osg::Vec3& attitude,int handle);
 
@@ -104,6 +189,7 @@ namespace txp
         // Get light attrib
         inline DeferredLightAttribute& getLightAttribute(unsigned int i)
         {
+            OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_cacheMutex);
             return _lights[i];
         };
 
@@ -163,10 +249,10 @@ namespace txp
             y=_swExtents.y;
         }
 
-        // Returns global texture
-        inline osg::Texture2D* getGlobalTexture(int id)
+        // Returns global texture, as a ref_ptr since the textures no tile uses are pruned by the other parsing threads
+        inline osg::ref_ptr<osg::Texture2D> getGlobalTexture(int id)
         {
-            return GetTexMapEntry(id).get();
+            return GetTexMapEntry(id);
         }
 
         // Returns scenegraph representing the Tile.
@@ -240,8 +326,33 @@ namespace txp
         trpg2dPoint _swExtents;
         trpg2dPoint _neExtents;
 
-        // Terra Page Parser
-        osg::ref_ptr<TXPParser>    _parser;
+        // Each thread reading tiles gets its own tile file handles and parser from a pool,
+        // so that several DatabasePager threads can read and parse tiles of the archive at once.
+        class TileReader : public osg::Referenced
+        {
+        public:
+            TileReader();
+
+            trpgrAppFileCache*          _tileCache;
+            osg::ref_ptr<TXPParser>     _parser;
+
+        protected:
+            virtual ~TileReader();
+        };
+
+        typedef std::vector< osg::ref_ptr<TileReader> > TileReaderList;
+
+        osg::ref_ptr<TileReader> acquireTileReader();
+        void releaseTileReader(TileReader* reader);
+
+        OpenThreads::Mutex  _tileReaderMutex;
+        TileReaderList      _tileReaders;
+
+        // Guards the trpg tables of the archive, tiles are parsed with it held for reading while
+        // loadSubArchive() takes it for writing as it adds to the tables.
+        TableMutex _tableMutex;
+
+        std::set< std::pair<int,int> > _loadedSubArchives;
 
         // Textures
         typedef std::map<int,osg::ref_ptr<osg::Texture2D> > OSGTexMapType;
@@ -274,6 +385,9 @@ namespace txp
         //
         OpenThreads::Mutex  _mutex;
 
+        // Guards the states, textures, models and lights shared by all the tiles
+        OpenThreads::ReentrantMutex _cacheMutex;
+
         // Cache those: TerraPage version
         int _majorVersion, _minorVersion;
 
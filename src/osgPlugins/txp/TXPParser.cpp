@@ -448,7 +448,7 @@ void TXPParser::loadLocalMaterials()
 
                 trpgTexture::ImageMode mode;
                 tex->GetImageMode(mode);
-                osg::Texture2D* osg_texture = 0L;
+                osg::ref_ptr<osg::Texture2D> osg_texture;
                 if(mode == trpgTexture::Template)
                     osg_texture = getTemplateTexture(image_helper,&locmat, tex, texNo);
                 else if(mode == trpgTexture::Local)
@@ -654,24 +654,16 @@ void *modelRefRead::Parse(trpgToken /*tok*/,trpgReadBuffer &buf)
         );
 
     // Note: Array check before you do this
-    osg::Node *osg_Model = NULL;
-    std::map<int,osg::ref_ptr<osg::Node> >*modelList = _parse->getModels();
-    //if( modelList->size() )
+    // the model table is shared by the threads parsing tiles, so go through the archive which loads it on first use
+    osg::ref_ptr<osg::Node> osg_Model = _parse->getArchive()->getModel(modelID);
     {
-       osg_Model = (*modelList)[modelID].get();
-
-       if (osg_Model==NULL)
-       {
-           _parse->requestModel(modelID);
-           osg_Model = (*modelList)[modelID].get();
-       }
 
         // Create the SCS and position the model
         if (osg_Model)
         {
             osg::MatrixTransform *scs = new osg::MatrixTransform();
             scs->setMatrix(osg_Mat);
-            scs->addChild(osg_Model);
+            scs->addChild(osg_Model.get());
 
             // Add the SCS to the hierarchy
             _parse->setCurrentNode(scs);
@@ -1042,10 +1034,10 @@ void* labelRead::Parse(trpgToken /*tok*/,trpgReadBuffer &buf)
         text->setCharacterSizeMode(osgText::Text::OBJECT_COORDS);
 
         // Font
-        text->setFont(_parse->getArchive()->getStyles()[labelProperty->GetFontStyle()].get());
+        text->setFont(_parse->getArchive()->getStyle(labelProperty->GetFontStyle()));
 
         // Color
-        text->setColor(_parse->getArchive()->getTextColors()[labelProperty->GetFontStyle()]);
+        text->setColor(_parse->getArchive()->getTextColor(labelProperty->GetFontStyle()));
 
         // Cube
         osg::ref_ptr<osg::ShapeDrawable> cube = 0;
@@ -1150,8 +1142,7 @@ void* labelRead::Parse(trpgToken /*tok*/,trpgReadBuffer &buf)
                 int matId = supStyle->GetMaterial();
 
                 osg::Vec4 supLineColor(1.f,1.f,1.f,1.f);
-                 _parse->loadMaterial(matId);
-                osg::ref_ptr<osg::StateSet>  sset = (*_parse->getMaterials())[matId];
+                osg::ref_ptr<osg::StateSet>  sset = _parse->getArchive()->getMaterial(matId);
 
                 if (cube.get())
                 {
@@ -1457,8 +1448,7 @@ void* geomRead::Parse(trpgToken /*tok*/,trpgReadBuffer &buf)
                 tmp_ss = (*_parse->getLocalMaterials())[matId];
             else
             {
-                _parse->loadMaterial(matId);
-                tmp_ss = (*_parse->getMaterials())[matId];
+                tmp_ss = _parse->getArchive()->getMaterial(matId);
             }
             if(sset.valid())
             {
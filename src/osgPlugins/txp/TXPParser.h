@@ -130,6 +130,13 @@ public:
         std::map<int,osg::ref_ptr<osg::Node> > &models,
         double realMinRange, double realMaxRange, double usedMaxRange);
 
+    // Drop the scene graph of the last parsed tile, so the parser may be reused by another thread
+    inline void releaseScene()
+    {
+        _root = 0;
+        _currentTop = 0;
+    }
+
     // Returns the current Top Group
     inline osg::Group* getCurrTop()
     {
@@ -21,6 +21,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <sstream>
 #include <cstdio>
 #include "unzip.h"
@@ -37,6 +38,132 @@
 #endif
 
 
+// Inflates an entry of the archive as the ReaderWriter reads it, rather than all of it into a
+// temporary buffer that is then copied into a std::stringstream. The entry is inflated into a
+// single buffer that is kept so that the readers seeking backwards, as the rgb one does for
+// each row, don't have to inflate it again. The handle is given back as soon as all of the
+// entry has been inflated, or when the ReaderWriter is done with it.
+class ZipEntryStreamBuffer : public std::streambuf
+{
+public:
+
+    ZipEntryStreamBuffer(const ZipArchive& archive, const ZIPENTRY& entry):
+        _archive(archive),
+        _entry(entry),
+        _handle(archive.AcquireZipHandle()),
+        _data(NULL),
+        _inflatedSize(0)
+    {
+        // go straight to the entry rather than stepping through the ones preceding it.
+        if (_handle && !_archive.CheckZipErrorCode(GoToZipItem(_handle, &_entry)))
+        {
+            releaseHandle();
+        }
+
+        if (_handle && _entry.unc_size > 0)
+        {
+            _data = new (std::nothrow) char[_entry.unc_size];
+            if (!_data) releaseHandle();
+        }
+
+        setg(_data, _data, _data);
+    }
+
+    virtual ~ZipEntryStreamBuffer()
+    {
+        releaseHandle();
+        delete [] _data;
+    }
+
+    bool valid() const { return _handle != NULL || _entry.unc_size == 0; }
+
+protected:
+
+    void releaseHandle()
+    {
+        if (_handle)
+        {
+            _archive.ReleaseZipHandle(_handle);
+            _handle = NULL;
+        }
+    }
+
+    // Inflate the entry up to at least size bytes, or the next chunk of it.
+    bool inflate(std::streamoff size)
+    {
+        if (!_handle) return false;
+
+        size = std::min<std::streamoff>(std::max<std::streamoff>(size, _inflatedSize + 65536), _entry.unc_size);
+        if (size <= _inflatedSize) return false;
+
+        unsigned int numInflate = static_cast<unsigned int>(size - _inflatedSize);
+        ZRESULT result = UnzipItem(_handle, _entry.index, _data + _inflatedSize, numInflate);
+        if (result != ZR_OK && result != ZR_MORE)
+        {
+            _archive.CheckZipErrorCode(result);
+            releaseHandle();
+            return false;
+        }
+
+        _inflatedSize = size;
+        setg(_data, gptr(), _data + _inflatedSize);
+
+        if (_inflatedSize == _entry.unc_size) releaseHandle();
+
+        return true;
+    }
+
+    virtual int_type underflow()
+    {
+        if (gptr() < egptr() || inflate(_inflatedSize + 1)) return traits_type::to_int_type(*gptr());
+        return traits_type::eof();
+    }
+
+    virtual pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode mode)
+    {
+        std::streamoff position = offset;
+        if (direction == std::ios_base::cur) position += gptr() - eback();
+        else if (direction == std::ios_base::end) position += _entry.unc_size;
+
+        return seekpos(pos_type(position), mode);
+    }
+
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode mode)
+    {
+        std::streamoff position = pos;
+        if (!(mode & std::ios_base::in) || position < 0 || position > _entry.unc_size) return pos_type(off_type(-1));
+
+        if (position > _inflatedSize && !inflate(position)) return pos_type(off_type(-1));
+
+        setg(_data, _data + position, egptr());
+        return pos;
+    }
+
+    const ZipArchive&   _archive;
+    ZIPENTRY            _entry;
+    HZIP                _handle;
+    char*               _data;
+    std::streamoff      _inflatedSize;
+};
+
+class ZipEntryStream : public std::istream
+{
+public:
+
+    ZipEntryStream(const ZipArchive& archive, const ZIPENTRY& entry):
+        std::istream(NULL),
+        _streamBuffer(archive, entry)
+    {
+        rdbuf(&_streamBuffer);
+        if (!_streamBuffer.valid()) setstate(std::ios_base::failbit);
+    }
+
+protected:
+
+    ZipEntryStreamBuffer _streamBuffer;
+};
+
+
 ZipArchive::ZipArchive()  :
 _zipLoaded( false )
 {
@@ -44,6 +171,7 @@ _zipLoaded( false )
 
 ZipArchive::~ZipArchive()
 {
+    close();
 }
 
 /** close the archive (on all threads) */
@@ -54,14 +182,18 @@ void ZipArchive::close()
         OpenThreads::ScopedLock<OpenThreads::Mutex> exclusive(_zipMutex);
         if ( _zipLoaded )
         {
-            // close the file (on one thread since it's a shared file)
-            const PerThreadData& data = getDataNoLock();
-            CloseZip( data._zipHandle );
-
-            // clear out the file handles
-            _perThreadData.clear();
+            // close the handles not in use, the others are closed as the reads using them complete.
+            for (ZipHandleList::iterator itr = _zipHandles.begin(); itr != _zipHandles.end(); ++itr)
+            {
+                CloseZip( *itr );
+            }
+            _zipHandles.clear();
 
             // clear out the index.
+            for (ZipEntryMap::iterator itr = _zipIndex.begin(); itr != _zipIndex.end(); ++itr)
+            {
+                delete itr->second;
+            }
             _zipIndex.clear();
 
             _zipLoaded = false;
@@ -129,13 +261,13 @@ bool ZipArchive::open(const std::string& file, ArchiveStatus /*status*/, const o
 
             _password = ReadPassword(options);
 
-            // open the zip file in this thread:
-            const PerThreadData& data = getDataNoLock();
+            HZIP handle = CreateZipHandle();
 
             // establish a shared (read-only) index:
-            if ( data._zipHandle != NULL )
+            if ( handle != NULL )
             {
-                IndexZipFiles( data._zipHandle );
+                IndexZipFiles( handle );
+                _zipHandles.push_back( handle );
                 _zipLoaded = true;
             }
         }
@@ -165,12 +297,12 @@ bool ZipArchive::open(std::istream& fin, const osgDB::ReaderWriter::Options* opt
 
             _password = ReadPassword(options);
 
-            // open on this thread:
-            const PerThreadData& data = getDataNoLock();
+            HZIP handle = CreateZipHandle();
 
-            if ( data._zipHandle != NULL )
+            if ( handle != NULL )
             {
-                IndexZipFiles( data._zipHandle );
+                IndexZipFiles( handle );
+                _zipHandles.push_back( handle );
                 _zipLoaded = true;
             }
         }
@@ -189,11 +321,11 @@ osgDB::ReaderWriter::ReadResult ZipArchive::readObject(const std::string& file,
     const ZIPENTRY* ze = GetZipEntry(file);
     if(ze != NULL)
     {
-        std::stringstream buffer;
-
-        osgDB::ReaderWriter* rw = ReadFromZipEntry(ze, options, buffer);
+        osgDB::ReaderWriter* rw = GetReaderWriterForZipEntry(ze);
         if (rw != NULL)
         {
+            ZipEntryStream buffer(*this, *ze);
+
             // Setup appropriate options
             osg::ref_ptr<osgDB::ReaderWriter::Options> local_opt = options ?
             static_cast<osgDB::ReaderWriter::Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) :
@@ -222,11 +354,11 @@ osgDB::ReaderWriter::ReadResult ZipArchive::readImage(const std::string& file,co
     const ZIPENTRY* ze = GetZipEntry(file);
     if(ze != NULL)
     {
-        std::stringstream buffer;
-
-        osgDB::ReaderWriter* rw = ReadFromZipEntry(ze, options, buffer);
+        osgDB::ReaderWriter* rw = GetReaderWriterForZipEntry(ze);
         if (rw != NULL)
         {
+            ZipEntryStream buffer(*this, *ze);
+
             // Setup appropriate options
             osg::ref_ptr<osgDB::ReaderWriter::Options> local_opt = options ?
             static_cast<osgDB::ReaderWriter::Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) :
@@ -255,11 +387,11 @@ osgDB::ReaderWriter::ReadResult ZipArchive::readHeightField(const std::string& f
     const ZIPENTRY* ze = GetZipEntry(file);
     if(ze != NULL)
     {
-        std::stringstream buffer;
-
-        osgDB::ReaderWriter* rw = ReadFromZipEntry(ze, options, buffer);
+        osgDB::ReaderWriter* rw = GetReaderWriterForZipEntry(ze);
         if (rw != NULL)
         {
+            ZipEntryStream buffer(*this, *ze);
+
             // Setup appropriate options
             osg::ref_ptr<osgDB::ReaderWriter::Options> local_opt = options ?
             options->cloneOptions() :
@@ -288,11 +420,11 @@ osgDB::ReaderWriter::ReadResult ZipArchive::readNode(const std::string& file,con
     const ZIPENTRY* ze = GetZipEntry(file);
     if(ze != NULL)
     {
-        std::stringstream buffer;
-
-        osgDB::ReaderWriter* rw = ReadFromZipEntry(ze, options, buffer);
+        osgDB::ReaderWriter* rw = GetReaderWriterForZipEntry(ze);
         if (rw != NULL)
         {
+            ZipEntryStream buffer(*this, *ze);
+
             // Setup appropriate options
             osg::ref_ptr<osgDB::ReaderWriter::Options> local_opt = options ?
                 options->cloneOptions() :
@@ -321,11 +453,11 @@ osgDB::ReaderWriter::ReadResult ZipArchive::readScript(const std::string& file,c
     const ZIPENTRY* ze = GetZipEntry(file);
     if (ze != NULL)
     {
-        std::stringstream buffer;
-
-        osgDB::ReaderWriter* rw = ReadFromZipEntry(ze, options, buffer);
+        osgDB::ReaderWriter* rw = GetReaderWriterForZipEntry(ze);
         if (rw != NULL)
         {
+            ZipEntryStream buffer(*this, *ze);
+
             // Setup appropriate options
             osg::ref_ptr<osgDB::ReaderWriter::Options> local_opt = options ?
                 options->cloneOptions() :
@@ -354,11 +486,11 @@ osgDB::ReaderWriter::ReadResult ZipArchive::readShader(const std::string& file,c
     const ZIPENTRY* ze = GetZipEntry(file);
     if(ze != NULL)
     {
-        std::stringstream buffer;
-
-        osgDB::ReaderWriter* rw = ReadFromZipEntry(ze, options, buffer);
+        osgDB::ReaderWriter* rw = GetReaderWriterForZipEntry(ze);
         if (rw != NULL)
         {
+            ZipEntryStream buffer(*this, *ze);
+
             // Setup appropriate options
             osg::ref_ptr<osgDB::ReaderWriter::Options> local_opt = options ?
                 options->cloneOptions() :
@@ -408,43 +540,13 @@ osgDB::ReaderWriter::WriteResult ZipArchive::writeShader(const osg::Shader& /*sh
 }
 
 
-osgDB::ReaderWriter* ZipArchive::ReadFromZipEntry(const ZIPENTRY* ze, const osgDB::ReaderWriter::Options* /*options*/, std::stringstream& buffer) const
+osgDB::ReaderWriter* ZipArchive::GetReaderWriterForZipEntry(const ZIPENTRY* ze) const
 {
     if (ze != 0)
     {
-        char* ibuf = new (std::nothrow) char[ze->unc_size];
-        if (ibuf)
-        {
-            // fetch the handle for the current thread:
-            const PerThreadData& data = getData();
-            if ( data._zipHandle != NULL )
-            {
-                ZRESULT result = UnzipItem(data._zipHandle, ze->index, ibuf, ze->unc_size);
-                bool unzipSuccesful = CheckZipErrorCode(result);
-                if(unzipSuccesful)
-                {
-                    buffer.write(ibuf,ze->unc_size);
-                }
-
-                delete[] ibuf;
+        std::string file_ext = osgDB::getFileExtension(ze->name);
 
-                std::string file_ext = osgDB::getFileExtension(ze->name);
-
-                osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension(file_ext);
-                if (rw != NULL)
-                {
-                    return rw;
-                }
-            }
-            else
-            {
-                delete[] ibuf;
-            }
-        }
-        else
-        {
-            //std::cout << "Error- failed to allocate enough memory to unzip file '" << ze->name << ", with size '" << ze->unc_size << std::endl;
-        }
+        return osgDB::Registry::instance()->getReaderWriterForExtension(file_ext);
     }
 
     return NULL;
@@ -660,45 +762,49 @@ bool ZipArchive::CheckZipErrorCode(ZRESULT result) const
     }
 }
 
-const ZipArchive::PerThreadData&
-ZipArchive::getData() const
+HZIP ZipArchive::CreateZipHandle() const
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> exclusive( const_cast<ZipArchive*>(this)->_zipMutex );
-    return getDataNoLock();
+    if ( !_filename.empty() )
+    {
+        return OpenZip( _filename.c_str(), _password.c_str() );
+    }
+    else if ( !_membuffer.empty() )
+    {
+        return OpenZip( (void*)_membuffer.c_str(), _membuffer.length(), _password.c_str() );
+    }
+    else
+    {
+        return NULL;
+    }
 }
 
-
-const ZipArchive::PerThreadData&
-ZipArchive::getDataNoLock() const
+HZIP ZipArchive::AcquireZipHandle() const
 {
-    // get/create data for the currently running thread:
-    OpenThreads::Thread* current = OpenThreads::Thread::CurrentThread();
-
-    PerThreadDataMap::const_iterator i = _perThreadData.find( current );
-
-    if ( i == _perThreadData.end() || i->second._zipHandle == NULL )
     {
-        // cache pattern: cast to const for caching purposes
-        ZipArchive* ncThis = const_cast<ZipArchive*>(this);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> exclusive( _zipMutex );
+        if ( !_zipLoaded ) return NULL;
 
-        // data does not already exist, so open the ZIP with a handle exclusively for this thread:
-        PerThreadData& data = ncThis->_perThreadData[current];
-        if ( !_filename.empty() )
-        {
-            data._zipHandle = OpenZip( _filename.c_str(), _password.c_str() );
-        }
-        else if ( !_membuffer.empty() )
+        if ( !_zipHandles.empty() )
         {
-            data._zipHandle = OpenZip( (void*)_membuffer.c_str(), _membuffer.length(), _password.c_str() );
+            HZIP handle = _zipHandles.back();
+            _zipHandles.pop_back();
+            return handle;
         }
-        else
-        {
-            data._zipHandle = NULL;
-        }
-        return data;
+    }
+
+    // only the end of the central directory is read, the index is shared.
+    return CreateZipHandle();
+}
+
+void ZipArchive::ReleaseZipHandle(HZIP handle) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> exclusive( _zipMutex );
+    if ( _zipLoaded )
+    {
+        _zipHandles.push_back( handle );
     }
     else
     {
-        return i->second;
+        CloseZip( handle );
     }
 }
@@ -7,8 +7,11 @@
 #include <osgDB/Archive>
 #include <OpenThreads/Mutex>
 
+#include <vector>
+
 #include "unzip.h"
 
+class ZipEntryStreamBuffer;
 
 class ZipArchive : public osgDB::Archive
 {
@@ -66,7 +69,9 @@ class ZipArchive : public osgDB::Archive
 
     protected:
 
-        osgDB::ReaderWriter* ReadFromZipEntry(const ZIPENTRY* ze, const osgDB::ReaderWriter::Options* options, std::stringstream& streamIn) const;
+        friend class ZipEntryStreamBuffer;
+
+        osgDB::ReaderWriter* GetReaderWriterForZipEntry(const ZIPENTRY* ze) const;
 
         void IndexZipFiles(HZIP hz);
         const ZIPENTRY* GetZipEntry(const std::string& filename) const;
@@ -83,20 +88,20 @@ class ZipArchive : public osgDB::Archive
 
         std::string _filename, _password, _membuffer;
 
-        OpenThreads::Mutex _zipMutex;
+        mutable OpenThreads::Mutex _zipMutex;
         bool               _zipLoaded;
         ZipEntryMap        _zipIndex;
         ZIPENTRY           _mainRecord;
 
-        struct PerThreadData {
-            HZIP _zipHandle;
-        };
-
-        typedef std::map<OpenThreads::Thread*, PerThreadData> PerThreadDataMap;
-        PerThreadDataMap _perThreadData;
+        // Each entry being read has a handle of its own, as reading an entry may
+        // read others from the archive before it is done, so handles that aren't
+        // in use are kept here to be reused by the next reads, on any thread.
+        typedef std::vector<HZIP> ZipHandleList;
+        mutable ZipHandleList _zipHandles;
 
-        const PerThreadData& getData() const;
-        const PerThreadData& getDataNoLock() const;
+        HZIP CreateZipHandle() const;
+        HZIP AcquireZipHandle() const;
+        void ReleaseZipHandle(HZIP handle) const;
 };
 
 
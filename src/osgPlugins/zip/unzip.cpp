@@ -3471,6 +3471,30 @@ int unzGoToNextFile (unzFile file)
 }
 
 
+//  Set the current file of the zipfile to the file recorded at pos_in_central_dir,
+//  being the num_file'th file of the zipfile.
+//  return UNZ_OK if there is no problem
+int unzGoToFilePos (unzFile file, uLong num_file, uLong pos_in_central_dir)
+{
+	unz_s* s;
+	int err;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (num_file>=s->gi.number_entry)
+		return UNZ_PARAMERROR;
+
+	s->pos_in_central_dir = pos_in_central_dir;
+	s->num_file = num_file;
+	err = unzlocal_GetCurrentFileInfoInternal(file,&s->cur_file_info,
+											   &s->cur_file_info_internal,
+											   NULL,0,NULL,0,NULL,0);
+	s->current_file_ok = (err == UNZ_OK);
+	return err;
+}
+
+
 //  Try locate the file szFileName in the zipfile.
 //  For the iCaseSensitivity signification, see unzStringFileNameCompare
 //  return value :
@@ -3982,6 +4006,7 @@ class TUnzip
   ZRESULT Open(void *z,unsigned int len,DWORD flags);
   ZRESULT Get(int index,ZIPENTRY *ze);
   ZRESULT Find(const TCHAR *name,bool ic,int *index,ZIPENTRY *ze);
+  ZRESULT GoTo(const ZIPENTRY *ze);
   ZRESULT Unzip(int index,void *dst,unsigned int len,DWORD flags);
   ZRESULT SetUnzipBaseDir(const TCHAR *dir);
   ZRESULT Close();
@@ -4064,6 +4089,7 @@ ZRESULT TUnzip::Get(int index,ZIPENTRY *ze)
   if (lufread(extra,1,(uInt)extralen,uf->file)!=extralen) {delete[] extra; return ZR_READ;}
   //
   ze->index=uf->num_file;
+  ze->pos_in_central_dir=uf->pos_in_central_dir;
   TCHAR tfn[MAX_PATH];
 #ifdef UNICODE
   MultiByteToWideChar(CP_UTF8,0,fn,-1,tfn,MAX_PATH);
@@ -4274,6 +4300,13 @@ void EnsureDirectory(const TCHAR *rootdir, const TCHAR *dir)
 
 
 
+ZRESULT TUnzip::GoTo(const ZIPENTRY *ze)
+{ if (ze->index<0 || ze->index>=(int)uf->gi.number_entry) return ZR_ARGS;
+  if (currentfile!=-1) unzCloseCurrentFile(uf); currentfile=-1;
+  if (unzGoToFilePos(uf,ze->index,ze->pos_in_central_dir)!=UNZ_OK) return ZR_CORRUPT;
+  return ZR_OK;
+}
+
 ZRESULT TUnzip::Unzip(int index,void *dst,unsigned int len,DWORD flags)
 { if (flags!=ZIP_MEMORY && flags!=ZIP_FILENAME && flags!=ZIP_HANDLE) return ZR_ARGS;
   if (flags==ZIP_MEMORY)
@@ -4507,6 +4540,15 @@ ZRESULT FindZipItem(HZIP hz, const TCHAR *name, bool ic, int *index, ZIPENTRY *z
   return lasterrorU;
 }
 
+ZRESULT GoToZipItem(HZIP hz, const ZIPENTRY *ze)
+{ if (hz==0 || ze==0) {lasterrorU=ZR_ARGS;return ZR_ARGS;}
+  TUnzipHandleData *han = (TUnzipHandleData*)hz;
+  if (han->flag!=1) {lasterrorU=ZR_ZMODE;return ZR_ZMODE;}
+  TUnzip *unz = han->unz;
+  lasterrorU = unz->GoTo(ze);
+  return lasterrorU;
+}
+
 ZRESULT UnzipItemInternal(HZIP hz, int index, void *dst, unsigned int len, DWORD flags)
 { if (hz==0) {lasterrorU=ZR_ARGS;return ZR_ARGS;}
   TUnzipHandleData *han = (TUnzipHandleData*)hz;
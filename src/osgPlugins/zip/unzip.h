@@ -84,7 +84,8 @@ struct ZIPENTRY
     ctime(0),
     mtime(0),
     comp_size(0),
-    unc_size(0) {}
+    unc_size(0),
+    pos_in_central_dir(0) {}
 
   int index;                 // index of this file within the zip
   TCHAR name[MAX_PATH];      // filename within the zip
@@ -92,6 +93,7 @@ struct ZIPENTRY
   FILETIME atime,ctime,mtime;// access, create, modify filetimes
   long comp_size;            // sizes of item, compressed and uncompressed. These
   long unc_size;             // may be -1 if not yet known (e.g. being streamed in)
+  unsigned long pos_in_central_dir; // where the item is recorded in the zip, used by GoToZipItem
 };
 
 HZIP OpenZip(const TCHAR *fn, const char *password);
@@ -128,6 +130,12 @@ ZRESULT GetZipItem(HZIP hz, int index, ZIPENTRY *ze);
 // then then comp_size and sometimes unc_size as well may not be known until
 // after the item has been unzipped.
 
+ZRESULT GoToZipItem(HZIP hz, const ZIPENTRY *ze);
+// GoToZipItem - moves straight to an item previously returned by GetZipItem
+// or FindZipItem, so that the following UnzipItem call on its index doesn't
+// have to step through the items preceding it. Any partial unzip is abandoned,
+// the next UnzipItem to memory starts from the beginning of the item.
+
 ZRESULT FindZipItem(HZIP hz, const TCHAR *name, bool ic, int *index, ZIPENTRY *ze);
 // FindZipItem - finds an item by name. ic means 'insensitive to case'.
 // It returns the index of the item, and returns information about it.
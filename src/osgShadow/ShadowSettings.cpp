@@ -32,7 +32,11 @@ ShadowSettings::ShadowSettings():
     _multipleShadowMapHint(PARALLEL_SPLIT),
     _shaderHint(NO_SHADERS),
 //    _shaderHint(PROVIDE_FRAGMENT_SHADER),
-    _debugDraw(false)
+    _debugDraw(false),
+    _numShadowCastingCullThreads(0),
+    _cacheShadowCastingRenderLists(false),
+    _splitStaticShadowCasters(false),
+    _staticShadowMapUpdateThreshold(0.02)
 {
     //_computeNearFearModeOverride = osg::CullSettings::COMPUTE_NEAR_FAR_USING_PRIMITIVES;
     //_computeNearFearModeOverride = osg::CullSettings::COMPUTE_NEAR_USING_PRIMITIVES);
@@ -54,7 +58,11 @@ ShadowSettings::ShadowSettings(const ShadowSettings& ss, const osg::CopyOp& copy
     _numShadowMapsPerLight(ss._numShadowMapsPerLight),
     _multipleShadowMapHint(ss._multipleShadowMapHint),
     _shaderHint(ss._shaderHint),
-    _debugDraw(ss._debugDraw)
+    _debugDraw(ss._debugDraw),
+    _numShadowCastingCullThreads(ss._numShadowCastingCullThreads),
+    _cacheShadowCastingRenderLists(ss._cacheShadowCastingRenderLists),
+    _splitStaticShadowCasters(ss._splitStaticShadowCasters),
+    _staticShadowMapUpdateThreshold(ss._staticShadowMapUpdateThreshold)
 {
 }
 
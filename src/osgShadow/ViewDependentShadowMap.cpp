@@ -14,10 +14,12 @@
 #include <osgShadow/ViewDependentShadowMap>
 #include <osgShadow/ShadowedScene>
 #include <osg/CullFace>
+#include <osg/Depth>
 #include <osg/Geode>
 #include <osg/io_utils>
 
 #include <sstream>
+#include <typeinfo>
 
 using namespace osgShadow;
 
@@ -70,6 +72,27 @@ static const char fragmentShaderSource_withBaseTexture_twoShadowMaps[] =
         "} \n";
 #endif
 
+//////////////////////////////////////////////////////////////////
+// shaders used to copy the cached static shadow caster depth map into a shadow map
+//
+static const char vertexShaderSource_staticDepthCopy[] =
+        "varying vec2 texCoord;                                                  \n"
+        "                                                                        \n"
+        "void main(void)                                                         \n"
+        "{                                                                       \n"
+        "  texCoord = gl_Vertex.xy*0.5+0.5;                                      \n"
+        "  gl_Position = vec4(gl_Vertex.xy, 0.0, 1.0);                           \n"
+        "} \n";
+
+static const char fragmentShaderSource_staticDepthCopy[] =
+        "uniform sampler2D staticDepthTexture;                                   \n"
+        "varying vec2 texCoord;                                                  \n"
+        "                                                                        \n"
+        "void main(void)                                                         \n"
+        "{                                                                       \n"
+        "  gl_FragDepth = texture2D( staticDepthTexture, texCoord ).r;           \n"
+        "} \n";
+
 template<class T>
 class RenderLeafTraverser : public T
 {
@@ -152,17 +175,28 @@ class VDSMCameraCullCallback : public osg::NodeCallback
         osg::RefMatrix* getProjectionMatrix() { return _projectionMatrix.get(); }
         osgUtil::RenderStage* getRenderStage() { return _renderStage.get(); }
 
+        /** Restrict the traversal to the specified shadow casters rather than all the children of the ShadowedScene.*/
+        void setCasters(const osg::NodeList& casters) { _useCasters = true; _casters = casters; }
+
+        /** Draw the depth copy geometry with the specified state before the shadow casters.*/
+        void setDepthCopy(osg::StateSet* stateset, osg::Drawable* drawable) { _depthCopyStateSet = stateset; _depthCopyDrawable = drawable; }
+
     protected:
 
         ViewDependentShadowMap*                 _vdsm;
         osg::ref_ptr<osg::RefMatrix>            _projectionMatrix;
         osg::ref_ptr<osgUtil::RenderStage>      _renderStage;
         osg::Polytope                           _polytope;
+        bool                                    _useCasters;
+        osg::NodeList                           _casters;
+        osg::ref_ptr<osg::StateSet>             _depthCopyStateSet;
+        osg::ref_ptr<osg::Drawable>             _depthCopyDrawable;
 };
 
 VDSMCameraCullCallback::VDSMCameraCullCallback(ViewDependentShadowMap* vdsm, osg::Polytope& polytope):
     _vdsm(vdsm),
-    _polytope(polytope)
+    _polytope(polytope),
+    _useCasters(false)
 {
 }
 
@@ -184,7 +218,23 @@ void VDSMCameraCullCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
         cv->pushCullingSet();
     }
 #endif
-    if (_vdsm->getShadowedScene())
+    if (_depthCopyDrawable.valid())
+    {
+        cv->pushStateSet(_depthCopyStateSet.get());
+        cv->addDrawableAndDepth(_depthCopyDrawable.get(), cv->getModelViewMatrix(), 0.0f);
+        cv->popStateSet();
+    }
+
+    if (_useCasters)
+    {
+        for(osg::NodeList::iterator itr = _casters.begin();
+            itr != _casters.end();
+            ++itr)
+        {
+            (*itr)->accept(*nv);
+        }
+    }
+    else if (_vdsm->getShadowedScene())
     {
         _vdsm->getShadowedScene()->osg::Group::traverse(*nv);
     }
@@ -248,6 +298,180 @@ void VDSMCameraCullCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ShadowCastingRenderStage
+//
+// RenderStage used for the shadow cameras culled by a ShadowData's own CullVisitor, when retained
+// the contents survive the reset of the view's RenderStage so they can be drawn again next frame.
+class ShadowCastingRenderStage : public osgUtil::RenderStage
+{
+    public:
+
+        ShadowCastingRenderStage():
+            _retainContents(false) {}
+
+        ShadowCastingRenderStage(const ShadowCastingRenderStage& rhs, const osg::CopyOp& copyop=osg::CopyOp::SHALLOW_COPY):
+            osgUtil::RenderStage(rhs, copyop),
+            _retainContents(false) {}
+
+        META_Object(osgShadow, ShadowCastingRenderStage);
+
+        void setRetainContents(bool flag) { _retainContents = flag; }
+        bool getRetainContents() const { return _retainContents; }
+
+        virtual void reset()
+        {
+            if (_retainContents)
+            {
+                _stageDrawnThisFrame = false;
+                return;
+            }
+
+            osgUtil::RenderStage::reset();
+        }
+
+    protected:
+
+        bool _retainContents;
+};
+
+static void collectRenderGraphObjects(const osgUtil::StateGraph* sg, ViewDependentShadowMap::ShadowData::CachedObjects& objects)
+{
+    if (sg->getStateSet()) objects.push_back(sg->getStateSet());
+
+    for(osgUtil::StateGraph::LeafList::const_iterator itr = sg->_leaves.begin();
+        itr != sg->_leaves.end();
+        ++itr)
+    {
+        if ((*itr)->getDrawable()) objects.push_back((*itr)->getDrawable());
+    }
+
+    for(osgUtil::StateGraph::ChildList::const_iterator itr = sg->_children.begin();
+        itr != sg->_children.end();
+        ++itr)
+    {
+        collectRenderGraphObjects(itr->second.get(), objects);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+//
+// ShadowCastingCullOperation
+//
+class ShadowCastingCullOperation : public osg::Operation
+{
+    public:
+
+        ShadowCastingCullOperation(const ViewDependentShadowMap* vdsm, osgUtil::CullVisitor* cv, ViewDependentShadowMap::ShadowData* sd, osg::RefBlockCount* blockCount):
+            osg::Operation("ShadowCastingCull", false),
+            _vdsm(vdsm),
+            _cv(cv),
+            _sd(sd),
+            _blockCount(blockCount) {}
+
+        virtual void operator () (osg::Object*)
+        {
+            _vdsm->cullShadowCastingSceneUsingShadowData(*_cv, *_sd);
+            _blockCount->completed();
+        }
+
+    protected:
+
+        const ViewDependentShadowMap*                       _vdsm;
+        osgUtil::CullVisitor*                               _cv;
+        osg::ref_ptr<ViewDependentShadowMap::ShadowData>    _sd;
+        osg::ref_ptr<osg::RefBlockCount>                    _blockCount;
+};
+
+// Split the shadow casters below node into those that can be cached in a static depth map and those that need rendering every frame.
+static void collectShadowCasters(osg::Node* node, unsigned int castsShadowTraversalMask, osg::NodeList& staticCasters, osg::NodeList& dynamicCasters)
+{
+    if ((node->getNodeMask() & castsShadowTraversalMask)==0) return;
+
+    if (node->getDataVariance()==osg::Object::DYNAMIC || node->getUpdateCallback())
+    {
+        dynamicCasters.push_back(node);
+        return;
+    }
+
+    // look through plain groups so that their children can be classified individually
+    osg::Group* group = node->asGroup();
+    if (group && typeid(*group)==typeid(osg::Group) && !group->getStateSet() && !group->getCullCallback())
+    {
+        for(unsigned int i=0; i<group->getNumChildren(); ++i)
+        {
+            collectShadowCasters(group->getChild(i), castsShadowTraversalMask, staticCasters, dynamicCasters);
+        }
+        return;
+    }
+
+    if (node->getNumChildrenRequiringUpdateTraversal()>0) dynamicCasters.push_back(node);
+    else staticCasters.push_back(node);
+}
+
+// Clamp the depth range of the shadow camera's projection to the bound of the shadowed scene so that the static and dynamic
+// passes share the same depth range, returns false if the projection matrix could not be adjusted.
+static bool clampProjectionDepthRangeToBound(osg::Matrixd& projection, const osg::Matrixd& view, const osg::BoundingSphere& bound, double minimumNearFarRatio)
+{
+    if (!bound.valid()) return false;
+
+    osg::Vec3d center = osg::Vec3d(bound.center()) * view;
+    double zNear = -center.z() - bound.radius();
+    double zFar = -center.z() + bound.radius();
+
+    double left, right, bottom, top, previousNear, previousFar;
+    if (projection.getOrtho(left, right, bottom, top, previousNear, previousFar))
+    {
+        projection.makeOrtho(left, right, bottom, top, zNear, zFar);
+        return true;
+    }
+
+    if (projection.getFrustum(left, right, bottom, top, previousNear, previousFar))
+    {
+        if (zFar<=0.0) return false;
+        zNear = osg::maximum(zNear, zFar*minimumNearFarRatio);
+
+        double ratio = zNear/previousNear;
+        projection.makeFrustum(left*ratio, right*ratio, bottom*ratio, top*ratio, zNear, zFar);
+        return true;
+    }
+
+    return false;
+}
+
+// Return true if the shadow camera given by viewProjection covers the same region as previousViewProjection
+// to within the threshold, expressed as a fraction of the shadow map.
+static bool shadowCameraWithinThreshold(const osg::Matrixd& previousViewProjection, const osg::Matrixd& viewProjection, double threshold)
+{
+    osg::Matrixd inverseViewProjection;
+    if (!inverseViewProjection.invert(viewProjection)) return false;
+
+    osg::Matrixd newToPrevious = inverseViewProjection * previousViewProjection;
+
+    double maximumDisplacement = threshold*2.0;
+    for(int i=0; i<8; ++i)
+    {
+        osg::Vec3d corner((i&1) ? 1.0 : -1.0, (i&2) ? 1.0 : -1.0, (i&4) ? 1.0 : -1.0);
+        osg::Vec3d displacement = corner*newToPrevious - corner;
+        if (fabs(displacement.x())>maximumDisplacement ||
+            fabs(displacement.y())>maximumDisplacement ||
+            fabs(displacement.z())>maximumDisplacement) return false;
+    }
+
+    return true;
+}
+
+// shadow map whose RTT camera is to be traversed once all the shadow maps of the view have been set up
+struct ShadowMapCull
+{
+    osg::ref_ptr<ViewDependentShadowMap::ShadowData>    sd;
+    osg::ref_ptr<VDSMCameraCullCallback>                cullCallback;
+    ViewDependentShadowMap::LightData*                  pl;
+    unsigned int                                        textureUnit;
+    bool                                                reuseRenderLists;
+};
+
 class ComputeLightSpaceBounds : public osg::NodeVisitor, public osg::CullStack
 {
 public:
@@ -421,7 +645,10 @@ void ViewDependentShadowMap::LightData::setLightData(osg::RefMatrix* lm, const o
 //
 ViewDependentShadowMap::ShadowData::ShadowData(ViewDependentShadowMap::ViewDependentData* vdd):
     _viewDependentData(vdd),
-    _textureUnit(0)
+    _textureUnit(0),
+    _cachedRevision(0),
+    _staticTextureValid(false),
+    _staticRevision(0)
 {
 
     const ShadowSettings* settings = vdd->getViewDependentShadowMap()->getShadowedScene()->getShadowSettings();
@@ -504,11 +731,68 @@ ViewDependentShadowMap::ShadowData::ShadowData(ViewDependentShadowMap::ViewDepen
     }
 }
 
+void ViewDependentShadowMap::ShadowData::createStaticShadowMap()
+{
+    osg::Vec2s textureSize(static_cast<short>(_texture->getTextureWidth()), static_cast<short>(_texture->getTextureHeight()));
+
+    // set up the texture, read back as depth values so no shadow comparison
+    _staticTexture = new osg::Texture2D;
+    _staticTexture->setTextureSize(textureSize.x(), textureSize.y());
+    _staticTexture->setInternalFormat(GL_DEPTH_COMPONENT);
+    _staticTexture->setFilter(osg::Texture2D::MIN_FILTER,osg::Texture2D::NEAREST);
+    _staticTexture->setFilter(osg::Texture2D::MAG_FILTER,osg::Texture2D::NEAREST);
+    _staticTexture->setWrap(osg::Texture2D::WRAP_S,osg::Texture2D::CLAMP_TO_EDGE);
+    _staticTexture->setWrap(osg::Texture2D::WRAP_T,osg::Texture2D::CLAMP_TO_EDGE);
+
+    // set up the camera to render the static casters before the shadow map camera
+    _staticCamera = new osg::Camera;
+    _staticCamera->setName("StaticShadowCamera");
+    _staticCamera->setReferenceFrame(osg::Camera::ABSOLUTE_RF_INHERIT_VIEWPOINT);
+    _staticCamera->setComputeNearFarMode(osg::Camera::DO_NOT_COMPUTE_NEAR_FAR);
+    _staticCamera->setCullingMode(_staticCamera->getCullingMode() & ~osg::CullSettings::SMALL_FEATURE_CULLING);
+    _staticCamera->setViewport(0,0,textureSize.x(),textureSize.y());
+    _staticCamera->setClearMask(GL_DEPTH_BUFFER_BIT);
+    _staticCamera->setRenderOrder(osg::Camera::PRE_RENDER, _camera->getRenderOrderNum()-1);
+    _staticCamera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+    _staticCamera->attach(osg::Camera::DEPTH_BUFFER, _staticTexture.get());
+
+    // full screen quad, in clip coords, that writes the static depth map into the shadow map
+    _staticDepthCopyGeometry = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    vertices->push_back(osg::Vec3(-1.0f,-1.0f,0.0f));
+    vertices->push_back(osg::Vec3(1.0f,-1.0f,0.0f));
+    vertices->push_back(osg::Vec3(1.0f,1.0f,0.0f));
+    vertices->push_back(osg::Vec3(-1.0f,1.0f,0.0f));
+    _staticDepthCopyGeometry->setVertexArray(vertices.get());
+    _staticDepthCopyGeometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    _staticDepthCopyGeometry->setCullingActive(false);
+
+    osg::ref_ptr<osg::Program> program = new osg::Program;
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, vertexShaderSource_staticDepthCopy));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragmentShaderSource_staticDepthCopy));
+
+    // protect the copy from the overrides applied to the shadow casting scene, and draw it before the casters.
+    _staticDepthCopyStateSet = new osg::StateSet;
+    _staticDepthCopyStateSet->setAttribute(program.get(), osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
+    _staticDepthCopyStateSet->setTextureAttributeAndModes(0, _staticTexture.get(), osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
+    _staticDepthCopyStateSet->addUniform(new osg::Uniform("staticDepthTexture", 0));
+    _staticDepthCopyStateSet->setAttributeAndModes(new osg::Depth(osg::Depth::ALWAYS), osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
+    _staticDepthCopyStateSet->setMode(GL_CULL_FACE, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+    _staticDepthCopyStateSet->setMode(GL_POLYGON_OFFSET_FILL, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+    _staticDepthCopyStateSet->setRenderBinDetails(-1, "RenderBin");
+
+    _staticTextureValid = false;
+}
+
 void ViewDependentShadowMap::ShadowData::releaseGLObjects(osg::State* state) const
 {
     OSG_INFO<<"ViewDependentShadowMap::ShadowData::releaseGLObjects"<<std::endl;
     _texture->releaseGLObjects(state);
     _camera->releaseGLObjects(state);
+    if (_staticTexture.valid()) _staticTexture->releaseGLObjects(state);
+    if (_staticCamera.valid()) _staticCamera->releaseGLObjects(state);
+    if (_staticDepthCopyStateSet.valid()) _staticDepthCopyStateSet->releaseGLObjects(state);
+    if (_staticDepthCopyGeometry.valid()) _staticDepthCopyGeometry->releaseGLObjects(state);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -666,19 +950,52 @@ void ViewDependentShadowMap::ViewDependentData::releaseGLObjects(osg::State* sta
 // ViewDependentShadowMap
 //
 ViewDependentShadowMap::ViewDependentShadowMap():
-    ShadowTechnique()
+    ShadowTechnique(),
+    _shadowCastingCacheRevision(0)
 {
     _shadowRecievingPlaceholderStateSet = new osg::StateSet;
 }
 
 ViewDependentShadowMap::ViewDependentShadowMap(const ViewDependentShadowMap& vdsm, const osg::CopyOp& copyop):
-    ShadowTechnique(vdsm,copyop)
+    ShadowTechnique(vdsm,copyop),
+    _shadowCastingCacheRevision(0)
 {
     _shadowRecievingPlaceholderStateSet = new osg::StateSet;
 }
 
 ViewDependentShadowMap::~ViewDependentShadowMap()
 {
+    for(OperationThreads::iterator itr = _shadowCastingCullThreads.begin();
+        itr != _shadowCastingCullThreads.end();
+        ++itr)
+    {
+        (*itr)->cancel();
+    }
+}
+
+osg::OperationQueue* ViewDependentShadowMap::getOrCreateShadowCastingCullQueue(unsigned int numThreads)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shadowCastingCullThreadsMutex);
+
+    if (!_shadowCastingCullQueue) _shadowCastingCullQueue = new osg::OperationQueue;
+
+    while(_shadowCastingCullThreads.size()>numThreads)
+    {
+        _shadowCastingCullThreads.back()->cancel();
+        _shadowCastingCullThreads.pop_back();
+    }
+
+    while(_shadowCastingCullThreads.size()<numThreads)
+    {
+        OSG_INFO<<"ViewDependentShadowMap starting shadow casting cull thread "<<_shadowCastingCullThreads.size()<<std::endl;
+
+        osg::ref_ptr<osg::OperationThread> thread = new osg::OperationThread;
+        thread->setOperationQueue(_shadowCastingCullQueue.get());
+        thread->startThread();
+        _shadowCastingCullThreads.push_back(thread);
+    }
+
+    return _shadowCastingCullQueue.get();
 }
 
 
@@ -690,6 +1007,8 @@ void ViewDependentShadowMap::init()
 
     createShaders();
 
+    dirtyShadowCastingCache();
+
     _dirty = false;
 }
 
@@ -827,6 +1146,30 @@ void ViewDependentShadowMap::cull(osgUtil::CullVisitor& cv)
         numShadowMapsPerLight = 2;
     }
 
+    // shadow maps are culled with their own CullVisitor when culling in parallel or retaining render lists
+    unsigned int numCullThreads = settings->getNumShadowCastingCullThreads();
+    bool splitStaticCasters = settings->getSplitStaticShadowCasters() && !settings->getDebugDraw();
+    bool retainRenderLists = settings->getCacheShadowCastingRenderLists() && !splitStaticCasters;
+    bool useShadowDataCullVisitors = numCullThreads>0 || retainRenderLists;
+
+    osg::BoundingSphere sceneBound;
+    if (retainRenderLists || splitStaticCasters) sceneBound = _shadowedScene->getBound();
+
+    // split the shadow casters into those rendered into the cached static depth maps and those rendered every frame
+    osg::NodeList staticCasters;
+    osg::NodeList dynamicCasters;
+    if (splitStaticCasters)
+    {
+        for(unsigned int i=0; i<_shadowedScene->getNumChildren(); ++i)
+        {
+            collectShadowCasters(_shadowedScene->getChild(i), settings->getCastsShadowTraversalMask(), staticCasters, dynamicCasters);
+        }
+    }
+
+    // shadow maps that have been set up but whose RTT camera is still to be traversed
+    typedef std::vector<ShadowMapCull> ShadowMapCulls;
+    ShadowMapCulls shadowMapCulls;
+
     LightDataList& pll = vdd->getLightDataList();
     for(LightDataList::iterator itr = pll.begin();
         itr != pll.end();
@@ -1043,30 +1386,104 @@ void ViewDependentShadowMap::cull(osgUtil::CullVisitor& cv)
             }
 
 
-            osg::ref_ptr<VDSMCameraCullCallback> vdsmCallback = new VDSMCameraCullCallback(this, local_polytope);
-            camera->setCullCallback(vdsmCallback.get());
+            if (splitStaticCasters)
+            {
+                if (!sd->_staticCamera) sd->createStaticShadowMap();
 
-            // 4.3 traverse RTT camera
-            //
+                // both passes must share the same depth range so don't compute near/far from the casters
+                camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
 
-            cv.pushStateSet(_shadowCastingStateSet.get());
+                osg::Matrixd staticProjectionMatrix = camera->getProjectionMatrix();
+                clampProjectionDepthRangeToBound(staticProjectionMatrix, camera->getViewMatrix(), sceneBound, settings->getMinimumShadowMapNearFarRatio());
 
-            cullShadowCastingScene(&cv, camera.get());
+                bool staticTextureUpToDate = sd->_staticTextureValid &&
+                                             sd->_staticRevision==_shadowCastingCacheRevision &&
+                                             sd->_staticSceneBound==sceneBound &&
+                                             sd->_staticCasters==staticCasters &&
+                                             shadowCameraWithinThreshold(sd->_staticViewMatrix*sd->_staticProjectionMatrix,
+                                                                         camera->getViewMatrix()*staticProjectionMatrix,
+                                                                         settings->getStaticShadowMapUpdateThreshold());
 
-            cv.popStateSet();
+                if (staticTextureUpToDate)
+                {
+                    // keep the shadow camera where the static depth map was rendered, moving the polytope into its eye coords.
+                    local_polytope.transformProvidingInverse(osg::Matrixd::inverse(sd->_staticViewMatrix)*camera->getViewMatrix());
+
+                    camera->setProjectionMatrix(sd->_staticProjectionMatrix);
+                    camera->setViewMatrix(sd->_staticViewMatrix);
+                }
+                else
+                {
+                    OSG_INFO<<"Rendering static shadow casters"<<std::endl;
 
-            if (!orthographicViewFrustum && settings->getShadowMapProjectionHint()==ShadowSettings::PERSPECTIVE_SHADOW_MAP)
+                    camera->setProjectionMatrix(staticProjectionMatrix);
+
+                    sd->_staticTextureValid = true;
+                    sd->_staticRevision = _shadowCastingCacheRevision;
+                    sd->_staticSceneBound = sceneBound;
+                    sd->_staticCasters = staticCasters;
+                    sd->_staticProjectionMatrix = camera->getProjectionMatrix();
+                    sd->_staticViewMatrix = camera->getViewMatrix();
+
+                    sd->_staticCamera->setProjectionMatrix(sd->_staticProjectionMatrix);
+                    sd->_staticCamera->setViewMatrix(sd->_staticViewMatrix);
+
+                    osg::Polytope staticPolytope;
+                    osg::ref_ptr<VDSMCameraCullCallback> staticCallback = new VDSMCameraCullCallback(this, staticPolytope);
+                    staticCallback->setCasters(staticCasters);
+                    sd->_staticCamera->setCullCallback(staticCallback.get());
+
+                    cv.pushStateSet(_shadowCastingStateSet.get());
+
+                    cullShadowCastingScene(&cv, sd->_staticCamera.get());
+
+                    cv.popStateSet();
+                }
+            }
+            else
             {
-                adjustPerspectiveShadowMapCameraSettings(vdsmCallback->getRenderStage(), frustum, pl, camera.get());
-                if (vdsmCallback->getProjectionMatrix())
+                camera->setComputeNearFarMode(osg::CullSettings::COMPUTE_NEAR_FAR_USING_BOUNDING_VOLUMES);
+            }
+
+            ShadowMapCull smc;
+            smc.sd = sd;
+            smc.pl = &pl;
+            smc.textureUnit = textureUnit;
+            smc.reuseRenderLists = retainRenderLists &&
+                                   sd->_cachedRenderStage.valid() &&
+                                   sd->_cachedRevision==_shadowCastingCacheRevision &&
+                                   sd->_cachedProjectionMatrix==camera->getProjectionMatrix() &&
+                                   sd->_cachedViewMatrix==camera->getViewMatrix() &&
+                                   sd->_cachedPolytope==local_polytope.getPlaneList() &&
+                                   sd->_cachedViewPoint==cv.getViewPoint() &&
+                                   sd->_cachedSceneBound==sceneBound;
+
+            if (smc.reuseRenderLists)
+            {
+                // shadow camera and scene are unchanged so draw the render lists retained from a previous frame.
+                camera->setProjectionMatrix(sd->_cachedRenderProjectionMatrix);
+            }
+            else
+            {
+                if (retainRenderLists)
                 {
-                    vdsmCallback->getProjectionMatrix()->set(camera->getProjectionMatrix());
+                    sd->_cachedProjectionMatrix = camera->getProjectionMatrix();
+                    sd->_cachedViewMatrix = camera->getViewMatrix();
+                    sd->_cachedPolytope = local_polytope.getPlaneList();
+                    sd->_cachedViewPoint = cv.getViewPoint();
+                    sd->_cachedSceneBound = sceneBound;
+                }
+
+                smc.cullCallback = new VDSMCameraCullCallback(this, local_polytope);
+                if (splitStaticCasters)
+                {
+                    smc.cullCallback->setCasters(dynamicCasters);
+                    smc.cullCallback->setDepthCopy(sd->_staticDepthCopyStateSet.get(), sd->_staticDepthCopyGeometry.get());
                 }
+                camera->setCullCallback(smc.cullCallback.get());
             }
 
-            // 4.4 compute main scene graph TexGen + uniform settings + setup state
-            //
-            assignTexGenSettings(&cv, camera.get(), textureUnit, sd->_texgen.get());
+            shadowMapCulls.push_back(smc);
 
             // mark the light as one that has active shadows and requires shaders
             pl.textureUnits.push_back(textureUnit);
@@ -1089,6 +1506,116 @@ void ViewDependentShadowMap::cull(osgUtil::CullVisitor& cv)
         }
     }
 
+    // 4.3 traverse RTT cameras
+    //
+    if (!useShadowDataCullVisitors)
+    {
+        for(ShadowMapCulls::iterator itr = shadowMapCulls.begin();
+            itr != shadowMapCulls.end();
+            ++itr)
+        {
+            cv.pushStateSet(_shadowCastingStateSet.get());
+
+            cullShadowCastingScene(&cv, itr->sd->_camera.get());
+
+            cv.popStateSet();
+        }
+    }
+    else
+    {
+        typedef std::vector<ShadowData*> ShadowDataToCull;
+        ShadowDataToCull shadowDataToCull;
+        for(ShadowMapCulls::iterator itr = shadowMapCulls.begin();
+            itr != shadowMapCulls.end();
+            ++itr)
+        {
+            if (!itr->reuseRenderLists) shadowDataToCull.push_back(itr->sd.get());
+        }
+
+        osg::OperationQueue* queue = (numCullThreads>0 && shadowDataToCull.size()>1) ? getOrCreateShadowCastingCullQueue(numCullThreads) : 0;
+        if (queue)
+        {
+            // hand all but the first shadow map to the worker threads and cull the first one on this thread
+            osg::ref_ptr<osg::RefBlockCount> blockCount = new osg::RefBlockCount(shadowDataToCull.size()-1);
+            blockCount->reset();
+
+            for(unsigned int i=1; i<shadowDataToCull.size(); ++i)
+            {
+                queue->add(new ShadowCastingCullOperation(this, &cv, shadowDataToCull[i], blockCount.get()));
+            }
+
+            cullShadowCastingSceneUsingShadowData(cv, *shadowDataToCull[0]);
+
+            blockCount->block();
+        }
+        else
+        {
+            for(ShadowDataToCull::iterator itr = shadowDataToCull.begin();
+                itr != shadowDataToCull.end();
+                ++itr)
+            {
+                cullShadowCastingSceneUsingShadowData(cv, **itr);
+            }
+        }
+
+        // attach the shadow cameras' RenderStages to the view's RenderStage
+        osgUtil::RenderStage* currentStage = cv.getCurrentRenderBin()->getStage();
+        for(ShadowMapCulls::iterator itr = shadowMapCulls.begin();
+            itr != shadowMapCulls.end();
+            ++itr)
+        {
+            ShadowData& sd = *(itr->sd);
+            osgUtil::RenderStage* renderStage = itr->reuseRenderLists ? sd._cachedRenderStage.get() : itr->cullCallback->getRenderStage();
+            if (!renderStage) continue;
+
+            renderStage->setInheritedPositionalStateContainer(currentStage->getPositionalStateContainer());
+
+            if (sd._camera->getRenderOrder()==osg::Camera::PRE_RENDER) currentStage->addPreRenderStage(renderStage, sd._camera->getRenderOrderNum());
+            else currentStage->addPostRenderStage(renderStage, sd._camera->getRenderOrderNum());
+
+            if (retainRenderLists && !itr->reuseRenderLists)
+            {
+                ShadowCastingRenderStage* scrs = dynamic_cast<ShadowCastingRenderStage*>(renderStage);
+                if (scrs)
+                {
+                    scrs->setRetainContents(true);
+                    sd._cachedRenderStage = scrs;
+                    sd._cachedRevision = _shadowCastingCacheRevision;
+
+                    // keep the drawables and state referenced by the retained render lists alive.
+                    if (scrs->getStateGraph()) collectRenderGraphObjects(scrs->getStateGraph(), sd._cachedObjects);
+                }
+            }
+        }
+    }
+
+    // 4.4 compute main scene graph TexGen + uniform settings + setup state
+    //
+    for(ShadowMapCulls::iterator itr = shadowMapCulls.begin();
+        itr != shadowMapCulls.end();
+        ++itr)
+    {
+        ShadowData& sd = *(itr->sd);
+        osg::Camera* camera = sd._camera.get();
+
+        if (!itr->reuseRenderLists)
+        {
+            VDSMCameraCullCallback* vdsmCallback = itr->cullCallback.get();
+            if (!orthographicViewFrustum && !splitStaticCasters && settings->getShadowMapProjectionHint()==ShadowSettings::PERSPECTIVE_SHADOW_MAP)
+            {
+                adjustPerspectiveShadowMapCameraSettings(vdsmCallback->getRenderStage(), frustum, *(itr->pl), camera);
+                if (vdsmCallback->getProjectionMatrix())
+                {
+                    vdsmCallback->getProjectionMatrix()->set(camera->getProjectionMatrix());
+                }
+            }
+
+            if (retainRenderLists) sd._cachedRenderProjectionMatrix = camera->getProjectionMatrix();
+        }
+
+        assignTexGenSettings(&cv, camera, itr->textureUnit, sd._texgen.get());
+    }
+
     if (numValidShadows>0)
     {
         decoratorStateGraph->setStateSet(selectStateSetForRenderingShadow(*vdd));
@@ -2333,6 +2860,98 @@ void ViewDependentShadowMap::cullShadowCastingScene(osgUtil::CullVisitor* cv, os
     return;
 }
 
+void ViewDependentShadowMap::cullShadowCastingSceneUsingShadowData(osgUtil::CullVisitor& cv, ShadowData& sd) const
+{
+    OSG_INFO<<"cullShadowCastingSceneUsingShadowData()"<<std::endl;
+
+    // release any render lists retained from previous frames so the RenderStage is properly reset.
+    if (sd._cachedRenderStage.valid())
+    {
+        ShadowCastingRenderStage* scrs = dynamic_cast<ShadowCastingRenderStage*>(sd._cachedRenderStage.get());
+        if (scrs) scrs->setRetainContents(false);
+        sd._cachedRenderStage = 0;
+        sd._cachedObjects.clear();
+    }
+
+    if (!sd._cullVisitor)
+    {
+        sd._cullVisitor = cv.clone();
+        sd._rootStateGraph = new osgUtil::StateGraph;
+        sd._rootRenderStage = new ShadowCastingRenderStage;
+    }
+
+    osgUtil::CullVisitor* scv = sd._cullVisitor.get();
+
+    // mirror the view's current RenderStage as the parent of the shadow camera's RenderStage
+    osgUtil::RenderStage* currentStage = cv.getCurrentRenderBin()->getStage();
+    osgUtil::RenderStage* rootStage = sd._rootRenderStage.get();
+    rootStage->reset();
+    rootStage->setViewport(currentStage->getViewport());
+    rootStage->setDrawBuffer(currentStage->getDrawBuffer(), currentStage->getDrawBufferApplyMask());
+    rootStage->setReadBuffer(currentStage->getReadBuffer(), currentStage->getReadBufferApplyMask());
+    rootStage->setClearMask(currentStage->getClearMask());
+    rootStage->setClearColor(currentStage->getClearColor());
+    rootStage->setColorMask(currentStage->getColorMask());
+
+    sd._rootStateGraph->clean();
+
+    scv->reset();
+    scv->setFrameStamp(const_cast<osg::FrameStamp*>(cv.getFrameStamp()));
+    scv->setTraversalNumber(cv.getTraversalNumber());
+    scv->setTraversalMask(cv.getTraversalMask());
+    scv->setNodeMaskOverride(cv.getNodeMaskOverride());
+    scv->inheritCullSettings(cv);
+    scv->setRenderInfo(cv.getRenderInfo());
+    scv->setDatabaseRequestHandler(cv.getDatabaseRequestHandler());
+    scv->setImageRequestHandler(cv.getImageRequestHandler());
+    scv->setStateGraph(sd._rootStateGraph.get());
+    scv->setRenderStage(rootStage);
+
+    // replicate the StateGraph parental chain of the view so the shadow camera inherits the same state.
+    typedef std::vector<osgUtil::StateGraph*> StateGraphStack;
+    StateGraphStack stateGraphParentalChain;
+    for(osgUtil::StateGraph* sg = cv.getCurrentStateGraph(); sg; sg = sg->_parent)
+    {
+        stateGraphParentalChain.push_back(sg);
+    }
+
+    unsigned int numPushedStateSets = 0;
+    StateGraphStack::reverse_iterator ritr = stateGraphParentalChain.rbegin();
+    if (ritr!=stateGraphParentalChain.rend())
+    {
+        sd._rootStateGraph->setStateSet((*ritr++)->getStateSet());
+
+        for(; ritr!=stateGraphParentalChain.rend(); ++ritr)
+        {
+            if ((*ritr)->getStateSet())
+            {
+                scv->pushStateSet((*ritr)->getStateSet());
+                ++numPushedStateSets;
+            }
+        }
+    }
+
+    scv->pushStateSet(_shadowCastingStateSet.get());
+
+    scv->pushViewport(cv.getViewport());
+    scv->pushProjectionMatrix(new osg::RefMatrix(*cv.getProjectionMatrix()));
+    scv->pushModelViewMatrix(new osg::RefMatrix(*cv.getModelViewMatrix()), osg::Transform::ABSOLUTE_RF);
+
+    cullShadowCastingScene(scv, sd._camera.get());
+
+    scv->popModelViewMatrix();
+    scv->popProjectionMatrix();
+    scv->popViewport();
+
+    scv->popStateSet();
+    for(unsigned int i=0; i<numPushedStateSets; ++i)
+    {
+        scv->popStateSet();
+    }
+
+    sd._rootStateGraph->prune();
+}
+
 osg::StateSet* ViewDependentShadowMap::selectStateSetForRenderingShadow(ViewDependentData& vdd) const
 {
     OSG_INFO<<"   selectStateSetForRenderingShadow() "<<vdd.getStateSet()<<std::endl;
@@ -22,10 +22,19 @@
 #include <osg/BlendFunc>
 #include <osg/Material>
 #include <osg/PointSprite>
+#include <osg/Depth>
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/Texture2D>
+
+#include <osgDB/ReadFile>
 
 #include <osgUtil/CullVisitor>
 
+#include <OpenThreads/ScopedLock>
+
 #include <typeinfo>
+#include <map>
 
 namespace osgSim
 {
@@ -43,13 +52,88 @@ osg::StateSet* getSingletonLightPointSystemSet()
     return s_stateset.get();
 }
 
+static const unsigned int LIGHT_POINT_PARAMETERS_ATTRIBUTE = 6;
+static const unsigned int LIGHT_POINT_BLINK_ATTRIBUTE = 7;
+static const unsigned int LIGHT_POINT_DATA_TEXTURE_UNIT = 1;
+static const unsigned int MAX_LIGHT_POINT_DATA_WIDTH = 1024;
+static const int MAX_SHADER_PULSES = 64;
+
+static osg::Program* getSingletonLightPointProgram()
+{
+    static OpenThreads::Mutex s_mutex;
+    static osg::ref_ptr<osg::Program> s_program;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_mutex);
+    if (!s_program)
+    {
+        s_program = new osg::Program;
+        s_program->setName("LightPointNode");
+
+        {
+            #include "shaders/osgSim_LightPoint_vert.cpp"
+            s_program->addShader(osgDB::readRefShaderFileWithFallback(osg::Shader::VERTEX, "shaders/osgSim_LightPoint.vert", osgSim_LightPoint_vert));
+        }
+
+        {
+            #include "shaders/osgSim_LightPoint_frag.cpp"
+            s_program->addShader(osgDB::readRefShaderFileWithFallback(osg::Shader::FRAGMENT, "shaders/osgSim_LightPoint.frag", osgSim_LightPoint_frag));
+        }
+
+        s_program->addBindAttribLocation("osgSim_LightPointParameters", LIGHT_POINT_PARAMETERS_ATTRIBUTE);
+        s_program->addBindAttribLocation("osgSim_LightPointBlink", LIGHT_POINT_BLINK_ATTRIBUTE);
+    }
+    return s_program.get();
+}
+
+static osg::StateSet* getSingletonLightPointBlendingStateSet(LightPoint::BlendingMode blendingMode)
+{
+    static OpenThreads::Mutex s_mutex;
+    static osg::ref_ptr<osg::StateSet> s_statesets[2];
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_mutex);
+    osg::ref_ptr<osg::StateSet>& stateset = s_statesets[blendingMode==LightPoint::ADDITIVE ? 1 : 0];
+    if (!stateset)
+    {
+        // match the blending used by LightPointDrawable for blended and additive light points.
+        osg::BlendFunc* blendFunc = new osg::BlendFunc;
+        if (blendingMode==LightPoint::ADDITIVE) blendFunc->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE);
+        else blendFunc->setFunction(osg::BlendFunc::SRC_ALPHA, osg::BlendFunc::ONE_MINUS_SRC_ALPHA);
+
+        stateset = new osg::StateSet;
+        stateset->setAttributeAndModes(blendFunc, osg::StateAttribute::ON);
+    }
+    return stateset.get();
+}
+
+static osg::StateSet* getOrCreateLightPointViewportStateSet(const osg::Viewport* viewport)
+{
+    typedef std::map< std::pair<int, int>, osg::ref_ptr<osg::StateSet> > ViewportStateSets;
+    static OpenThreads::Mutex s_mutex;
+    static ViewportStateSets s_viewportStateSets;
+
+    int width = viewport ? static_cast<int>(viewport->width()) : 1280;
+    int height = viewport ? static_cast<int>(viewport->height()) : 1024;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_mutex);
+    osg::ref_ptr<osg::StateSet>& stateset = s_viewportStateSets[std::pair<int, int>(width, height)];
+    if (!stateset)
+    {
+        stateset = new osg::StateSet;
+        stateset->addUniform(new osg::Uniform("osgSim_ViewportSize", osg::Vec2(static_cast<float>(width), static_cast<float>(height))));
+    }
+    return stateset.get();
+}
+
 
 LightPointNode::LightPointNode():
     _minPixelSize(0.0f),
     _maxPixelSize(30.0f),
     _maxVisibleDistance2(FLT_MAX),
     _lightSystem(0),
-    _pointSprites(false)
+    _pointSprites(false),
+    _computeMode(COMPUTE_ON_CPU),
+    _shaderGeometryDirty(true),
+    _shaderGeometrySupported(false)
 {
     setStateSet(getSingletonLightPointSystemSet());
 }
@@ -63,7 +147,10 @@ LightPointNode::LightPointNode(const LightPointNode& lpn,const osg::CopyOp& copy
     _maxPixelSize(lpn._maxPixelSize),
     _maxVisibleDistance2(lpn._maxVisibleDistance2),
     _lightSystem(lpn._lightSystem),
-    _pointSprites(lpn._pointSprites)
+    _pointSprites(lpn._pointSprites),
+    _computeMode(lpn._computeMode),
+    _shaderGeometryDirty(true),
+    _shaderGeometrySupported(false)
 {
 }
 
@@ -71,6 +158,7 @@ unsigned int LightPointNode::addLightPoint(const LightPoint& lp)
 {
     unsigned int num = _lightPointList.size();
     _lightPointList.push_back(lp);
+    _shaderGeometryDirty = true;
     dirtyBound();
     return num;
 }
@@ -80,6 +168,7 @@ void LightPointNode::removeLightPoint(unsigned int pos)
     if (pos<_lightPointList.size())
     {
         _lightPointList.erase(_lightPointList.begin()+pos);
+        _shaderGeometryDirty = true;
         dirtyBound();
     }
     dirtyBound();
@@ -121,6 +210,219 @@ osg::BoundingSphere LightPointNode::computeBound() const
     return bsphere;
 }
 
+void LightPointNode::resizeGLObjectBuffers(unsigned int maxSize)
+{
+    Node::resizeGLObjectBuffers(maxSize);
+
+    if (_shaderGeode.valid()) _shaderGeode->resizeGLObjectBuffers(maxSize);
+}
+
+void LightPointNode::releaseGLObjects(osg::State* state) const
+{
+    Node::releaseGLObjects(state);
+
+    if (_shaderGeode.valid()) _shaderGeode->releaseGLObjects(state);
+}
+
+bool LightPointNode::buildShaderGeometry()
+{
+    typedef std::map<const Sector*, osg::Vec2> SectorIndices;
+    typedef std::map< std::vector<float>, unsigned int > PulseIndices;
+
+    // sector parameters and blink sequence pulses shared between light points, packed into a float texture.
+    std::vector<osg::Vec4> data;
+    SectorIndices sectorIndices;
+    PulseIndices pulseIndices;
+
+    osg::ref_ptr<osg::Vec3Array> vertices[2];
+    osg::ref_ptr<osg::Vec4Array> colors[2];
+    osg::ref_ptr<osg::Vec4Array> parameters[2];
+    osg::ref_ptr<osg::Vec4Array> blinks[2];
+    for(unsigned int i=0; i<2; ++i)
+    {
+        vertices[i] = new osg::Vec3Array;
+        colors[i] = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+        parameters[i] = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+        blinks[i] = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+    }
+
+    for(LightPointList::const_iterator itr=_lightPointList.begin();
+        itr!=_lightPointList.end();
+        ++itr)
+    {
+        const LightPoint& lp = *itr;
+
+        if (!lp._on) continue;
+
+        osg::Vec2 sector(0.0f, 0.0f);
+        if (lp._sector.valid())
+        {
+            SectorIndices::iterator sitr = sectorIndices.find(lp._sector.get());
+            if (sitr==sectorIndices.end())
+            {
+                Sector::ShaderParameters shaderParameters;
+                if (!lp._sector->getShaderParameters(shaderParameters))
+                {
+                    OSG_INFO<<"LightPointNode::buildShaderGeometry() "<<lp._sector->className()<<" has no shader implementation, using COMPUTE_ON_CPU."<<std::endl;
+                    return false;
+                }
+
+                osg::Vec2 entry(static_cast<float>(shaderParameters.type), static_cast<float>(data.size()));
+                for(unsigned int i=0; i<4; ++i)
+                {
+                    data.push_back(shaderParameters.values[i]);
+                }
+                sitr = sectorIndices.insert(SectorIndices::value_type(lp._sector.get(), entry)).first;
+            }
+            sector = sitr->second;
+        }
+
+        osg::Vec4 blink(0.0f, 0.0f, 1.0f, 0.0f);
+        if (lp._blinkSequence.valid() && lp._blinkSequence->getNumPulses()>0)
+        {
+            const BlinkSequence& bs = *lp._blinkSequence;
+            if (bs.getNumPulses()>MAX_SHADER_PULSES)
+            {
+                OSG_INFO<<"LightPointNode::buildShaderGeometry() BlinkSequence with "<<bs.getNumPulses()<<" pulses exceeds shader limit, using COMPUTE_ON_CPU."<<std::endl;
+                return false;
+            }
+
+            std::vector<float> pulses;
+            for(int i=0; i<bs.getNumPulses(); ++i)
+            {
+                double length;
+                osg::Vec4 color;
+                bs.getPulse(i, length, color);
+                pulses.push_back(static_cast<float>(length));
+                pulses.insert(pulses.end(), color.ptr(), color.ptr()+4);
+            }
+
+            PulseIndices::iterator pitr = pulseIndices.find(pulses);
+            if (pitr==pulseIndices.end())
+            {
+                pitr = pulseIndices.insert(PulseIndices::value_type(pulses, static_cast<unsigned int>(data.size()))).first;
+                for(std::vector<float>::const_iterator fitr=pulses.begin(); fitr!=pulses.end(); fitr+=5)
+                {
+                    data.push_back(osg::Vec4(*(fitr+1), *(fitr+2), *(fitr+3), *(fitr+4)));
+                    data.push_back(osg::Vec4(*fitr, 0.0f, 0.0f, 0.0f));
+                }
+            }
+
+            double phase = bs.getPhaseShift();
+            if (bs.getSequenceGroup()) phase += bs.getSequenceGroup()->getBaseTime();
+
+            blink.set(static_cast<float>(pitr->second), static_cast<float>(bs.getNumPulses()), static_cast<float>(bs.getPulsePeriod()), static_cast<float>(phase));
+        }
+
+        unsigned int i = (lp._blendingMode==LightPoint::ADDITIVE) ? 1 : 0;
+        vertices[i]->push_back(lp._position);
+        colors[i]->push_back(lp._color);
+        parameters[i]->push_back(osg::Vec4(lp._intensity, lp._radius, sector.x(), sector.y()));
+        blinks[i]->push_back(blink);
+    }
+
+    if (data.empty()) data.push_back(osg::Vec4(0.0f, 0.0f, 0.0f, 0.0f));
+
+    unsigned int width = osg::minimum(static_cast<unsigned int>(data.size()), MAX_LIGHT_POINT_DATA_WIDTH);
+    unsigned int height = (static_cast<unsigned int>(data.size())+width-1)/width;
+    data.resize(width*height);
+
+    osg::ref_ptr<osg::Image> image = new osg::Image;
+    image->allocateImage(width, height, 1, GL_RGBA, GL_FLOAT);
+    image->setInternalTextureFormat(GL_RGBA32F_ARB);
+    memcpy(image->data(), &data.front(), data.size()*sizeof(osg::Vec4));
+
+    osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image.get());
+    texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+    texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+    texture->setResizeNonPowerOfTwoHint(false);
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->setCullingActive(false);
+
+    osg::StateSet* stateset = geode->getOrCreateStateSet();
+    stateset->setAttribute(getSingletonLightPointProgram());
+    stateset->setTextureAttribute(LIGHT_POINT_DATA_TEXTURE_UNIT, texture.get());
+    stateset->setTextureAttributeAndModes(0, new osg::PointSprite, osg::StateAttribute::ON);
+    stateset->setMode(GL_VERTEX_PROGRAM_POINT_SIZE, osg::StateAttribute::ON);
+    stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+    stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+    osg::Depth* depth = new osg::Depth;
+    depth->setWriteMask(false);
+    stateset->setAttribute(depth);
+
+    stateset->addUniform(new osg::Uniform("osgSim_LightPointData", static_cast<int>(LIGHT_POINT_DATA_TEXTURE_UNIT)));
+    stateset->addUniform(new osg::Uniform("osgSim_LightPointDataSize", osg::Vec2(static_cast<float>(width), static_cast<float>(height))));
+    stateset->addUniform(new osg::Uniform("osgSim_PointSpriteTexture", 0));
+
+    // the uniforms below are updated during the cull traversal, so have to be DYNAMIC to stop the draw of
+    // the previous frame reading them at the same time when running DrawThreadPerContext.
+    stateset->setDataVariance(osg::Object::DYNAMIC);
+
+    osg::Uniform* dynamicUniforms[] =
+    {
+        new osg::Uniform("osgSim_PointSprite", _pointSprites),
+        new osg::Uniform("osgSim_PixelSizeRange", osg::Vec3(_minPixelSize, _maxPixelSize, _maxVisibleDistance2)),
+        new osg::Uniform("osgSim_SystemIntensity", -1.0f),
+        new osg::Uniform("osgSim_BlinkEnabled", true)
+    };
+    for(unsigned int i=0; i<4; ++i)
+    {
+        dynamicUniforms[i]->setDataVariance(osg::Object::DYNAMIC);
+        stateset->addUniform(dynamicUniforms[i]);
+    }
+
+    for(unsigned int i=0; i<2; ++i)
+    {
+        if (vertices[i]->empty()) continue;
+
+        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+        geometry->setUseDisplayList(false);
+        geometry->setUseVertexBufferObjects(true);
+        geometry->setCullingActive(false);
+        geometry->setVertexArray(vertices[i].get());
+        geometry->setColorArray(colors[i].get());
+        geometry->setVertexAttribArray(LIGHT_POINT_PARAMETERS_ATTRIBUTE, parameters[i].get());
+        geometry->setVertexAttribArray(LIGHT_POINT_BLINK_ATTRIBUTE, blinks[i].get());
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices[i]->size()));
+        geometry->setStateSet(getSingletonLightPointBlendingStateSet(i==1 ? LightPoint::ADDITIVE : LightPoint::BLENDED));
+
+        geode->addDrawable(geometry.get());
+    }
+
+    _shaderGeode = geode;
+
+    return true;
+}
+
+void LightPointNode::updateShaderUniforms(osg::StateSet* stateset)
+{
+
+    osg::Vec3 pixelSizeRange(_minPixelSize, _maxPixelSize, _maxVisibleDistance2);
+    float systemIntensity = _lightSystem.valid() ? _lightSystem->getIntensity() : -1.0f;
+    bool blinkEnabled = !_lightSystem.valid() || _lightSystem->getAnimationState()==LightPointSystem::ANIMATION_ON;
+
+    // only modify the uniforms when values change to avoid updating them on every cull.
+    osg::Uniform* uniform = stateset->getUniform("osgSim_PixelSizeRange");
+    osg::Vec3 currentPixelSizeRange;
+    if (uniform->get(currentPixelSizeRange) && currentPixelSizeRange!=pixelSizeRange) uniform->set(pixelSizeRange);
+
+    uniform = stateset->getUniform("osgSim_SystemIntensity");
+    float currentSystemIntensity;
+    if (uniform->get(currentSystemIntensity) && currentSystemIntensity!=systemIntensity) uniform->set(systemIntensity);
+
+    uniform = stateset->getUniform("osgSim_BlinkEnabled");
+    bool currentBlinkEnabled;
+    if (uniform->get(currentBlinkEnabled) && currentBlinkEnabled!=blinkEnabled) uniform->set(blinkEnabled);
+
+    uniform = stateset->getUniform("osgSim_PointSprite");
+    bool currentPointSprites;
+    if (uniform->get(currentPointSprites) && currentPointSprites!=_pointSprites) uniform->set(_pointSprites);
+}
+
 
 void LightPointNode::traverse(osg::NodeVisitor& nv)
 {
@@ -147,6 +449,44 @@ void LightPointNode::traverse(osg::NodeVisitor& nv)
     t2 = timer.tick();
 #endif
 
+    if (cv && _computeMode==COMPUTE_ON_GPU)
+    {
+        // other cull threads may rebuild _shaderGeode, so only use the local reference taken under the mutex.
+        osg::ref_ptr<osg::Geode> shaderGeode;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shaderGeometryMutex);
+            if (_shaderGeometryDirty)
+            {
+                _shaderGeometrySupported = buildShaderGeometry();
+                _shaderGeometryDirty = false;
+            }
+            if (_shaderGeometrySupported)
+            {
+                shaderGeode = _shaderGeode;
+                updateShaderUniforms(shaderGeode->getStateSet());
+            }
+        }
+
+        if (shaderGeode.valid())
+        {
+            // the light points are culled as a whole, with the per light point work done in the shaders.
+            if (_maxVisibleDistance2!=FLT_MAX)
+            {
+                const osg::BoundingSphere& bs = getBound();
+                float distance = (cv->getEyeLocal()-bs.center()).length()-bs.radius();
+                if (distance>0.0f && distance*distance>_maxVisibleDistance2) return;
+            }
+
+            // the viewport dimensions are required to compute light point sizes in pixels on the GPU.
+            cv->pushStateSet(getOrCreateLightPointViewportStateSet(cv->getViewport()));
+
+            shaderGeode->accept(nv);
+
+            cv->popStateSet();
+            return;
+        }
+    }
+
 
     // should we disable small feature culling here?
     if (cv /*&& !cv->isCulled(_bbox)*/)
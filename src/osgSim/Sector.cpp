@@ -131,6 +131,13 @@ float AzimSector::operator() (const osg::Vec3& eyeLocal) const
     return azimSector(eyeLocal);
 }
 
+bool AzimSector::getShaderParameters(ShaderParameters& parameters) const
+{
+    parameters.type = ShaderParameters::AZIM_SECTOR;
+    parameters.values[0].set(_cosAzim, _sinAzim, _cosAngle, _cosFadeAngle);
+    return true;
+}
+
 //
 // ElevationSector
 //
@@ -146,6 +153,13 @@ float ElevationSector::operator() (const osg::Vec3& eyeLocal) const
     return elevationSector(eyeLocal);
 }
 
+bool ElevationSector::getShaderParameters(ShaderParameters& parameters) const
+{
+    parameters.type = ShaderParameters::ELEVATION_SECTOR;
+    parameters.values[1].set(_cosMinElevation, _cosMinFadeElevation, _cosMaxElevation, _cosMaxFadeElevation);
+    return true;
+}
+
 //
 // AzimElevationSector
 //
@@ -169,6 +183,14 @@ float AzimElevationSector::operator() (const osg::Vec3& eyeLocal) const
     return elevIntensity;
 }
 
+bool AzimElevationSector::getShaderParameters(ShaderParameters& parameters) const
+{
+    parameters.type = ShaderParameters::AZIM_ELEVATION_SECTOR;
+    parameters.values[0].set(_cosAzim, _sinAzim, _cosAngle, _cosFadeAngle);
+    parameters.values[1].set(_cosMinElevation, _cosMinFadeElevation, _cosMaxElevation, _cosMaxFadeElevation);
+    return true;
+}
+
 //
 // ConeSector
 //
@@ -215,6 +237,14 @@ float ConeSector::operator() (const osg::Vec3& eyeLocal) const
     return (dotproduct-_cosAngleFade*length)/((_cosAngle-_cosAngleFade)*length);
 }
 
+bool ConeSector::getShaderParameters(ShaderParameters& parameters) const
+{
+    parameters.type = ShaderParameters::CONE_SECTOR;
+    parameters.values[0].set(_axis.x(), _axis.y(), _axis.z(), 0.0f);
+    parameters.values[1].set(_cosAngle, _cosAngleFade, 0.0f, 0.0f);
+    return true;
+}
+
 //
 // DirectionalSector
 //
@@ -364,3 +394,17 @@ float DirectionalSector::operator() (const osg::Vec3& eyeLocal) const
    //fprintf(stderr, "   %%%% Returning intensity = %f\n", elev_intensity * azim_intensity) ;
    return elev_intensity * azim_intensity ;
 }
+
+bool DirectionalSector::getShaderParameters(ShaderParameters& parameters) const
+{
+    parameters.type = ShaderParameters::DIRECTIONAL_SECTOR;
+
+    // rows of the rotation from the local frame into the light point frame.
+    for(unsigned int i=0; i<3; ++i)
+    {
+        parameters.values[i].set(_local_to_LP(i,0), _local_to_LP(i,1), _local_to_LP(i,2), 0.0f);
+    }
+
+    parameters.values[3].set(_cosVertAngle, _cosVertFadeAngle, _cosHorizAngle, _cosHorizFadeAngle);
+    return true;
+}
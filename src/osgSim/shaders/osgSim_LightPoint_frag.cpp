@@ -0,0 +1,36 @@
+char osgSim_LightPoint_frag[] = "$OSG_GLSL_VERSION\n"
+                                "$OSG_PRECISION_FLOAT\n"
+                                "\n"
+                                "#if __VERSION__>=130\n"
+                                "    #define TEXTURE texture\n"
+                                "    out vec4 osg_FragColor;\n"
+                                "#else\n"
+                                "    #define TEXTURE texture2D\n"
+                                "    #define osg_FragColor gl_FragColor\n"
+                                "#endif\n"
+                                "\n"
+                                "uniform bool osgSim_PointSprite;\n"
+                                "uniform sampler2D osgSim_PointSpriteTexture;\n"
+                                "\n"
+                                "$OSG_VARYING_IN vec4 vertexColor;\n"
+                                "\n"
+                                "void main(void)\n"
+                                "{\n"
+                                "    vec4 color = vertexColor;\n"
+                                "\n"
+                                "    if (osgSim_PointSprite)\n"
+                                "    {\n"
+                                "        color *= TEXTURE(osgSim_PointSpriteTexture, gl_PointCoord);\n"
+                                "    }\n"
+                                "    else\n"
+                                "    {\n"
+                                "        // round, smoothed light point\n"
+                                "        vec2 delta = gl_PointCoord*2.0-1.0;\n"
+                                "        float radius2 = dot(delta, delta);\n"
+                                "        if (radius2>1.0) discard;\n"
+                                "        color.a *= 1.0-smoothstep(0.5, 1.0, radius2);\n"
+                                "    }\n"
+                                "\n"
+                                "    osg_FragColor = color;\n"
+                                "}\n"
+                                "\n";
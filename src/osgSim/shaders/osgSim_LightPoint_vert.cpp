@@ -0,0 +1,192 @@
+char osgSim_LightPoint_vert[] = "$OSG_GLSL_VERSION\n"
+                                "$OSG_PRECISION_FLOAT\n"
+                                "\n"
+                                "#if __VERSION__>=130\n"
+                                "    #define ATTRIBUTE_IN in\n"
+                                "    #define TEXTURELOD textureLod\n"
+                                "#else\n"
+                                "    #define ATTRIBUTE_IN attribute\n"
+                                "    #define TEXTURELOD texture2DLod\n"
+                                "#endif\n"
+                                "\n"
+                                "#define MAX_PULSES 64\n"
+                                "\n"
+                                "uniform float osg_SimulationTime;\n"
+                                "\n"
+                                "uniform vec2 osgSim_ViewportSize;\n"
+                                "\n"
+                                "// x = min pixel size, y = max pixel size, z = max visible distance squared\n"
+                                "uniform vec3 osgSim_PixelSizeRange;\n"
+                                "\n"
+                                "// intensity set by the LightPointSystem, negative when each light point's own intensity is used\n"
+                                "uniform float osgSim_SystemIntensity;\n"
+                                "uniform bool osgSim_BlinkEnabled;\n"
+                                "\n"
+                                "// sector parameters and blink sequence pulses stored as a linear array of texels\n"
+                                "uniform sampler2D osgSim_LightPointData;\n"
+                                "uniform vec2 osgSim_LightPointDataSize;\n"
+                                "\n"
+                                "// x = intensity, y = radius, z = sector type, w = index of the sector parameters\n"
+                                "ATTRIBUTE_IN vec4 osgSim_LightPointParameters;\n"
+                                "\n"
+                                "// x = index of the first pulse, y = number of pulses, z = pulse period, w = phase\n"
+                                "ATTRIBUTE_IN vec4 osgSim_LightPointBlink;\n"
+                                "\n"
+                                "$OSG_VARYING_OUT vec4 vertexColor;\n"
+                                "\n"
+                                "vec4 lightPointData(float index)\n"
+                                "{\n"
+                                "    float row = floor(index/osgSim_LightPointDataSize.x);\n"
+                                "    vec2 texel = vec2(index-row*osgSim_LightPointDataSize.x, row);\n"
+                                "    return TEXTURELOD(osgSim_LightPointData, (texel+0.5)/osgSim_LightPointDataSize, 0.0);\n"
+                                "}\n"
+                                "\n"
+                                "vec2 safeNormalize(vec2 v)\n"
+                                "{\n"
+                                "    float length2 = dot(v,v);\n"
+                                "    return (length2>0.0) ? v*inversesqrt(length2) : v;\n"
+                                "}\n"
+                                "\n"
+                                "float azimSector(vec3 eyeLocal, vec4 p)\n"
+                                "{\n"
+                                "    // p = (cosAzim, sinAzim, cosAngle, cosFadeAngle)\n"
+                                "    float dotproduct = eyeLocal.x*p.y+eyeLocal.y*p.x;\n"
+                                "    float len = length(eyeLocal.xy);\n"
+                                "    if (dotproduct<p.w*len) return 0.0;\n"
+                                "    if (dotproduct>=p.z*len) return 1.0;\n"
+                                "    return (dotproduct-p.w*len)/((p.z-p.w)*len);\n"
+                                "}\n"
+                                "\n"
+                                "float elevationSector(vec3 eyeLocal, vec4 p)\n"
+                                "{\n"
+                                "    // p = (cosMinElevation, cosMinFadeElevation, cosMaxElevation, cosMaxFadeElevation)\n"
+                                "    float dotproduct = eyeLocal.z;\n"
+                                "    float len = length(eyeLocal);\n"
+                                "    if (dotproduct>p.w*len) return 0.0;\n"
+                                "    if (dotproduct<p.y*len) return 0.0;\n"
+                                "    if (dotproduct>p.z*len) return (dotproduct-p.w*len)/((p.z-p.w)*len);\n"
+                                "    if (dotproduct<p.x*len) return (dotproduct-p.y*len)/((p.x-p.y)*len);\n"
+                                "    return 1.0;\n"
+                                "}\n"
+                                "\n"
+                                "float coneSector(vec3 eyeLocal, vec4 axis, vec4 p)\n"
+                                "{\n"
+                                "    // p = (cosAngle, cosAngleFade, 0, 0)\n"
+                                "    float dotproduct = dot(eyeLocal, axis.xyz);\n"
+                                "    float len = length(eyeLocal);\n"
+                                "    if (dotproduct>p.x*len) return 1.0;\n"
+                                "    if (dotproduct<p.y*len) return 0.0;\n"
+                                "    return (dotproduct-p.y*len)/((p.x-p.y)*len);\n"
+                                "}\n"
+                                "\n"
+                                "float directionalSector(vec3 eyeLocal, vec4 row0, vec4 row1, vec4 row2, vec4 p)\n"
+                                "{\n"
+                                "    // p = (cosVertAngle, cosVertFadeAngle, cosHorizAngle, cosHorizFadeAngle)\n"
+                                "    vec3 ep = vec3(dot(row0.xyz, eyeLocal), dot(row1.xyz, eyeLocal), dot(row2.xyz, eyeLocal));\n"
+                                "\n"
+                                "    vec2 yz = safeNormalize(ep.yz);\n"
+                                "    if (yz.x<p.y) return 0.0;\n"
+                                "    float elevationIntensity = (yz.x<p.x) ? (yz.x-p.y)/(p.x-p.y) : 1.0;\n"
+                                "\n"
+                                "    vec2 xy = safeNormalize(ep.xy);\n"
+                                "    if (yz.x<0.0) xy = -xy;\n"
+                                "    if (xy.y<p.w) return 0.0;\n"
+                                "    float azimIntensity = (xy.y<p.z) ? (xy.y-p.w)/(p.z-p.w) : 1.0;\n"
+                                "\n"
+                                "    return elevationIntensity*azimIntensity;\n"
+                                "}\n"
+                                "\n"
+                                "float sectorIntensity(vec3 eyeLocal)\n"
+                                "{\n"
+                                "    float type = osgSim_LightPointParameters.z;\n"
+                                "    float index = osgSim_LightPointParameters.w;\n"
+                                "\n"
+                                "    if (type<0.5) return 1.0;\n"
+                                "    if (type<1.5) return azimSector(eyeLocal, lightPointData(index));\n"
+                                "    if (type<2.5) return elevationSector(eyeLocal, lightPointData(index+1.0));\n"
+                                "    if (type<3.5)\n"
+                                "    {\n"
+                                "        float azimIntensity = azimSector(eyeLocal, lightPointData(index));\n"
+                                "        if (azimIntensity==0.0) return 0.0;\n"
+                                "        return min(azimIntensity, elevationSector(eyeLocal, lightPointData(index+1.0)));\n"
+                                "    }\n"
+                                "    if (type<4.5) return coneSector(eyeLocal, lightPointData(index), lightPointData(index+1.0));\n"
+                                "    return directionalSector(eyeLocal, lightPointData(index), lightPointData(index+1.0), lightPointData(index+2.0), lightPointData(index+3.0));\n"
+                                "}\n"
+                                "\n"
+                                "vec4 blinkColor()\n"
+                                "{\n"
+                                "    float localTime = mod(osg_SimulationTime-osgSim_LightPointBlink.w, osgSim_LightPointBlink.z);\n"
+                                "    float index = osgSim_LightPointBlink.x;\n"
+                                "    for(int i=0; i<MAX_PULSES; ++i)\n"
+                                "    {\n"
+                                "        if (float(i)>=osgSim_LightPointBlink.y-1.0) break;\n"
+                                "\n"
+                                "        // each pulse is stored as its color followed by its length\n"
+                                "        float pulseLength = lightPointData(index+1.0).x;\n"
+                                "        if (localTime<=pulseLength) break;\n"
+                                "\n"
+                                "        localTime -= pulseLength;\n"
+                                "        index += 2.0;\n"
+                                "    }\n"
+                                "    return lightPointData(index);\n"
+                                "}\n"
+                                "\n"
+                                "void main(void)\n"
+                                "{\n"
+                                "    const float minimumIntensity = 1.0/256.0;\n"
+                                "\n"
+                                "    vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+                                "    gl_Position = gl_ProjectionMatrix * eye;\n"
+                                "\n"
+                                "#if !defined(GL_ES) && __VERSION__<140\n"
+                                "    gl_ClipVertex = eye;\n"
+                                "#endif\n"
+                                "\n"
+                                "    vec3 eyeLocal = (gl_ModelViewMatrixInverse * vec4(0.0, 0.0, 0.0, 1.0)).xyz - gl_Vertex.xyz;\n"
+                                "\n"
+                                "    float intensity = (osgSim_SystemIntensity>=0.0) ? osgSim_SystemIntensity : osgSim_LightPointParameters.x;\n"
+                                "\n"
+                                "    // clip on distance, fading out light points as they approach the limit\n"
+                                "    float distance2 = dot(eyeLocal, eyeLocal);\n"
+                                "    float distanceFactor = 1.0;\n"
+                                "    if (distance2>osgSim_PixelSizeRange.z) intensity = 0.0;\n"
+                                "    else if (osgSim_PixelSizeRange.z>0.0) distanceFactor = 1.0 - pow(distance2/osgSim_PixelSizeRange.z, 2.0);\n"
+                                "\n"
+                                "    if (intensity>minimumIntensity) intensity *= sectorIntensity(eyeLocal);\n"
+                                "\n"
+                                "    vec4 color = gl_Color;\n"
+                                "    if (osgSim_BlinkEnabled && osgSim_LightPointBlink.y>0.0) color *= blinkColor();\n"
+                                "\n"
+                                "    // size of the light point in pixels, matching osg::CullingSet::pixelSize()\n"
+                                "    vec2 scale = vec2(gl_ProjectionMatrix[0][0]*osgSim_ViewportSize.x, gl_ProjectionMatrix[1][1]*osgSim_ViewportSize.y)*0.5;\n"
+                                "    float pixelSize = osgSim_LightPointParameters.y*sqrt(2.0*dot(scale, scale))/abs(gl_Position.w);\n"
+                                "    if (intensity!=1.0) pixelSize *= sqrt(max(intensity, 0.0));\n"
+                                "\n"
+                                "    color.a *= distanceFactor;\n"
+                                "\n"
+                                "    float originalPixelSize = pixelSize;\n"
+                                "    pixelSize = max(pixelSize, osgSim_PixelSizeRange.x);\n"
+                                "\n"
+                                "    if (pixelSize<1.0)\n"
+                                "    {\n"
+                                "        color.a *= pixelSize;\n"
+                                "        pixelSize = 1.0;\n"
+                                "    }\n"
+                                "    else if (originalPixelSize<osgSim_PixelSizeRange.x)\n"
+                                "    {\n"
+                                "        color.a *= (2.0/3.0) + (1.0/3.0) * sqrt(originalPixelSize/pixelSize);\n"
+                                "    }\n"
+                                "\n"
+                                "    gl_PointSize = min(pixelSize, osgSim_PixelSizeRange.y);\n"
+                                "\n"
+                                "    if (intensity<=minimumIntensity || color.a<=minimumIntensity)\n"
+                                "    {\n"
+                                "        // move the light point outside the clip volume so that it is discarded\n"
+                                "        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n"
+                                "        color.a = 0.0;\n"
+                                "    }\n"
+                                "\n"
+                                "    vertexColor = color;\n"
+                                "}\n"
+                                "\n";
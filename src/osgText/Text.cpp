@@ -45,7 +45,8 @@ Text::Text():
     _colorGradientTopLeft(1.0f, 0.0f, 0.0f, 1.0f),
     _colorGradientBottomLeft(0.0f, 1.0f, 0.0f, 1.0f),
     _colorGradientBottomRight(0.0f, 0.0f, 1.0f, 1.0f),
-    _colorGradientTopRight(1.0f, 1.0f, 1.0f, 1.0f)
+    _colorGradientTopRight(1.0f, 1.0f, 1.0f, 1.0f),
+    _glyphLayoutAlignmentOffset(0.0f)
 {
     _supportsVertexBufferObjects = true;
 
@@ -73,7 +74,8 @@ Text::Text(const Text& text,const osg::CopyOp& copyop):
     _colorGradientTopLeft(text._colorGradientTopLeft),
     _colorGradientBottomLeft(text._colorGradientBottomLeft),
     _colorGradientBottomRight(text._colorGradientBottomRight),
-    _colorGradientTopRight(text._colorGradientTopRight)
+    _colorGradientTopRight(text._colorGradientTopRight),
+    _glyphLayoutAlignmentOffset(0.0f)
 {
     computeGlyphRepresentation();
 }
@@ -387,6 +389,51 @@ String::iterator Text::computeLastCharacterOnLine(osg::Vec2& cursor, String::ite
     return lastChar;
 }
 
+// Compute the coords and texture coords of a glyph quad whose bottom left corner is at local,
+// adjusted to avoid clipping the edges of antialiased characters.
+static void computeGlyphQuadCoords(const Glyph::TextureInfo* info, const osg::Vec2& local, float width, float height,
+                                   osg::Vec2& minc, osg::Vec2& maxc, osg::Vec2& mintc, osg::Vec2& maxtc)
+{
+    mintc = info->minTexCoord;
+    maxtc = info->maxTexCoord;
+    osg::Vec2 vDiff = maxtc - mintc;
+    float texelMargin = info->texelMargin;
+
+    float fHorizTCMargin = texelMargin / info->texture->getTextureWidth();
+    float fVertTCMargin = texelMargin / info->texture->getTextureHeight();
+    float fHorizQuadMargin = vDiff.x() == 0.0f ? 0.0f : width * fHorizTCMargin / vDiff.x();
+    float fVertQuadMargin = vDiff.y() == 0.0f ? 0.0f : height * fVertTCMargin / vDiff.y();
+
+    mintc.x() -= fHorizTCMargin;
+    mintc.y() -= fVertTCMargin;
+    maxtc.x() += fHorizTCMargin;
+    maxtc.y() += fVertTCMargin;
+    minc = local+osg::Vec2(0.0f-fHorizQuadMargin,0.0f-fVertQuadMargin);
+    maxc = local+osg::Vec2(width+fHorizQuadMargin,height+fVertQuadMargin);
+}
+
+// Compute the horizontal offset applied to a LEFT_TO_RIGHT line of the specified length to honour the alignment.
+static float computeLeftToRightAlignmentOffset(TextBase::AlignmentType alignment, float lineLength)
+{
+    switch(alignment)
+    {
+      case TextBase::CENTER_TOP:
+      case TextBase::CENTER_CENTER:
+      case TextBase::CENTER_BOTTOM:
+      case TextBase::CENTER_BASE_LINE:
+      case TextBase::CENTER_BOTTOM_BASE_LINE:
+        return -lineLength * 0.5f;
+      case TextBase::RIGHT_TOP:
+      case TextBase::RIGHT_CENTER:
+      case TextBase::RIGHT_BOTTOM:
+      case TextBase::RIGHT_BASE_LINE:
+      case TextBase::RIGHT_BOTTOM_BASE_LINE:
+        return -lineLength;
+      default:
+        return 0.0f;
+    }
+}
+
 void Text::addGlyphQuad(Glyph* glyph, const osg::Vec2& minc, const osg::Vec2& maxc, const osg::Vec2& mintc, const osg::Vec2& maxtc)
 {
     // set up the coords of the quad
@@ -456,6 +503,9 @@ void Text::computeGlyphRepresentation()
         }
     }
 
+    // only single line, LEFT_TO_RIGHT text has its layout recorded for use by computeIncrementalGlyphRepresentation()
+    _glyphLayouts.clear();
+    bool recordGlyphLayouts = _layout==LEFT_TO_RIGHT && _maximumWidth<=0.0f && _maximumHeight<=0.0f;
 
     _lineCount = 0;
 
@@ -598,6 +648,8 @@ void Text::computeGlyphRepresentation()
           }
         }
 
+        if (_lineCount==0) _glyphLayoutAlignmentOffset = cursor.x();
+
         if (itr!=endOfLine_itr)
         {
 
@@ -605,6 +657,11 @@ void Text::computeGlyphRepresentation()
             {
                 unsigned int charcode = *itr;
 
+                GlyphLayout glyphLayout;
+                glyphLayout.charcode = charcode;
+                glyphLayout.glyph = 0;
+                glyphLayout.texture = 0;
+
                 Glyph* glyph = activefont->getGlyph(_fontSize, charcode);
                 if (glyph)
                 {
@@ -648,27 +705,16 @@ void Text::computeGlyphRepresentation()
                     const Glyph::TextureInfo* info = glyph->getOrCreateTextureInfo(_shaderTechnique);
                     if (info)
                     {
-                        // Adjust coordinates and texture coordinates to avoid
-                        // clipping the edges of antialiased characters.
-                        osg::Vec2 mintc = info->minTexCoord;
-                        osg::Vec2 maxtc = info->maxTexCoord;
-                        osg::Vec2 vDiff = maxtc - mintc;
-                        float texelMargin = info->texelMargin;
-
-                        float fHorizTCMargin = texelMargin / info->texture->getTextureWidth();
-                        float fVertTCMargin = texelMargin / info->texture->getTextureHeight();
-                        float fHorizQuadMargin = vDiff.x() == 0.0f ? 0.0f : width * fHorizTCMargin / vDiff.x();
-                        float fVertQuadMargin = vDiff.y() == 0.0f ? 0.0f : height * fVertTCMargin / vDiff.y();
-
-                        mintc.x() -= fHorizTCMargin;
-                        mintc.y() -= fVertTCMargin;
-                        maxtc.x() += fHorizTCMargin;
-                        maxtc.y() += fVertTCMargin;
-                        osg::Vec2 minc = local+osg::Vec2(0.0f-fHorizQuadMargin,0.0f-fVertQuadMargin);
-                        osg::Vec2 maxc = local+osg::Vec2(width+fHorizQuadMargin,height+fVertQuadMargin);
+                        osg::Vec2 minc, maxc, mintc, maxtc;
+                        computeGlyphQuadCoords(info, local, width, height, minc, maxc, mintc, maxtc);
 
                         addGlyphQuad(glyph, minc, maxc, mintc, maxtc);
 
+                        osg::Vec2 alignmentOffset(_glyphLayoutAlignmentOffset, 0.0f);
+                        glyphLayout.texture = info->texture;
+                        glyphLayout.bbMin = local - alignmentOffset;
+                        glyphLayout.bbMax = local + osg::Vec2(width, height) - alignmentOffset;
+
                         // move the cursor onto the next character.
                         // also expand bounding box
                         switch(_layout)
@@ -694,8 +740,15 @@ void Text::computeGlyphRepresentation()
                         OSG_NOTICE<<"No TextureInfo for "<<charcode<<std::endl;
                     }
 
+                    glyphLayout.glyph = glyph;
                     previous_charcode = charcode;
                 }
+
+                if (recordGlyphLayouts)
+                {
+                    glyphLayout.cursor = cursor - osg::Vec2(_glyphLayoutAlignmentOffset, 0.0f);
+                    _glyphLayouts.push_back(glyphLayout);
+                }
             }
 
             // skip over spaces and return.
@@ -739,11 +792,287 @@ void Text::computeGlyphRepresentation()
         }
     }
 
+    if (_lineCount!=1 || _glyphLayouts.size()!=_text.size()) _glyphLayouts.clear();
+
+    computePositions();
+    computeColorGradients();
+
+    // set up the vertices for any boundinbox or alignment decoration
+    setupDecoration();
+}
+
+void Text::computeGlyphRepresentationForTextChange()
+{
+    if (!computeIncrementalGlyphRepresentation()) computeGlyphRepresentation();
+}
+
+bool Text::computeIncrementalGlyphRepresentation()
+{
+    if (_glyphLayouts.empty() || _layout!=LEFT_TO_RIGHT || _maximumWidth>0.0f || _maximumHeight>0.0f) return false;
+
+    Font* activefont = getActiveFont();
+    if (!activefont || !_coords || !_texcoords) return false;
+
+    // leave large text to computeGlyphRepresentation() as it may need to switch to DrawElementsUInt primitives.
+    unsigned int numCharacters = _text.size();
+    if (numCharacters*4>=16384) return false;
+
+    unsigned int firstChanged = 0;
+    while(firstChanged<numCharacters && firstChanged<_glyphLayouts.size() && _glyphLayouts[firstChanged].charcode==_text[firstChanged]) ++firstChanged;
+
+    // nothing can be reused
+    if (firstChanged==0) return false;
+
+    for(unsigned int i=firstChanged; i<numCharacters; ++i)
+    {
+        if (_text[i]=='\n') return false;
+    }
+
+    // glyph quads are added in character order so the quads of the unchanged characters come first in the vertex arrays.
+    unsigned int numPreviousQuads = 0;
+    unsigned int numUnchangedQuads = 0;
+    for(unsigned int i=0; i<_glyphLayouts.size(); ++i)
+    {
+        if (_glyphLayouts[i].texture)
+        {
+            ++numPreviousQuads;
+            if (i<firstChanged) ++numUnchangedQuads;
+        }
+    }
+
+    if (_coords->size()<numPreviousQuads*4 || _texcoords->size()<numPreviousQuads*4) return false;
+
+    float hr = _characterHeight;
+    float wr = hr/getCharacterAspectRatio();
+
+    unsigned int previous_charcode = 0;
+    for(unsigned int i=firstChanged; i>0 && previous_charcode==0; --i)
+    {
+        if (_glyphLayouts[i-1].glyph) previous_charcode = _glyphLayouts[i-1].charcode;
+    }
+
+    GlyphLayouts glyphLayouts(_glyphLayouts.begin(), _glyphLayouts.begin()+firstChanged);
+    osg::Vec2 cursor = glyphLayouts.back().cursor;
+
+    struct GlyphQuadCoords
+    {
+        osg::Vec2 minc, maxc, mintc, maxtc;
+    };
+    std::vector<GlyphQuadCoords> newQuads;
+
+    for(unsigned int i=firstChanged; i<numCharacters; ++i)
+    {
+        unsigned int charcode = _text[i];
+
+        GlyphLayout glyphLayout;
+        glyphLayout.charcode = charcode;
+        glyphLayout.glyph = 0;
+        glyphLayout.texture = 0;
+
+        Glyph* glyph = activefont->getGlyph(_fontSize, charcode);
+        if (glyph)
+        {
+            float width = (float)(glyph->getWidth()) * wr;
+            float height = (float)(glyph->getHeight()) * hr;
+
+            // adjust cursor position w.r.t any kerning.
+            if (previous_charcode)
+            {
+                osg::Vec2 delta(activefont->getKerning(_fontSize, previous_charcode, charcode, _kerningType));
+                cursor.x() += delta.x() * wr;
+                cursor.y() += delta.y() * hr;
+            }
+
+            osg::Vec2 local = cursor;
+            osg::Vec2 bearing(glyph->getHorizontalBearing());
+            local.x() += bearing.x() * wr;
+            local.y() += bearing.y() * hr;
+
+            const Glyph::TextureInfo* info = glyph->getOrCreateTextureInfo(_shaderTechnique);
+            if (info)
+            {
+                GlyphQuadCoords quad;
+                computeGlyphQuadCoords(info, local, width, height, quad.minc, quad.maxc, quad.mintc, quad.maxtc);
+                newQuads.push_back(quad);
+
+                glyphLayout.texture = info->texture;
+                glyphLayout.bbMin = local;
+                glyphLayout.bbMax = local + osg::Vec2(width, height);
+
+                cursor.x() += glyph->getHorizontalAdvance() * wr;
+            }
+            else
+            {
+                OSG_NOTICE<<"No TextureInfo for "<<charcode<<std::endl;
+            }
+
+            glyphLayout.glyph = glyph;
+            previous_charcode = charcode;
+        }
+
+        glyphLayout.cursor = cursor;
+        glyphLayouts.push_back(glyphLayout);
+    }
+
+    float alignmentOffset = computeLeftToRightAlignmentOffset(_alignment, cursor.x());
+    osg::Vec2 offset(alignmentOffset, 0.0f);
+
+    // the vertex arrays can be updated in place if the changed characters map to the same number of quads on the same textures.
+    bool updateInPlace = alignmentOffset==_glyphLayoutAlignmentOffset && (numPreviousQuads-numUnchangedQuads)==newQuads.size();
+    for(unsigned int i=firstChanged, j=firstChanged; updateInPlace && (i<_glyphLayouts.size() || j<glyphLayouts.size()); ++i, ++j)
+    {
+        while(i<_glyphLayouts.size() && !_glyphLayouts[i].texture) ++i;
+        while(j<glyphLayouts.size() && !glyphLayouts[j].texture) ++j;
+
+        if (i<_glyphLayouts.size() && j<glyphLayouts.size())
+        {
+            if (_glyphLayouts[i].texture!=glyphLayouts[j].texture) updateInPlace = false;
+        }
+        else if (i<_glyphLayouts.size() || j<glyphLayouts.size())
+        {
+            updateInPlace = false;
+        }
+    }
+
+    unsigned int firstCoord = numUnchangedQuads*4;
+    unsigned int numGlyphCoords = numPreviousQuads*4;
+
+    if (updateInPlace)
+    {
+        // remove any decoration vertices, setupDecoration() adds them back.
+        if (_coords->size()>numGlyphCoords) _coords->resize(numGlyphCoords);
+        if (_texcoords->size()>numGlyphCoords) _texcoords->resize(numGlyphCoords);
+
+        unsigned int c = firstCoord;
+        for(std::vector<GlyphQuadCoords>::iterator itr = newQuads.begin();
+            itr != newQuads.end();
+            ++itr, c+=4)
+        {
+            (*_coords)[c]   = osg::Vec3(itr->minc.x()+offset.x(), itr->maxc.y(), 0.0f);
+            (*_coords)[c+1] = osg::Vec3(itr->minc.x()+offset.x(), itr->minc.y(), 0.0f);
+            (*_coords)[c+2] = osg::Vec3(itr->maxc.x()+offset.x(), itr->minc.y(), 0.0f);
+            (*_coords)[c+3] = osg::Vec3(itr->maxc.x()+offset.x(), itr->maxc.y(), 0.0f);
+
+            (*_texcoords)[c]   = osg::Vec2(itr->mintc.x(), itr->maxtc.y());
+            (*_texcoords)[c+1] = osg::Vec2(itr->mintc.x(), itr->mintc.y());
+            (*_texcoords)[c+2] = osg::Vec2(itr->maxtc.x(), itr->mintc.y());
+            (*_texcoords)[c+3] = osg::Vec2(itr->maxtc.x(), itr->maxtc.y());
+        }
+
+        if (c>firstCoord)
+        {
+            _coords->dirtyRange(firstCoord*sizeof(osg::Vec3), (c-firstCoord)*sizeof(osg::Vec3));
+            _texcoords->dirtyRange(firstCoord*sizeof(osg::Vec2), (c-firstCoord)*sizeof(osg::Vec2));
+        }
+
+        for(TextureGlyphQuadMap::iterator itr = _textureGlyphQuadMap.begin();
+            itr != _textureGlyphQuadMap.end();
+            ++itr)
+        {
+            itr->second._glyphs.clear();
+        }
+
+        for(GlyphLayouts::iterator itr = glyphLayouts.begin();
+            itr != glyphLayouts.end();
+            ++itr)
+        {
+            if (itr->texture) _textureGlyphQuadMap[itr->texture]._glyphs.push_back(itr->glyph);
+        }
+    }
+    else
+    {
+        _coords->resize(firstCoord);
+        _texcoords->resize(firstCoord);
+
+        if (alignmentOffset!=_glyphLayoutAlignmentOffset)
+        {
+            float delta = alignmentOffset-_glyphLayoutAlignmentOffset;
+            for(osg::Vec3Array::iterator itr = _coords->begin();
+                itr != _coords->end();
+                ++itr)
+            {
+                itr->x() += delta;
+            }
+        }
+
+        _coords->dirty();
+        _texcoords->dirty();
+
+        for(TextureGlyphQuadMap::iterator itr = _textureGlyphQuadMap.begin();
+            itr != _textureGlyphQuadMap.end();
+            ++itr)
+        {
+            GlyphQuads& glyphquads = itr->second;
+            glyphquads._glyphs.clear();
+            if (glyphquads._primitives.valid())
+            {
+                glyphquads._primitives->resizeElements(0);
+                glyphquads._primitives->dirty();
+            }
+        }
+
+        // re-add the unchanged quads to the primitives, their coords are already in place
+        unsigned int c = 0;
+        for(unsigned int i=0; i<firstChanged; ++i)
+        {
+            const GlyphLayout& glyphLayout = glyphLayouts[i];
+            if (!glyphLayout.texture) continue;
+
+            GlyphQuads& glyphquad = _textureGlyphQuadMap[glyphLayout.texture];
+            glyphquad._glyphs.push_back(glyphLayout.glyph);
+
+            osg::DrawElements* primitives = glyphquad._primitives.get();
+            if (!primitives)
+            {
+                primitives = new osg::DrawElementsUShort(GL_TRIANGLES);
+                primitives->setBufferObject(_ebo.get());
+                glyphquad._primitives = primitives;
+            }
+
+            primitives->addElement(c);
+            primitives->addElement(c+1);
+            primitives->addElement(c+2);
+
+            primitives->addElement(c);
+            primitives->addElement(c+2);
+            primitives->addElement(c+3);
+
+            c += 4;
+        }
+
+        std::vector<GlyphQuadCoords>::iterator qitr = newQuads.begin();
+        for(unsigned int i=firstChanged; i<glyphLayouts.size(); ++i)
+        {
+            const GlyphLayout& glyphLayout = glyphLayouts[i];
+            if (!glyphLayout.texture) continue;
+
+            addGlyphQuad(glyphLayout.glyph, qitr->minc+offset, qitr->maxc+offset, qitr->mintc, qitr->maxtc);
+            ++qitr;
+        }
+    }
+
+    _glyphLayouts.swap(glyphLayouts);
+    _glyphLayoutAlignmentOffset = alignmentOffset;
+    _lineCount = 1;
+
+    _textBB.set(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    for(GlyphLayouts::iterator itr = _glyphLayouts.begin();
+        itr != _glyphLayouts.end();
+        ++itr)
+    {
+        if (!itr->texture) continue;
+
+        _textBB.expandBy(osg::Vec3(itr->bbMin.x()+offset.x(), itr->bbMin.y(), 0.0f));
+        _textBB.expandBy(osg::Vec3(itr->bbMax.x()+offset.x(), itr->bbMax.y(), 0.0f));
+    }
+
     computePositions();
     computeColorGradients();
 
     // set up the vertices for any boundinbox or alignment decoration
     setupDecoration();
+
+    return true;
 }
 
 // Returns false if there are no glyphs and the width/height values are invalid.
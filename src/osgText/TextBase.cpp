@@ -48,7 +48,8 @@ TextBase::TextBase():
     _textBBColor(0.0, 0.0, 0.0, 0.5),
     _kerningType(KERNING_DEFAULT),
     _lineCount(0),
-    _glyphNormalized(false)
+    _glyphNormalized(false),
+    _modifiedCount(0)
 {
     setUseDisplayList(false);
     setSupportsDisplayList(false);
@@ -79,7 +80,8 @@ TextBase::TextBase(const TextBase& textBase,const osg::CopyOp& copyop):
     _textBBColor(textBase._textBBColor),
     _kerningType(textBase._kerningType),
     _lineCount(textBase._lineCount),
-    _glyphNormalized(textBase._glyphNormalized)
+    _glyphNormalized(textBase._glyphNormalized),
+    _modifiedCount(0)
 {
     initArraysAndBuffers();
 }
@@ -183,7 +185,10 @@ void TextBase::releaseGLObjects(osg::State* state) const
 
 void TextBase::setColor(const osg::Vec4& color)
 {
+    if (_color==color) return;
+
     _color = color;
+    ++_modifiedCount;
 }
 
 void TextBase::assignStateSet()
@@ -266,7 +271,7 @@ void TextBase::setText(const String& text)
     if (_text==text) return;
 
     _text = text;
-    computeGlyphRepresentation();
+    computeGlyphRepresentationForTextChange();
 }
 
 void TextBase::setText(const std::string& text)
@@ -452,6 +457,8 @@ void TextBase::computePositions()
     osg::Matrix matrix;
     computeMatrix(matrix, 0);
 
+    ++_modifiedCount;
+
     const_cast<TextBase*>(this)->dirtyBound();
 }
 
@@ -0,0 +1,442 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgText/TextBatch>
+
+#include <osg/Depth>
+#include <osg/Notify>
+
+#include <osgUtil/CullVisitor>
+
+#include <osgDB/ReadFile>
+
+using namespace osgText;
+
+// vertex attribute locations used to pass the per label settings to the batch vertex shader
+static const unsigned int LABEL_POSITION_ATTRIBUTE = 6;
+static const unsigned int LABEL_PARAMETERS_ATTRIBUTE = 7;
+
+namespace
+{
+
+struct BatchBoundingBoxCallback : public osg::Drawable::ComputeBoundingBoxCallback
+{
+    // the batch vertices are relative to each label's position so the bounding box is
+    // accumulated from the labels bounding boxes into the initial bound instead.
+    virtual osg::BoundingBox computeBound(const osg::Drawable&) const { return osg::BoundingBox(); }
+};
+
+osg::Program* createTextBatchProgram()
+{
+    osg::ref_ptr<osg::Program> program = new osg::Program;
+
+    {
+        #include "shaders/osgText_TextBatch_vert.cpp"
+        program->addShader(osgDB::readRefShaderFileWithFallback(osg::Shader::VERTEX, "shaders/osgText_TextBatch.vert", osgText_TextBatch_vert));
+    }
+
+    {
+        #include "shaders/osgText_Text_frag.cpp"
+        program->addShader(osgDB::readRefShaderFileWithFallback(osg::Shader::FRAGMENT, "shaders/osgText_Text.frag", osgText_Text_frag));
+    }
+
+    program->addBindAttribLocation("osgText_LabelPosition", LABEL_POSITION_ATTRIBUTE);
+    program->addBindAttribLocation("osgText_LabelParameters", LABEL_PARAMETERS_ATTRIBUTE);
+
+    return program.release();
+}
+
+}
+
+TextBatch::TextBatch():
+    _labelsDirty(false),
+    _batchRoot(new osg::Group)
+{
+    setNumChildrenRequiringUpdateTraversal(1);
+
+    _program = createTextBatchProgram();
+}
+
+TextBatch::TextBatch(const TextBatch& tb, const osg::CopyOp& copyop):
+    osg::Node(tb, copyop),
+    _labels(tb._labels),
+    _labelsDirty(true),
+    _batchRoot(new osg::Group),
+    _program(tb._program)
+{
+    setNumChildrenRequiringUpdateTraversal(getNumChildrenRequiringUpdateTraversal()+1);
+
+    _labelRecords.resize(_labels.size());
+}
+
+TextBatch::~TextBatch()
+{
+}
+
+unsigned int TextBatch::addLabel(Text* text)
+{
+    if (!text) return getNumLabels();
+
+    _labels.push_back(text);
+
+    // the default LabelRecord won't match the text so the label's style will be rebuilt on the next update
+    _labelRecords.push_back(LabelRecord());
+
+    return getNumLabels()-1;
+}
+
+bool TextBatch::removeLabel(Text* text)
+{
+    unsigned int pos = getLabelIndex(text);
+    if (pos>=_labels.size()) return false;
+
+    _dirtyStyles.insert(_labelRecords[pos].stateset);
+
+    _labels.erase(_labels.begin()+pos);
+    _labelRecords.erase(_labelRecords.begin()+pos);
+
+    return true;
+}
+
+void TextBatch::removeAllLabels()
+{
+    _labels.clear();
+    _labelRecords.clear();
+    _labelsDirty = true;
+}
+
+void TextBatch::setLabels(const Labels& labels)
+{
+    _labels = labels;
+    _labelRecords.clear();
+    _labelRecords.resize(_labels.size());
+    _labelsDirty = true;
+}
+
+unsigned int TextBatch::getLabelIndex(const Text* text) const
+{
+    for(unsigned int i=0; i<_labels.size(); ++i)
+    {
+        if (_labels[i]==text) return i;
+    }
+    return getNumLabels();
+}
+
+void TextBatch::update()
+{
+    if (_labelsDirty)
+    {
+        // rebuild every existing style as well as the styles of all the current labels
+        for(StyleGroups::iterator itr = _styleGroups.begin();
+            itr != _styleGroups.end();
+            ++itr)
+        {
+            _dirtyStyles.insert(itr->first);
+        }
+
+        _labelsDirty = false;
+    }
+
+    for(unsigned int i=0; i<_labels.size(); ++i)
+    {
+        const Text* text = _labels[i].get();
+        LabelRecord& record = _labelRecords[i];
+
+        const osg::StateSet* stateset = text->getStateSet();
+        if (record.stateset!=stateset ||
+            record.modifiedCount!=text->getModifiedCount() ||
+            record.nodeMask!=text->getNodeMask())
+        {
+            _dirtyStyles.insert(record.stateset);
+            _dirtyStyles.insert(stateset);
+
+            record.stateset = stateset;
+            record.modifiedCount = text->getModifiedCount();
+            record.nodeMask = text->getNodeMask();
+        }
+    }
+
+    _dirtyStyles.erase(0);
+
+    if (_dirtyStyles.empty()) return;
+
+    for(DirtyStyles::iterator itr = _dirtyStyles.begin();
+        itr != _dirtyStyles.end();
+        ++itr)
+    {
+        rebuildStyle(*itr);
+    }
+
+    _dirtyStyles.clear();
+
+    dirtyBound();
+}
+
+osg::Group* TextBatch::getOrCreateStyleGroup(const osg::StateSet* textStateSet)
+{
+    osg::ref_ptr<osg::Group>& group = _styleGroups[textStateSet];
+    if (group.valid()) return group.get();
+
+    // copy the defines, modes and uniforms that Text sets up, replacing the Text program by the batch program.
+    osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet(*textStateSet, osg::CopyOp::SHALLOW_COPY);
+    stateset->setAttributeAndModes(_program.get());
+
+    // glyphs quads overlap, so without the second depth only pass that Text::drawImplementation() does
+    // depth writes have to be disabled to avoid neighbouring glyphs clipping each other.
+    stateset->setAttribute(new osg::Depth(osg::Depth::LESS, 0.0, 1.0, false));
+
+    group = new osg::Group;
+    group->setStateSet(stateset.get());
+
+    _batchRoot->addChild(group.get());
+
+    return group.get();
+}
+
+osg::Geometry* TextBatch::getOrCreateBatch(const osg::StateSet* textStateSet, GlyphTexture* glyphTexture)
+{
+    osg::ref_ptr<osg::Geometry>& geometry = _batches[BatchKey(textStateSet, glyphTexture)];
+    if (geometry.valid()) return geometry.get();
+
+    geometry = new osg::Geometry;
+    geometry->setDataVariance(osg::Object::DYNAMIC);
+    geometry->setUseDisplayList(false);
+    geometry->setUseVertexBufferObjects(true);
+    geometry->setComputeBoundingBoxCallback(new BatchBoundingBoxCallback);
+
+    osg::ref_ptr<osg::VertexBufferObject> vbo = new osg::VertexBufferObject;
+    vbo->setUsage(GL_DYNAMIC_DRAW_ARB);
+
+    osg::Vec3Array* vertices = new osg::Vec3Array;
+    vertices->setBufferObject(vbo.get());
+    geometry->setVertexArray(vertices);
+
+    osg::Vec4Array* colors = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+    colors->setBufferObject(vbo.get());
+    geometry->setColorArray(colors);
+
+    osg::Vec2Array* texcoords = new osg::Vec2Array(osg::Array::BIND_PER_VERTEX);
+    texcoords->setBufferObject(vbo.get());
+    geometry->setTexCoordArray(0, texcoords);
+
+    osg::Vec3Array* positions = new osg::Vec3Array(osg::Array::BIND_PER_VERTEX);
+    positions->setBufferObject(vbo.get());
+    geometry->setVertexAttribArray(LABEL_POSITION_ATTRIBUTE, positions);
+
+    osg::Vec4Array* parameters = new osg::Vec4Array(osg::Array::BIND_PER_VERTEX);
+    parameters->setBufferObject(vbo.get());
+    geometry->setVertexAttribArray(LABEL_PARAMETERS_ATTRIBUTE, parameters);
+
+    osg::ref_ptr<osg::ElementBufferObject> ebo = new osg::ElementBufferObject;
+    ebo->setUsage(GL_DYNAMIC_DRAW_ARB);
+
+    osg::DrawElementsUInt* primitives = new osg::DrawElementsUInt(GL_TRIANGLES);
+    primitives->setBufferObject(ebo.get());
+    geometry->addPrimitiveSet(primitives);
+
+    geometry->getOrCreateStateSet()->setTextureAttribute(0, glyphTexture);
+
+    getOrCreateStyleGroup(textStateSet)->addChild(geometry.get());
+
+    return geometry.get();
+}
+
+void TextBatch::rebuildStyle(const osg::StateSet* textStateSet)
+{
+    Batches::iterator begin = _batches.lower_bound(BatchKey(textStateSet, 0));
+
+    // reset the existing batches of this style, reusing the arrays and their buffer objects.
+    for(Batches::iterator itr = begin;
+        itr != _batches.end() && itr->first.first==textStateSet;
+        ++itr)
+    {
+        osg::Geometry* geometry = itr->second.get();
+        static_cast<osg::Vec3Array*>(geometry->getVertexArray())->clear();
+        static_cast<osg::Vec4Array*>(geometry->getColorArray())->clear();
+        static_cast<osg::Vec2Array*>(geometry->getTexCoordArray(0))->clear();
+        static_cast<osg::Vec3Array*>(geometry->getVertexAttribArray(LABEL_POSITION_ATTRIBUTE))->clear();
+        static_cast<osg::Vec4Array*>(geometry->getVertexAttribArray(LABEL_PARAMETERS_ATTRIBUTE))->clear();
+        static_cast<osg::DrawElementsUInt*>(geometry->getPrimitiveSet(0))->clear();
+        geometry->setInitialBound(osg::BoundingBox());
+    }
+
+    for(unsigned int i=0; i<_labels.size(); ++i)
+    {
+        const LabelRecord& record = _labelRecords[i];
+        if (record.stateset==textStateSet && record.nodeMask!=0)
+        {
+            addLabelToBatches(*_labels[i], textStateSet);
+        }
+    }
+
+    // dirty the updated batches and remove the ones that are now empty.
+    for(Batches::iterator itr = _batches.lower_bound(BatchKey(textStateSet, 0));
+        itr != _batches.end() && itr->first.first==textStateSet;
+        )
+    {
+        osg::Geometry* geometry = itr->second.get();
+        if (geometry->getVertexArray()->getNumElements()==0)
+        {
+            while(geometry->getNumParents()>0)
+            {
+                geometry->getParent(0)->removeChild(geometry);
+            }
+            _batches.erase(itr++);
+        }
+        else
+        {
+            geometry->getVertexArray()->dirty();
+            geometry->getColorArray()->dirty();
+            geometry->getTexCoordArray(0)->dirty();
+            geometry->getVertexAttribArray(LABEL_POSITION_ATTRIBUTE)->dirty();
+            geometry->getVertexAttribArray(LABEL_PARAMETERS_ATTRIBUTE)->dirty();
+            geometry->getPrimitiveSet(0)->dirty();
+            ++itr;
+        }
+    }
+
+    StyleGroups::iterator sitr = _styleGroups.find(textStateSet);
+    if (sitr!=_styleGroups.end() && sitr->second->getNumChildren()==0)
+    {
+        _batchRoot->removeChild(sitr->second.get());
+        _styleGroups.erase(sitr);
+    }
+}
+
+void TextBatch::addLabelToBatches(const Text& text, const osg::StateSet* textStateSet)
+{
+    const TextBase::Coords& coords = text.getCoords();
+    const TextBase::TexCoords& texcoords = text.getTexCoords();
+    const TextBase::ColorCoords& colorCoords = text.getColorCoords();
+    if (!coords || !texcoords || coords->empty()) return;
+
+    bool useColorCoords = text.getColorGradientMode()!=Text::SOLID && colorCoords.valid() && colorCoords->size()==coords->size();
+
+    const osg::Vec3& offset = text.getOffset();
+    const osg::Quat& rotation = text.getRotation();
+    const osg::Vec3& position = text.getPosition();
+    const osg::Vec4& color = text.getColor();
+    osg::Vec4 parameters(static_cast<float>(text.getCharacterSizeMode()),
+                         text.getAutoRotateToScreen() ? 1.0f : 0.0f,
+                         text.getCharacterHeight(),
+                         static_cast<float>(text.getFontHeight()));
+
+    const Text::TextureGlyphQuadMap& textureGlyphQuadMap = text.getTextureGlyphQuadMap();
+    for(Text::TextureGlyphQuadMap::const_iterator titr = textureGlyphQuadMap.begin();
+        titr != textureGlyphQuadMap.end();
+        ++titr)
+    {
+        const osg::DrawElements* textPrimitives = titr->second._primitives.get();
+        if (!textPrimitives || textPrimitives->getNumIndices()==0) continue;
+
+        osg::Geometry* geometry = getOrCreateBatch(textStateSet, titr->first.get());
+
+        osg::Vec3Array* batchVertices = static_cast<osg::Vec3Array*>(geometry->getVertexArray());
+        osg::Vec4Array* batchColors = static_cast<osg::Vec4Array*>(geometry->getColorArray());
+        osg::Vec2Array* batchTexCoords = static_cast<osg::Vec2Array*>(geometry->getTexCoordArray(0));
+        osg::Vec3Array* batchPositions = static_cast<osg::Vec3Array*>(geometry->getVertexAttribArray(LABEL_POSITION_ATTRIBUTE));
+        osg::Vec4Array* batchParameters = static_cast<osg::Vec4Array*>(geometry->getVertexAttribArray(LABEL_PARAMETERS_ATTRIBUTE));
+        osg::DrawElementsUInt* batchPrimitives = static_cast<osg::DrawElementsUInt*>(geometry->getPrimitiveSet(0));
+
+        // Text::addGlyphQuad() adds each glyph as 4 consecutive vertices, lt, lb, rb, rt, referenced by 6 indices.
+        for(unsigned int i=0; i+5<textPrimitives->getNumIndices(); i+=6)
+        {
+            unsigned int lt = textPrimitives->index(i);
+            if (lt+4>coords->size()) continue;
+
+            unsigned int base = static_cast<unsigned int>(batchVertices->size());
+            for(unsigned int v=lt; v<lt+4; ++v)
+            {
+                batchVertices->push_back(rotation*((*coords)[v]-offset));
+                batchTexCoords->push_back((*texcoords)[v]);
+                batchColors->push_back(useColorCoords ? (*colorCoords)[v] : color);
+                batchPositions->push_back(position);
+                batchParameters->push_back(parameters);
+            }
+
+            batchPrimitives->push_back(base);
+            batchPrimitives->push_back(base+1);
+            batchPrimitives->push_back(base+2);
+            batchPrimitives->push_back(base);
+            batchPrimitives->push_back(base+2);
+            batchPrimitives->push_back(base+3);
+        }
+
+        osg::BoundingBox bb = geometry->getInitialBound();
+        bb.expandBy(text.getBoundingBox());
+        geometry->setInitialBound(bb);
+    }
+}
+
+osg::StateSet* TextBatch::getOrCreateViewportStateSet(const osg::Viewport* viewport)
+{
+    // same default as used by TextBase::computeMatrix() when no viewport is available.
+    int width = viewport ? static_cast<int>(viewport->width()) : 1280;
+    int height = viewport ? static_cast<int>(viewport->height()) : 1024;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_viewportStateSetsMutex);
+
+    osg::ref_ptr<osg::StateSet>& stateset = _viewportStateSets[std::pair<int, int>(width, height)];
+    if (!stateset)
+    {
+        stateset = new osg::StateSet;
+        stateset->addUniform(new osg::Uniform("osgText_ViewportSize", osg::Vec2(static_cast<float>(width), static_cast<float>(height))));
+    }
+    return stateset.get();
+}
+
+void TextBatch::traverse(osg::NodeVisitor& nv)
+{
+    if (nv.getVisitorType()==osg::NodeVisitor::UPDATE_VISITOR)
+    {
+        update();
+    }
+
+    osgUtil::CullVisitor* cv = nv.asCullVisitor();
+    if (cv)
+    {
+        // the viewport dimensions are required to compute screen space character sizes on the GPU.
+        cv->pushStateSet(getOrCreateViewportStateSet(cv->getViewport()));
+
+        _batchRoot->accept(nv);
+
+        cv->popStateSet();
+    }
+    else
+    {
+        _batchRoot->accept(nv);
+    }
+}
+
+osg::BoundingSphere TextBatch::computeBound() const
+{
+    return _batchRoot->getBound();
+}
+
+void TextBatch::resizeGLObjectBuffers(unsigned int maxSize)
+{
+    Node::resizeGLObjectBuffers(maxSize);
+
+    _batchRoot->resizeGLObjectBuffers(maxSize);
+
+    if (_program.valid()) _program->resizeGLObjectBuffers(maxSize);
+}
+
+void TextBatch::releaseGLObjects(osg::State* state) const
+{
+    Node::releaseGLObjects(state);
+
+    _batchRoot->releaseGLObjects(state);
+
+    if (_program.valid()) _program->releaseGLObjects(state);
+}
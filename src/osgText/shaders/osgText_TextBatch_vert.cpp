@@ -0,0 +1,57 @@
+char osgText_TextBatch_vert[] = "$OSG_GLSL_VERSION\n"
+                                "$OSG_PRECISION_FLOAT\n"
+                                "\n"
+                                "#if __VERSION__>=130\n"
+                                "    #define ATTRIBUTE_IN in\n"
+                                "#else\n"
+                                "    #define ATTRIBUTE_IN attribute\n"
+                                "#endif\n"
+                                "\n"
+                                "uniform vec2 osgText_ViewportSize;\n"
+                                "\n"
+                                "// position of the label in model coordinates\n"
+                                "ATTRIBUTE_IN vec3 osgText_LabelPosition;\n"
+                                "\n"
+                                "// x = CharacterSizeMode, y = AutoRotateToScreen, z = CharacterHeight, w = FontHeight\n"
+                                "ATTRIBUTE_IN vec4 osgText_LabelParameters;\n"
+                                "\n"
+                                "$OSG_VARYING_OUT vec2 texCoord;\n"
+                                "$OSG_VARYING_OUT vec4 vertexColor;\n"
+                                "\n"
+                                "void main(void)\n"
+                                "{\n"
+                                "    vec3 local = gl_Vertex.xyz;\n"
+                                "    vec4 anchor = gl_ModelViewMatrix * vec4(osgText_LabelPosition, 1.0);\n"
+                                "\n"
+                                "    if (osgText_LabelParameters.x>0.5)\n"
+                                "    {\n"
+                                "        // size of a pixel in eye coordinates at the depth of the label\n"
+                                "        vec4 clipAnchor = gl_ProjectionMatrix * anchor;\n"
+                                "        vec2 pixelSize = 2.0 * abs(clipAnchor.w) / vec2(gl_ProjectionMatrix[0][0]*osgText_ViewportSize.x, gl_ProjectionMatrix[1][1]*osgText_ViewportSize.y);\n"
+                                "\n"
+                                "        if (osgText_LabelParameters.x<1.5)\n"
+                                "        {\n"
+                                "            // SCREEN_COORDS\n"
+                                "            local *= vec3(pixelSize.x, pixelSize.y, pixelSize.x);\n"
+                                "        }\n"
+                                "        else\n"
+                                "        {\n"
+                                "            // OBJECT_COORDS_WITH_MAXIMUM_SCREEN_SIZE_CAPPED_BY_FONT_HEIGHT\n"
+                                "            float pixelSizeVert = max(osgText_LabelParameters.z / pixelSize.y, 1.0);\n"
+                                "            if (pixelSizeVert>osgText_LabelParameters.w) local *= osgText_LabelParameters.w/pixelSizeVert;\n"
+                                "        }\n"
+                                "    }\n"
+                                "\n"
+                                "    vec4 eye;\n"
+                                "    if (osgText_LabelParameters.y>0.5) eye = anchor + vec4(local, 0.0);\n"
+                                "    else eye = gl_ModelViewMatrix * vec4(osgText_LabelPosition + local, 1.0);\n"
+                                "\n"
+                                "    gl_Position = gl_ProjectionMatrix * eye;\n"
+                                "    texCoord = gl_MultiTexCoord0.xy;\n"
+                                "    vertexColor = gl_Color;\n"
+                                "\n"
+                                "#if !defined(GL_ES) && __VERSION__<140\n"
+                                "    gl_ClipVertex = eye;\n"
+                                "#endif\n"
+                                "}\n"
+                                "\n";
@@ -16,6 +16,7 @@
 #include <osg/Notify>
 #include <osg/Timer>
 #include <osg/GLObjects>
+#include <osg/ContextData>
 #include <osg/Depth>
 #include <osg/ColorMask>
 #include <osg/ApplicationUsage>
@@ -24,6 +25,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <set>
 #include <stdlib.h>
 #include <string.h>
 
@@ -48,6 +50,8 @@ namespace osgUtil
 static osg::ApplicationUsageProxy ICO_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MINIMUM_COMPILE_TIME_PER_FRAME <float>","minimum compile time alloted to compiling OpenGL objects per frame in database pager.");
 static osg::ApplicationUsageProxy UCO_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_MAXIMUM_OBJECTS_TO_COMPILE_PER_FRAME <int>","maximum number of OpenGL objects to compile per frame in database pager.");
 static osg::ApplicationUsageProxy UCO_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FORCE_TEXTURE_DOWNLOAD <ON/OFF>","should the texture compiles be forced to download using a dummy Geometry.");
+static osg::ApplicationUsageProxy UCO_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_ENFORCE_COMPILE_TIME_BUDGET <ON/OFF>","should the per frame compile time be treated as a hard budget, splitting large texture and buffer uploads across frames.");
+static osg::ApplicationUsageProxy UCO_e5(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_STAGED_TEXTURE_UPLOAD <ON/OFF>","should texture images be uploaded asynchronously through a pool of staging pixel buffer objects.");
 
 /////////////////////////////////////////////////////////////////
 //
@@ -218,10 +222,464 @@ void StateToCompile::apply(osg::Texture& texture)
     _textures.insert(&texture);
 }
 
+/////////////////////////////////////////////////////////////////
+//
+// CompileCostCalibration
+//
+IncrementalCompileOperation::CompileCostCalibration::CompileCostCalibration()
+{
+}
+
+void IncrementalCompileOperation::CompileCostCalibration::Fit::add(double x, double y)
+{
+    // progressively discard older samples so that the fit follows changes in driver and bus load.
+    const double decay = 0.95;
+
+    weight = weight*decay + 1.0;
+    sumX = sumX*decay + x;
+    sumY = sumY*decay + y;
+    sumXX = sumXX*decay + x*x;
+    sumXY = sumXY*decay + x*y;
+    ++numSamples;
+}
+
+bool IncrementalCompileOperation::CompileCostCalibration::Fit::solve(double& constant, double& perByte) const
+{
+    const unsigned int minimumNumSamples = 3;
+    if (numSamples<minimumNumSamples || weight<=0.0) return false;
+
+    double det = weight*sumXX - sumX*sumX;
+    if (det > 1e-6*weight*sumXX)
+    {
+        perByte = (weight*sumXY - sumX*sumY)/det;
+        constant = (sumY - perByte*sumX)/weight;
+    }
+    else
+    {
+        // all samples uploaded the same amount of data so only the mean cost is known.
+        perByte = 0.0;
+        constant = sumY/weight;
+        if (sumX>0.0)
+        {
+            perByte = sumY/sumX;
+            constant = 0.0;
+        }
+    }
+
+    if (perByte<0.0)
+    {
+        perByte = (sumX>0.0) ? sumY/sumX : 0.0;
+        constant = (sumX>0.0) ? 0.0 : sumY/weight;
+    }
+
+    if (constant<0.0) constant = 0.0;
+
+    return true;
+}
+
+void IncrementalCompileOperation::CompileCostCalibration::record(const Key& key, unsigned int numBytes, double time)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _fits[key].add(double(numBytes), time);
+}
+
+bool IncrementalCompileOperation::CompileCostCalibration::estimateTime(const Key& key, unsigned int numBytes, double& time) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    Fits::const_iterator itr = _fits.find(key);
+    if (itr==_fits.end()) return false;
+
+    double constant, perByte;
+    if (!itr->second.solve(constant, perByte)) return false;
+
+    time = constant + perByte*double(numBytes);
+    return true;
+}
+
+bool IncrementalCompileOperation::CompileCostCalibration::estimateNumBytes(const Key& key, double time, unsigned int& numBytes) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    Fits::const_iterator itr = _fits.find(key);
+    if (itr==_fits.end()) return false;
+
+    double constant, perByte;
+    if (!itr->second.solve(constant, perByte) || perByte<=0.0) return false;
+
+    double bytes = (time - constant)/perByte;
+    if (bytes<=0.0) numBytes = 0;
+    else if (bytes>=4.0e9) numBytes = 0xffffffff;
+    else numBytes = static_cast<unsigned int>(bytes);
+    return true;
+}
+
+void IncrementalCompileOperation::CompileCostCalibration::clear()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    _fits.clear();
+}
+
+/////////////////////////////////////////////////////////////////
+//
+// StagingBufferPool
+//
+IncrementalCompileOperation::StagingBufferPool::StagingBufferPool(unsigned int maximumSize):
+    _maximumSize(maximumSize),
+    _totalSize(0)
+{
+}
+
+bool IncrementalCompileOperation::StagingBufferPool::isSupported(osg::State& state)
+{
+    const osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+    return extensions && extensions->isPBOSupported &&
+           extensions->glMapBufferRange && extensions->glUnmapBuffer &&
+           extensions->glFenceSync && extensions->glClientWaitSync && extensions->glDeleteSync;
+}
+
+IncrementalCompileOperation::StagingBufferPool::StagingBuffer* IncrementalCompileOperation::StagingBufferPool::acquire(osg::State& state, unsigned int size)
+{
+    osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+
+    state.unbindPixelBufferObject();
+
+    // look for the smallest free buffer that is large enough.
+    StagingBuffers::iterator best_itr = _freeBuffers.end();
+    for(StagingBuffers::iterator itr = _freeBuffers.begin();
+        itr != _freeBuffers.end();
+        ++itr)
+    {
+        if ((*itr)->size>=size && (best_itr==_freeBuffers.end() || (*itr)->size<(*best_itr)->size)) best_itr = itr;
+    }
+
+    osg::ref_ptr<StagingBuffer> buffer;
+    if (best_itr!=_freeBuffers.end())
+    {
+        buffer = *best_itr;
+        _freeBuffers.erase(best_itr);
+
+        extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, buffer->id);
+    }
+    else
+    {
+        // round up the allocation to reduce the number of different buffer sizes in the pool.
+        const unsigned int granularity = 65536;
+        unsigned int allocationSize = ((size+granularity-1)/granularity)*granularity;
+
+        // make room by deleting free buffers, all of which are too small for this request.
+        while(_totalSize+allocationSize>_maximumSize && !_freeBuffers.empty())
+        {
+            deleteBuffer(state, _freeBuffers.back().get());
+            _freeBuffers.pop_back();
+        }
+
+        if (_totalSize+allocationSize>_maximumSize) return 0;
+
+        buffer = new StagingBuffer;
+        buffer->size = allocationSize;
+
+        extensions->glGenBuffers(1, &(buffer->id));
+        extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, buffer->id);
+        extensions->glBufferData(GL_PIXEL_UNPACK_BUFFER_ARB, buffer->size, 0, GL_STREAM_DRAW_ARB);
+
+        _totalSize += allocationSize;
+    }
+
+    buffer->mappedData = extensions->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER_ARB, 0, buffer->size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+
+    if (!buffer->mappedData)
+    {
+        OSG_INFO<<"IncrementalCompileOperation::StagingBufferPool::acquire() failed to map staging buffer."<<std::endl;
+        _freeBuffers.push_back(buffer);
+        return 0;
+    }
+
+    buffer->copyCompleted.exchange(0);
+    _activeBuffers.push_back(buffer);
+
+    return buffer.get();
+}
+
+void IncrementalCompileOperation::StagingBufferPool::submit(osg::State& state, StagingBuffer* buffer, const osg::Texture2D& texture)
+{
+    osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+
+    StagingBuffers::iterator itr = std::find(_activeBuffers.begin(), _activeBuffers.end(), buffer);
+    if (itr==_activeBuffers.end()) return;
+
+    osg::ref_ptr<StagingBuffer> keep(buffer);
+    _activeBuffers.erase(itr);
+
+    state.unbindPixelBufferObject();
+
+    extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, buffer->id);
+    extensions->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+    extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+    buffer->mappedData = 0;
+
+    bool uploaded = texture.applyFromPixelUnpackBuffer(state, buffer->id);
+
+    if (!uploaded)
+    {
+        // the texture has been compiled elsewhere or changed since the copy was started.
+        texture.apply(state);
+    }
+
+    buffer->fence = extensions->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _inFlightBuffers.push_back(buffer);
+}
+
+void IncrementalCompileOperation::StagingBufferPool::recycle(osg::State& state)
+{
+    osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+
+    for(StagingBuffers::iterator itr = _inFlightBuffers.begin();
+        itr != _inFlightBuffers.end();
+        )
+    {
+        StagingBuffer* buffer = itr->get();
+        GLenum result = buffer->fence ? extensions->glClientWaitSync(buffer->fence, 0, 0) : GL_ALREADY_SIGNALED;
+        if (result==GL_ALREADY_SIGNALED || result==GL_CONDITION_SATISFIED)
+        {
+            if (buffer->fence) extensions->glDeleteSync(buffer->fence);
+            buffer->fence = 0;
+
+            _freeBuffers.push_back(buffer);
+            itr = _inFlightBuffers.erase(itr);
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+
+    // buffers only referenced by the pool have been abandoned by their compile and finished by the staging thread.
+    for(StagingBuffers::iterator itr = _activeBuffers.begin();
+        itr != _activeBuffers.end();
+        )
+    {
+        StagingBuffer* buffer = itr->get();
+        if (buffer->referenceCount()==1)
+        {
+            state.unbindPixelBufferObject();
+
+            extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, buffer->id);
+            extensions->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+            extensions->glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+            buffer->mappedData = 0;
+
+            _freeBuffers.push_back(buffer);
+            itr = _activeBuffers.erase(itr);
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+}
+
+namespace
+{
+
+// Deletes the staging buffers, and their fences, of pools released while their graphics context isn't current,
+// the next time the context flushes its deleted GL objects.
+class GLStagingBufferManager : public osg::GLObjectManager
+{
+public:
+    GLStagingBufferManager(unsigned int contextID) : osg::GLObjectManager("GLStagingBufferManager", contextID) {}
+
+    void scheduleFenceForDeletion(GLsync fence)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _deleteFences.push_back(fence);
+    }
+
+    virtual void flushDeletedGLObjects(double currentTime, double& availableTime)
+    {
+        deleteFences();
+        osg::GLObjectManager::flushDeletedGLObjects(currentTime, availableTime);
+    }
+
+    virtual void flushAllDeletedGLObjects()
+    {
+        deleteFences();
+        osg::GLObjectManager::flushAllDeletedGLObjects();
+    }
+
+    virtual void discardAllGLObjects()
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            _deleteFences.clear();
+        }
+        osg::GLObjectManager::discardAllGLObjects();
+    }
+
+    virtual void deleteGLObject(GLuint globj)
+    {
+        const osg::GLExtensions* extensions = osg::GLExtensions::Get(_contextID, true);
+        if (extensions->isPBOSupported) extensions->glDeleteBuffers(1, &globj);
+    }
+
+protected:
+
+    void deleteFences()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        if (_deleteFences.empty()) return;
+
+        const osg::GLExtensions* extensions = osg::GLExtensions::Get(_contextID, true);
+        for(std::vector<GLsync>::iterator itr = _deleteFences.begin();
+            itr != _deleteFences.end();
+            ++itr)
+        {
+            if (extensions->glDeleteSync) extensions->glDeleteSync(*itr);
+        }
+        _deleteFences.clear();
+    }
+
+    std::vector<GLsync> _deleteFences;
+};
+
+}
+
+void IncrementalCompileOperation::StagingBufferPool::releaseGLObjects(unsigned int contextID)
+{
+    GLStagingBufferManager* manager = osg::get<GLStagingBufferManager>(contextID);
+
+    StagingBuffers buffers;
+    buffers.insert(buffers.end(), _freeBuffers.begin(), _freeBuffers.end());
+    buffers.insert(buffers.end(), _activeBuffers.begin(), _activeBuffers.end());
+    buffers.insert(buffers.end(), _inFlightBuffers.begin(), _inFlightBuffers.end());
+
+    for(StagingBuffers::iterator itr = buffers.begin();
+        itr != buffers.end();
+        ++itr)
+    {
+        StagingBuffer* buffer = itr->get();
+
+        // the staging thread may still be writing into a mapped buffer, which deleting it would unmap.
+        if (buffer->mappedData)
+        {
+            while(buffer->copyCompleted==0) OpenThreads::Thread::YieldCurrentThread();
+            buffer->mappedData = 0;
+        }
+
+        if (buffer->fence) manager->scheduleFenceForDeletion(buffer->fence);
+        buffer->fence = 0;
+
+        if (buffer->id) manager->scheduleGLObjectForDeletion(buffer->id);
+        buffer->id = 0;
+    }
+
+    _freeBuffers.clear();
+    _activeBuffers.clear();
+    _inFlightBuffers.clear();
+    _totalSize = 0;
+}
+
+void IncrementalCompileOperation::StagingBufferPool::deleteBuffer(osg::State& state, StagingBuffer* buffer)
+{
+    osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+    extensions->glDeleteBuffers(1, &(buffer->id));
+    buffer->id = 0;
+
+    _totalSize -= buffer->size;
+}
+
+struct StagingCopyOperation : public osg::Operation
+{
+    StagingCopyOperation(const osg::Image* image, IncrementalCompileOperation::StagingBufferPool::StagingBuffer* buffer):
+        osg::Operation("StagingCopyOperation", false),
+        _image(image),
+        _buffer(buffer) {}
+
+    virtual void operator () (osg::Object*)
+    {
+        memcpy(_buffer->mappedData, _image->data(), _image->getTotalSizeInBytesIncludingMipmaps());
+        _buffer->copyCompleted.exchange(1);
+    }
+
+    osg::ref_ptr<const osg::Image> _image;
+    osg::ref_ptr<IncrementalCompileOperation::StagingBufferPool::StagingBuffer> _buffer;
+};
+
 /////////////////////////////////////////////////////////////////
 //
 // CompileOps
 //
+typedef std::set<osg::BufferObject*> BufferObjects;
+
+static void collectBufferObjects(const osg::Geometry& geometry, BufferObjects& bufferObjects)
+{
+    const osg::Array* arrays[] = { geometry.getVertexArray(), geometry.getNormalArray(), geometry.getColorArray(),
+                                   geometry.getSecondaryColorArray(), geometry.getFogCoordArray() };
+    for(unsigned int i=0; i<sizeof(arrays)/sizeof(arrays[0]); ++i)
+    {
+        if (arrays[i] && arrays[i]->getBufferObject()) bufferObjects.insert(const_cast<osg::BufferObject*>(arrays[i]->getBufferObject()));
+    }
+
+    for(osg::Geometry::ArrayList::const_iterator itr = geometry.getTexCoordArrayList().begin();
+        itr != geometry.getTexCoordArrayList().end();
+        ++itr)
+    {
+        if (itr->valid() && (*itr)->getBufferObject()) bufferObjects.insert(const_cast<osg::BufferObject*>((*itr)->getBufferObject()));
+    }
+
+    for(osg::Geometry::ArrayList::const_iterator itr = geometry.getVertexAttribArrayList().begin();
+        itr != geometry.getVertexAttribArrayList().end();
+        ++itr)
+    {
+        if (itr->valid() && (*itr)->getBufferObject()) bufferObjects.insert(const_cast<osg::BufferObject*>((*itr)->getBufferObject()));
+    }
+
+    for(osg::Geometry::PrimitiveSetList::const_iterator itr = geometry.getPrimitiveSetList().begin();
+        itr != geometry.getPrimitiveSetList().end();
+        ++itr)
+    {
+        if ((*itr)->getBufferObject()) bufferObjects.insert(const_cast<osg::BufferObject*>((*itr)->getBufferObject()));
+    }
+}
+
+static unsigned int computeTotalDataSize(const BufferObjects& bufferObjects)
+{
+    unsigned int totalSize = 0;
+    for(BufferObjects::const_iterator itr = bufferObjects.begin();
+        itr != bufferObjects.end();
+        ++itr)
+    {
+        for(unsigned int i=0; i<(*itr)->getNumBufferData(); ++i)
+        {
+            const osg::BufferData* bd = (*itr)->getBufferData(i);
+            if (bd) totalSize += bd->getTotalDataSize();
+        }
+    }
+    return totalSize;
+}
+
+static unsigned int computeTotalDataSize(const osg::Texture& texture)
+{
+    unsigned int totalSize = 0;
+    for(unsigned int i=0; i<texture.getNumImages(); ++i)
+    {
+        const osg::Image* image = texture.getImage(i);
+        if (image) totalSize += image->getTotalSizeInBytesIncludingMipmaps();
+    }
+    return totalSize;
+}
+
+static IncrementalCompileOperation::CompileCostCalibration::Key computeCompileCostKey(unsigned int contextID, const osg::Texture& texture)
+{
+    GLenum format = texture.getInternalFormat();
+    if (format==0 && texture.getNumImages()>0 && texture.getImage(0)) format = texture.getImage(0)->getInternalTextureFormat();
+    return IncrementalCompileOperation::CompileCostCalibration::Key(contextID, IncrementalCompileOperation::CompileCostCalibration::TEXTURE_OBJECT, texture.getTextureTarget(), format);
+}
+
+static IncrementalCompileOperation::CompileCostCalibration::Key computeCompileCostKey(unsigned int contextID, bool useVertexBufferObjects)
+{
+    return IncrementalCompileOperation::CompileCostCalibration::Key(contextID, IncrementalCompileOperation::CompileCostCalibration::BUFFER_OBJECT, useVertexBufferObjects ? GL_ARRAY_BUFFER_ARB : 0, 0);
+}
+
 IncrementalCompileOperation::CompileDrawableOp::CompileDrawableOp(osg::Drawable* drawable):
     _drawable(drawable)
 {
@@ -229,38 +687,189 @@ IncrementalCompileOperation::CompileDrawableOp::CompileDrawableOp(osg::Drawable*
 
 double IncrementalCompileOperation::CompileDrawableOp::estimatedTimeForCompile(CompileInfo& compileInfo) const
 {
-    osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
     osg::Geometry* geometry = _drawable->asGeometry();
-    if (gce && geometry)
+    if (!geometry) return 0.0;
+
+    BufferObjects bufferObjects;
+    collectBufferObjects(*geometry, bufferObjects);
+
+    double time = 0.0;
+    bool useVBO = compileInfo.getState()->useVertexBufferObject(geometry->getUseVertexBufferObjects());
+    if (compileInfo.incrementalCompileOperation->getCompileCostCalibration()->estimateTime(computeCompileCostKey(compileInfo.getState()->getContextID(), useVBO),
+                                                                                            computeTotalDataSize(bufferObjects), time))
+    {
+        return time;
+    }
+
+    osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
+    if (gce)
     {
         return gce->estimateCompileCost(geometry).first;
     }
     else return 0.0;
 }
 
+bool IncrementalCompileOperation::CompileDrawableOp::supportsPartialCompile(CompileInfo& compileInfo) const
+{
+    osg::Geometry* geometry = _drawable->asGeometry();
+    return geometry && compileInfo.getState()->useVertexBufferObject(geometry->getUseVertexBufferObjects());
+}
+
 bool IncrementalCompileOperation::CompileDrawableOp::compile(CompileInfo& compileInfo)
 {
     //OSG_NOTICE<<"CompileDrawableOp::compile(..)"<<std::endl;
+    osg::State& state = *compileInfo.getState();
+    osg::Geometry* geometry = _drawable->asGeometry();
+    bool useVBO = geometry && state.useVertexBufferObject(geometry->getUseVertexBufferObjects());
+
+    CompileCostCalibration::Key key = computeCompileCostKey(state.getContextID(), useVBO);
+    osg::ElapsedTime timer;
+
+    BufferObjects bufferObjects;
+    if (geometry) collectBufferObjects(*geometry, bufferObjects);
+
+    if (useVBO && compileInfo.budgetEnforced())
+    {
+        osg::GLExtensions* extensions = state.get<osg::GLExtensions>();
+        unsigned int maxUploadSize = compileInfo.computeMaximumUploadSize(key);
+        unsigned int totalUploaded = 0;
+        bool complete = true;
+
+        for(BufferObjects::iterator itr = bufferObjects.begin();
+            itr != bufferObjects.end();
+            ++itr)
+        {
+            osg::GLBufferObject* glBufferObject = (*itr)->getOrCreateGLBufferObject(state.getContextID());
+            if (!glBufferObject || !glBufferObject->isDirty()) continue;
+
+            unsigned int numBytesUploaded = 0;
+            unsigned int uploadSize = (totalUploaded<maxUploadSize) ? maxUploadSize-totalUploaded : 0;
+            if (uploadSize==0 || !glBufferObject->compileBufferIncrementally(uploadSize, numBytesUploaded))
+            {
+                complete = false;
+            }
+            totalUploaded += numBytesUploaded;
+        }
+
+        if (!complete)
+        {
+            extensions->glBindBuffer(GL_ARRAY_BUFFER_ARB,0);
+            extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER_ARB,0);
+
+            ++compileInfo.stats.numPartialUploads;
+            compileInfo.stats.numBytesUploaded += totalUploaded;
+            compileInfo.incrementalCompileOperation->getCompileCostCalibration()->record(key, totalUploaded, timer.elapsedTime());
+            return false;
+        }
+
+        // the buffers are complete, the remaining compileGLObjects() sets up the vertex array objects.
+        _drawable->compileGLObjects(compileInfo);
+
+        compileInfo.stats.numBytesUploaded += totalUploaded;
+        compileInfo.incrementalCompileOperation->getCompileCostCalibration()->record(key, totalUploaded, timer.elapsedTime());
+        return true;
+    }
+
+    unsigned int totalDataSize = computeTotalDataSize(bufferObjects);
+
     _drawable->compileGLObjects(compileInfo);
+
+    compileInfo.stats.numBytesUploaded += totalDataSize;
+    compileInfo.incrementalCompileOperation->getCompileCostCalibration()->record(key, totalDataSize, timer.elapsedTime());
     return true;
 }
 
 IncrementalCompileOperation::CompileTextureOp::CompileTextureOp(osg::Texture* texture):
-    _texture(texture)
+    _texture(texture),
+    _uploadedSize(0)
 {
 }
 
 double IncrementalCompileOperation::CompileTextureOp::estimatedTimeForCompile(CompileInfo& compileInfo) const
 {
+    unsigned int totalDataSize = computeTotalDataSize(*_texture);
+    unsigned int remainingDataSize = totalDataSize>_uploadedSize ? totalDataSize-_uploadedSize : 0;
+
+    double time = 0.0;
+    if (compileInfo.incrementalCompileOperation->getCompileCostCalibration()->estimateTime(computeCompileCostKey(compileInfo.getState()->getContextID(), *_texture),
+                                                                                            remainingDataSize, time))
+    {
+        return time;
+    }
+
     osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
     if (gce) return gce->estimateCompileCost(_texture.get()).first;
     else return 0.0;
 }
 
+bool IncrementalCompileOperation::CompileTextureOp::supportsPartialCompile(CompileInfo& compileInfo) const
+{
+    return dynamic_cast<osg::Texture2D*>(_texture.get())!=0 &&
+           compileInfo.incrementalCompileOperation->getForceTextureDownloadGeometry()==0;
+}
+
 bool IncrementalCompileOperation::CompileTextureOp::compile(CompileInfo& compileInfo)
 {
     //OSG_NOTICE<<"CompileTextureOp::compile(..)"<<std::endl;
+    CompileCostCalibration::Key key = computeCompileCostKey(compileInfo.getState()->getContextID(), *_texture);
+    unsigned int totalDataSize = computeTotalDataSize(*_texture);
+    osg::ElapsedTime timer;
+
     osg::Geometry* forceDownloadGeometry = compileInfo.incrementalCompileOperation->getForceTextureDownloadGeometry();
+    osg::Texture2D* texture2D = dynamic_cast<osg::Texture2D*>(_texture.get());
+    if (texture2D && !forceDownloadGeometry && _uploadedSize==0 &&
+        (_stagingBuffer.valid() || compileInfo.incrementalCompileOperation->getUseStagedTextureUploads()))
+    {
+        IncrementalCompileOperation* ico = compileInfo.incrementalCompileOperation;
+        osg::State& state = *compileInfo.getState();
+
+        if (_stagingBuffer.valid())
+        {
+            // wait for the staging thread to finish copying the image data.
+            if (_stagingBuffer->copyCompleted==0) return false;
+
+            // uploads sourced from staging buffers aren't recorded as their cost isn't representative of direct uploads.
+            ico->getOrCreateStagingBufferPool(state)->submit(state, _stagingBuffer.get(), *texture2D);
+            _stagingBuffer = 0;
+
+            ++compileInfo.stats.numStagedUploads;
+            compileInfo.stats.numBytesUploaded += totalDataSize;
+            return true;
+        }
+
+        osg::Image* image = texture2D->getImage();
+        StagingBufferPool* pool = ico->getOrCreateStagingBufferPool(state);
+        if (pool && image && totalDataSize<=pool->getMaximumSize() &&
+            !texture2D->getTextureObject(state.getContextID()) && texture2D->isSubImageUploadSupported(state))
+        {
+            // if the pool is exhausted try again once buffers in flight have been recycled.
+            _stagingBuffer = pool->acquire(state, image->getTotalSizeInBytesIncludingMipmaps());
+            if (!_stagingBuffer) return false;
+
+            ico->copyToStagingBuffer(image, _stagingBuffer.get());
+            return false;
+        }
+    }
+
+    if (texture2D && !forceDownloadGeometry && compileInfo.budgetEnforced())
+    {
+        unsigned int previouslyUploaded = _uploadedSize;
+        bool complete = texture2D->applyIncrementally(*compileInfo.getState(), compileInfo.computeMaximumUploadSize(key), _uploadedSize);
+
+        // applyIncrementally() falls back to a full apply() for textures that can't be split.
+        unsigned int numBytesUploaded = (complete && previouslyUploaded==0) ? totalDataSize : _uploadedSize-previouslyUploaded;
+
+        compileInfo.stats.numBytesUploaded += numBytesUploaded;
+        compileInfo.incrementalCompileOperation->getCompileCostCalibration()->record(key, numBytesUploaded, timer.elapsedTime());
+
+        if (!complete)
+        {
+            ++compileInfo.stats.numPartialUploads;
+            return false;
+        }
+        return true;
+    }
+
     if (forceDownloadGeometry)
     {
 
@@ -279,6 +888,9 @@ bool IncrementalCompileOperation::CompileTextureOp::compile(CompileInfo& compile
     {
         _texture->apply(*compileInfo.getState());
     }
+
+    compileInfo.stats.numBytesUploaded += totalDataSize;
+    compileInfo.incrementalCompileOperation->getCompileCostCalibration()->record(key, totalDataSize, timer.elapsedTime());
     return true;
 }
 
@@ -289,6 +901,13 @@ IncrementalCompileOperation::CompileProgramOp::CompileProgramOp(osg::Program* pr
 
 double IncrementalCompileOperation::CompileProgramOp::estimatedTimeForCompile(CompileInfo& compileInfo) const
 {
+    double time = 0.0;
+    CompileCostCalibration::Key key(compileInfo.getState()->getContextID(), CompileCostCalibration::PROGRAM_OBJECT);
+    if (compileInfo.incrementalCompileOperation->getCompileCostCalibration()->estimateTime(key, 0, time))
+    {
+        return time;
+    }
+
     osg::GraphicsCostEstimator* gce = compileInfo.getState()->getGraphicsCostEstimator();
     if (gce) return gce->estimateCompileCost(_program.get()).first;
     else return 0.0;
@@ -297,12 +916,18 @@ double IncrementalCompileOperation::CompileProgramOp::estimatedTimeForCompile(Co
 bool IncrementalCompileOperation::CompileProgramOp::compile(CompileInfo& compileInfo)
 {
     //OSG_NOTICE<<"CompileProgramOp::compile(..)"<<std::endl;
+    osg::ElapsedTime timer;
+
     _program->compileGLObjects(*compileInfo.getState());
+
+    CompileCostCalibration::Key key(compileInfo.getState()->getContextID(), CompileCostCalibration::PROGRAM_OBJECT);
+    compileInfo.incrementalCompileOperation->getCompileCostCalibration()->record(key, 0, timer.elapsedTime());
     return true;
 }
 
 IncrementalCompileOperation::CompileInfo::CompileInfo(osg::GraphicsContext* context, IncrementalCompileOperation* ico):
     compileAll(false),
+    enforceCompileTimeBudget(false),
     maxNumObjectsToCompile(0),
     allocatedTime(0)
 {
@@ -310,6 +935,20 @@ IncrementalCompileOperation::CompileInfo::CompileInfo(osg::GraphicsContext* cont
     incrementalCompileOperation = ico;
 }
 
+unsigned int IncrementalCompileOperation::CompileInfo::computeMaximumUploadSize(const CompileCostCalibration::Key& key) const
+{
+    unsigned int minimumUploadSize = incrementalCompileOperation->getMinimumUploadSize();
+
+    unsigned int numBytes = 0;
+    if (incrementalCompileOperation->getCompileCostCalibration()->estimateNumBytes(key, timeRemaining(), numBytes))
+    {
+        return osg::maximum(numBytes, minimumUploadSize);
+    }
+
+    // until the upload cost has been calibrated stick to small uploads.
+    return minimumUploadSize;
+}
+
 
 /////////////////////////////////////////////////////////////////
 //
@@ -342,35 +981,31 @@ double IncrementalCompileOperation::CompileList::estimatedTimeForCompile(Compile
 
 bool IncrementalCompileOperation::CompileList::compile(CompileInfo& compileInfo)
 {
-//#define USE_TIME_ESTIMATES
-
     for(CompileOps::iterator itr = _compileOps.begin();
         itr != _compileOps.end() && compileInfo.okToCompile();
     )
     {
-        #ifdef USE_TIME_ESTIMATES
-        double estimatedCompileCost = (*itr)->estimatedTimeForCompile(compileInfo);
-        #endif
+        if (compileInfo.budgetEnforced() && !(*itr)->supportsPartialCompile(compileInfo))
+        {
+            // leave compiles that won't fit in the time remaining to a later frame, but always make some progress each frame.
+            bool compiledThisFrame = compileInfo.stats.numObjectsCompiled>0 || compileInfo.stats.numPartialUploads>0;
+            if (compiledThisFrame && (*itr)->estimatedTimeForCompile(compileInfo)>compileInfo.timeRemaining())
+            {
+                ++compileInfo.stats.numObjectsDeferred;
+                ++itr;
+                continue;
+            }
+        }
 
         --compileInfo.maxNumObjectsToCompile;
 
-        #ifdef USE_TIME_ESTIMATES
-        osg::ElapsedTime timer;
-        #endif
-
         CompileOps::iterator saved_itr(itr);
         ++itr;
         if ((*saved_itr)->compile(compileInfo))
         {
+            ++compileInfo.stats.numObjectsCompiled;
             _compileOps.erase(saved_itr);
         }
-
-        #ifdef USE_TIME_ESTIMATES
-        double actualCompileCost = timer.elapsedTime();
-        OSG_NOTICE<<"IncrementalCompileOperation::CompileList::compile() estimatedTimForCompile = "<<estimatedCompileCost*1000.0<<"ms, actual = "<<actualCompileCost*1000.0<<"ms";
-        if (estimatedCompileCost>0.0) OSG_NOTICE<<", ratio="<<(actualCompileCost/estimatedCompileCost);
-        OSG_NOTICE<<std::endl;
-        #endif
     }
     return empty();
 }
@@ -450,9 +1085,15 @@ IncrementalCompileOperation::IncrementalCompileOperation():
     osg::GraphicsOperation("IncrementalCompileOperation",true),
     _flushTimeRatio(0.5),
     _conservativeTimeRatio(0.5),
+    _enforceCompileTimeBudget(false),
+    _minimumUploadSize(65536),
+    _useStagedTextureUploads(false),
+    _maximumStagingBufferPoolSize(64*1024*1024),
     _currentFrameNumber(0),
     _compileAllTillFrameNumber(0)
 {
+    _compileCostCalibration = new CompileCostCalibration;
+
     _markerObject = new osg::DummyObject;
     _markerObject->setName("HasBeenProcessedByStateToCompile");
 
@@ -479,6 +1120,18 @@ IncrementalCompileOperation::IncrementalCompileOperation():
         OSG_NOTICE<<"OSG_FORCE_TEXTURE_DOWNLOAD set to "<<useForceTextureDownload<<std::endl;
     }
 
+    if( (ptr = getenv("OSG_ENFORCE_COMPILE_TIME_BUDGET")) != 0)
+    {
+        _enforceCompileTimeBudget = strcmp(ptr,"yes")==0 || strcmp(ptr,"YES")==0 ||
+                                    strcmp(ptr,"on")==0 || strcmp(ptr,"ON")==0;
+    }
+
+    if( (ptr = getenv("OSG_STAGED_TEXTURE_UPLOAD")) != 0)
+    {
+        _useStagedTextureUploads = strcmp(ptr,"yes")==0 || strcmp(ptr,"YES")==0 ||
+                                   strcmp(ptr,"on")==0 || strcmp(ptr,"ON")==0;
+    }
+
     if (useForceTextureDownload)
     {
         assignForceTextureDownloadGeometry();
@@ -488,6 +1141,15 @@ IncrementalCompileOperation::IncrementalCompileOperation():
 
 IncrementalCompileOperation::~IncrementalCompileOperation()
 {
+    // release the staging buffers while the staging thread is still running to finish the copies into them.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_stagingBufferPoolsMutex);
+    for(StagingBufferPoolMap::iterator itr = _stagingBufferPools.begin();
+        itr != _stagingBufferPools.end();
+        ++itr)
+    {
+        if (itr->second.valid()) itr->second->releaseGLObjects(itr->first);
+    }
+    _stagingBufferPools.clear();
 }
 
 void IncrementalCompileOperation::assignForceTextureDownloadGeometry()
@@ -555,6 +1217,17 @@ void IncrementalCompileOperation::removeGraphicsContext(osg::GraphicsContext* gc
     {
         gc->remove(this);
         _contexts.erase(gc);
+
+        if (gc->getState())
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_stagingBufferPoolsMutex);
+            StagingBufferPoolMap::iterator itr = _stagingBufferPools.find(gc->getState()->getContextID());
+            if (itr!=_stagingBufferPools.end())
+            {
+                if (itr->second.valid()) itr->second->releaseGLObjects(itr->first);
+                _stagingBufferPools.erase(itr);
+            }
+        }
     }
 }
 
@@ -699,6 +1372,19 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
     compileInfo.maxNumObjectsToCompile = _maximumNumOfObjectsToCompilePerFrame;
     compileInfo.allocatedTime = compileTime;
     compileInfo.compileAll = (_compileAllTillFrameNumber > _currentFrameNumber);
+    compileInfo.enforceCompileTimeBudget = _enforceCompileTimeBudget;
+    compileInfo.stats.frameNumber = fs ? fs->getFrameNumber() : 0;
+
+    {
+        // return staging buffers whose uploads have completed to the pool.
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_stagingBufferPoolsMutex);
+        StagingBufferPoolMap::iterator itr = _stagingBufferPools.find(context->getState()->getContextID());
+        if (itr!=_stagingBufferPools.end() && itr->second.valid())
+        {
+            itr->second->setMaximumSize(_maximumStagingBufferPoolSize);
+            itr->second->recycle(*(context->getState()));
+        }
+    }
 
     CompileSets toCompileCopy;
     {
@@ -711,6 +1397,8 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
         compileSets(toCompileCopy, compileInfo);
     }
 
+    double firstPassCompileTime = compileInfo.timer.elapsedTime();
+
     osg::flushDeletedGLObjects(context->getState()->getContextID(), currentTime, flushTime);
 
     if (!toCompileCopy.empty() && compileInfo.maxNumObjectsToCompile>0)
@@ -721,14 +1409,72 @@ void IncrementalCompileOperation::operator () (osg::GraphicsContext* context)
         if (compileInfo.okToCompile())
         {
             OSG_NOTIFY(level)<<"    Passing on "<<flushTime<<" to second round of compileSets(..)"<<std::endl;
+
+            double startSecondPass = compileInfo.timer.elapsedTime();
             compileSets(toCompileCopy, compileInfo);
+            firstPassCompileTime += compileInfo.timer.elapsedTime()-startSecondPass;
         }
     }
 
+    if (!toCompileCopy.empty())
+    {
+        compileInfo.stats.allocatedTime = compileInfo.allocatedTime;
+        compileInfo.stats.compileTime = firstPassCompileTime;
+
+        OSG_NOTIFY(level)<<"    compiled "<<compileInfo.stats.numObjectsCompiled<<" objects, "<<compileInfo.stats.numPartialUploads<<" partial uploads, "
+                         <<compileInfo.stats.numBytesUploaded<<" bytes in "<<compileInfo.stats.compileTime*1000.0<<"ms, deferred "
+                         <<compileInfo.stats.numObjectsDeferred<<std::endl;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileStatsMutex);
+        _compileStatsMap[context] = compileInfo.stats;
+    }
+
     //glFush();
     //glFinish();
 }
 
+IncrementalCompileOperation::StagingBufferPool* IncrementalCompileOperation::getOrCreateStagingBufferPool(osg::State& state)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_stagingBufferPoolsMutex);
+
+    osg::ref_ptr<StagingBufferPool>& pool = _stagingBufferPools[state.getContextID()];
+    if (!pool)
+    {
+        if (!StagingBufferPool::isSupported(state))
+        {
+            OSG_INFO<<"IncrementalCompileOperation staged texture uploads not supported by context "<<state.getContextID()<<std::endl;
+            return 0;
+        }
+
+        pool = new StagingBufferPool(_maximumStagingBufferPoolSize);
+    }
+    return pool.get();
+}
+
+void IncrementalCompileOperation::copyToStagingBuffer(const osg::Image* image, StagingBufferPool::StagingBuffer* buffer)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_stagingBufferPoolsMutex);
+        if (!_stagingThread)
+        {
+            _stagingThread = new osg::OperationThread;
+            _stagingThread->startThread();
+        }
+    }
+
+    _stagingThread->add(new StagingCopyOperation(image, buffer));
+}
+
+bool IncrementalCompileOperation::getCompileStats(const osg::GraphicsContext* context, CompileStats& stats) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_compileStatsMutex);
+    CompileStatsMap::const_iterator itr = _compileStatsMap.find(context);
+    if (itr==_compileStatsMap.end()) return false;
+
+    stats = itr->second;
+    return true;
+}
+
 void IncrementalCompileOperation::compileSets(CompileSets& toCompile, CompileInfo& compileInfo)
 {
     osg::NotifySeverity level = osg::INFO;
@@ -14,6 +14,7 @@
 #include <osg/GLExtensions>
 #include <osg/TextureRectangle>
 #include <osg/TextureCubeMap>
+#include <osg/ContextData>
 
 #include <osgGA/TrackballManipulator>
 #include <osgViewer/CompositeViewer>
@@ -610,6 +611,7 @@ void CompositeViewer::realize()
 
         // set the pool sizes, 0 the default will result in no GL object pools.
         gc->getState()->setMaxTexturePoolSize(maxTexturePoolSize);
+        osg::get<osg::TextureObjectManager>(gc->getState()->getContextID())->setEnforceMaxTexturePoolSize(ds->getEnforceMaxTexturePoolSize());
         gc->getState()->setMaxBufferObjectPoolSize(maxBufferObjectPoolSize);
 
         gc->realize();
@@ -19,6 +19,7 @@
 #include <osg/os_utils>
 #include <osg/TextureRectangle>
 #include <osg/TextureCubeMap>
+#include <osg/ContextData>
 
 #include <osgUtil/RayIntersector>
 
@@ -572,6 +573,7 @@ void Viewer::realize()
 
         // set the pool sizes, 0 the default will result in no GL object pools.
         gc->getState()->setMaxTexturePoolSize(maxTexturePoolSize);
+        osg::get<osg::TextureObjectManager>(gc->getState()->getContextID())->setEnforceMaxTexturePoolSize(ds->getEnforceMaxTexturePoolSize());
         gc->getState()->setMaxBufferObjectPoolSize(maxBufferObjectPoolSize);
 
         gc->realize();
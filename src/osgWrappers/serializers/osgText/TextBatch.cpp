@@ -0,0 +1,41 @@
+#include <osgText/TextBatch>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/InputStream>
+#include <osgDB/OutputStream>
+
+static bool checkLabels( const osgText::TextBatch& node )
+{
+    return node.getNumLabels()>0;
+}
+
+static bool readLabels( osgDB::InputStream& is, osgText::TextBatch& node )
+{
+    unsigned int size = 0; is >> size >> is.BEGIN_BRACKET;
+    for ( unsigned int i=0; i<size; ++i )
+    {
+        osg::ref_ptr<osgText::Text> text = is.readObjectOfType<osgText::Text>();
+        if ( text ) node.addLabel( text.get() );
+    }
+    is >> is.END_BRACKET;
+    return true;
+}
+
+static bool writeLabels( osgDB::OutputStream& os, const osgText::TextBatch& node )
+{
+    unsigned int size = node.getNumLabels();
+    os << size << os.BEGIN_BRACKET << std::endl;
+    for ( unsigned int i=0; i<size; ++i )
+    {
+        os << node.getLabel(i);
+    }
+    os << os.END_BRACKET << std::endl;
+    return true;
+}
+
+REGISTER_OBJECT_WRAPPER( osgText_TextBatch,
+                         new osgText::TextBatch,
+                         osgText::TextBatch,
+                         "osg::Object osg::Node osgText::TextBatch" )
+{
+    ADD_USER_SERIALIZER( Labels );  // _labels
+}